@@ -26,7 +26,11 @@
 #include "dbLayout.h"
 #include "dbReader.h"
 #include "dbCIFWriter.h"
+#include "dbStreamingWriter.h"
 #include "tlCommandLineParser.h"
+#include "tlLog.h"
+
+#include <algorithm>
 
 namespace bd
 {
@@ -36,6 +40,8 @@ int converter_main (int argc, char *argv[], const std::string &format)
   bd::GenericWriterOptions generic_writer_options;
   bd::GenericReaderOptions generic_reader_options;
   std::string infile, outfile;
+  bool streaming = false;
+  double streaming_budget = 0.0;
 
   tl::CommandLineOptions cmd;
   generic_writer_options.add_options (cmd, format);
@@ -43,6 +49,19 @@ int converter_main (int argc, char *argv[], const std::string &format)
 
   cmd << tl::arg ("input",  &infile,  "The input file (any format, may be gzip compressed)")
       << tl::arg ("output", &outfile, tl::sprintf ("The output file (%s format)", format))
+      << tl::arg ("#--streaming", &streaming, "Converts cell by cell",
+                  "With this option, the cells are written as soon as they have been read and their content "
+                  "is released afterwards. This way, the layout does not need to be held in memory entirely. "
+                  "The memory savings apply to GDS2 input. Streaming is available for GDS2 and OASIS output. "
+                  "Cell selection (--write-cells) and dropping of empty cells are not supported in this mode. "
+                  "PCell and library context information is not written. OASIS files are always written in "
+                  "non-strict mode."
+                 )
+      << tl::arg ("#--streaming-budget=mb", &streaming_budget, "Specifies the memory budget for streaming",
+                  "In streaming mode, cells are collected until their content exceeds the given amount of memory "
+                  "(in megabytes). Then they are written and released. The default is 0 which means every cell is "
+                  "written immediately."
+                 )
     ;
 
   cmd.brief (tl::sprintf ("This program will convert the given file to a %s file", format));
@@ -51,6 +70,37 @@ int converter_main (int argc, char *argv[], const std::string &format)
 
   db::Layout layout;
 
+  if (streaming) {
+
+    db::SaveLayoutOptions save_options;
+    generic_writer_options.configure (save_options, layout);
+    save_options.set_format (format);
+
+    if (generic_writer_options.needs_full_layout ()) {
+      tl::warn << "Streaming is not available with cell selection or when dropping empty cells - using normal mode";
+    } else if (! db::StreamingWriter::supports (save_options)) {
+      tl::warn << tl::sprintf ("Streaming is not available for format %s - using normal mode", format);
+    } else {
+
+      db::LoadLayoutOptions load_options;
+      generic_reader_options.configure (load_options);
+
+      tl::OutputStream out_stream (outfile);
+      db::StreamingWriter writer (save_options, out_stream, size_t (std::max (0.0, streaming_budget) * 1024.0 * 1024.0));
+
+      tl::InputStream stream (infile);
+      db::Reader reader (stream);
+      reader.set_cell_sink (&writer);
+      reader.read (layout, load_options);
+
+      writer.finish (layout);
+
+      return 0;
+
+    }
+
+  }
+
   {
     db::LoadLayoutOptions load_options;
     generic_reader_options.configure (load_options);
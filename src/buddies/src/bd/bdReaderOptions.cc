@@ -72,6 +72,12 @@ GenericReaderOptions::add_options (tl::CommandLineOptions &cmd)
                     "* A:1/0 B:2/0\n"
                     "  Maps named layer A to 1/0 and named layer B to 2/0"
                    )
+        << tl::arg (group +
+                    "#--" + m_long_prefix + "update-threads=threads", &m_common_reader_options.update_threads, "Specifies the number of threads for preparing the layout after reading",
+                    "If this value is larger than 0, the bounding box computation and the sorting of the shape "
+                    "and instance trees after reading is distributed over the given number of threads. "
+                    "The default is 0 (no threads)."
+                   )
       ;
   }
 
@@ -86,6 +92,12 @@ GenericReaderOptions::add_options (tl::CommandLineOptions &cmd)
                     "#!--" + m_long_prefix + "no-properties", &m_common_reader_options.enable_properties, "Skips properties",
                     "With this option set, properties won't be read."
                    )
+        << tl::arg (group +
+                    "#--" + m_long_prefix + "read-threads=threads", this, &GenericReaderOptions::set_read_threads, "Specifies the number of threads for decoding the cells",
+                    "If this value is larger than 0, the cells of GDS2 files and of strict-mode OASIS files with "
+                    "cell offsets are decoded in parallel using the given number of threads. Compressed files and "
+                    "OASIS files without cell offsets are read sequentially. The default is 0 (sequential reading)."
+                   )
       ;
   }
 
@@ -228,6 +240,12 @@ void GenericReaderOptions::set_dbu (double dbu)
   m_cif_reader_options.dbu = dbu;
 }
 
+void GenericReaderOptions::set_read_threads (int n)
+{
+  m_gds2_reader_options.read_threads = n;
+  m_oasis_reader_options.read_threads = n;
+}
+
 void
 GenericReaderOptions::configure (db::LoadLayoutOptions &load_options) const
 {
@@ -109,6 +109,7 @@ private:
 
   void set_layer_map (const std::string &lm);
   void set_dbu (double dbu);
+  void set_read_threads (int n);
 };
 
 }
@@ -181,6 +181,11 @@ GenericWriterOptions::add_options (tl::CommandLineOptions &cmd, const std::strin
         << tl::arg (group +
                     "-ob|--cblocks", &m_oasis_writer_options.write_cblocks, "Uses CBLOCK compression"
                    )
+        << tl::arg (group +
+                    "#--cblock-threads", &m_oasis_writer_options.cblock_threads, "Compresses CBLOCKs in multiple threads",
+                    "Specifies the number of threads to use for CBLOCK compression (with --cblocks). "
+                    "The output is identical to the one produced without threads. The default is 0 (no threads)."
+                   )
         << tl::arg (group +
                     "-ot|--strict-mode", &m_oasis_writer_options.strict_mode, "Uses strict mode"
                    )
@@ -102,6 +102,16 @@ public:
    */
   void configure (db::SaveLayoutOptions &save_options, const db::Layout &layout) const;
 
+  /**
+   *  @brief Returns true, if the options require the full layout for writing
+   *  Cell selections for example need the full hierarchy. In this case, cell-wise
+   *  (streaming) output is not possible.
+   */
+  bool needs_full_layout () const
+  {
+    return ! m_cell_selection.empty () || m_dont_write_empty_cells;
+  }
+
 private:
   double m_scale_factor;
   double m_dbu;
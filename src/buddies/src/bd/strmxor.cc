@@ -22,77 +22,81 @@
 
 #include "bdReaderOptions.h"
 #include "dbLayout.h"
+#include "dbHashMix.h"
 #include "dbTilingProcessor.h"
+#include "dbRecursiveShapeIterator.h"
+#include "dbRegion.h"
 #include "dbReader.h"
 #include "dbWriter.h"
 #include "dbSaveLayoutOptions.h"
-#include "gsiExpression.h"
 #include "tlCommandLineParser.h"
+#include "tlThreadedWorkers.h"
+#include "tlTimer.h"
 
-class CountingInserter
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <stdint.h>
+#include <algorithm>
+
+namespace {
+
+/**
+ *  @brief An inserter collecting the polygons of a tile's output
+ */
+class PolygonCollector
 {
 public:
-  CountingInserter ()
-    : m_count (0)
+  PolygonCollector (std::vector<db::Polygon> &polygons)
+    : mp_polygons (&polygons)
   {
     //  .. nothing yet ..
   }
 
   template <class T>
-  void operator() (const T & /*t*/)
+  void operator() (const T &t)
   {
-    m_count += 1;
+    mp_polygons->push_back (db::Polygon (t));
   }
 
-  size_t count () const
+  void operator() (const db::Polygon &p)
   {
-    return m_count;
+    mp_polygons->push_back (p);
   }
 
-private:
-  size_t m_count;
-};
-
-class CountingReceiver
-  : public db::TileOutputReceiver
-{
-public:
-  CountingReceiver ()
-    : m_count (0)
+  void operator() (const db::Text &)
   {
-    //  .. nothing yet ..
+    //  .. texts are discarded ..
   }
 
-  virtual void put (size_t /*ix*/, size_t /*iy*/, const db::Box &tile, size_t /*id*/, const tl::Variant &obj, double /*dbu*/, const db::ICplxTrans & /*trans*/, bool clip)
+  void operator() (const db::Edge &)
   {
-    CountingInserter inserter;
-    db::insert_var (inserter, obj, tile, clip);
-    m_count += inserter.count ();
+    //  .. edges are discarded ..
   }
 
-  size_t count () const
+  void operator() (const db::EdgePair &)
   {
-    return m_count;
+    //  .. edge pairs are discarded ..
   }
 
 private:
-  size_t m_count;
+  std::vector<db::Polygon> *mp_polygons;
 };
 
 struct ResultDescriptor
 {
   ResultDescriptor ()
-    : layer_a (-1), layer_b (-1), layer_output (-1), layout (0), top_cell (0)
+    : layer_a (-1), layer_b (-1), layer_output (-1), layout (0), top_cell (0), shape_count (0)
   {
     //  .. nothing yet ..
   }
 
-  tl::shared_ptr<CountingReceiver> counter;
   int layer_a;
   int layer_b;
   int layer_output;
   db::Layout *layout;
   db::cell_index_type top_cell;
+  size_t shape_count;
 
   size_t count () const
   {
@@ -100,31 +104,646 @@ struct ResultDescriptor
       //  NOTE: this assumes the output is flat
       tl_assert (layout->cells () == 1);
       return layout->cell (top_cell).shapes (layer_output).size ();
-    } else if (counter) {
-      return counter->count ();
     } else {
-      return 0;
+      return shape_count;
     }
   }
 
   bool is_empty () const
   {
-    if (layout && layer_output >= 0) {
-      //  NOTE: this assumes the output is flat
-      tl_assert (layout->cells () == 1);
-      return layout->cell (top_cell).shapes (layer_output).empty ();
-    } else if (counter) {
-      return counter->count () == 0;
+    return count () == 0;
+  }
+};
+
+// ----------------------------------------------------------------------------------
+//  Layer signatures
+
+/**
+ *  @brief Layer-specific signatures of the cells of a layout
+ *
+ *  The signature of a cell summarizes the polygons, boxes and paths on one layer 
+ *  plus the instances of child cells which are not empty on this layer. Cells with 
+ *  the same signature are considered identical on this layer - even if they come 
+ *  from different layouts. A signature of 0 indicates a cell which is empty on the layer.
+ *
+ *  The signatures allow telling whether the content of two layouts inside a 
+ *  region is identical without flattening the hierarchy.
+ */
+class LayerSignatures
+{
+public:
+  LayerSignatures ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void compute (const db::Layout &layout, unsigned int layer)
+  {
+    m_signatures.clear ();
+    m_signatures.resize (layout.cells (), 0);
+
+    for (db::Layout::bottom_up_const_iterator c = layout.begin_bottom_up (); c != layout.end_bottom_up (); ++c) {
+
+      const db::Cell &cell = layout.cell (*c);
+
+      uint64_t sum = 0;
+      uint64_t n = 0;
+
+      for (db::ShapeIterator s = cell.shapes (layer).begin (shape_flags ()); ! s.at_end (); ++s) {
+        sum += shape_signature (*s);
+        ++n;
+      }
+
+      for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+        uint64_t cs = m_signatures [i->cell_index ()];
+        if (cs != 0) {
+          sum += inst_signature (i->cell_inst (), cs);
+          ++n;
+        }
+      }
+
+      uint64_t sig = 0;
+      if (n > 0) {
+        sig = db::hmix (sum, n);
+        if (sig == 0) {
+          sig = 1;
+        }
+      }
+
+      m_signatures [*c] = sig;
+
+    }
+  }
+
+  /**
+   *  @brief Describes an instance straddling the region's border
+   */
+  struct PartialInstance
+  {
+    PartialInstance (uint64_t _sig, db::cell_index_type _cell_index, const db::ICplxTrans &_trans)
+      : sig (_sig), cell_index (_cell_index), trans (_trans)
+    { }
+
+    bool operator< (const PartialInstance &other) const
+    {
+      return sig < other.sig;
+    }
+
+    uint64_t sig;
+    db::cell_index_type cell_index;
+    db::ICplxTrans trans;
+  };
+
+  /**
+   *  @brief Collects the signatures of the objects inside the given cell touching the given region
+   *
+   *  "trans" is the transformation of the cell into the top cell. The region is given in top 
+   *  cell coordinates. Shapes and instances completely inside the region deliver their signatures 
+   *  combined with the transformation, so the signatures are independent of the hierarchy level 
+   *  they are collected on. The signature of an instance covers the whole subtree. Hence instances
+   *  straddling the region's border are delivered in "partial", so the caller can descend into
+   *  them if required.
+   */
+  void collect (const db::Layout &layout, db::cell_index_type ci, const db::ICplxTrans &trans, unsigned int layer, const db::Box &region, std::vector<uint64_t> &sigs, std::vector<PartialInstance> &partial) const
+  {
+    const db::Cell &cell = layout.cell (ci);
+    uint64_t th = db::hash_trans (0, trans);
+
+    db::Box local_region = region;
+    if (! trans.is_unity ()) {
+      local_region = region.transformed (trans.inverted ());
+    }
+
+    for (db::ShapeIterator s = cell.shapes (layer).begin_touching (local_region, shape_flags ()); ! s.at_end (); ++s) {
+      sigs.push_back (db::hmix (shape_signature (*s), th));
+    }
+
+    db::box_convert<db::CellInst> bc (layout, layer);
+
+    for (db::Cell::touching_iterator i = cell.begin_touching (local_region); ! i.at_end (); ++i) {
+
+      uint64_t cs = m_signatures [i->cell_index ()];
+      if (cs == 0) {
+        continue;
+      }
+
+      const db::CellInstArray &inst = i->cell_inst ();
+      if (inst.bbox (bc).transformed (trans).inside (region)) {
+        sigs.push_back (db::hmix (inst_signature (inst, cs), th));
+        continue;
+      }
+
+      const db::Box &child_box = layout.cell (i->cell_index ()).bbox (layer);
+
+      for (db::CellInstArray::iterator a = inst.begin_touching (local_region, bc); ! a.at_end (); ++a) {
+        db::ICplxTrans t = trans * inst.complex_trans (*a);
+        uint64_t h = db::hash_trans (cs, t);
+        if (child_box.transformed (t).inside (region)) {
+          sigs.push_back (h);
+        } else {
+          partial.push_back (PartialInstance (h, i->cell_index (), t));
+        }
+      }
+
+    }
+  }
+
+private:
+  std::vector<uint64_t> m_signatures;
+
+  static unsigned int shape_flags ()
+  {
+    //  the same shapes which make up a db::Region
+    return db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes;
+  }
+
+  static uint64_t shape_signature (const db::Shape &shape)
+  {
+    db::Polygon poly;
+    shape.polygon (poly);
+
+    uint64_t h = 0;
+    for (unsigned int c = 0; c <= poly.holes (); ++c) {
+      h = db::hash_contour (h, poly.contour (c));
+    }
+
+    return h;
+  }
+
+  static uint64_t inst_signature (const db::CellInstArray &inst, uint64_t child_sig)
+  {
+    uint64_t h = db::hmix (child_sig, db::hash_trans (0, inst.complex_trans ()));
+
+    db::Vector a, b;
+    unsigned long na = 1, nb = 1;
+    if (inst.is_regular_array (a, b, na, nb)) {
+      h = db::hmix (h, a);
+      h = db::hmix (h, b);
+      h = db::hmix (h, uint64_t (na));
+      h = db::hmix (h, uint64_t (nb));
+    } else if (inst.size () > 1) {
+      for (db::CellInstArray::iterator i = inst.begin (); ! i.at_end (); ++i) {
+        h = db::hmix (h, db::hash_trans (0, inst.complex_trans (*i)));
+      }
+    }
+
+    return h;
+  }
+};
+
+// ----------------------------------------------------------------------------------
+//  The XOR job
+
+/**
+ *  @brief Describes one layer to XOR
+ */
+struct XORLayer
+{
+  XORLayer ()
+    : layer_a (-1), layer_b (-1), use_signatures (false)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::LayerProperties lp;
+  int layer_a, layer_b;
+  db::RecursiveShapeIterator iter_a, iter_b;
+  std::vector<ResultDescriptor *> results;
+  bool use_signatures;
+  LayerSignatures signatures_a, signatures_b;
+};
+
+/**
+ *  @brief The XOR job
+ *
+ *  The job schedules one task per layer. If tiling is enabled, this task
+ *  schedules the tasks for the tiles the layer is present on. Tiles with identical
+ *  content in both layouts are skipped. In early-exit mode, the job stops once
+ *  a difference is found.
+ */
+class XORJob
+  : public tl::JobBase
+{
+public:
+  XORJob (int nworkers, double dbu, const std::vector<db::Coord> &sizing, bool early_exit)
+    : tl::JobBase (nworkers),
+      m_dbu (dbu), m_sizing (sizing), m_early_exit (early_exit),
+      m_has_tiles (false), m_tile_width (0.0), m_tile_height (0.0), m_ntiles_w (0), m_ntiles_h (0), m_border (0.0),
+      m_difference_found (false), m_tiles_computed (0), m_tiles_skipped (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  ~XORJob ()
+  {
+    for (std::vector<XORLayer *>::const_iterator l = m_layers.begin (); l != m_layers.end (); ++l) {
+      delete *l;
+    }
+    m_layers.clear ();
+  }
+
+  void set_tiles (const db::DPoint &p0, double tile_width, double tile_height, size_t ntiles_w, size_t ntiles_h, double border)
+  {
+    m_has_tiles = true;
+    m_p0 = p0;
+    m_tile_width = tile_width;
+    m_tile_height = tile_height;
+    m_ntiles_w = ntiles_w;
+    m_ntiles_h = ntiles_h;
+    m_border = border;
+  }
+
+  size_t add_layer (XORLayer *layer)
+  {
+    m_layers.push_back (layer);
+    return m_layers.size () - 1;
+  }
+
+  XORLayer &layer (size_t index)
+  {
+    return *m_layers [index];
+  }
+
+  double dbu () const
+  {
+    return m_dbu;
+  }
+
+  const std::vector<db::Coord> &sizing () const
+  {
+    return m_sizing;
+  }
+
+  bool has_tiles () const
+  {
+    return m_has_tiles;
+  }
+
+  size_t ntiles_w () const
+  {
+    return m_ntiles_w;
+  }
+
+  size_t ntiles_h () const
+  {
+    return m_ntiles_h;
+  }
+
+  db::DBox tile_box (size_t ix, size_t iy) const
+  {
+    return db::DBox (m_p0.x () + ix * m_tile_width, m_p0.y () + iy * m_tile_height, m_p0.x () + (ix + 1) * m_tile_width, m_p0.y () + (iy + 1) * m_tile_height);
+  }
+
+  double border () const
+  {
+    return m_border;
+  }
+
+  bool done () const
+  {
+    return m_early_exit && m_difference_found;
+  }
+
+  void add_results (size_t layer_index, unsigned int tol_index, const std::vector<db::Polygon> &polygons)
+  {
+    if (polygons.empty ()) {
+      return;
+    }
+
+    QMutexLocker locker (&m_mutex);
+
+    ResultDescriptor *rd = m_layers [layer_index]->results [tol_index];
+    rd->shape_count += polygons.size ();
+
+    if (rd->layout && rd->layer_output >= 0) {
+      db::Shapes &shapes = rd->layout->cell (rd->top_cell).shapes (rd->layer_output);
+      for (std::vector<db::Polygon>::const_iterator p = polygons.begin (); p != polygons.end (); ++p) {
+        shapes.insert (*p);
+      }
+    }
+
+    m_difference_found = true;
+  }
+
+  void tile_done (bool skipped)
+  {
+    QMutexLocker locker (&m_mutex);
+    if (skipped) {
+      ++m_tiles_skipped;
     } else {
-      return true;
+      ++m_tiles_computed;
     }
   }
+
+  size_t tiles_computed () const
+  {
+    return m_tiles_computed;
+  }
+
+  size_t tiles_skipped () const
+  {
+    return m_tiles_skipped;
+  }
+
+  virtual tl::Worker *create_worker ();
+
+private:
+  double m_dbu;
+  std::vector<db::Coord> m_sizing;
+  bool m_early_exit;
+  bool m_has_tiles;
+  db::DPoint m_p0;
+  double m_tile_width, m_tile_height;
+  size_t m_ntiles_w, m_ntiles_h;
+  double m_border;
+  std::vector<XORLayer *> m_layers;
+  QMutex m_mutex;
+  volatile bool m_difference_found;
+  size_t m_tiles_computed, m_tiles_skipped;
 };
 
-BD_PUBLIC int strmxor (int argc, char *argv[])
+/**
+ *  @brief A task preparing a layer
+ */
+class XORLayerTask
+  : public tl::Task
+{
+public:
+  XORLayerTask (size_t layer_index)
+    : m_layer_index (layer_index)
+  {
+    //  .. nothing yet ..
+  }
+
+  size_t layer_index () const
+  {
+    return m_layer_index;
+  }
+
+private:
+  size_t m_layer_index;
+};
+
+/**
+ *  @brief A task computing the XOR for one layer and one tile
+ */
+class XORTileTask
+  : public tl::Task
 {
-  gsi::initialize_expressions ();
+public:
+  XORTileTask (size_t layer_index, size_t ix, size_t iy)
+    : m_layer_index (layer_index), m_ix (ix), m_iy (iy)
+  {
+    //  prefer finishing the tiles of the layers already prepared
+    set_priority (1);
+  }
+
+  size_t layer_index () const
+  {
+    return m_layer_index;
+  }
+
+  size_t ix () const
+  {
+    return m_ix;
+  }
+
+  size_t iy () const
+  {
+    return m_iy;
+  }
+
+private:
+  size_t m_layer_index;
+  size_t m_ix, m_iy;
+};
+
+class XORWorker
+  : public tl::Worker
+{
+public:
+  XORWorker (XORJob *job)
+    : tl::Worker (), mp_job (job)
+  {
+    //  .. nothing yet ..
+  }
+
+  void perform_task (tl::Task *task) 
+  {
+    //  in early-exit mode, skip the remaining tasks once a difference was found
+    if (mp_job->done ()) {
+      return;
+    }
+
+    XORTileTask *tile_task = dynamic_cast <XORTileTask *> (task);
+    if (tile_task) {
+      do_perform_tile (tile_task->layer_index (), tile_task->ix (), tile_task->iy ());
+    } else {
+      XORLayerTask *layer_task = dynamic_cast <XORLayerTask *> (task);
+      if (layer_task) {
+        do_perform_layer (layer_task->layer_index ());
+      }
+    }
+  }
+
+private:
+  XORJob *mp_job;
+
+  void do_perform_layer (size_t layer_index);
+  void do_perform_tile (size_t layer_index, size_t ix, size_t iy);
+  bool is_identical (const XORLayer &layer, const db::Box &region) const;
+  void do_xor (size_t layer_index, const db::Region &a, const db::Region &b, const db::Box &clip_box, bool clip);
+};
+
+void
+XORWorker::do_perform_layer (size_t layer_index)
+{
+  XORLayer &layer = mp_job->layer (layer_index);
+
+  if (layer.use_signatures) {
+    tl::SelfTimer timer (tl::verbosity () >= 31, "Computing layer signatures for " + layer.lp.to_string ());
+    layer.signatures_a.compute (*layer.iter_a.layout (), (unsigned int) layer.layer_a);
+    layer.signatures_b.compute (*layer.iter_b.layout (), (unsigned int) layer.layer_b);
+  }
+
+  if (! mp_job->has_tiles ()) {
+    do_perform_tile (layer_index, 0, 0);
+    return;
+  }
+
+  //  Only schedule the tiles the layer is present on
+  db::DBox layer_box;
+  if (! layer.iter_a.at_end ()) {
+    layer_box += layer.iter_a.bbox ().transformed (db::CplxTrans (layer.iter_a.layout ()->dbu ()));
+  }
+  if (! layer.iter_b.at_end ()) {
+    layer_box += layer.iter_b.bbox ().transformed (db::CplxTrans (layer.iter_b.layout ()->dbu ()));
+  }
+
+  if (layer_box.empty ()) {
+    return;
+  }
+
+  layer_box.enlarge (db::DVector (mp_job->border (), mp_job->border ()));
+
+  size_t n = 0;
+
+  for (size_t ix = 0; ix < mp_job->ntiles_w () && ! mp_job->done (); ++ix) {
+    for (size_t iy = 0; iy < mp_job->ntiles_h () && ! mp_job->done (); ++iy) {
+      if (mp_job->tile_box (ix, iy).touches (layer_box)) {
+        mp_job->schedule (new XORTileTask (layer_index, ix, iy));
+        ++n;
+      }
+    }
+  }
+
+  if (tl::verbosity () >= 20) {
+    tl::log << "Layer " << layer.lp.to_string () << ": " << n << " of " << mp_job->ntiles_w () * mp_job->ntiles_h () << " tiles";
+  }
+}
+
+bool
+XORWorker::is_identical (const XORLayer &layer, const db::Box &region) const
+{
+  typedef LayerSignatures::PartialInstance partial_instance;
+
+  std::vector<uint64_t> sigs_a, sigs_b;
+  std::vector<partial_instance> partial_a, partial_b;
+
+  const db::Layout &layout_a = *layer.iter_a.layout ();
+  const db::Layout &layout_b = *layer.iter_b.layout ();
+
+  layer.signatures_a.collect (layout_a, layer.iter_a.top_cell ()->cell_index (), db::ICplxTrans (), (unsigned int) layer.layer_a, region, sigs_a, partial_a);
+  layer.signatures_b.collect (layout_b, layer.iter_b.top_cell ()->cell_index (), db::ICplxTrans (), (unsigned int) layer.layer_b, region, sigs_b, partial_b);
+
+  //  Instances straddling the region's border are identical if their signatures are (same subtree,
+  //  same placement). The other ones are descended into, so a difference in a child cell outside
+  //  the region does not render the region different.
+  while (! partial_a.empty () || ! partial_b.empty ()) {
+
+    std::sort (partial_a.begin (), partial_a.end ());
+    std::sort (partial_b.begin (), partial_b.end ());
+
+    std::vector<partial_instance> next_a, next_b;
+
+    std::vector<partial_instance>::const_iterator pa = partial_a.begin (), pb = partial_b.begin ();
+    while (pa != partial_a.end () || pb != partial_b.end ()) {
+      if (pb == partial_b.end () || (pa != partial_a.end () && pa->sig < pb->sig)) {
+        layer.signatures_a.collect (layout_a, pa->cell_index, pa->trans, (unsigned int) layer.layer_a, region, sigs_a, next_a);
+        ++pa;
+      } else if (pa == partial_a.end () || pb->sig < pa->sig) {
+        layer.signatures_b.collect (layout_b, pb->cell_index, pb->trans, (unsigned int) layer.layer_b, region, sigs_b, next_b);
+        ++pb;
+      } else {
+        ++pa;
+        ++pb;
+      }
+    }
+
+    partial_a.swap (next_a);
+    partial_b.swap (next_b);
+
+  }
+
+  if (sigs_a.size () != sigs_b.size ()) {
+    return false;
+  }
+
+  std::sort (sigs_a.begin (), sigs_a.end ());
+  std::sort (sigs_b.begin (), sigs_b.end ());
+  return sigs_a == sigs_b;
+}
+
+void
+XORWorker::do_perform_tile (size_t layer_index, size_t ix, size_t iy)
+{
+  const XORLayer &layer = mp_job->layer (layer_index);
+
+  db::Box clip_box_dbu = db::Box::world ();
+  db::DBox region;
+
+  if (mp_job->has_tiles ()) {
+    db::DBox clip_box = mp_job->tile_box (ix, iy);
+    clip_box_dbu = db::Box (clip_box.transformed (db::DCplxTrans (mp_job->dbu ()).inverted ()));
+    region = clip_box.enlarged (db::DVector (mp_job->border (), mp_job->border ()));
+  }
+
+  //  NOTE: the signatures are only used if both layouts have the same database unit 
+  //  which is the database unit used for the output.
+  if (layer.use_signatures && is_identical (layer, mp_job->has_tiles () ? db::Box (region.transformed (db::DCplxTrans (mp_job->dbu ()).inverted ())) : db::Box::world ())) {
+    if (tl::verbosity () >= 30) {
+      tl::log << "Layer " << layer.lp.to_string () << ", tile " << ix + 1 << "," << iy + 1 << ": identical";
+    }
+    mp_job->tile_done (true);
+    return;
+  }
+
+  const db::RecursiveShapeIterator *iters[] = { &layer.iter_a, &layer.iter_b };
+  db::Region inputs [2];
+
+  for (unsigned int i = 0; i < 2; ++i) {
 
+    const db::RecursiveShapeIterator &iter = *iters [i];
+
+    double dbu = iter.layout () ? iter.layout ()->dbu () : mp_job->dbu ();
+    double sf = dbu / mp_job->dbu ();
+
+    if (! mp_job->has_tiles ()) {
+      inputs [i] = db::Region (iter, db::ICplxTrans (sf), true);
+    } else {
+
+      db::Box region_dbu = db::Box (region.transformed (db::DCplxTrans (dbu).inverted ()));
+      region_dbu &= iter.region ();
+
+      db::RecursiveShapeIterator tile_iter;
+      if (! region_dbu.empty ()) {
+        tile_iter = iter;
+        tile_iter.confine_region (region_dbu);
+      }
+
+      inputs [i] = db::Region (tile_iter, db::ICplxTrans (sf), true);
+
+    }
+
+  }
+
+  do_xor (layer_index, inputs [0], inputs [1], clip_box_dbu, mp_job->has_tiles () && ! clip_box_dbu.empty ());
+
+  mp_job->tile_done (false);
+}
+
+void
+XORWorker::do_xor (size_t layer_index, const db::Region &a, const db::Region &b, const db::Box &clip_box, bool clip)
+{
+  db::Region x = a ^ b;
+
+  unsigned int tol_index = 0;
+  for (std::vector<db::Coord>::const_iterator s = mp_job->sizing ().begin (); s != mp_job->sizing ().end (); ++s, ++tol_index) {
+
+    //  a negative sizing value means "no sizing"
+    if (*s >= 0) {
+      x = x.sized (-*s).sized (*s);
+    }
+
+    std::vector<db::Polygon> polygons;
+    PolygonCollector collector (polygons);
+    db::insert (collector, x, clip_box, clip);
+
+    mp_job->add_results (layer_index, tol_index, polygons);
+
+  }
+}
+
+tl::Worker *
+XORJob::create_worker ()
+{
+  return new XORWorker (this);
+}
+
+}
+
+BD_PUBLIC int strmxor (int argc, char *argv[])
+{
   bd::GenericReaderOptions generic_reader_options_a;
   generic_reader_options_a.set_prefix ("a");
   generic_reader_options_a.set_long_prefix ("a-");
@@ -144,6 +763,8 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
   int tolerance_bump = 10000;
   int threads = 1;
   double tile_size = 0.0;
+  bool early_exit = false;
+  bool no_hierarchy_check = false;
 
   tl::CommandLineOptions cmd;
   generic_reader_options_a.add_options (cmd);
@@ -193,6 +814,16 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
                   "original layers. A second tolerance value will produce XOR results on the original layers + 1000. "
                   "A third tolerance value will produce XOR results on the original layers + 2000."
                  )
+      << tl::arg ("-x|--early-exit",           &early_exit, "Stops on the first difference",
+                  "With this option, the XOR computation stops as soon as a difference is found. The exit code "
+                  "indicates whether differences exist, but the summary and the output file will only list "
+                  "the differences found so far. This option is useful to quickly check whether two layouts are "
+                  "identical."
+                 )
+      << tl::arg ("#--no-hierarchy-check",     &no_hierarchy_check, "Disables the hierarchical identity check",
+                  "By default, tiles or layers are not computed if the hierarchical content of both layouts "
+                  "is identical. This option disables this check and computes all tiles."
+                 )
     ;
 
   cmd.brief ("This program will compare two layout files with a geometrical XOR operation");
@@ -277,41 +908,53 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
     l2l_map.insert (std::make_pair (*(*l).second, std::make_pair (-1, -1))).first->second.second = (*l).first;
   }
 
-  db::TilingProcessor proc;
-  proc.set_dbu (std::min (layout_a.dbu (), layout_b.dbu ()));
-  proc.set_threads (std::max (1, threads));
-  if (tile_size > db::epsilon) {
-    if (tl::verbosity () >= 20) {
-      tl::log << "Tile size: " << tile_size;
-    }
-    proc.tile_size (tile_size, tile_size);
-  }
+  layout_a.update ();
+  layout_b.update ();
 
-  proc.tile_border (tolerances.back () * 2.0, tolerances.back () * 2.0);
-  if (tl::verbosity () >= 20) {
-    tl::log << "Tile border: " << tolerances.back () * 2.0;
-  }
+  double dbu = std::min (layout_a.dbu (), layout_b.dbu ());
+
+  //  the signatures can only be compared if both layouts use the same database unit
+  bool use_signatures = ! no_hierarchy_check && fabs (layout_a.dbu () - layout_b.dbu ()) < db::epsilon;
+
+  double tile_border = tolerances.back () * 2.0;
 
   if (tl::verbosity () >= 20) {
-    tl::log << "Database unit: " << proc.dbu ();
+    if (tile_size > db::epsilon) {
+      tl::log << "Tile size: " << tile_size;
+    }
+    tl::log << "Tile border: " << tile_border;
+    tl::log << "Database unit: " << dbu;
     tl::log << "Threads: " << threads;
     tl::log << "Layer bump for tolerance: " << tolerance_bump;
   }
 
+  //  Computes the sizing values for the tolerances (a negative value means "no sizing").
+  //  The tolerances are applied cumulatively.
+  std::vector<db::Coord> sizing;
+  for (std::vector<double>::const_iterator t = tolerances.begin (); t != tolerances.end (); ++t) {
+    if (*t > db::epsilon) {
+      sizing.push_back (db::Coord (floor (0.5 + *t / dbu) / 2.0));
+    } else {
+      sizing.push_back (-1);
+    }
+  }
+
   std::auto_ptr<db::Layout> output_layout;
   db::cell_index_type output_top = 0;
 
   if (! output.empty ()) {
     output_layout.reset (new db::Layout ());
-    output_layout->dbu (proc.dbu ());
+    output_layout->dbu (dbu);
     output_top = output_layout->add_cell ("XOR");
   }
 
+  XORJob job (std::max (1, threads), dbu, sizing, early_exit);
+
   std::map<std::pair<int, db::LayerProperties>, ResultDescriptor> results;
 
   bool result = true;
 
-  int index = 1;
+  db::DBox tot_box;
 
   for (std::map<db::LayerProperties, std::pair<int, int> >::const_iterator ll = l2l_map.begin (); ll != l2l_map.end (); ++ll) {
 
@@ -340,28 +983,29 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
 
     } else {
 
-      std::string in_a = "a" + tl::to_string (index);
-      std::string in_b = "b" + tl::to_string (index);
+      XORLayer *layer = new XORLayer ();
+      layer->lp = ll->first;
+      layer->layer_a = ll->second.first;
+      layer->layer_b = ll->second.second;
+      layer->use_signatures = use_signatures && layer->layer_a >= 0 && layer->layer_b >= 0;
 
-      if (ll->second.first < 0) {
-        proc.input (in_a, db::RecursiveShapeIterator ());
-      } else {
-        proc.input (in_a, db::RecursiveShapeIterator (layout_a, layout_a.cell (index_a.second), ll->second.first));
+      if (layer->layer_a >= 0) {
+        layer->iter_a = db::RecursiveShapeIterator (layout_a, layout_a.cell (index_a.second), layer->layer_a);
+        if (! layer->iter_a.at_end ()) {
+          tot_box += layer->iter_a.bbox ().transformed (db::CplxTrans (layout_a.dbu ()));
+        }
       }
 
-      if (ll->second.second < 0) {
-        proc.input (in_b, db::RecursiveShapeIterator ());
-      } else {
-        proc.input (in_b, db::RecursiveShapeIterator (layout_b, layout_b.cell (index_b.second), ll->second.second));
+      if (layer->layer_b >= 0) {
+        layer->iter_b = db::RecursiveShapeIterator (layout_b, layout_b.cell (index_b.second), layer->layer_b);
+        if (! layer->iter_b.at_end ()) {
+          tot_box += layer->iter_b.bbox ().transformed (db::CplxTrans (layout_b.dbu ()));
+        }
       }
 
-      std::string expr = "var x=" + in_a + "^" + in_b + "; ";
-
       int tol_index = 0;
       for (std::vector<double>::const_iterator t = tolerances.begin (); t != tolerances.end (); ++t) {
 
-        std::string out = "o" + tl::to_string (index) + "_" + tl::to_string (tol_index + 1);
-
         db::LayerProperties lp = ll->first;
         if (lp.layer >= 0) {
           lp.layer += tol_index * tolerance_bump;
@@ -375,37 +1019,71 @@ BD_PUBLIC int strmxor (int argc, char *argv[])
 
         if (result.layout) {
           result.layer_output = result.layout->insert_layer (lp);
-          proc.output (out, *result.layout, result.top_cell, result.layer_output);
-        } else {
-          CountingReceiver *counter = new CountingReceiver ();
-          result.counter = counter;
-          proc.output (out, 0, counter, db::ICplxTrans ());
         }
 
-        if (*t > db::epsilon) {
-          expr += "x=x.sized(-round(" + tl::to_string (*t) + "/_dbu)/2).sized(round(" + tl::to_string (*t) + "/_dbu)/2); ";
-        }
-        expr += "_output(" + out + ",x); ";
+        layer->results.push_back (&result);
 
         ++tol_index;
 
       }
 
+      job.schedule (new XORLayerTask (job.add_layer (layer)));
+
+    }
+
+  }
+
+  //  Sets up the tiles: the tile grid is centered over the total bounding box of all layers
+
+  if (! tot_box.empty () && tile_size > db::epsilon) {
+
+    tot_box.enlarge (db::DVector (tile_border, tile_border));
+
+    double tile_width = dbu * floor (0.5 + tile_size / dbu + 1e-10);
+    size_t ntiles_w = tile_size > 1e-6 ? size_t (ceil (tot_box.width () / tile_size - 1e-10)) : 1;
+    size_t ntiles_h = tile_size > 1e-6 ? size_t (ceil (tot_box.height () / tile_size - 1e-10)) : 1;
+
+    if (ntiles_w > 1 || ntiles_h > 1) {
+
+      double l = dbu * floor (0.5 + (tot_box.center ().x () - ntiles_w * 0.5 * tile_width) / dbu + 1e-10);
+      double b = dbu * floor (0.5 + (tot_box.center ().y () - ntiles_h * 0.5 * tile_width) / dbu + 1e-10);
+
+      job.set_tiles (db::DPoint (l, b), tile_width, tile_width, ntiles_w, ntiles_h, tile_border);
+
       if (tl::verbosity () >= 20) {
-        tl::log << "Running expression: '" << expr << "' for layer " << ll->first;
+        tl::log << "Tiles: " << ntiles_w << "x" << ntiles_h;
       }
-      proc.queue (expr);
 
     }
 
-    ++index;
-
   }
 
-  //  Runs the processor
+  //  Runs the XOR: with a difference already known from a missing layer, the XOR is only
+  //  needed to produce a summary or an output file. In early-exit mode, this difference is sufficient.
+
+  if (! tot_box.empty () && (((! silent && ! no_summary) || result || output_layout.get ()) && ! (early_exit && ! result))) {
+
+    tl::SelfTimer timer (tl::verbosity () >= 11, "Running XOR");
+
+    if (output_layout.get ()) {
+      output_layout->start_changes ();
+    }
+
+    job.start ();
+    job.wait ();
+
+    if (output_layout.get ()) {
+      output_layout->end_changes ();
+    }
+
+    if (job.has_error ()) {
+      throw tl::Exception (job.error_messages ().front ());
+    }
+
+    if (tl::verbosity () >= 20) {
+      tl::log << "Tiles computed: " << job.tiles_computed () << ", skipped as identical: " << job.tiles_skipped ();
+    }
 
-  if ((! silent && ! no_summary) || result || output_layout.get ()) {
-    proc.execute ("Running XOR");
   }
 
   //  Writes the output layout
@@ -22,6 +22,7 @@
 
 #include "bdCommon.h"
 #include "dbReader.h"
+#include "dbWriter.h"
 #include "dbTestSupport.h"
 #include "tlLog.h"
 #include "tlUnitTest.h"
@@ -326,3 +327,110 @@ TEST(6)
     "Layer 10/0 is not present in first layout, but in second\n"
   );
 }
+
+TEST(7A)
+{
+  tl::CaptureChannel cap;
+
+  std::string input_a = tl::testsrc ();
+  input_a += "/testdata/bd/strmxor_in1.gds";
+
+  std::string input_b = tl::testsrc ();
+  input_b += "/testdata/bd/strmxor_in1.gds";
+
+  const char *argv[] = { "x", "-x", "-p=1.0", "-n=4", input_a.c_str (), input_b.c_str () };
+
+  EXPECT_EQ (strmxor (sizeof (argv) / sizeof (argv[0]), (char **) argv), 0);
+
+  EXPECT_EQ (cap.captured_text (),
+    "No differences found\n"
+  );
+}
+
+TEST(7B)
+{
+  tl::CaptureChannel cap;
+
+  std::string input_a = tl::testsrc ();
+  input_a += "/testdata/bd/strmxor_in1.gds";
+
+  std::string input_b = tl::testsrc ();
+  input_b += "/testdata/bd/strmxor_in1.gds";
+
+  const char *argv[] = { "x", "--no-hierarchy-check", "-p=1.0", "-n=4", input_a.c_str (), input_b.c_str () };
+
+  EXPECT_EQ (strmxor (sizeof (argv) / sizeof (argv[0]), (char **) argv), 0);
+
+  EXPECT_EQ (cap.captured_text (),
+    "No differences found\n"
+  );
+}
+
+TEST(7C)
+{
+  tl::CaptureChannel cap;
+
+  std::string input_a = tl::testsrc ();
+  input_a += "/testdata/bd/strmxor_in1.gds";
+
+  std::string input_b = tl::testsrc ();
+  input_b += "/testdata/bd/strmxor_in2.gds";
+
+  const char *argv[] = { "x", "-s", "-x", "-l", "-p=1.0", "-n=4", input_a.c_str (), input_b.c_str () };
+
+  EXPECT_EQ (strmxor (sizeof (argv) / sizeof (argv[0]), (char **) argv), 1);
+  EXPECT_EQ (cap.captured_text (), "");
+}
+
+static void write_hier_test_layout (const std::string &fn, db::Coord leaf2_size)
+{
+  db::Layout layout;
+  layout.dbu (0.001);
+  unsigned int l1 = layout.insert_layer (db::LayerProperties (1, 0));
+
+  db::Cell &leaf1 = layout.cell (layout.add_cell ("LEAF1"));
+  leaf1.shapes (l1).insert (db::Box (0, 0, 1000, 1000));
+
+  db::Cell &leaf2 = layout.cell (layout.add_cell ("LEAF2"));
+  leaf2.shapes (l1).insert (db::Box (0, 0, leaf2_size, leaf2_size));
+
+  db::Cell &chip = layout.cell (layout.add_cell ("CHIP"));
+  chip.insert (db::CellInstArray (db::CellInst (leaf1.cell_index ()), db::Trans (), db::Vector (2000, 0), db::Vector (0, 2000), 4, 4));
+  chip.insert (db::CellInstArray (db::CellInst (leaf2.cell_index ()), db::Trans (db::Vector (20000, 20000))));
+
+  db::Cell &top = layout.cell (layout.add_cell ("TOP"));
+  top.insert (db::CellInstArray (db::CellInst (chip.cell_index ()), db::Trans ()));
+
+  tl::OutputStream stream (fn);
+  db::SaveLayoutOptions options;
+  db::Writer writer (options);
+  writer.write (layout, stream);
+}
+
+//  a difference in a leaf cell outside a tile does not render the tile different
+TEST(8)
+{
+  std::string input_a = this->tmp_file ("a.gds");
+  write_hier_test_layout (input_a, 500);
+
+  std::string input_b = this->tmp_file ("b.gds");
+  write_hier_test_layout (input_b, 600);
+
+  tl::CaptureChannel cap;
+  tl::log.add (&cap, false);
+
+  int verbosity = tl::verbosity ();
+  tl::verbosity (20);
+
+  const char *argv[] = { "x", "-s", "-p=3.0", input_a.c_str (), input_b.c_str () };
+  int ret = strmxor (sizeof (argv) / sizeof (argv[0]), (char **) argv);
+
+  tl::verbosity (verbosity);
+
+  EXPECT_EQ (ret, 1);
+
+  //  only the tile with LEAF2 is computed, all others are skipped
+  std::string text = cap.captured_text ();
+  EXPECT_EQ (text.find ("Tiles computed: 1, skipped as identical: ") != std::string::npos, true);
+  EXPECT_EQ (text.find ("skipped as identical: 0\n") == std::string::npos, true);
+}
@@ -23,6 +23,7 @@ SOURCES = \
   dbClipboard.cc \
   dbClipboardData.cc \
   dbClip.cc \
+  dbDeepRegion.cc \
   dbDXF.cc \
   dbDXFReader.cc \
   dbDXFWriter.cc \
@@ -85,6 +86,7 @@ SOURCES = \
   dbStatic.cc \
   dbStream.cc \
   dbStreamLayers.cc \
+  dbStreamingWriter.cc \
   dbTestSupport.cc \
   dbText.cc \
   dbTextWriter.cc \
@@ -101,6 +103,7 @@ SOURCES = \
   gsiDeclDbBox.cc \
   gsiDeclDbCell.cc \
   gsiDeclDbCellMapping.cc \
+  gsiDeclDbDeepRegion.cc \
   gsiDeclDbEdge.cc \
   gsiDeclDbEdgePair.cc \
   gsiDeclDbEdgePairs.cc \
@@ -148,6 +151,7 @@ HEADERS = \
   dbClipboardData.h \
   dbClipboard.h \
   dbClip.h \
+  dbDeepRegion.h \
   dbDXF.h \
   dbDXFReader.h \
   dbDXFWriter.h \
@@ -166,6 +170,7 @@ HEADERS = \
   dbGDS2WriterBase.h \
   dbGDS2Writer.h \
   dbHash.h \
+  dbHashMix.h \
   dbHersheyFont.h \
   dbHershey.h \
   dbInstances.h \
@@ -213,6 +218,7 @@ HEADERS = \
   dbStatic.h \
   dbStream.h \
   dbStreamLayers.h \
+  dbStreamingWriter.h \
   dbTestSupport.h \
   dbText.h \
   dbTextWriter.h \
@@ -28,6 +28,7 @@
 
 #include "dbBoxConvert.h"
 #include "tlProgress.h"
+#include "tlThreadedWorkers.h"
 
 #include <list>
 #include <vector>
@@ -131,6 +132,134 @@ struct box_scanner_receiver
   void add (const Obj * /*o1*/, const Prop & /*p1*/, const Obj * /*o2*/, const Prop & /*p2*/) { }
 };
 
+/**
+ *  @brief The base class for the tasks of the multi-threaded box scanner
+ */
+class box_scanner_task_base
+  : public tl::Task
+{
+public:
+  virtual void perform () = 0;
+};
+
+/**
+ *  @brief The worker of the multi-threaded box scanner
+ */
+class box_scanner_worker
+  : public tl::Worker
+{
+public:
+  box_scanner_worker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    box_scanner_task_base *bs_task = dynamic_cast<box_scanner_task_base *> (task);
+    if (bs_task) {
+      bs_task->perform ();
+    }
+  }
+};
+
+/**
+ *  @brief The job of the multi-threaded box scanner
+ */
+class box_scanner_job
+  : public tl::JobBase
+{
+public:
+  box_scanner_job (int nworkers)
+    : tl::JobBase (nworkers)
+  { }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new box_scanner_worker ();
+  }
+};
+
+/**
+ *  @brief A receiver recording the interactions found inside a partition 
+ *
+ *  The properties are the indexes of the objects in the box scanner's sorted list.
+ *  Interactions are recorded only if one object is an object of the partition
+ *  (index "from" or larger). Interactions between the objects carried over from
+ *  the previous partitions are reported by these.
+ */
+template <class Obj>
+struct box_scanner_partition_receiver
+{
+  box_scanner_partition_receiver (size_t from, std::vector<std::pair<size_t, size_t> > *interactions)
+    : m_from (from), mp_interactions (interactions)
+  { }
+
+  void finish (const Obj *, size_t) { }
+
+  void add (const Obj *, size_t i1, const Obj *, size_t i2)
+  {
+    if (i1 >= m_from || i2 >= m_from) {
+      mp_interactions->push_back (std::make_pair (i1, i2));
+    }
+  }
+
+private:
+  size_t m_from;
+  std::vector<std::pair<size_t, size_t> > *mp_interactions;
+};
+
+template <class Obj, class Prop> class box_scanner;
+
+/**
+ *  @brief The task computing the interactions of one partition of the multi-threaded box scanner
+ */
+template <class Obj, class Prop, class BoxConvert>
+class box_scanner_partition_task
+  : public box_scanner_task_base
+{
+public:
+  typedef typename BoxConvert::box_type::coord_type coord_type;
+  typedef std::vector<std::pair<const Obj *, Prop> > container_type;
+
+  box_scanner_partition_task (const container_type *pp, std::vector<size_t> &carried, size_t from, size_t to, 
+                              coord_type enl, const BoxConvert &bc, double fill_factor, size_t scanner_thr,
+                              std::vector<std::pair<size_t, size_t> > *interactions)
+    : mp_pp (pp), m_from (from), m_to (to), m_enl (enl), m_bc (bc), 
+      m_fill_factor (fill_factor), m_scanner_thr (scanner_thr), mp_interactions (interactions)
+  {
+    m_carried.swap (carried);
+  }
+
+  virtual void perform ()
+  {
+    db::box_scanner<Obj, size_t> bs;
+    bs.set_fill_factor (m_fill_factor);
+    bs.set_scanner_threshold (m_scanner_thr);
+    bs.reserve (m_carried.size () + (m_to - m_from));
+
+    for (std::vector<size_t>::const_iterator i = m_carried.begin (); i != m_carried.end (); ++i) {
+      bs.insert ((*mp_pp) [*i].first, *i);
+    }
+    for (size_t i = m_from; i < m_to; ++i) {
+      bs.insert ((*mp_pp) [i].first, i);
+    }
+
+    box_scanner_partition_receiver<Obj> rec (m_from, mp_interactions);
+    bs.process (rec, m_enl, m_bc);
+  }
+
+private:
+  const container_type *mp_pp;
+  std::vector<size_t> m_carried;
+  size_t m_from, m_to;
+  coord_type m_enl;
+  BoxConvert m_bc;
+  double m_fill_factor;
+  size_t m_scanner_thr;
+  std::vector<std::pair<size_t, size_t> > *mp_interactions;
+};
+
 /**
  *  @brief A box scanner framework
  *
@@ -161,12 +290,35 @@ public:
    *  @brief Default ctor
    */
   box_scanner (bool report_progress = false, const std::string &progress_desc = std::string ())
-    : m_fill_factor (2), m_scanner_thr (100), 
+    : m_fill_factor (2), m_scanner_thr (100), m_threads (0),
       m_report_progress (report_progress), m_progress_desc (progress_desc)
   {
     //  .. nothing yet ..
   }
 
+  /**
+   *  @brief Sets the number of threads to use
+   *
+   *  With a value larger than 0, "process" computes the interactions on the given
+   *  number of threads. The receiver is still called from the calling thread only, so
+   *  it does not need to be thread-safe. The receiver gets the same interactions, but 
+   *  in a different order. "finish" is still called after the last interaction
+   *  of the object has been reported.
+   *  The default value is 0 (single-threaded).
+   */
+  void set_threads (int n)
+  {
+    m_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads to use
+   */
+  int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Sets the scanner threshold
    *
@@ -261,7 +413,11 @@ public:
     typedef bs_side_compare_vs_const_func<BoxConvert, Obj, Prop, box_top<Box> > below_func;
     typedef bs_side_compare_vs_const_func<BoxConvert, Obj, Prop, box_right<Box> > left_func;
 
-    if (m_pp.size () <= m_scanner_thr) {
+    if (m_threads > 0 && m_pp.size () > m_scanner_thr && m_pp.size () >= min_objects_per_partition * 2) {
+
+      process_mt (rec, enl, bc);
+
+    } else if (m_pp.size () <= m_scanner_thr) {
 
       //  below m_scanner_thr elements use the brute force approach which is faster in that case
 
@@ -385,8 +541,139 @@ private:
   container_type m_pp;
   double m_fill_factor;
   size_t m_scanner_thr;
+  int m_threads;
   bool m_report_progress;
   std::string m_progress_desc;
+
+  //  The partition size limits and the number of partitions per thread processed in one wave
+  static const size_t min_objects_per_partition = 10000;
+  static const size_t max_objects_per_partition = 256 * 1024;
+  static const size_t partitions_per_thread = 2;
+
+  /**
+   *  @brief The multi-threaded implementation of "process"
+   *
+   *  The objects are sorted by their bottom coordinate and split into partitions 
+   *  of consecutive objects. An interaction belongs to the partition of the object 
+   *  which comes later in that order. Hence a partition needs its own objects and 
+   *  those of the previous partitions reaching into it ("carried" objects).
+   *  The partitions are scanned in parallel. The interactions are reported to the 
+   *  receiver partition by partition. After a partition, the objects are finished 
+   *  which don't reach into the next partition.
+   */
+  template <class Rec, class BoxConvert>
+  void process_mt (Rec &rec, typename BoxConvert::box_type::coord_type enl, const BoxConvert &bc)
+  {
+    typedef typename BoxConvert::box_type box_type;
+    typedef typename box_type::coord_type coord_type;
+    typedef bs_side_compare_func<BoxConvert, Obj, Prop, box_bottom<Box> > bottom_side_compare_func;
+
+    std::sort (m_pp.begin (), m_pp.end (), bottom_side_compare_func (bc));
+
+    size_t n = m_pp.size ();
+    size_t part_size = n / (size_t (m_threads) * partitions_per_thread);
+    part_size = std::max (min_objects_per_partition, std::min (max_objects_per_partition, part_size));
+
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < n; i += part_size) {
+      starts.push_back (i);
+    }
+    starts.push_back (n);
+
+    size_t nparts = starts.size () - 1;
+
+    std::auto_ptr<tl::RelativeProgress> progress (0);
+    if (m_report_progress) {
+      if (m_progress_desc.empty ()) {
+        progress.reset (new tl::RelativeProgress (tl::to_string (QObject::tr ("Processing")), n, 1000));
+      } else {
+        progress.reset (new tl::RelativeProgress (m_progress_desc, n, 1000));
+      }
+    }
+
+    box_scanner_job job (m_threads);
+
+    //  the objects which may interact with objects of the next partitions
+    std::vector<size_t> active;
+
+    size_t wave = size_t (m_threads) * partitions_per_thread;
+
+    for (size_t p0 = 0; p0 < nparts; p0 += wave) {
+
+      size_t p1 = std::min (nparts, p0 + wave);
+
+      std::vector<std::vector<std::pair<size_t, size_t> > > interactions (p1 - p0);
+      std::vector<std::vector<size_t> > finished (p1 - p0);
+
+      for (size_t p = p0; p < p1; ++p) {
+
+        //  drop the objects which cannot reach into this partition
+        if (p > 0) {
+
+          coord_type y = bc (*m_pp [starts [p]].first).bottom ();
+
+          std::vector<size_t> carried;
+          carried.reserve (active.size ());
+          for (std::vector<size_t>::const_iterator a = active.begin (); a != active.end (); ++a) {
+            if (bc (*m_pp [*a].first).top () < y + 1 - enl) {
+              if (p > p0) {
+                finished [p - 1 - p0].push_back (*a);
+              } else {
+                //  finish objects of the previous wave right away: all of their interactions have been reported
+                rec.finish (m_pp [*a].first, m_pp [*a].second);
+              }
+            } else {
+              carried.push_back (*a);
+            }
+          }
+
+          active.swap (carried);
+
+        }
+
+        std::vector<size_t> carried (active);
+        job.schedule (new box_scanner_partition_task<Obj, Prop, BoxConvert> (&m_pp, carried, starts [p], starts [p + 1], enl, bc, m_fill_factor, m_scanner_thr, &interactions [p - p0]));
+
+        for (size_t i = starts [p]; i < starts [p + 1]; ++i) {
+          active.push_back (i);
+        }
+
+      }
+
+      job.start ();
+      job.wait ();
+
+      if (job.has_error ()) {
+        throw tl::Exception (tl::to_string (QObject::tr ("Errors occured during processing. First error message says:\n")) + job.error_messages ().front ());
+      }
+
+      //  report the interactions in the order of the partitions
+      for (size_t p = p0; p < p1; ++p) {
+
+        const std::vector<std::pair<size_t, size_t> > &ia = interactions [p - p0];
+        for (std::vector<std::pair<size_t, size_t> >::const_iterator i = ia.begin (); i != ia.end (); ++i) {
+          rec.add (m_pp [i->first].first, m_pp [i->first].second, m_pp [i->second].first, m_pp [i->second].second);
+        }
+
+        if (p + 1 < p1) {
+          const std::vector<size_t> &f = finished [p - p0];
+          for (std::vector<size_t>::const_iterator i = f.begin (); i != f.end (); ++i) {
+            rec.finish (m_pp [*i].first, m_pp [*i].second);
+          }
+        }
+
+        if (progress.get ()) {
+          progress->set (starts [p + 1]);
+        }
+
+      }
+
+    }
+
+    for (std::vector<size_t>::const_iterator a = active.begin (); a != active.end (); ++a) {
+      rec.finish (m_pp [*a].first, m_pp [*a].second);
+    }
+  }
 };
 
 /**
@@ -258,6 +258,79 @@ private:
   box_tree_node &operator= (const box_tree_node &d);
 };
 
+/**
+ *  @brief The packed node object
+ *
+ *  This node is used by the "unstable" box tree. The nodes of such a tree
+ *  are stored in a single, contiguous vector in depth-first order (which is
+ *  the order in which the objects are arranged too). Instead of pointers,
+ *  the nodes link to their parent and children through relative offsets
+ *  within this vector. Hence the nodes can be copied as plain values and
+ *  a query will walk through memory mostly linearly.
+ */
+
+template <class Tree>
+class box_tree_packed_node
+{
+public:
+  typedef typename Tree::point_type point_type;
+  typedef typename Tree::coord_type coord_type;
+  typedef typename Tree::box_type box_type;
+
+  box_tree_packed_node (const point_type &center, unsigned int parent_offset, unsigned int quad)
+    : m_center (center), m_parent_offset (parent_offset), m_quad (quad)
+  {
+    for (int i = 0; i < 5; ++i) {
+      m_lenq[i] = 0;
+    }
+    for (int i = 0; i < 4; ++i) {
+      m_child_offsets[i] = 0;
+    }
+  }
+
+  const box_tree_packed_node *child (int i) const
+  {
+    return m_child_offsets [i] ? this + m_child_offsets [i] : 0;
+  }
+
+  void set_child_offset (int i, unsigned int offset)
+  {
+    m_child_offsets [i] = offset;
+  }
+
+  void lenq (int i, size_t l)
+  {
+    m_lenq[i + 1] = l;
+  }
+
+  size_t lenq (int i) const
+  {
+    return m_lenq[i + 1];
+  }
+
+  const box_tree_packed_node *parent () const
+  {
+    return m_parent_offset ? this - m_parent_offset : 0;
+  }
+
+  int quad () const
+  {
+    return int (m_quad);
+  }
+
+  const point_type &center () const
+  {
+    return m_center;
+  }
+
+private:
+  size_t m_lenq [5];
+  point_type m_center;
+  unsigned int m_parent_offset;
+  unsigned int m_child_offsets [4];
+  unsigned int m_quad;
+};
+
 /**
  *  @brief The flat iterator class
  *
@@ -1352,7 +1425,7 @@ public:
   typedef typename Tree::const_iterator const_iterator;
   typedef typename Tree::box_tree_picker_type value_picker_type;
   typedef typename Tree::size_type size_type;
-  typedef db::box_tree_node<Tree> box_tree_node;
+  typedef typename Tree::box_tree_node box_tree_node;
 
   unstable_box_tree_it ()
     : mp_tree (0), m_picker (), m_compare () 
@@ -1501,7 +1574,7 @@ public:
   }
 
 private:
-  box_tree_node *mp_node;
+  const box_tree_node *mp_node;
   size_t m_index;
   size_t m_offset;
   int m_quad;
@@ -1543,7 +1616,7 @@ private:
   //  one level up. 
   bool up () 
   {
-    box_tree_node *p = mp_node->parent ();
+    const box_tree_node *p = mp_node->parent ();
     if (p) {
 
       //  move the position to the beginning of the child node
@@ -1579,7 +1652,7 @@ private:
   //  returns true if this is possible
   bool down ()
   {
-    box_tree_node *c = mp_node->child (m_quad);
+    const box_tree_node *c = mp_node->child (m_quad);
     if (c) {
 
       mp_node = c;
@@ -1650,7 +1723,8 @@ public:
   typedef typename obj_vector_type::const_iterator const_iterator;
   typedef typename obj_vector_type::iterator iterator;
   typedef unstable_box_tree<box_type, object_type, box_conv_type, min_bin, min_quads> box_tree_type;
-  typedef db::box_tree_node<box_tree_type> box_tree_node;
+  typedef db::box_tree_packed_node<box_tree_type> box_tree_node;
+  typedef std::vector<box_tree_node> node_vector_type;
   typedef box_tree_sel<box_type, object_type, box_conv_type, db::boxes_overlap<box_type> > box_tree_sel_overlap_type;
   typedef box_tree_sel<box_type, object_type, box_conv_type, db::boxes_touch<box_type> > box_tree_sel_touch_type;
   typedef unstable_box_tree_flat_it<box_tree_type> flat_iterator;
@@ -1662,7 +1736,6 @@ public:
    *  @brief Creates a empty box tree object 
    */
   unstable_box_tree ()
-    : mp_root (0)
   {
     // .. nothing else ..
   }
@@ -1671,7 +1744,7 @@ public:
    *  @brief Copy constructor
    */
   unstable_box_tree (const unstable_box_tree &b)
-    : m_objects (b.m_objects), mp_root (b.mp_root ? b.mp_root->clone () : 0)
+    : m_objects (b.m_objects), m_nodes (b.m_nodes)
   {
     // .. nothing else ..
   }
@@ -1681,25 +1754,13 @@ public:
    */
   unstable_box_tree &operator= (const unstable_box_tree &b)
   {
-    clear ();
-    m_objects = b.m_objects;
-    if (b.mp_root) {
-      mp_root = b.mp_root->clone ();
+    if (&b != this) {
+      m_objects = b.m_objects;
+      m_nodes = b.m_nodes;
     }
     return *this;
   }
 
-  /**
-   *  @brief The destructor
-   */
-  ~unstable_box_tree ()
-  {
-    if (mp_root) {
-      delete mp_root;
-    }
-    mp_root = 0;
-  }
-
   /**
    *  @brief Insert a new object into the box tree
    *
@@ -1885,10 +1946,7 @@ public:
   void clear ()
   {
     m_objects.clear ();
-    if (mp_root) {
-      delete mp_root;
-    }
-    mp_root = 0;
+    m_nodes.clear ();
   }
 
   /**
@@ -2028,15 +2086,25 @@ public:
    *
    *  This is mainly used by the iterator implementation
    */
-  box_tree_node *root () const
+  const box_tree_node *root () const
   {
-    return mp_root;
+    return m_nodes.empty () ? 0 : &m_nodes.front ();
+  }
+
+  /**
+   *  @brief Access to the node vector
+   *
+   *  The nodes are stored in depth-first order, the first node being the root node.
+   */
+  const node_vector_type &nodes () const
+  {
+    return m_nodes;
   }
 
 private:
   /// The basic object and element vector
   obj_vector_type m_objects;
-  box_tree_node *mp_root;
+  node_vector_type m_nodes;
 
   /// Sort implementation for simple bboxes - no caching
   void sort (const BoxConv &conv, const db::simple_bbox_tag &/*complexity*/)
@@ -2047,10 +2115,7 @@ private:
 
     box_tree_picker_type picker (conv);
 
-    if (mp_root) {
-      delete mp_root;
-    }
-    mp_root = 0;
+    m_nodes.clear ();
 
     box_type bbox;
     for (typename obj_vector_type::const_iterator o = m_objects.begin (); o != m_objects.end (); ++o) {
@@ -2061,6 +2126,7 @@ private:
     }
 
     tree_sort (0, m_objects.begin (), m_objects.end (), picker, bbox, 0);
+    compact_nodes ();
   }
 
   /// Sort implementation for complex bboxes - with caching
@@ -2072,16 +2138,22 @@ private:
 
     box_tree_cached_picker<object_type, box_type, box_conv_type, obj_vector_type> picker (conv, m_objects.begin (), m_objects.end ());
 
-    if (mp_root) {
-      delete mp_root;
-    }
-    mp_root = 0;
+    m_nodes.clear ();
 
     tree_sort (0, m_objects.begin (), m_objects.end (), picker, picker.bbox (), 0);
+    compact_nodes ();
+  }
+
+  /// Releases the excess capacity of the node vector once the tree has been built
+  void compact_nodes ()
+  {
+    if (m_nodes.capacity () > m_nodes.size ()) {
+      node_vector_type (m_nodes).swap (m_nodes);
+    }
   }
 
   template <class CoordPicker>
-  void tree_sort (box_tree_node *parent, obj_iterator from, obj_iterator to, CoordPicker &picker, const box_type &bbox, int quad)
+  void tree_sort (size_t parent, obj_iterator from, obj_iterator to, CoordPicker &picker, const box_type &bbox, int quad)
   {
     size_t ntot = size_t (to - from);
     if (ntot <= min_bin || (bbox.width () < 2 && bbox.height () < 2)) {
@@ -2143,14 +2215,18 @@ private:
     //  is it worth to split into sub-quads?
     if (nn >= min_quads) {
 
-      //  create a new node representing this tree
-      box_tree_node *node = new box_tree_node (parent, center, quad);
-      if (parent == 0) {
-        mp_root = node;
+      //  create a new node representing this tree: the nodes are created in depth-first
+      //  order and are referred to by index as the node vector may get reallocated.
+      size_t node = m_nodes.size ();
+      if (node == 0) {
+        m_nodes.push_back (box_tree_node (center, 0, 0));
+      } else {
+        m_nodes.push_back (box_tree_node (center, (unsigned int) (node - parent), (unsigned int) quad));
+        m_nodes [parent].set_child_offset (quad, (unsigned int) (node - parent));
       }
 
       //  tell the parent the length of the "overall" bin
-      node->lenq (-1, nx);
+      m_nodes [node].lenq (-1, nx);
 
       //  yes: create sub-quads
       box_type qboxes [4];
@@ -2160,7 +2236,7 @@ private:
       qboxes [3] = box_type (center.x (), bbox.bottom (), bbox.right (), center.y ());
       for (unsigned int q = 0; q < 4; ++q) {
         if (n[q] > 0) {
-          node->lenq (q, n[q]);
+          m_nodes [node].lenq (q, n[q]);
           tree_sort (node, qloc[q], qloc[q + 1], picker, qboxes [q], int (q));
         }
       }
@@ -2175,17 +2251,16 @@ template <class Box, class Obj, class BoxConv>
 size_t mem_used (const db::unstable_box_tree<Box, Obj, BoxConv> &bt)
 {
   return mem_used (bt.objects ()) +
-         sizeof (void *) + 
-         (bt.root () ? bt.root ()->mem_used () : 0);
+         sizeof (bt.nodes ()) +
+         bt.nodes ().capacity () * sizeof (typename db::unstable_box_tree<Box, Obj, BoxConv>::box_tree_node);
 }
 
 template <class Box, class Obj, class BoxConv>
 size_t mem_reqd (const db::unstable_box_tree<Box, Obj, BoxConv> &bt)
 {
   return mem_reqd (bt.objects ()) +
-         sizeof (box_tree_node<db::box_tree<Box, Obj, BoxConv> > *) +
-         sizeof (void *) + 
-         (bt.root () ? bt.root ()->mem_used () : 0);
+         sizeof (bt.nodes ()) +
+         bt.nodes ().size () * sizeof (typename db::unstable_box_tree<Box, Obj, BoxConv>::box_tree_node);
 }
 
 
@@ -387,6 +387,8 @@ Cell::prop_id (db::properties_id_type id)
       manager ()->queue (this, new SetCellPropId (m_prop_id, id));
     }
     m_prop_id = id;
+    //  the cell's properties are part of the cell hashes
+    mp_layout->invalidate_cell_hashes ();
   }
 }
 
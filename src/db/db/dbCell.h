@@ -55,6 +55,7 @@ template <class Coord> class generic_repository;
 class Layout;
 class Library;
 class ImportLayerMapping;
+class LayoutUpdateTask;
 
 /**
  *  @brief The cell object
@@ -95,6 +96,7 @@ public:
 
   friend class db::Layout;
   friend class db::Library;
+  friend class db::LayoutUpdateTask;
   friend class db::cell_list<Cell>;
   friend class db::cell_list_iterator<Cell>;
   friend class db::cell_list_const_iterator<Cell>;
@@ -44,7 +44,8 @@ public:
   CommonReaderOptions ()
     : create_other_layers (true),
       enable_text_objects (true),
-      enable_properties (true)
+      enable_properties (true),
+      update_threads (0)
   {
     //  .. nothing yet ..
   }
@@ -83,6 +84,16 @@ public:
    */
   bool enable_properties;
 
+  /**
+   *  @brief The number of threads used for updating the layout after reading
+   *
+   *  If this value is larger than 0, the reader configures the target layout to 
+   *  distribute the bounding box computation and the sorting of the shape and 
+   *  instance trees over the given number of threads (see db::Layout::set_update_threads).
+   *  The default is 0 which leaves the layout's setting unchanged.
+   */
+  int update_threads;
+
   /** 
    *  @brief Implementation of FormatSpecificReaderOptions
    */
@@ -0,0 +1,1015 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbDeepRegion.h"
+#include "dbEdgeProcessor.h"
+#include "dbClip.h"
+
+#include "tlException.h"
+#include "tlInternational.h"
+
+#include <limits>
+#include <algorithm>
+
+namespace db
+{
+
+// -------------------------------------------------------------------------------------------------------------
+//  DeepShapeStore implementation
+
+DeepShapeStore::DeepShapeStore ()
+  : m_top_cell (0), mp_source_layout (0), m_source_top_cell (0), m_flat (true)
+{
+  m_top_cell = m_layout.add_cell ();
+  compute_instance_counts ();
+}
+
+DeepShapeStore::DeepShapeStore (const db::Layout &layout, db::cell_index_type top_cell)
+  : m_top_cell (0), mp_source_layout (&layout), m_source_top_cell (top_cell), m_flat (false)
+{
+  m_layout.dbu (layout.dbu ());
+
+  std::set<db::cell_index_type> called;
+  layout.cell (top_cell).collect_called_cells (called);
+  called.insert (top_cell);
+
+  //  complex instances would require transformations involving rounding: in that case we
+  //  keep the shapes flat.
+  for (std::set<db::cell_index_type>::const_iterator c = called.begin (); c != called.end () && ! m_flat; ++c) {
+    for (db::Cell::const_iterator i = layout.cell (*c).begin (); ! i.at_end (); ++i) {
+      if (i->is_complex ()) {
+        m_flat = true;
+        break;
+      }
+    }
+  }
+
+  if (m_flat) {
+
+    m_top_cell = m_layout.add_cell (layout.cell_name (top_cell));
+    m_source_cells.insert (std::make_pair (m_top_cell, top_cell));
+
+  } else {
+
+    std::map<db::cell_index_type, db::cell_index_type> cell_map;
+    for (std::set<db::cell_index_type>::const_iterator c = called.begin (); c != called.end (); ++c) {
+      db::cell_index_type ci = m_layout.add_cell (layout.cell_name (*c));
+      cell_map.insert (std::make_pair (*c, ci));
+      m_source_cells.insert (std::make_pair (ci, *c));
+    }
+
+    m_top_cell = cell_map [top_cell];
+
+    for (std::set<db::cell_index_type>::const_iterator c = called.begin (); c != called.end (); ++c) {
+      db::Cell &target = m_layout.cell (cell_map [*c]);
+      for (db::Cell::const_iterator i = layout.cell (*c).begin (); ! i.at_end (); ++i) {
+        db::CellInstArray inst (i->cell_inst ());
+        inst.object () = db::CellInst (cell_map [i->cell_index ()]);
+        target.insert (inst);
+      }
+    }
+
+  }
+
+  compute_instance_counts ();
+}
+
+void
+DeepShapeStore::compute_instance_counts ()
+{
+  m_layout.update ();
+
+  m_instance_counts.clear ();
+  m_instance_counts.insert (std::make_pair (m_top_cell, size_t (1)));
+
+  for (db::Layout::top_down_const_iterator c = m_layout.begin_top_down (); c != m_layout.end_top_down (); ++c) {
+
+    std::map<db::cell_index_type, size_t>::const_iterator n = m_instance_counts.find (*c);
+    if (n == m_instance_counts.end ()) {
+      continue;
+    }
+
+    size_t count = n->second;
+    for (db::Cell::const_iterator i = m_layout.cell (*c).begin (); ! i.at_end (); ++i) {
+      m_instance_counts [i->cell_index ()] += count * i->cell_inst ().size ();
+    }
+
+  }
+}
+
+size_t
+DeepShapeStore::instance_count (db::cell_index_type ci) const
+{
+  std::map<db::cell_index_type, size_t>::const_iterator n = m_instance_counts.find (ci);
+  return n != m_instance_counts.end () ? n->second : 0;
+}
+
+db::cell_index_type
+DeepShapeStore::source_cell (db::cell_index_type ci) const
+{
+  std::map<db::cell_index_type, db::cell_index_type>::const_iterator c = m_source_cells.find (ci);
+  return c != m_source_cells.end () ? c->second : m_source_top_cell;
+}
+
+bool
+DeepShapeStore::is_hierarchical_source (const db::RecursiveShapeIterator &si) const
+{
+  if (m_flat || ! mp_source_layout || si.layout () != mp_source_layout || ! si.top_cell ()) {
+    return false;
+  }
+
+  //  NOTE: the name check protects against a layout which has been recreated at the same address
+  return si.top_cell ()->cell_index () == m_source_top_cell
+      && std::string (m_layout.cell_name (m_top_cell)) == si.layout ()->cell_name (m_source_top_cell)
+      && si.region () == db::Box::world ()
+      && ! si.has_complex_region ()
+      && ! si.has_cell_selection ()
+      && si.min_depth () == 0
+      && si.max_depth () == std::numeric_limits<int>::max ();
+}
+
+unsigned int
+DeepShapeStore::import_layer (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans)
+{
+  unsigned int layer = new_layer ();
+
+  if (trans.is_unity () && is_hierarchical_source (si)) {
+
+    db::RecursiveShapeIterator s (si);
+    std::vector<unsigned int> layers;
+    if (s.multiple_layers ()) {
+      layers = s.layers ();
+    } else {
+      layers.push_back (s.layer ());
+    }
+
+    for (std::map<db::cell_index_type, db::cell_index_type>::const_iterator c = m_source_cells.begin (); c != m_source_cells.end (); ++c) {
+
+      const db::Cell &source = mp_source_layout->cell (c->second);
+      db::Shapes &shapes = m_layout.cell (c->first).shapes (layer);
+
+      for (std::vector<unsigned int>::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+        if (mp_source_layout->is_valid_layer (*l)) {
+          for (db::ShapeIterator sh = source.shapes (*l).begin (db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes); ! sh.at_end (); ++sh) {
+            db::Polygon poly;
+            sh->polygon (poly);
+            shapes.insert (poly);
+          }
+        }
+      }
+
+    }
+
+  } else {
+
+    db::Shapes &shapes = m_layout.cell (m_top_cell).shapes (layer);
+
+    db::RecursiveShapeIterator s (si);
+    s.shape_flags (db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes);
+    for ( ; ! s.at_end (); ++s) {
+      db::Polygon poly;
+      s->polygon (poly);
+      shapes.insert (poly.transformed (trans * s.trans ()));
+    }
+
+  }
+
+  return layer;
+}
+
+unsigned int
+DeepShapeStore::new_layer ()
+{
+  return m_layout.insert_layer ();
+}
+
+void
+DeepShapeStore::release_layer (unsigned int layer)
+{
+  if (m_layout.is_valid_layer (layer)) {
+    m_layout.delete_layer (layer);
+  }
+}
+
+// -------------------------------------------------------------------------------------------------------------
+//  Hierarchical boolean implementation
+
+namespace
+{
+
+/**
+ *  @brief Implements the hierarchical boolean between two layers of a deep shape store
+ *
+ *  The algorithm works in two passes: in the first (top-down) pass, the contexts of every
+ *  cell are determined. A context is the set of polygons of the second operand which
+ *  overlap the first operand's bounding box of a cell instance. This set is taken in the
+ *  cell's coordinate system and normalized, so identical surroundings are detected as
+ *  identical contexts.
+ *  In the second (bottom-up) pass, the boolean is computed for every cell and context.
+ *  The part of the result which is common to all contexts is stored inside the cell.
+ *  The context-specific parts are handed over to the parent cells.
+ */
+class HierarchicalBoolean
+{
+public:
+  typedef std::vector<db::Polygon> polygon_list;
+  typedef std::map<polygon_list, size_t> context_map;
+
+  HierarchicalBoolean (db::Layout &layout, db::cell_index_type top_cell, unsigned int la, unsigned int lb, unsigned int lr, int mode)
+    : m_layout (layout), m_top_cell (top_cell), m_la (la), m_lb (lb), m_lr (lr), m_mode (mode)
+  {
+    //  .. nothing yet ..
+  }
+
+  void run ()
+  {
+    m_layout.update ();
+
+    std::vector<db::cell_index_type> cells (m_layout.begin_top_down (), m_layout.end_top_down ());
+
+    m_contexts.clear ();
+    m_specific.clear ();
+    m_member_contexts.clear ();
+    m_contexts [m_top_cell].insert (std::make_pair (polygon_list (), size_t (0)));
+
+    for (std::vector<db::cell_index_type>::const_iterator c = cells.begin (); c != cells.end (); ++c) {
+      compute_child_contexts (*c);
+    }
+
+    for (std::vector<db::cell_index_type>::const_reverse_iterator c = cells.rbegin (); c != cells.rend (); ++c) {
+      compute_results (*c);
+    }
+
+    m_contexts.clear ();
+    m_specific.clear ();
+    m_member_contexts.clear ();
+  }
+
+private:
+  /**
+   *  @brief The child contexts of the members of one instance within one parent context
+   *
+   *  For regular arrays, "special" flags the members which have an individual context. 
+   *  All other members are interior members sharing the "interior" context. The context 
+   *  indexes of the other members are listed in "members" in the order of iteration.
+   *  For instances which are not regular arrays, "special" is empty and all members are listed.
+   */
+  struct MemberContexts
+  {
+    MemberContexts ()
+      : na (0), interior (0)
+    { }
+
+    bool is_special (const db::CellInstArray::iterator &a) const
+    {
+      return special.empty () || special [size_t (a.index_a ()) + na * size_t (a.index_b ())];
+    }
+
+    std::vector<bool> special;
+    size_t na;
+    size_t interior;
+    std::vector<size_t> members;
+  };
+
+  db::Layout &m_layout;
+  db::cell_index_type m_top_cell;
+  unsigned int m_la, m_lb, m_lr;
+  int m_mode;
+  std::map<db::cell_index_type, context_map> m_contexts;
+  std::map<db::cell_index_type, std::vector<polygon_list> > m_specific;
+  //  per parent cell, parent context index and instance: the contexts of the members
+  std::map<db::cell_index_type, std::vector<std::vector<MemberContexts> > > m_member_contexts;
+  db::EdgeProcessor m_ep;
+
+  /**
+   *  @brief Collects the polygons of the second operand inside the given cell (including the context) clipped at the given box
+   */
+  void collect_intruders (db::cell_index_type ci, const db::Box &box, const polygon_list &context, polygon_list &intruders)
+  {
+    for (polygon_list::const_iterator p = context.begin (); p != context.end (); ++p) {
+      if (p->box ().inside (box)) {
+        intruders.push_back (*p);
+      } else if (p->box ().overlaps (box)) {
+        db::clip_poly (*p, box, intruders, false);
+      }
+    }
+
+    db::RecursiveShapeIterator si (m_layout, m_layout.cell (ci), m_lb, box, true);
+    for ( ; ! si.at_end (); ++si) {
+      db::Polygon poly;
+      si->polygon (poly);
+      poly.transform (si.trans ());
+      if (poly.box ().inside (box)) {
+        intruders.push_back (poly);
+      } else {
+        db::clip_poly (poly, box, intruders, false);
+      }
+    }
+  }
+
+  /**
+   *  @brief Computes the normalized context of a child cell instance with transformation t inside the given parent context
+   */
+  void child_context (db::cell_index_type parent, const polygon_list &parent_context, const db::ICplxTrans &t, db::cell_index_type child, polygon_list &context)
+  {
+    context.clear ();
+
+    db::Box box = m_layout.cell (child).bbox (m_la).transformed (t);
+
+    polygon_list intruders;
+    collect_intruders (parent, box, parent_context, intruders);
+    if (intruders.empty ()) {
+      return;
+    }
+
+    db::ICplxTrans ti = t.inverted ();
+    for (polygon_list::iterator p = intruders.begin (); p != intruders.end (); ++p) {
+      p->transform (ti);
+    }
+
+    //  merging normalizes the context, so equivalent contexts become identical
+    m_ep.merge (intruders, context, 0, true, false);
+    std::sort (context.begin (), context.end ());
+  }
+
+  /**
+   *  @brief Marks the members of a regular array whose first operand's bounding box touches the given box as special
+   */
+  void mark_special (const db::CellInstArray &array, size_t na, const db::Box &box, std::vector<bool> &special)
+  {
+    db::box_convert<db::CellInst> bc (m_layout, m_la);
+    for (db::CellInstArray::iterator a = array.begin_touching (box, bc); ! a.at_end (); ++a) {
+      special [size_t (a.index_a ()) + na * size_t (a.index_b ())] = true;
+    }
+  }
+
+  /**
+   *  @brief Determines the members of a regular array which may have an individual context
+   *
+   *  Returns false if the instance is not a regular array. Otherwise, "special" receives the 
+   *  flags for the members which are close to the border of the array (so their array neighborhood
+   *  is not complete) or which interact with second operand shapes not originating from the array.
+   *  All other members share the same context within a given parent context. The parent context
+   *  itself is not considered here.
+   */
+  bool special_members (const db::Cell &cell, const db::Instance &inst, size_t &na, std::vector<bool> &special)
+  {
+    const db::CellInstArray &array = inst.cell_inst ();
+
+    db::Vector va, vb;
+    unsigned long amax = 0, bmax = 0;
+    if (! array.is_regular_array (va, vb, amax, bmax) || amax * bmax <= 1) {
+      return false;
+    }
+
+    na = amax;
+    special.clear ();
+    special.resize (size_t (amax) * size_t (bmax), false);
+
+    db::box_convert<db::CellInst> bc_la (m_layout, m_la);
+    db::box_convert<db::CellInst> bc_lb (m_layout, m_lb);
+
+    //  determine the reach of the array neighborhood from the center member
+    unsigned long ca = amax / 2, cb = bmax / 2;
+    db::Vector dc (va.x () * db::Coord (ca) + vb.x () * db::Coord (cb), va.y () * db::Coord (ca) + vb.y () * db::Coord (cb));
+    db::Box center_box = bc_la (array.object ()).transformed (array.complex_trans (db::Trans (dc) * array.front ()));
+
+    unsigned long ka = 0, kb = 0;
+    for (db::CellInstArray::iterator a = array.begin_touching (center_box, bc_lb); ! a.at_end (); ++a) {
+      ka = std::max (ka, (unsigned long) std::abs (a.index_a () - long (ca)));
+      kb = std::max (kb, (unsigned long) std::abs (a.index_b () - long (cb)));
+    }
+
+    for (unsigned long ib = 0; ib < bmax; ++ib) {
+      for (unsigned long ia = 0; ia < amax; ++ia) {
+        if (ia < ka || ia + ka >= amax || ib < kb || ib + kb >= bmax) {
+          special [ia + na * ib] = true;
+        }
+      }
+    }
+
+    //  the shapes of the parent cell and other instances
+    db::Box array_box = array.bbox (bc_la);
+
+    for (db::ShapeIterator s = cell.shapes (m_lb).begin_touching (array_box, db::ShapeIterator::All); ! s.at_end (); ++s) {
+      mark_special (array, na, s->bbox (), special);
+    }
+
+    for (db::Cell::touching_iterator j = cell.begin_touching (array_box); ! j.at_end (); ++j) {
+      if (*j == inst) {
+        continue;
+      }
+      const db::CellInstArray &other = j->cell_inst ();
+      db::Box other_box = bc_lb (other.object ());
+      if (! other_box.empty ()) {
+        for (db::CellInstArray::iterator a = other.begin_touching (array_box, bc_lb); ! a.at_end (); ++a) {
+          mark_special (array, na, other_box.transformed (other.complex_trans (*a)), special);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   *  @brief Registers a child context and returns its index
+   */
+  static size_t register_context (context_map &contexts, const polygon_list &cc)
+  {
+    context_map::const_iterator c = contexts.find (cc);
+    if (c == contexts.end ()) {
+      size_t index = contexts.size ();
+      contexts.insert (std::make_pair (cc, index));
+      return index;
+    } else {
+      return c->second;
+    }
+  }
+
+  void compute_child_contexts (db::cell_index_type ci)
+  {
+    std::map<db::cell_index_type, context_map>::const_iterator cm = m_contexts.find (ci);
+    if (cm == m_contexts.end ()) {
+      return;
+    }
+
+    const context_map &contexts = cm->second;
+    const db::Cell &cell = m_layout.cell (ci);
+
+    std::vector<std::vector<MemberContexts> > &member_contexts = m_member_contexts [ci];
+    member_contexts.resize (contexts.size ());
+
+    for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+
+      for (std::vector<std::vector<MemberContexts> >::iterator mc = member_contexts.begin (); mc != member_contexts.end (); ++mc) {
+        mc->push_back (MemberContexts ());
+      }
+
+      db::cell_index_type child = i->cell_index ();
+      if (m_layout.cell (child).bbox (m_la).empty ()) {
+        continue;
+      }
+
+      context_map &child_contexts = m_contexts [child];
+
+      //  members of regular arrays are classified, so the interior members need to be computed once only
+      size_t na = 0;
+      std::vector<bool> special;
+      bool is_array = special_members (cell, *i, na, special);
+
+      polygon_list cc;
+      for (context_map::const_iterator ctx = contexts.begin (); ctx != contexts.end (); ++ctx) {
+
+        MemberContexts &mc = member_contexts [ctx->second].back ();
+        bool has_interior = false;
+
+        if (is_array) {
+          mc.na = na;
+          mc.special = special;
+          for (polygon_list::const_iterator p = ctx->first.begin (); p != ctx->first.end (); ++p) {
+            mark_special (i->cell_inst (), na, p->box (), mc.special);
+          }
+        }
+
+        for (db::CellInstArray::iterator a = i->cell_inst ().begin (); ! a.at_end (); ++a) {
+
+          bool is_special = mc.is_special (a);
+          if (! is_special && has_interior) {
+            continue;
+          }
+
+          db::ICplxTrans t = i->cell_inst ().complex_trans (*a);
+          child_context (ci, ctx->first, t, child, cc);
+          size_t index = register_context (child_contexts, cc);
+
+          if (is_special) {
+            mc.members.push_back (index);
+          } else {
+            mc.interior = index;
+            has_interior = true;
+          }
+
+        }
+
+      }
+
+    }
+  }
+
+  void compute_results (db::cell_index_type ci)
+  {
+    std::map<db::cell_index_type, context_map>::const_iterator cm = m_contexts.find (ci);
+    if (cm == m_contexts.end ()) {
+      return;
+    }
+
+    const context_map &contexts = cm->second;
+    const db::Cell &cell = m_layout.cell (ci);
+    const std::vector<std::vector<MemberContexts> > &member_contexts = m_member_contexts [ci];
+
+    polygon_list subjects;
+    for (db::ShapeIterator s = cell.shapes (m_la).begin (db::ShapeIterator::All); ! s.at_end (); ++s) {
+      subjects.push_back (db::Polygon ());
+      s->polygon (subjects.back ());
+    }
+
+    //  the intruders from the cell itself and from the child cells are common for all contexts
+    db::Box subject_box = cell.shapes (m_la).bbox ();
+    polygon_list local_intruders;
+    if (! subjects.empty ()) {
+      collect_intruders (ci, subject_box, polygon_list (), local_intruders);
+    }
+
+    std::vector<polygon_list> results (contexts.size ());
+
+    for (context_map::const_iterator ctx = contexts.begin (); ctx != contexts.end (); ++ctx) {
+
+      polygon_list &res = results [ctx->second];
+
+      if (! subjects.empty ()) {
+
+        polygon_list intruders (local_intruders);
+        for (polygon_list::const_iterator p = ctx->first.begin (); p != ctx->first.end (); ++p) {
+          if (p->box ().overlaps (subject_box)) {
+            intruders.push_back (*p);
+          }
+        }
+
+        if (! intruders.empty ()) {
+          m_ep.boolean (subjects, intruders, res, m_mode, true, false);
+        } else if (m_mode == db::BooleanOp::ANotB) {
+          res = subjects;
+        }
+
+      }
+
+      //  add the context-specific results of the child cells (using the child contexts from the first pass)
+      size_t n = 0;
+      for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i, ++n) {
+
+        db::cell_index_type child = i->cell_index ();
+        std::map<db::cell_index_type, std::vector<polygon_list> >::const_iterator sp = m_specific.find (child);
+        if (sp == m_specific.end ()) {
+          continue;
+        }
+
+        tl_assert (ctx->second < member_contexts.size () && n < member_contexts [ctx->second].size ());
+        const MemberContexts &mc = member_contexts [ctx->second][n];
+
+        std::vector<size_t>::const_iterator m = mc.members.begin ();
+        for (db::CellInstArray::iterator a = i->cell_inst ().begin (); ! a.at_end (); ++a) {
+
+          size_t index = mc.interior;
+          if (mc.is_special (a)) {
+            tl_assert (m != mc.members.end ());
+            index = *m++;
+          }
+
+          const polygon_list &specific = sp->second [index];
+          if (! specific.empty ()) {
+            db::ICplxTrans t = i->cell_inst ().complex_trans (*a);
+            for (polygon_list::const_iterator p = specific.begin (); p != specific.end (); ++p) {
+              res.push_back (p->transformed (t));
+            }
+          }
+
+        }
+
+      }
+
+    }
+
+    db::Shapes &out = m_layout.cell (ci).shapes (m_lr);
+
+    bool all_same = true;
+    for (size_t i = 1; i < results.size () && all_same; ++i) {
+      all_same = (results [i] == results [0]);
+    }
+
+    if (all_same) {
+
+      if (! results.empty ()) {
+        insert (out, results [0]);
+      }
+
+    } else {
+
+      polygon_list common (results [0]);
+      for (size_t i = 1; i < results.size () && ! common.empty (); ++i) {
+        polygon_list tmp;
+        m_ep.boolean (common, results [i], tmp, db::BooleanOp::And, true, false);
+        common.swap (tmp);
+      }
+
+      insert (out, common);
+
+      std::vector<polygon_list> &specific = m_specific [ci];
+      specific.resize (results.size ());
+      for (size_t i = 0; i < results.size (); ++i) {
+        if (common.empty ()) {
+          specific [i].swap (results [i]);
+        } else {
+          m_ep.boolean (results [i], common, specific [i], db::BooleanOp::ANotB, true, false);
+        }
+      }
+
+    }
+  }
+
+  static void insert (db::Shapes &shapes, const polygon_list &polygons)
+  {
+    for (polygon_list::const_iterator p = polygons.begin (); p != polygons.end (); ++p) {
+      shapes.insert (*p);
+    }
+  }
+};
+
+}
+
+// -------------------------------------------------------------------------------------------------------------
+//  DeepRegion implementation
+
+DeepRegion::DeepRegion ()
+  : mp_store (), m_layer (0)
+{
+  //  .. nothing yet ..
+}
+
+DeepRegion::DeepRegion (DeepShapeStore &store, const db::RecursiveShapeIterator &si)
+  : mp_store (&store), m_layer (0)
+{
+  m_layer = store.import_layer (si, db::ICplxTrans ());
+}
+
+DeepRegion::DeepRegion (DeepShapeStore &store, const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans)
+  : mp_store (&store), m_layer (0)
+{
+  m_layer = store.import_layer (si, trans);
+}
+
+DeepRegion::DeepRegion (DeepShapeStore *store, unsigned int layer)
+  : mp_store (store), m_layer (layer)
+{
+  //  .. nothing yet ..
+}
+
+DeepRegion::DeepRegion (const DeepRegion &other)
+  : mp_store (other.mp_store), m_layer (0)
+{
+  if (store ()) {
+    m_layer = store ()->new_layer ();
+    store ()->layout ().copy_layer (other.m_layer, m_layer);
+  }
+}
+
+DeepRegion &
+DeepRegion::operator= (const DeepRegion &other)
+{
+  if (this != &other) {
+    DeepRegion tmp (other);
+    swap (tmp);
+  }
+  return *this;
+}
+
+DeepRegion::~DeepRegion ()
+{
+  release ();
+}
+
+void
+DeepRegion::release ()
+{
+  if (store ()) {
+    store ()->release_layer (m_layer);
+  }
+  mp_store.reset (0);
+  m_layer = 0;
+}
+
+void
+DeepRegion::swap (DeepRegion &other)
+{
+  std::swap (m_layer, other.m_layer);
+  DeepShapeStore *s = other.store ();
+  other.mp_store.reset (store ());
+  mp_store.reset (s);
+}
+
+DeepShapeStore *
+DeepRegion::common_store (const DeepRegion &other) const
+{
+  if (store () && other.store () && store () != other.store ()) {
+    throw tl::Exception (tl::to_string (QObject::tr ("Deep regions must belong to the same deep shape store for this operation")));
+  }
+  return store () ? store () : other.store ();
+}
+
+bool
+DeepRegion::empty () const
+{
+  if (! store ()) {
+    return true;
+  }
+
+  const db::Layout &layout = store ()->layout ();
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+    if (! c->shapes (m_layer).empty ()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+db::Box
+DeepRegion::bbox () const
+{
+  if (! store ()) {
+    return db::Box ();
+  }
+
+  db::Layout &layout = store ()->layout ();
+  layout.update ();
+  return layout.cell (store ()->top_cell ()).bbox (m_layer);
+}
+
+size_t
+DeepRegion::size () const
+{
+  if (! store ()) {
+    return 0;
+  }
+
+  size_t n = 0;
+  const db::Layout &layout = store ()->layout ();
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+    n += c->shapes (m_layer).size () * store ()->instance_count (c->cell_index ());
+  }
+
+  return n;
+}
+
+size_t
+DeepRegion::hier_size () const
+{
+  if (! store ()) {
+    return 0;
+  }
+
+  size_t n = 0;
+  const db::Layout &layout = store ()->layout ();
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+    n += c->shapes (m_layer).size ();
+  }
+
+  return n;
+}
+
+DeepRegion
+DeepRegion::operator& (const DeepRegion &other) const
+{
+  DeepShapeStore *s = common_store (other);
+  if (! s) {
+    return DeepRegion ();
+  }
+
+  DeepRegion res (s, s->new_layer ());
+  if (store () && other.store ()) {
+    HierarchicalBoolean op (s->layout (), s->top_cell (), m_layer, other.m_layer, res.m_layer, db::BooleanOp::And);
+    op.run ();
+  }
+
+  return res;
+}
+
+DeepRegion
+DeepRegion::operator- (const DeepRegion &other) const
+{
+  DeepShapeStore *s = common_store (other);
+  if (! store ()) {
+    return DeepRegion ();
+  } else if (! other.store ()) {
+    return *this;
+  }
+
+  DeepRegion res (s, s->new_layer ());
+  HierarchicalBoolean op (s->layout (), s->top_cell (), m_layer, other.m_layer, res.m_layer, db::BooleanOp::ANotB);
+  op.run ();
+
+  return res;
+}
+
+DeepRegion
+DeepRegion::operator^ (const DeepRegion &other) const
+{
+  DeepShapeStore *s = common_store (other);
+  if (! store ()) {
+    return other;
+  } else if (! other.store ()) {
+    return *this;
+  }
+
+  //  A XOR B is computed as (A NOT B) + (B NOT A)
+  DeepRegion res (s, s->new_layer ());
+  HierarchicalBoolean op1 (s->layout (), s->top_cell (), m_layer, other.m_layer, res.m_layer, db::BooleanOp::ANotB);
+  op1.run ();
+  HierarchicalBoolean op2 (s->layout (), s->top_cell (), other.m_layer, m_layer, res.m_layer, db::BooleanOp::ANotB);
+  op2.run ();
+
+  return res;
+}
+
+DeepRegion
+DeepRegion::operator+ (const DeepRegion &other) const
+{
+  DeepShapeStore *s = common_store (other);
+  if (! store ()) {
+    return other;
+  } else if (! other.store ()) {
+    return *this;
+  }
+
+  DeepRegion res (*this);
+  s->layout ().copy_layer (other.m_layer, res.m_layer);
+  return res;
+}
+
+DeepRegion
+DeepRegion::operator| (const DeepRegion &other) const
+{
+  return (*this + other).merged ();
+}
+
+DeepRegion
+DeepRegion::merged () const
+{
+  DeepShapeStore *s = store ();
+  if (! s) {
+    return DeepRegion ();
+  }
+
+  DeepRegion res (s, s->new_layer ());
+
+  db::EdgeProcessor ep;
+  db::Layout &layout = s->layout ();
+
+  for (db::Layout::iterator c = layout.begin (); c != layout.end (); ++c) {
+
+    const db::Shapes &shapes = c->shapes (m_layer);
+    if (shapes.empty ()) {
+      continue;
+    }
+
+    std::vector<db::Polygon> in, out;
+    in.reserve (shapes.size ());
+    for (db::ShapeIterator sh = shapes.begin (db::ShapeIterator::All); ! sh.at_end (); ++sh) {
+      in.push_back (db::Polygon ());
+      sh->polygon (in.back ());
+    }
+
+    ep.merge (in, out, 0, true, true);
+
+    db::Shapes &target = c->shapes (res.m_layer);
+    for (std::vector<db::Polygon>::const_iterator p = out.begin (); p != out.end (); ++p) {
+      target.insert (*p);
+    }
+
+  }
+
+  return res;
+}
+
+db::Region
+DeepRegion::flattened () const
+{
+  db::Region region;
+
+  if (store ()) {
+    const db::Layout &layout = store ()->layout ();
+    for (db::RecursiveShapeIterator si (layout, layout.cell (store ()->top_cell ()), m_layer); ! si.at_end (); ++si) {
+      db::Polygon poly;
+      si->polygon (poly);
+      region.insert (poly.transformed (si.trans ()));
+    }
+  }
+
+  return region;
+}
+
+void
+DeepRegion::insert_into (db::Layout *layout, db::cell_index_type into_cell, unsigned int into_layer) const
+{
+  DeepShapeStore *s = store ();
+  if (! s) {
+    return;
+  }
+
+  const db::Layout &source = s->layout ();
+
+  if (s->is_source (layout, into_cell)) {
+
+    //  output into the original hierarchy
+    for (db::Layout::const_iterator c = source.begin (); c != source.end (); ++c) {
+
+      const db::Shapes &shapes = c->shapes (m_layer);
+      db::cell_index_type target_ci = s->source_cell (c->cell_index ());
+      if (shapes.empty () || ! layout->is_valid_cell_index (target_ci)) {
+        continue;
+      }
+
+      db::Shapes &target = layout->cell (target_ci).shapes (into_layer);
+      for (db::ShapeIterator sh = shapes.begin (db::ShapeIterator::All); ! sh.at_end (); ++sh) {
+        db::Polygon poly;
+        sh->polygon (poly);
+        target.insert (poly);
+      }
+
+    }
+
+  } else {
+
+    //  reproduce the cell tree for all cells carrying polygons
+    std::set<db::cell_index_type> used_cells;
+    for (db::Layout::bottom_up_const_iterator c = source.begin_bottom_up (); c != source.end_bottom_up (); ++c) {
+      const db::Cell &cell = source.cell (*c);
+      bool used = ! cell.shapes (m_layer).empty ();
+      for (db::Cell::child_cell_iterator cc = cell.begin_child_cells (); ! cc.at_end () && ! used; ++cc) {
+        used = (used_cells.find (*cc) != used_cells.end ());
+      }
+      if (used) {
+        used_cells.insert (*c);
+      }
+    }
+
+    std::map<db::cell_index_type, db::cell_index_type> cell_map;
+    cell_map.insert (std::make_pair (s->top_cell (), into_cell));
+
+    for (db::Layout::top_down_const_iterator c = source.begin_top_down (); c != source.end_top_down (); ++c) {
+
+      std::map<db::cell_index_type, db::cell_index_type>::const_iterator cm = cell_map.find (*c);
+      if (cm == cell_map.end ()) {
+        continue;
+      }
+
+      db::cell_index_type target_ci = cm->second;
+      const db::Cell &cell = source.cell (*c);
+
+      db::Shapes &target = layout->cell (target_ci).shapes (into_layer);
+      for (db::ShapeIterator sh = cell.shapes (m_layer).begin (db::ShapeIterator::All); ! sh.at_end (); ++sh) {
+        db::Polygon poly;
+        sh->polygon (poly);
+        target.insert (poly);
+      }
+
+      for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+
+        db::cell_index_type child = i->cell_index ();
+        if (used_cells.find (child) == used_cells.end ()) {
+          continue;
+        }
+
+        std::map<db::cell_index_type, db::cell_index_type>::const_iterator cc = cell_map.find (child);
+        if (cc == cell_map.end ()) {
+          cc = cell_map.insert (std::make_pair (child, layout->add_cell (source.cell_name (child)))).first;
+        }
+
+        db::CellInstArray inst (i->cell_inst ());
+        inst.object () = db::CellInst (cc->second);
+        layout->cell (target_ci).insert (inst);
+
+      }
+
+    }
+
+  }
+}
+
+std::string
+DeepRegion::to_string (size_t nmax) const
+{
+  return flattened ().to_string (nmax);
+}
+
+}
+
@@ -0,0 +1,349 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_dbDeepRegion
+#define HDR_dbDeepRegion
+
+#include "dbCommon.h"
+
+#include "dbLayout.h"
+#include "dbRegion.h"
+#include "dbRecursiveShapeIterator.h"
+#include "tlObject.h"
+#include "tlTypeTraits.h"
+
+#include <map>
+#include <vector>
+
+namespace db
+{
+
+/**
+ *  @brief A store for hierarchical ("deep") shape data
+ *
+ *  The deep shape store keeps a working copy of the cell tree below a given
+ *  top cell of a source layout. Layers imported into the store are kept as
+ *  local shapes of the cells of that tree, so repetitions of cells are stored once.
+ *  db::DeepRegion objects refer to layers inside such a store. Hierarchical
+ *  operations between deep regions require both regions to live in the same store.
+ *
+ *  If the source hierarchy contains complex instances (arbitrary angles or
+ *  magnifications), the store falls back to flat mode: all shapes are kept in
+ *  the top cell then. This way the results are always exact in the sense of
+ *  integer coordinates.
+ *
+ *  The store does not keep a reference to the source layout. It can outlive
+ *  the source layout.
+ */
+class DB_PUBLIC DeepShapeStore
+  : public tl::Object
+{
+public:
+  /**
+   *  @brief Default constructor
+   *
+   *  Creates an empty store with a single (empty) top cell.
+   */
+  DeepShapeStore ();
+
+  /**
+   *  @brief Creates a store from the cell tree below the given cell of the given layout
+   */
+  DeepShapeStore (const db::Layout &layout, db::cell_index_type top_cell);
+
+  /**
+   *  @brief Gets the working layout
+   */
+  const db::Layout &layout () const
+  {
+    return m_layout;
+  }
+
+  /**
+   *  @brief Gets the working layout (non-const version)
+   */
+  db::Layout &layout ()
+  {
+    return m_layout;
+  }
+
+  /**
+   *  @brief Gets the top cell of the working layout
+   */
+  db::cell_index_type top_cell () const
+  {
+    return m_top_cell;
+  }
+
+  /**
+   *  @brief Returns true, if the store is in flat mode
+   */
+  bool is_flat () const
+  {
+    return m_flat;
+  }
+
+  /**
+   *  @brief Gets the number of flat instances of the given working cell below the top cell
+   */
+  size_t instance_count (db::cell_index_type ci) const;
+
+  /**
+   *  @brief Returns true, if the recursive shape iterator can be imported hierarchically
+   *
+   *  This is the case if the iterator refers to the source layout and cell, does not
+   *  use a search region, a depth limit or a cell selection.
+   */
+  bool is_hierarchical_source (const db::RecursiveShapeIterator &si) const;
+
+  /**
+   *  @brief Imports the polygons delivered by the given iterator into a new layer
+   *
+   *  If the iterator is compatible with the store (see is_hierarchical_source) and
+   *  the transformation is a unit transformation, the shapes are imported as local
+   *  shapes of the cells. Otherwise they are imported flat into the top cell.
+   *  Returns the new layer index.
+   */
+  unsigned int import_layer (const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans);
+
+  /**
+   *  @brief Creates a new, empty layer
+   */
+  unsigned int new_layer ();
+
+  /**
+   *  @brief Releases a layer which is no longer used
+   */
+  void release_layer (unsigned int layer);
+
+  /**
+   *  @brief Returns true, if the given layout and cell is the source of this store
+   *
+   *  The layout pointer is only compared, but not dereferenced.
+   */
+  bool is_source (const db::Layout *layout, db::cell_index_type ci) const
+  {
+    return ! m_flat && mp_source_layout != 0 && mp_source_layout == layout && ci == m_source_top_cell;
+  }
+
+  /**
+   *  @brief Gets the source cell for a given working cell
+   */
+  db::cell_index_type source_cell (db::cell_index_type ci) const;
+
+private:
+  db::Layout m_layout;
+  db::cell_index_type m_top_cell;
+  const db::Layout *mp_source_layout;
+  db::cell_index_type m_source_top_cell;
+  std::map<db::cell_index_type, db::cell_index_type> m_source_cells;
+  std::map<db::cell_index_type, size_t> m_instance_counts;
+  bool m_flat;
+
+  DeepShapeStore (const DeepShapeStore &);
+  DeepShapeStore &operator= (const DeepShapeStore &);
+
+  void compute_instance_counts ();
+};
+
+/**
+ *  @brief A hierarchical region
+ *
+ *  A deep region is a polygon collection which is kept as a layer inside a
+ *  db::DeepShapeStore. In contrast to db::Region, the polygons are not flattened
+ *  but stay local to the cells they originate from.
+ *
+ *  The boolean operations (AND, NOT, XOR) are computed hierarchically:
+ *  a cell's shapes are evaluated once per distinct context the cell is used in.
+ *  The context is formed by the shapes of the other operand around the instances
+ *  of the cell. Results common to all contexts stay inside the cell. Results
+ *  specific to a context are propagated into the parent cells. Hence for regular
+ *  arrays only the instances at the border of the array usually require a special
+ *  treatment.
+ *
+ *  The results are exact in terms of the covered area, but not merged: polygons
+ *  from different hierarchy levels may touch or overlap. "merged" merges the
+ *  polygons inside each cell, but does not merge across the hierarchy.
+ *  The flattened method will deliver a flat db::Region from a deep region.
+ */
+class DB_PUBLIC DeepRegion
+{
+public:
+  /**
+   *  @brief Default constructor
+   *
+   *  Creates an empty deep region which is not attached to a store.
+   */
+  DeepRegion ();
+
+  /**
+   *  @brief Creates a deep region from a recursive shape iterator
+   *
+   *  The shapes are imported into the given store.
+   */
+  DeepRegion (DeepShapeStore &store, const db::RecursiveShapeIterator &si);
+
+  /**
+   *  @brief Creates a deep region from a recursive shape iterator and a transformation
+   *
+   *  Non-unit transformations will make the region be imported flat.
+   */
+  DeepRegion (DeepShapeStore &store, const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans);
+
+  /**
+   *  @brief Copy constructor
+   */
+  DeepRegion (const DeepRegion &other);
+
+  /**
+   *  @brief Assignment
+   */
+  DeepRegion &operator= (const DeepRegion &other);
+
+  /**
+   *  @brief Destructor
+   */
+  ~DeepRegion ();
+
+  /**
+   *  @brief Swaps with another deep region
+   */
+  void swap (DeepRegion &other);
+
+  /**
+   *  @brief Gets the store this region lives in (may be 0)
+   */
+  DeepShapeStore *store () const
+  {
+    return const_cast<DeepShapeStore *> (mp_store.get ());
+  }
+
+  /**
+   *  @brief Gets the layer inside the store's layout
+   */
+  unsigned int layer () const
+  {
+    return m_layer;
+  }
+
+  /**
+   *  @brief Returns true, if the region is empty
+   */
+  bool empty () const;
+
+  /**
+   *  @brief Gets the bounding box of the region
+   */
+  db::Box bbox () const;
+
+  /**
+   *  @brief Gets the number of polygons in the flat view
+   *
+   *  This number is computed from the hierarchy without flattening.
+   */
+  size_t size () const;
+
+  /**
+   *  @brief Gets the number of polygons stored in the hierarchy
+   */
+  size_t hier_size () const;
+
+  /**
+   *  @brief Boolean AND operator
+   */
+  DeepRegion operator& (const DeepRegion &other) const;
+
+  /**
+   *  @brief Boolean NOT operator
+   */
+  DeepRegion operator- (const DeepRegion &other) const;
+
+  /**
+   *  @brief Boolean XOR operator
+   */
+  DeepRegion operator^ (const DeepRegion &other) const;
+
+  /**
+   *  @brief Boolean OR operator
+   *
+   *  This operator merges the polygons of both regions inside each cell.
+   */
+  DeepRegion operator| (const DeepRegion &other) const;
+
+  /**
+   *  @brief Joining of regions
+   *
+   *  This operator just combines the polygons of both regions.
+   */
+  DeepRegion operator+ (const DeepRegion &other) const;
+
+  /**
+   *  @brief Returns a region with the polygons merged inside each cell
+   */
+  DeepRegion merged () const;
+
+  /**
+   *  @brief Returns a flat region with the same content
+   */
+  db::Region flattened () const;
+
+  /**
+   *  @brief Inserts the polygons into the given cell and layer of the given layout
+   *
+   *  If the layout and cell are the source of the store, the polygons are
+   *  inserted into the original cells. Otherwise, the cell tree is
+   *  reproduced below the given cell for all cells which carry polygons.
+   */
+  void insert_into (db::Layout *layout, db::cell_index_type into_cell, unsigned int into_layer) const;
+
+  /**
+   *  @brief Converts the region to a string
+   *
+   *  The string lists the flat polygons up to the given number.
+   */
+  std::string to_string (size_t nmax = 10) const;
+
+private:
+  tl::weak_ptr<DeepShapeStore> mp_store;
+  unsigned int m_layer;
+
+  DeepRegion (DeepShapeStore *store, unsigned int layer);
+
+  DeepShapeStore *common_store (const DeepRegion &other) const;
+  void release ();
+};
+
+}
+
+namespace tl
+{
+  template <>
+  struct type_traits<db::DeepShapeStore> : public type_traits<void>
+  {
+    typedef tl::true_tag has_default_constructor;
+    typedef tl::false_tag has_copy_constructor;
+  };
+}
+
+#endif
+
@@ -27,12 +27,24 @@
 #include "dbLayout.h"
 #include "tlTimer.h"
 #include "tlProgress.h"
+#include "tlThreadedWorkers.h"
 #include "gsi.h"
 
 #include <vector>
 #include <deque>
+#include <map>
+#include <limits>
 #include <memory>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define DB_EDGE_FILTER_SSE2
+#  include <emmintrin.h>
+#  if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#    define DB_EDGE_FILTER_AVX2
+#    include <immintrin.h>
+#  endif
+#endif
+
 #if 0
 #define DEBUG_MERGEOP
 #define DEBUG_BOOLEAN
@@ -950,11 +962,89 @@ BooleanOp2::compare_ns () const
   return compare_ns_impl (inside_a, inside_b);
 }
 
+// -------------------------------------------------------------------------------
+//  EdgeProcessorOperand implementation
+
+EdgeProcessorOperand::EdgeProcessorOperand ()
+  : tl::Object (), m_sorted (true)
+{
+  mp_work_edges = new std::vector <WorkEdge> ();
+}
+
+EdgeProcessorOperand::EdgeProcessorOperand (const EdgeProcessorOperand &other)
+  : tl::Object (other), m_sorted (other.m_sorted)
+{
+  mp_work_edges = new std::vector <WorkEdge> (*other.mp_work_edges);
+}
+
+EdgeProcessorOperand &
+EdgeProcessorOperand::operator= (const EdgeProcessorOperand &other)
+{
+  if (this != &other) {
+    *mp_work_edges = *other.mp_work_edges;
+    m_sorted = other.m_sorted;
+  }
+  return *this;
+}
+
+EdgeProcessorOperand::~EdgeProcessorOperand ()
+{
+  if (mp_work_edges) {
+    delete mp_work_edges;
+    mp_work_edges = 0;
+  }
+}
+
+void 
+EdgeProcessorOperand::reserve (size_t n)
+{
+  mp_work_edges->reserve (n);
+}
+
+void 
+EdgeProcessorOperand::insert (const db::Edge &e, property_type p)
+{
+  if (e.p1 () != e.p2 ()) {
+    mp_work_edges->push_back (WorkEdge (e, p));
+    m_sorted = false;
+  }
+}
+
+void 
+EdgeProcessorOperand::insert (const db::Polygon &q, property_type p)
+{
+  for (db::Polygon::polygon_edge_iterator e = q.begin_edge (); ! e.at_end (); ++e) {
+    insert (*e, p);
+  }
+}
+
+void 
+EdgeProcessorOperand::clear ()
+{
+  mp_work_edges->clear ();
+  m_sorted = true;
+}
+
+size_t 
+EdgeProcessorOperand::size () const
+{
+  return mp_work_edges->size ();
+}
+
+void 
+EdgeProcessorOperand::ensure_sorted () const
+{
+  if (! m_sorted) {
+    std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+    m_sorted = true;
+  }
+}
+
 // -------------------------------------------------------------------------------
 //  EdgeProcessor implementation
 
 EdgeProcessor::EdgeProcessor (bool report_progress, const std::string &progress_desc)
-  : m_report_progress (report_progress), m_progress_desc (progress_desc)
+  : m_presorted (0), m_report_progress (report_progress), m_progress_desc (progress_desc), m_threads (0), m_thread_batch_size (1000000), m_simd_level (-1)
 {
   mp_work_edges = new std::vector <WorkEdge> ();
   mp_cpvector = new std::vector <CutPoints> ();
@@ -985,6 +1075,24 @@ EdgeProcessor::enable_progress (const std::string &progress_desc)
   m_progress_desc = progress_desc;
 }
 
+void 
+EdgeProcessor::set_threads (int n)
+{
+  m_threads = n;
+}
+
+void 
+EdgeProcessor::set_thread_batch_size (size_t n)
+{
+  m_thread_batch_size = n;
+}
+
+void 
+EdgeProcessor::set_simd_level (int level)
+{
+  m_simd_level = level;
+}
+
 void 
 EdgeProcessor::reserve (size_t n)
 {
@@ -1007,15 +1115,179 @@ EdgeProcessor::insert (const db::Polygon &q, EdgeProcessor::property_type p)
   }
 }
 
+void 
+EdgeProcessor::insert (const EdgeProcessorOperand &op, EdgeProcessor::property_type offset)
+{
+  op.ensure_sorted ();
+
+  //  The sorted part is kept at the beginning of the work edge vector: if all edges 
+  //  present are sorted already, the new ones are merged in. Otherwise they are just appended.
+  bool all_sorted = (m_presorted == mp_work_edges->size ());
+
+  size_t n0 = mp_work_edges->size ();
+  mp_work_edges->reserve (n0 + op.mp_work_edges->size ());
+  for (std::vector <WorkEdge>::const_iterator e = op.mp_work_edges->begin (); e != op.mp_work_edges->end (); ++e) {
+    mp_work_edges->push_back (WorkEdge (*e, e->prop + offset));
+  }
+
+  if (all_sorted) {
+    if (n0 > 0) {
+      std::inplace_merge (mp_work_edges->begin (), mp_work_edges->begin () + n0, mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+    }
+    m_presorted = mp_work_edges->size ();
+  }
+}
+
 void 
 EdgeProcessor::clear ()
 {
   mp_work_edges->clear ();
   mp_cpvector->clear ();
+  m_presorted = 0;
+}
+
+/**
+ *  @brief A cut point receiver which enters the cut points directly into the cut point vector
+ */
+struct DirectCutPointReceiver
+{
+  DirectCutPointReceiver (std::vector <CutPoints> &cutpoints)
+    : mp_cutpoints (&cutpoints)
+  { }
+
+  void add (WorkEdge &e, const db::Point &p)
+  {
+    e.make_cutpoints (*mp_cutpoints)->add (p, mp_cutpoints, true);
+  }
+
+private:
+  std::vector <CutPoints> *mp_cutpoints;
+};
+
+/**
+ *  @brief A cut point receiver which records the cut points as pairs of the edge's data member and point
+ *
+ *  This receiver is used for the multi-threaded case. The edge's data member is either a valid 
+ *  cut point index or a tentative edge ID (see ParallelCellHandler90) which is resolved later.
+ */
+struct RecordingCutPointReceiver
+{
+  RecordingCutPointReceiver (std::vector <std::pair<size_t, db::Point> > &cutpoints)
+    : mp_cutpoints (&cutpoints)
+  { }
+
+  void add (WorkEdge &e, const db::Point &p)
+  {
+    mp_cutpoints->push_back (std::make_pair (e.data, p));
+  }
+
+private:
+  std::vector <std::pair<size_t, db::Point> > *mp_cutpoints;
+};
+
+/**
+ *  @brief Computes the intersections of the edges within one cell (90 degree case)
+ *
+ *  In the 90 degree case, all cut points are strong ones. Hence the order in which they are 
+ *  delivered to the receiver does not matter.
+ */
+template <class Receiver>
+static void 
+get_intersections_per_cell_90 (std::vector <WorkEdge>::iterator c, std::vector <WorkEdge>::iterator f, const db::Box &cell, bool with_h, Receiver &receiver)
+{
+  for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) {
+
+    bool c1p1_in_cell = cell.contains (c1->p1 ());
+    bool c1p2_in_cell = cell.contains (c1->p2 ());
+
+    for (std::vector <WorkEdge>::iterator c2 = c; c2 != f; ++c2) {
+
+      if (c1 == c2) {
+        continue;
+      }
+
+      if (c2->dy () == 0) {
+
+        if ((with_h || c1->dy () != 0) && c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
+                                                     c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
+
+          std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
+          if (cp.first) {
+            
+            //  add a cut point to c1 and c2 (c2 only if necessary)
+            receiver.add (*c1, cp.second);
+            if (with_h) {
+              receiver.add (*c2, cp.second);
+            }
+
+#ifdef DEBUG_EDGE_PROCESSOR
+            printf ("intersection point %s between %s and %s (1).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+#endif
+
+          }
+
+        } 
+      
+      } else if (c1->dy () == 0) {
+        
+        if (c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
+                       c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
+
+          std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
+          if (cp.first) {
+            
+            //  add a cut point to c1 and c2
+            receiver.add (*c2, cp.second);
+            if (with_h) {
+              receiver.add (*c1, cp.second);
+            }
+
+#ifdef DEBUG_EDGE_PROCESSOR
+            printf ("intersection point %s between %s and %s (2).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
+#endif
+
+          }
+
+        }
+
+      } else if (c1->p1 ().x () == c2->p1 ().x ()) {
+
+        //  both edges are coincident - produce the ends of the edges involved as cut points
+        if (c1p1_in_cell && c1->p1 ().y () > db::edge_ymin (*c2) && c1->p1 ().y () < db::edge_ymax (*c2)) {
+          receiver.add (*c2, c1->p1 ());
+        }
+        if (c1p2_in_cell && c1->p2 ().y () > db::edge_ymin (*c2) && c1->p2 ().y () < db::edge_ymax (*c2)) {
+          receiver.add (*c2, c1->p2 ());
+        }
+
+      }
+
+    }
+
+  }
 }
 
+/**
+ *  @brief A cell handler for get_intersections_per_band_90 which computes the intersections immediately
+ */
+struct DirectCellHandler90
+{
+  DirectCellHandler90 (std::vector <CutPoints> &cutpoints)
+    : m_receiver (cutpoints)
+  { }
+
+  void operator() (std::vector <WorkEdge>::iterator c, std::vector <WorkEdge>::iterator f, const db::Box &cell, bool with_h)
+  {
+    get_intersections_per_cell_90 (c, f, cell, with_h, m_receiver);
+  }
+
+private:
+  DirectCutPointReceiver m_receiver;
+};
+
+template <class CellHandler>
 static void 
-get_intersections_per_band_90 (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
+get_intersections_per_band_90 (CellHandler &cell_handler, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
 {
   std::sort (current, future, edge_xmin_compare<db::Coord> ());
 
@@ -1050,80 +1322,7 @@ get_intersections_per_band_90 (std::vector <CutPoints> &cutpoints, std::vector <
 #endif
 
     if (std::distance (c, f) > 1) {
-
-      db::Box cell (x, y, xx, yy);
-
-      for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) {
-
-        bool c1p1_in_cell = cell.contains (c1->p1 ());
-        bool c1p2_in_cell = cell.contains (c1->p2 ());
-
-        for (std::vector <WorkEdge>::iterator c2 = c; c2 != f; ++c2) {
-
-          if (c1 == c2) {
-            continue;
-          }
-
-          if (c2->dy () == 0) {
-
-            if ((with_h || c1->dy () != 0) && c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
-                                                         c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
-
-              std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
-              if (cp.first) {
-                
-                //  add a cut point to c1 and c2 (c2 only if necessary)
-                c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                if (with_h) {
-                  c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                }
-
-#ifdef DEBUG_EDGE_PROCESSOR
-                printf ("intersection point %s between %s and %s (1).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-#endif
-
-              }
-
-            } 
-          
-          } else if (c1->dy () == 0) {
-            
-            if (c1 < c2 && c1->p1 () != c2->p1 () && c1->p2 () != c2->p1 () &&
-                           c1->p1 () != c2->p2 () && c1->p2 () != c2->p2 ()) {
-
-              std::pair <bool, db::Point> cp = c1->intersect_point (*c2);
-              if (cp.first) {
-                
-                //  add a cut point to c1 and c2
-                c2->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                if (with_h) {
-                  c1->make_cutpoints (cutpoints)->add (cp.second, &cutpoints, true);
-                }
-
-#ifdef DEBUG_EDGE_PROCESSOR
-                printf ("intersection point %s between %s and %s (2).\n", cp.second.to_string ().c_str (), c1->to_string ().c_str (), c2->to_string ().c_str ()); 
-#endif
-
-              }
-
-            }
-
-          } else if (c1->p1 ().x () == c2->p1 ().x ()) {
-
-            //  both edges are coincident - produce the ends of the edges involved as cut points
-            if (c1p1_in_cell && c1->p1 ().y () > db::edge_ymin (*c2) && c1->p1 ().y () < db::edge_ymax (*c2)) {
-              c2->make_cutpoints (cutpoints)->add (c1->p1 (), &cutpoints, true);
-            }
-            if (c1p2_in_cell && c1->p2 ().y () > db::edge_ymin (*c2) && c1->p2 ().y () < db::edge_ymax (*c2)) {
-              c2->make_cutpoints (cutpoints)->add (c1->p2 (), &cutpoints, true);
-            }
-
-          }
-
-        }
-
-      }
-
+      cell_handler (c, f, db::Box (x, y, xx, yy), with_h);
     }
 
     x = xx;
@@ -1228,50 +1427,432 @@ public:
   double m_y1, m_y2;
 };
 
-static void 
-get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h)
+// -------------------------------------------------------------------------------
+//  Vectorized filters for get_intersections_per_band_any
+
+/**
+ *  @brief The edges of a cell in a structure-of-arrays layout for the vectorized filters
+ */
+struct EdgeFilterBlock
 {
-  std::vector <WorkEdge *> p1_weak; // holds weak interactions of edge endpoints with other edges
-  std::vector <WorkEdge *> ip_weak;
-  double dy = y - 0.5;
-  double dyy = yy + 0.5;
+  std::vector<double> x1, y1, x2, y2;
+  std::vector<double> xmin, xmax, ymin, ymax;
 
-  std::sort (current, future, edge_xmin_at_yinterval_double_compare<db::Coord> (dy, dyy));
+  void assign (std::vector <WorkEdge>::const_iterator from, std::vector <WorkEdge>::const_iterator to)
+  {
+    size_t n = std::distance (from, to);
+    x1.resize (n); y1.resize (n); x2.resize (n); y2.resize (n);
+    xmin.resize (n); xmax.resize (n); ymin.resize (n); ymax.resize (n);
+
+    size_t i = 0;
+    for (std::vector <WorkEdge>::const_iterator e = from; e != to; ++e, ++i) {
+      x1 [i] = e->p1 ().x (); 
+      y1 [i] = e->p1 ().y (); 
+      x2 [i] = e->p2 ().x (); 
+      y2 [i] = e->p2 ().y (); 
+      xmin [i] = std::min (x1 [i], x2 [i]);
+      xmax [i] = std::max (x1 [i], x2 [i]);
+      ymin [i] = std::min (y1 [i], y2 [i]);
+      ymax [i] = std::max (y1 [i], y2 [i]);
+    }
+  }
 
-#ifdef DEBUG_EDGE_PROCESSOR
-  printf ("y=%d..%d\n", y, yy);
-  printf ("edges:"); 
-  for (std::vector <WorkEdge>::iterator c1 = current; c1 != future; ++c1) { 
-    printf (" %s", c1->to_string().c_str ()); 
-  } 
-  printf ("\n");
-#endif
-  db::Coord x = edge_xmin_at_yinterval_double (*current, dy, dyy);
+  size_t size () const
+  {
+    return x1.size ();
+  }
+};
 
-  std::vector <WorkEdge>::iterator f = current;
-  for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
+/**
+ *  @brief The parameters of the edge tested against a block
+ */
+struct EdgeFilterProbe
+{
+  EdgeFilterProbe (const db::Edge &e, bool p1_in_cell)
+  {
+    px = e.p1 ().x ();
+    py = e.p1 ().y ();
+    dx = e.dx ();
+    dy = e.dy ();
+    xmin = db::edge_xmin (e);
+    xmax = db::edge_xmax (e);
+    ymin = db::edge_ymin (e);
+    ymax = db::edge_ymax (e);
+    check_p1 = p1_in_cell;
+  }
 
-    while (f != future && edge_xmin_at_yinterval_double (*f, dy, dyy) <= x) {
-      ++f;
-    }
+  double px, py, dx, dy;
+  double xmin, xmax, ymin, ymax;
+  bool check_p1;
+};
 
-    db::Coord xx = std::numeric_limits <db::Coord>::max ();
-    if (f != future) {
-      xx = edge_xmin_at_yinterval_double (*f, dy, dyy);
-    }
+//  The relative error bound of the cross products computed in double precision: the differences
+//  are exact, the products and the sums add a few ulps at most.
+static const double edge_filter_eps = 1.0 / double (1ll << 50);
 
-#ifdef DEBUG_EDGE_PROCESSOR
-    printf ("edges %d..%d:", x, xx); 
-    for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) { 
-      printf (" %s", c1->to_string().c_str ()); 
-    } 
-    printf ("\n");
+/**
+ *  @brief Tests a probe edge against edge i of the block
+ *
+ *  The test is conservative: it returns false only if the edges cannot intersect (either
+ *  their bounding boxes don't touch or the second edge is entirely on one side of the 
+ *  probe edge) and the probe edge's first point is not inside the bounding box of the
+ *  other edge (required for the end point tests). In that case, get_intersections_per_band_any 
+ *  does not need to look at the pair.
+ */
+static inline bool 
+edge_filter_one (const EdgeFilterProbe &pr, const EdgeFilterBlock &blk, size_t i)
+{
+  double a1 = (blk.x1 [i] - pr.px) * pr.dy, b1 = (blk.y1 [i] - pr.py) * pr.dx;
+  double s1 = a1 - b1, e1 = (fabs (a1) + fabs (b1)) * edge_filter_eps;
+  double a2 = (blk.x2 [i] - pr.px) * pr.dy, b2 = (blk.y2 [i] - pr.py) * pr.dx;
+  double s2 = a2 - b2, e2 = (fabs (a2) + fabs (b2)) * edge_filter_eps;
+
+  bool no_cross = (s1 > e1 && s2 > e2) || (s1 < -e1 && s2 < -e2) ||
+                  blk.xmin [i] > pr.xmax || blk.xmax [i] < pr.xmin || blk.ymin [i] > pr.ymax || blk.ymax [i] < pr.ymin;
+  bool p1_outside = ! pr.check_p1 || 
+                  pr.px < blk.xmin [i] || pr.px > blk.xmax [i] || pr.py < blk.ymin [i] || pr.py > blk.ymax [i];
+
+  return ! (no_cross && p1_outside);
+}
+
+/**
+ *  @brief Tests a point against edge i of the block
+ *
+ *  This is a conservative version of is_point_on_fuzzy: it returns false only if 
+ *  the point is not within the bounding box of the edge or it's clearly farther away
+ *  from the edge than the fuzzy limit. Note that for a diagonal edge, the limit 
+ *  |vprod (offset, d)| of is_point_on_fuzzy is |dx| + |dy|.
+ */
+static inline bool 
+point_filter_one (double x, double y, const EdgeFilterBlock &blk, size_t i)
+{
+  if (x < blk.xmin [i] || x > blk.xmax [i] || y < blk.ymin [i] || y > blk.ymax [i]) {
+    return false;
+  }
+
+  double dx = blk.x2 [i] - blk.x1 [i], dy = blk.y2 [i] - blk.y1 [i];
+  double a = (x - blk.x1 [i]) * dy, b = (y - blk.y1 [i]) * dx;
+
+  return 2.0 * fabs (a - b) <= fabs (dx) + fabs (dy) + 4.0 * (fabs (a) + fabs (b)) * edge_filter_eps;
+}
+
+static void 
+edge_filter_plain (const EdgeFilterProbe &pr, const EdgeFilterBlock &blk, unsigned char *candidates)
+{
+  size_t n = blk.size ();
+  for (size_t i = 0; i < n; ++i) {
+    candidates [i] = edge_filter_one (pr, blk, i);
+  }
+}
+
+static void 
+point_filter_plain (const db::Point &pt, const EdgeFilterBlock &blk, unsigned char *candidates)
+{
+  size_t n = blk.size ();
+  for (size_t i = 0; i < n; ++i) {
+    candidates [i] = point_filter_one (pt.x (), pt.y (), blk, i);
+  }
+}
+
+#if defined(DB_EDGE_FILTER_SSE2)
+
+static void 
+edge_filter_sse2 (const EdgeFilterProbe &pr, const EdgeFilterBlock &blk, unsigned char *candidates)
+{
+  size_t n = blk.size ();
+  size_t i = 0;
+
+  const __m128d px = _mm_set1_pd (pr.px), py = _mm_set1_pd (pr.py);
+  const __m128d dx = _mm_set1_pd (pr.dx), dy = _mm_set1_pd (pr.dy);
+  const __m128d xmin = _mm_set1_pd (pr.xmin), xmax = _mm_set1_pd (pr.xmax);
+  const __m128d ymin = _mm_set1_pd (pr.ymin), ymax = _mm_set1_pd (pr.ymax);
+  const __m128d eps = _mm_set1_pd (edge_filter_eps);
+  const __m128d neps = _mm_set1_pd (-edge_filter_eps);
+  const __m128d abs_mask = _mm_castsi128_pd (_mm_set_epi32 (0x7fffffff, -1, 0x7fffffff, -1));
+  const __m128d all = _mm_castsi128_pd (_mm_set1_epi32 (-1));
+  const __m128d check_p1 = pr.check_p1 ? all : _mm_setzero_pd ();
+
+  for ( ; i + 2 <= n; i += 2) {
+
+    __m128d bxmin = _mm_loadu_pd (&blk.xmin [i]), bxmax = _mm_loadu_pd (&blk.xmax [i]);
+    __m128d bymin = _mm_loadu_pd (&blk.ymin [i]), bymax = _mm_loadu_pd (&blk.ymax [i]);
+
+    __m128d a1 = _mm_mul_pd (_mm_sub_pd (_mm_loadu_pd (&blk.x1 [i]), px), dy);
+    __m128d b1 = _mm_mul_pd (_mm_sub_pd (_mm_loadu_pd (&blk.y1 [i]), py), dx);
+    __m128d s1 = _mm_sub_pd (a1, b1);
+    __m128d m1 = _mm_add_pd (_mm_and_pd (a1, abs_mask), _mm_and_pd (b1, abs_mask));
+
+    __m128d a2 = _mm_mul_pd (_mm_sub_pd (_mm_loadu_pd (&blk.x2 [i]), px), dy);
+    __m128d b2 = _mm_mul_pd (_mm_sub_pd (_mm_loadu_pd (&blk.y2 [i]), py), dx);
+    __m128d s2 = _mm_sub_pd (a2, b2);
+    __m128d m2 = _mm_add_pd (_mm_and_pd (a2, abs_mask), _mm_and_pd (b2, abs_mask));
+
+    __m128d pos = _mm_and_pd (_mm_cmpgt_pd (s1, _mm_mul_pd (m1, eps)), _mm_cmpgt_pd (s2, _mm_mul_pd (m2, eps)));
+    __m128d neg = _mm_and_pd (_mm_cmplt_pd (s1, _mm_mul_pd (m1, neps)), _mm_cmplt_pd (s2, _mm_mul_pd (m2, neps)));
+    __m128d disjoint = _mm_or_pd (_mm_or_pd (_mm_cmpgt_pd (bxmin, xmax), _mm_cmplt_pd (bxmax, xmin)),
+                                  _mm_or_pd (_mm_cmpgt_pd (bymin, ymax), _mm_cmplt_pd (bymax, ymin)));
+    __m128d no_cross = _mm_or_pd (_mm_or_pd (pos, neg), disjoint);
+
+    __m128d p1_inside = _mm_and_pd (_mm_and_pd (_mm_cmpge_pd (px, bxmin), _mm_cmple_pd (px, bxmax)),
+                                    _mm_and_pd (_mm_cmpge_pd (py, bymin), _mm_cmple_pd (py, bymax)));
+    __m128d p1_outside = _mm_andnot_pd (_mm_and_pd (check_p1, p1_inside), all);
+
+    int skip = _mm_movemask_pd (_mm_and_pd (no_cross, p1_outside));
+    candidates [i] = (skip & 1) == 0;
+    candidates [i + 1] = (skip & 2) == 0;
+
+  }
+
+  for ( ; i < n; ++i) {
+    candidates [i] = edge_filter_one (pr, blk, i);
+  }
+}
+
+static void 
+point_filter_sse2 (const db::Point &pt, const EdgeFilterBlock &blk, unsigned char *candidates)
+{
+  size_t n = blk.size ();
+  size_t i = 0;
+
+  const __m128d x = _mm_set1_pd (pt.x ()), y = _mm_set1_pd (pt.y ());
+  const __m128d eps4 = _mm_set1_pd (4.0 * edge_filter_eps);
+  const __m128d two = _mm_set1_pd (2.0);
+  const __m128d abs_mask = _mm_castsi128_pd (_mm_set_epi32 (0x7fffffff, -1, 0x7fffffff, -1));
+
+  for ( ; i + 2 <= n; i += 2) {
+
+    __m128d inside = _mm_and_pd (_mm_and_pd (_mm_cmpge_pd (x, _mm_loadu_pd (&blk.xmin [i])), _mm_cmple_pd (x, _mm_loadu_pd (&blk.xmax [i]))),
+                                 _mm_and_pd (_mm_cmpge_pd (y, _mm_loadu_pd (&blk.ymin [i])), _mm_cmple_pd (y, _mm_loadu_pd (&blk.ymax [i]))));
+
+    __m128d x1 = _mm_loadu_pd (&blk.x1 [i]), y1 = _mm_loadu_pd (&blk.y1 [i]);
+    __m128d dx = _mm_sub_pd (_mm_loadu_pd (&blk.x2 [i]), x1), dy = _mm_sub_pd (_mm_loadu_pd (&blk.y2 [i]), y1);
+    __m128d a = _mm_mul_pd (_mm_sub_pd (x, x1), dy), b = _mm_mul_pd (_mm_sub_pd (y, y1), dx);
+
+    __m128d lhs = _mm_mul_pd (two, _mm_and_pd (_mm_sub_pd (a, b), abs_mask));
+    __m128d rhs = _mm_add_pd (_mm_add_pd (_mm_and_pd (dx, abs_mask), _mm_and_pd (dy, abs_mask)),
+                              _mm_mul_pd (_mm_add_pd (_mm_and_pd (a, abs_mask), _mm_and_pd (b, abs_mask)), eps4));
+
+    int hit = _mm_movemask_pd (_mm_and_pd (inside, _mm_cmple_pd (lhs, rhs)));
+    candidates [i] = (hit & 1) != 0;
+    candidates [i + 1] = (hit & 2) != 0;
+
+  }
+
+  for ( ; i < n; ++i) {
+    candidates [i] = point_filter_one (pt.x (), pt.y (), blk, i);
+  }
+}
+
+#endif
+
+#if defined(DB_EDGE_FILTER_AVX2)
+
+__attribute__((target("avx2")))
+static void 
+edge_filter_avx2 (const EdgeFilterProbe &pr, const EdgeFilterBlock &blk, unsigned char *candidates)
+{
+  size_t n = blk.size ();
+  size_t i = 0;
+
+  const __m256d px = _mm256_set1_pd (pr.px), py = _mm256_set1_pd (pr.py);
+  const __m256d dx = _mm256_set1_pd (pr.dx), dy = _mm256_set1_pd (pr.dy);
+  const __m256d xmin = _mm256_set1_pd (pr.xmin), xmax = _mm256_set1_pd (pr.xmax);
+  const __m256d ymin = _mm256_set1_pd (pr.ymin), ymax = _mm256_set1_pd (pr.ymax);
+  const __m256d eps = _mm256_set1_pd (edge_filter_eps);
+  const __m256d neps = _mm256_set1_pd (-edge_filter_eps);
+  const __m256d abs_mask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffll));
+  const __m256d all = _mm256_castsi256_pd (_mm256_set1_epi64x (-1));
+  const __m256d check_p1 = pr.check_p1 ? all : _mm256_setzero_pd ();
+
+  for ( ; i + 4 <= n; i += 4) {
+
+    __m256d bxmin = _mm256_loadu_pd (&blk.xmin [i]), bxmax = _mm256_loadu_pd (&blk.xmax [i]);
+    __m256d bymin = _mm256_loadu_pd (&blk.ymin [i]), bymax = _mm256_loadu_pd (&blk.ymax [i]);
+
+    __m256d a1 = _mm256_mul_pd (_mm256_sub_pd (_mm256_loadu_pd (&blk.x1 [i]), px), dy);
+    __m256d b1 = _mm256_mul_pd (_mm256_sub_pd (_mm256_loadu_pd (&blk.y1 [i]), py), dx);
+    __m256d s1 = _mm256_sub_pd (a1, b1);
+    __m256d m1 = _mm256_add_pd (_mm256_and_pd (a1, abs_mask), _mm256_and_pd (b1, abs_mask));
+
+    __m256d a2 = _mm256_mul_pd (_mm256_sub_pd (_mm256_loadu_pd (&blk.x2 [i]), px), dy);
+    __m256d b2 = _mm256_mul_pd (_mm256_sub_pd (_mm256_loadu_pd (&blk.y2 [i]), py), dx);
+    __m256d s2 = _mm256_sub_pd (a2, b2);
+    __m256d m2 = _mm256_add_pd (_mm256_and_pd (a2, abs_mask), _mm256_and_pd (b2, abs_mask));
+
+    __m256d pos = _mm256_and_pd (_mm256_cmp_pd (s1, _mm256_mul_pd (m1, eps), _CMP_GT_OQ), _mm256_cmp_pd (s2, _mm256_mul_pd (m2, eps), _CMP_GT_OQ));
+    __m256d neg = _mm256_and_pd (_mm256_cmp_pd (s1, _mm256_mul_pd (m1, neps), _CMP_LT_OQ), _mm256_cmp_pd (s2, _mm256_mul_pd (m2, neps), _CMP_LT_OQ));
+    __m256d disjoint = _mm256_or_pd (_mm256_or_pd (_mm256_cmp_pd (bxmin, xmax, _CMP_GT_OQ), _mm256_cmp_pd (bxmax, xmin, _CMP_LT_OQ)),
+                                     _mm256_or_pd (_mm256_cmp_pd (bymin, ymax, _CMP_GT_OQ), _mm256_cmp_pd (bymax, ymin, _CMP_LT_OQ)));
+    __m256d no_cross = _mm256_or_pd (_mm256_or_pd (pos, neg), disjoint);
+
+    __m256d p1_inside = _mm256_and_pd (_mm256_and_pd (_mm256_cmp_pd (px, bxmin, _CMP_GE_OQ), _mm256_cmp_pd (px, bxmax, _CMP_LE_OQ)),
+                                       _mm256_and_pd (_mm256_cmp_pd (py, bymin, _CMP_GE_OQ), _mm256_cmp_pd (py, bymax, _CMP_LE_OQ)));
+    __m256d p1_outside = _mm256_andnot_pd (_mm256_and_pd (check_p1, p1_inside), all);
+
+    int skip = _mm256_movemask_pd (_mm256_and_pd (no_cross, p1_outside));
+    candidates [i] = (skip & 1) == 0;
+    candidates [i + 1] = (skip & 2) == 0;
+    candidates [i + 2] = (skip & 4) == 0;
+    candidates [i + 3] = (skip & 8) == 0;
+
+  }
+
+  for ( ; i < n; ++i) {
+    candidates [i] = edge_filter_one (pr, blk, i);
+  }
+}
+
+__attribute__((target("avx2")))
+static void 
+point_filter_avx2 (const db::Point &pt, const EdgeFilterBlock &blk, unsigned char *candidates)
+{
+  size_t n = blk.size ();
+  size_t i = 0;
+
+  const __m256d x = _mm256_set1_pd (pt.x ()), y = _mm256_set1_pd (pt.y ());
+  const __m256d eps4 = _mm256_set1_pd (4.0 * edge_filter_eps);
+  const __m256d two = _mm256_set1_pd (2.0);
+  const __m256d abs_mask = _mm256_castsi256_pd (_mm256_set1_epi64x (0x7fffffffffffffffll));
+
+  for ( ; i + 4 <= n; i += 4) {
+
+    __m256d inside = _mm256_and_pd (_mm256_and_pd (_mm256_cmp_pd (x, _mm256_loadu_pd (&blk.xmin [i]), _CMP_GE_OQ), _mm256_cmp_pd (x, _mm256_loadu_pd (&blk.xmax [i]), _CMP_LE_OQ)),
+                                    _mm256_and_pd (_mm256_cmp_pd (y, _mm256_loadu_pd (&blk.ymin [i]), _CMP_GE_OQ), _mm256_cmp_pd (y, _mm256_loadu_pd (&blk.ymax [i]), _CMP_LE_OQ)));
+
+    __m256d x1 = _mm256_loadu_pd (&blk.x1 [i]), y1 = _mm256_loadu_pd (&blk.y1 [i]);
+    __m256d dx = _mm256_sub_pd (_mm256_loadu_pd (&blk.x2 [i]), x1), dy = _mm256_sub_pd (_mm256_loadu_pd (&blk.y2 [i]), y1);
+    __m256d a = _mm256_mul_pd (_mm256_sub_pd (x, x1), dy), b = _mm256_mul_pd (_mm256_sub_pd (y, y1), dx);
+
+    __m256d lhs = _mm256_mul_pd (two, _mm256_and_pd (_mm256_sub_pd (a, b), abs_mask));
+    __m256d rhs = _mm256_add_pd (_mm256_add_pd (_mm256_and_pd (dx, abs_mask), _mm256_and_pd (dy, abs_mask)),
+                                 _mm256_mul_pd (_mm256_add_pd (_mm256_and_pd (a, abs_mask), _mm256_and_pd (b, abs_mask)), eps4));
+
+    int hit = _mm256_movemask_pd (_mm256_and_pd (inside, _mm256_cmp_pd (lhs, rhs, _CMP_LE_OQ)));
+    candidates [i] = (hit & 1) != 0;
+    candidates [i + 1] = (hit & 2) != 0;
+    candidates [i + 2] = (hit & 4) != 0;
+    candidates [i + 3] = (hit & 8) != 0;
+
+  }
+
+  for ( ; i < n; ++i) {
+    candidates [i] = point_filter_one (pt.x (), pt.y (), blk, i);
+  }
+}
+
+#endif
+
+//  The minimum number of edges in a cell for which the filters are used
+static const ptrdiff_t edge_filter_min_edges = 16;
+
+typedef void (*edge_filter_func) (const EdgeFilterProbe &, const EdgeFilterBlock &, unsigned char *);
+typedef void (*point_filter_func) (const db::Point &, const EdgeFilterBlock &, unsigned char *);
+
+/**
+ *  @brief The filter implementations for a certain instruction set
+ */
+struct EdgeFilterFunctions
+{
+  EdgeFilterFunctions (edge_filter_func ef, point_filter_func pf)
+    : edge_filter (ef), point_filter (pf)
+  { }
+
+  edge_filter_func edge_filter;
+  point_filter_func point_filter;
+};
+
+static int max_simd_level ()
+{
+#if defined(DB_EDGE_FILTER_AVX2)
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2")) {
+    return 3;
+  }
+#endif
+#if defined(DB_EDGE_FILTER_SSE2)
+  return 2;
+#else
+  return 1;
+#endif
+}
+
+static EdgeFilterFunctions filter_functions_for_level (int level)
+{
+  static int max_level = max_simd_level ();
+  if (level == 0) {
+    //  no filters - every candidate is tested
+    return EdgeFilterFunctions (0, 0);
+  } else if (level < 0 || level > max_level) {
+    level = max_level;
+  }
+
+#if defined(DB_EDGE_FILTER_AVX2)
+  if (level >= 3) {
+    return EdgeFilterFunctions (&edge_filter_avx2, &point_filter_avx2);
+  }
+#endif
+#if defined(DB_EDGE_FILTER_SSE2)
+  if (level >= 2) {
+    return EdgeFilterFunctions (&edge_filter_sse2, &point_filter_sse2);
+  }
+#endif
+  return EdgeFilterFunctions (&edge_filter_plain, &point_filter_plain);
+}
+
+static void 
+get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future, db::Coord y, db::Coord yy, bool with_h, const EdgeFilterFunctions &filters)
+{
+  std::vector <WorkEdge *> p1_weak; // holds weak interactions of edge endpoints with other edges
+  std::vector <WorkEdge *> ip_weak;
+  EdgeFilterBlock filter_block;
+  std::vector<unsigned char> edge_candidates, point_candidates;
+  double dy = y - 0.5;
+  double dyy = yy + 0.5;
+
+  std::sort (current, future, edge_xmin_at_yinterval_double_compare<db::Coord> (dy, dyy));
+
+#ifdef DEBUG_EDGE_PROCESSOR
+  printf ("y=%d..%d\n", y, yy);
+  printf ("edges:"); 
+  for (std::vector <WorkEdge>::iterator c1 = current; c1 != future; ++c1) { 
+    printf (" %s", c1->to_string().c_str ()); 
+  } 
+  printf ("\n");
+#endif
+  db::Coord x = edge_xmin_at_yinterval_double (*current, dy, dyy);
+
+  std::vector <WorkEdge>::iterator f = current;
+  for (std::vector <WorkEdge>::iterator c = current; c != future; ) {
+
+    while (f != future && edge_xmin_at_yinterval_double (*f, dy, dyy) <= x) {
+      ++f;
+    }
+
+    db::Coord xx = std::numeric_limits <db::Coord>::max ();
+    if (f != future) {
+      xx = edge_xmin_at_yinterval_double (*f, dy, dyy);
+    }
+
+#ifdef DEBUG_EDGE_PROCESSOR
+    printf ("edges %d..%d:", x, xx); 
+    for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) { 
+      printf (" %s", c1->to_string().c_str ()); 
+    } 
+    printf ("\n");
 #endif
 
     if (std::distance (c, f) > 1) {
 
       db::Box cell (x, y, xx, yy);
 
+      //  the edge pair filter pays off only for cells with many edges
+      bool use_filter = filters.edge_filter != 0 && std::distance (c, f) >= edge_filter_min_edges;
+      if (use_filter) {
+        filter_block.assign (c, f);
+        edge_candidates.resize (filter_block.size ());
+        point_candidates.resize (filter_block.size ());
+      }
+
       for (std::vector <WorkEdge>::iterator c1 = c; c1 != f; ++c1) {
 
         p1_weak.clear (); 
@@ -1279,9 +1860,16 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
         bool c1p1_in_cell = cell.contains (c1->p1 ());
         bool c1p2_in_cell = cell.contains (c1->p2 ());
 
+        //  determine the edges which may interact with c1 (vectorized)
+        const unsigned char *candidate = 0;
+        if (use_filter) {
+          (*filters.edge_filter) (EdgeFilterProbe (*c1, c1p1_in_cell), filter_block, &edge_candidates.front ());
+          candidate = &edge_candidates.front ();
+        }
+
         for (std::vector <WorkEdge>::iterator c2 = c; c2 != f; ++c2) {
 
-          if (c1 == c2) {
+          if (c1 == c2 || (candidate && ! candidate [c2 - c])) {
             continue;
           }
 
@@ -1314,8 +1902,13 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
                 //  the cutpoint will be a weak attractor - that is an optional cutpoint.
                 //  In that case we can skip the cutpoint because no related edge will move.
                 ip_weak.clear ();
+                const unsigned char *on_point = 0;
+                if (use_filter) {
+                  (*filters.point_filter) (cp.second, filter_block, &point_candidates.front ());
+                  on_point = &point_candidates.front ();
+                }
                 for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
-                  if ((with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
+                  if ((! on_point || on_point [cc - c]) && (with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
                     ip_weak.push_back (&*cc);
                   }
                 }
@@ -1398,8 +1991,13 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
                 //  the cutpoint will be a weak attractor - that is an optional cutpoint.
                 //  In that case we can skip the cutpoint because no related edge will move.
                 ip_weak.clear ();
+                const unsigned char *on_point = 0;
+                if (use_filter) {
+                  (*filters.point_filter) (cp.second, filter_block, &point_candidates.front ());
+                  on_point = &point_candidates.front ();
+                }
                 for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
-                  if ((with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
+                  if ((! on_point || on_point [cc - c]) && (with_h || cc->dy () != 0) && cc != c1 && cc != c2 && is_point_on_fuzzy (*cc, cp.second)) {
                     ip_weak.push_back (&*cc);
                   }
                 }
@@ -1495,6 +2093,496 @@ get_intersections_per_band_any (std::vector <CutPoints> &cutpoints, std::vector
   }
 }
 
+// -------------------------------------------------------------------------------
+//  Multi-threading support for EdgeProcessor
+
+static void 
+throw_on_job_error (tl::JobBase &job)
+{
+  if (job.has_error ()) {
+    throw tl::Exception (tl::to_string (QObject::tr ("Errors occured during processing. First error message says:\n")) + job.error_messages ().front ());
+  }
+}
+
+/**
+ *  @brief The base class for the tasks of the EdgeProcessorJob
+ */
+class EdgeProcessorTask
+  : public tl::Task
+{
+public:
+  virtual void perform () = 0;
+};
+
+/**
+ *  @brief A task computing the intersections for a number of cells (90 degree case)
+ *
+ *  The task holds copies of the edges of each cell. The edges' data members are 
+ *  valid cut point indexes or tentative edge IDs, so the cut points can be recorded and 
+ *  entered into the cut point vector later.
+ */
+class EdgeProcessorIntersectionTask
+  : public EdgeProcessorTask
+{
+public:
+  EdgeProcessorIntersectionTask (bool with_h)
+    : m_with_h (with_h), mp_results (0)
+  { }
+
+  void add_cell (std::vector <WorkEdge>::const_iterator c, std::vector <WorkEdge>::const_iterator f, const db::Box &cell)
+  {
+    m_edges.insert (m_edges.end (), c, f);
+    m_cells.push_back (std::make_pair (cell, m_edges.size ()));
+  }
+
+  size_t size () const
+  {
+    return m_edges.size ();
+  }
+
+  void set_results (std::vector <std::pair<size_t, db::Point> > *results)
+  {
+    mp_results = results;
+  }
+
+  virtual void perform ()
+  {
+    RecordingCutPointReceiver receiver (*mp_results);
+
+    std::vector <WorkEdge>::iterator c = m_edges.begin ();
+    for (std::vector <std::pair<db::Box, size_t> >::const_iterator i = m_cells.begin (); i != m_cells.end (); ++i) {
+      std::vector <WorkEdge>::iterator f = m_edges.begin () + i->second;
+      get_intersections_per_cell_90 (c, f, i->first, m_with_h, receiver);
+      c = f;
+    }
+  }
+
+private:
+  bool m_with_h;
+  std::vector <WorkEdge> m_edges;
+  std::vector <std::pair<db::Box, size_t> > m_cells;
+  std::vector <std::pair<size_t, db::Point> > *mp_results;
+};
+
+/**
+ *  @brief A task sorting the cut points along the edges for a range of work edges
+ */
+class EdgeProcessorCutPointSortTask
+  : public EdgeProcessorTask
+{
+public:
+  EdgeProcessorCutPointSortTask (std::vector <WorkEdge>::const_iterator from, std::vector <WorkEdge>::const_iterator to, std::vector <CutPoints> *cpvector)
+    : m_from (from), m_to (to), mp_cpvector (cpvector)
+  { }
+
+  virtual void perform ()
+  {
+    for (std::vector <WorkEdge>::const_iterator e = m_from; e != m_to; ++e) {
+      if (e->data) {
+        CutPoints &cp = (*mp_cpvector) [e->data - 1];
+        if (cp.has_cutpoints && cp.cut_points.size () > 1) {
+          std::sort (cp.cut_points.begin (), cp.cut_points.end (), ProjectionCompare (*e));
+        }
+      }
+    }
+  }
+
+private:
+  std::vector <WorkEdge>::const_iterator m_from, m_to;
+  std::vector <CutPoints> *mp_cpvector;
+};
+
+/**
+ *  @brief The worker for the EdgeProcessorJob
+ */
+class EdgeProcessorWorker
+  : public tl::Worker
+{
+public:
+  EdgeProcessorWorker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    EdgeProcessorTask *ep_task = dynamic_cast<EdgeProcessorTask *> (task);
+    if (ep_task) {
+      ep_task->perform ();
+    }
+  }
+};
+
+/**
+ *  @brief The job executing the parallel parts of EdgeProcessor::process
+ */
+class EdgeProcessorJob
+  : public tl::JobBase
+{
+public:
+  EdgeProcessorJob (int nworkers)
+    : tl::JobBase (nworkers)
+  { }
+
+  /**
+   *  @brief Executes the tasks scheduled so far and waits for them to finish
+   */
+  void run ()
+  {
+    start ();
+    wait ();
+    throw_on_job_error (*this);
+  }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new EdgeProcessorWorker ();
+  }
+};
+
+/**
+ *  @brief A cell handler for get_intersections_per_band_90 which delegates the computation to worker threads
+ *
+ *  The cells are collected into tasks. The tasks are executed when "commit" is called. After the 
+ *  tasks have finished, the cut points are entered into the cut point vector. Since all cut points 
+ *  are strong ones in the 90 degree case, the result does not depend on the order in which the 
+ *  cut points are delivered. But "commit" needs to be called before the cut point vector is used
+ *  otherwise, i.e. before an all-angle band is processed.
+ *
+ *  Edges without cut points receive a tentative ID (marked by the tentative bit in the data member)
+ *  as the band walk moves the edges around. Cut points are only allocated for edges which actually 
+ *  receive an intersection. On "commit", the tentative IDs are replaced by the cut point indexes 
+ *  or reset to 0. The band walk moves edges to the current position when they are finished and
+ *  sorts the edges inside a band. Hence all edges carrying a tentative ID are located between
+ *  the current position of the band in which the first ID was given and the future position
+ *  of the latest band. "begin_band" needs to be called for every band to track these positions.
+ */
+class ParallelCellHandler90
+{
+public:
+  ParallelCellHandler90 (std::vector <WorkEdge> &work_edges, std::vector <CutPoints> &cutpoints, EdgeProcessorJob &job, size_t max_pending)
+    : mp_work_edges (&work_edges), mp_cutpoints (&cutpoints), mp_job (&job), mp_task (0), m_pending (0), 
+      m_max_pending (std::max (max_pending, size_t (1))), m_max_task_size (std::min (size_t (max_task_size), m_max_pending)),
+      m_next_id (0), m_from (std::numeric_limits<size_t>::max ()), m_to (0), m_band_from (0), m_band_to (0)
+  { }
+
+  ~ParallelCellHandler90 ()
+  {
+    for (std::vector <EdgeProcessorIntersectionTask *>::const_iterator t = m_tasks.begin (); t != m_tasks.end (); ++t) {
+      delete *t;
+    }
+    m_tasks.clear ();
+    delete mp_task;
+    mp_task = 0;
+  }
+
+  /**
+   *  @brief Announces the band which is processed next
+   */
+  void begin_band (std::vector <WorkEdge>::iterator current, std::vector <WorkEdge>::iterator future)
+  {
+    m_band_from = size_t (current - mp_work_edges->begin ());
+    m_band_to = size_t (future - mp_work_edges->begin ());
+
+    //  the band's sort may move edges with tentative IDs up to the band's end
+    if (m_from < m_to) {
+      m_to = std::max (m_to, m_band_to);
+    }
+  }
+
+  void operator() (std::vector <WorkEdge>::iterator c, std::vector <WorkEdge>::iterator f, const db::Box &cell, bool with_h)
+  {
+    //  give the edges without cut points a tentative ID, so the tasks can refer to them
+    for (std::vector <WorkEdge>::iterator cc = c; cc != f; ++cc) {
+      if (! cc->data) {
+        cc->data = tentative_bit | m_next_id++;
+      }
+    }
+
+    //  finished edges are moved to the current position, but not below the band's start
+    m_from = std::min (m_from, m_band_from);
+    m_to = std::max (m_to, m_band_to);
+
+    if (! mp_task) {
+      mp_task = new EdgeProcessorIntersectionTask (with_h);
+    }
+    mp_task->add_cell (c, f, cell);
+
+    if (mp_task->size () >= m_max_task_size) {
+      m_pending += mp_task->size ();
+      m_tasks.push_back (mp_task);
+      mp_task = 0;
+      if (m_pending >= m_max_pending) {
+        commit ();
+      }
+    }
+  }
+
+  void commit ()
+  {
+    if (mp_task) {
+      m_tasks.push_back (mp_task);
+      mp_task = 0;
+    }
+
+    if (! m_tasks.empty ()) {
+
+      std::vector <std::vector <std::pair<size_t, db::Point> > > results;
+      results.resize (m_tasks.size ());
+
+      std::vector <EdgeProcessorIntersectionTask *> tasks;
+      tasks.swap (m_tasks);
+      m_pending = 0;
+
+      for (size_t i = 0; i < tasks.size (); ++i) {
+        tasks [i]->set_results (&results [i]);
+        mp_job->schedule (tasks [i]);
+      }
+
+      mp_job->run ();
+
+      for (std::vector <std::vector <std::pair<size_t, db::Point> > >::const_iterator r = results.begin (); r != results.end (); ++r) {
+        for (std::vector <std::pair<size_t, db::Point> >::const_iterator p = r->begin (); p != r->end (); ++p) {
+
+          size_t d = p->first;
+          if ((d & tentative_bit) != 0) {
+            std::map <size_t, size_t>::iterator t = m_allocated.find (d);
+            if (t == m_allocated.end ()) {
+              mp_cutpoints->push_back (CutPoints ());
+              t = m_allocated.insert (std::make_pair (d, mp_cutpoints->size ())).first;
+            }
+            d = t->second;
+          }
+
+          (*mp_cutpoints) [d - 1].add (p->second, mp_cutpoints, true);
+
+        }
+      }
+
+    }
+
+    //  resolve the tentative IDs
+    for (size_t i = m_from; i < m_to; ++i) {
+      WorkEdge &e = (*mp_work_edges) [i];
+      if ((e.data & tentative_bit) != 0) {
+        std::map <size_t, size_t>::const_iterator t = m_allocated.find (e.data);
+        e.data = (t != m_allocated.end () ? t->second : 0);
+      }
+    }
+
+    m_allocated.clear ();
+    m_next_id = 0;
+    m_from = std::numeric_limits<size_t>::max ();
+    m_to = 0;
+  }
+
+private:
+  //  the maximum number of edges per task
+  static const size_t max_task_size = 10000;
+  //  marks a tentative edge ID in the data member
+  static const size_t tentative_bit = size_t (1) << (sizeof (size_t) * 8 - 1);
+
+  std::vector <WorkEdge> *mp_work_edges;
+  std::vector <CutPoints> *mp_cutpoints;
+  EdgeProcessorJob *mp_job;
+  EdgeProcessorIntersectionTask *mp_task;
+  std::vector <EdgeProcessorIntersectionTask *> m_tasks;
+  size_t m_pending;
+  size_t m_max_pending, m_max_task_size;
+  size_t m_next_id;
+  size_t m_from, m_to;
+  size_t m_band_from, m_band_to;
+  std::map <size_t, size_t> m_allocated;
+};
+
+/**
+ *  @brief An event recorded by the PipelinedEdgeSink
+ */
+struct EdgeSinkEvent
+{
+  enum event_type { BeginScanline, EndScanline, Put, CrossingEdge, SkipN };
+
+  EdgeSinkEvent (event_type t, const db::Edge &e, db::Coord y, size_t n)
+    : type (t), edge (e), y (y), n (n)
+  { }
+
+  event_type type;
+  db::Edge edge;
+  db::Coord y;
+  size_t n;
+};
+
+/**
+ *  @brief A task replaying a chunk of recorded events into the target edge sink
+ */
+class EdgeSinkReplayTask
+  : public tl::Task
+{
+public:
+  EdgeSinkReplayTask (db::EdgeSink *target)
+    : mp_target (target)
+  { }
+
+  void add (const EdgeSinkEvent &event)
+  {
+    m_events.push_back (event);
+  }
+
+  size_t size () const
+  {
+    return m_events.size ();
+  }
+
+  void replay ()
+  {
+    for (std::vector <EdgeSinkEvent>::const_iterator e = m_events.begin (); e != m_events.end (); ++e) {
+      switch (e->type) {
+      case EdgeSinkEvent::BeginScanline:
+        mp_target->begin_scanline (e->y);
+        break;
+      case EdgeSinkEvent::EndScanline:
+        mp_target->end_scanline (e->y);
+        break;
+      case EdgeSinkEvent::Put:
+        mp_target->put (e->edge);
+        break;
+      case EdgeSinkEvent::CrossingEdge:
+        mp_target->crossing_edge (e->edge);
+        break;
+      case EdgeSinkEvent::SkipN:
+        mp_target->skip_n (e->n);
+        break;
+      }
+    }
+  }
+
+private:
+  db::EdgeSink *mp_target;
+  std::vector <EdgeSinkEvent> m_events;
+};
+
+class EdgeSinkReplayWorker
+  : public tl::Worker
+{
+public:
+  EdgeSinkReplayWorker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    EdgeSinkReplayTask *replay_task = dynamic_cast<EdgeSinkReplayTask *> (task);
+    if (replay_task) {
+      replay_task->replay ();
+    }
+  }
+};
+
+/**
+ *  @brief An edge sink which forwards the events to another edge sink in a separate thread
+ *
+ *  The events are recorded and delivered in chunks to a single worker thread, so 
+ *  the target receives the same sequence of events than without pipelining. 
+ *  The target's "start" and "flush" methods are not called by this object.
+ *  "finish" needs to be called to wait for the last events to be delivered.
+ */
+class PipelinedEdgeSink
+  : public db::EdgeSink
+{
+public:
+  PipelinedEdgeSink (db::EdgeSink &target)
+    : mp_target (&target), mp_task (0), m_job (1)
+  { }
+
+  ~PipelinedEdgeSink ()
+  {
+    delete mp_task;
+    mp_task = 0;
+  }
+
+  virtual void put (const db::Edge &e)
+  {
+    record (EdgeSinkEvent (EdgeSinkEvent::Put, e, 0, 0));
+  }
+
+  virtual void crossing_edge (const db::Edge &e)
+  {
+    record (EdgeSinkEvent (EdgeSinkEvent::CrossingEdge, e, 0, 0));
+  }
+
+  virtual void skip_n (size_t n)
+  {
+    record (EdgeSinkEvent (EdgeSinkEvent::SkipN, db::Edge (), 0, n));
+  }
+
+  virtual void begin_scanline (db::Coord y)
+  {
+    record (EdgeSinkEvent (EdgeSinkEvent::BeginScanline, db::Edge (), y, 0));
+  }
+
+  virtual void end_scanline (db::Coord y)
+  {
+    record (EdgeSinkEvent (EdgeSinkEvent::EndScanline, db::Edge (), y, 0));
+    if (mp_task->size () >= chunk_size) {
+      deliver ();
+    }
+  }
+
+  void finish ()
+  {
+    deliver ();
+    m_job.wait ();
+    throw_on_job_error (m_job);
+  }
+
+private:
+  static const size_t chunk_size = 10000;
+
+  class ReplayJob
+    : public tl::JobBase
+  {
+  public:
+    ReplayJob (int nworkers)
+      : tl::JobBase (nworkers)
+    { }
+
+  protected:
+    virtual tl::Worker *create_worker ()
+    {
+      return new EdgeSinkReplayWorker ();
+    }
+  };
+
+  db::EdgeSink *mp_target;
+  EdgeSinkReplayTask *mp_task;
+  ReplayJob m_job;
+
+  void record (const EdgeSinkEvent &event)
+  {
+    if (! mp_task) {
+      mp_task = new EdgeSinkReplayTask (mp_target);
+    }
+    mp_task->add (event);
+  }
+
+  void deliver ()
+  {
+    if (! mp_task) {
+      return;
+    }
+
+    EdgeSinkReplayTask *task = mp_task;
+    mp_task = 0;
+    m_job.schedule (task);
+
+    //  restart the worker if it went idle (this will clear the error list, so check before)
+    if (! m_job.is_running ()) {
+      throw_on_job_error (m_job);
+      m_job.start ();
+    }
+  }
+};
+
 void 
 EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 {
@@ -1542,8 +2630,28 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
   todo_next += (todo_max - todo) / 5;
 
 
+  //  prepare multi-threaded operation if requested
+  std::auto_ptr<ParallelCellHandler90> parallel_cell_handler;
+  std::auto_ptr<EdgeProcessorJob> job;
+  if (m_threads > 0) {
+    job.reset (new EdgeProcessorJob (m_threads));
+    parallel_cell_handler.reset (new ParallelCellHandler90 (*mp_work_edges, *mp_cpvector, *job, m_thread_batch_size));
+  }
+
   //  step 2: find intersections
-  std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+
+  EdgeFilterFunctions filters = filter_functions_for_level (m_simd_level);
+
+  //  the edges of prepared operands are sorted already - only the others need to be sorted and merged in
+  if (m_presorted > 0 && m_presorted <= mp_work_edges->size ()) {
+    std::sort (mp_work_edges->begin () + m_presorted, mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+    std::inplace_merge (mp_work_edges->begin (), mp_work_edges->begin () + m_presorted, mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+  } else {
+    std::sort (mp_work_edges->begin (), mp_work_edges->end (), edge_ymin_compare<db::Coord> ());
+  }
+
+  //  the work edges will be modified from here on
+  m_presorted = 0;
 
   y = edge_ymin ((*mp_work_edges) [0]);
   future = mp_work_edges->begin ();
@@ -1585,9 +2693,19 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
       }
 
       if (is90) {
-        get_intersections_per_band_90 (*mp_cpvector, current, future, y, yy, selects_edges);
+        if (parallel_cell_handler.get ()) {
+          parallel_cell_handler->begin_band (current, future);
+          get_intersections_per_band_90 (*parallel_cell_handler, current, future, y, yy, selects_edges);
+        } else {
+          DirectCellHandler90 cell_handler (*mp_cpvector);
+          get_intersections_per_band_90 (cell_handler, current, future, y, yy, selects_edges);
+        }
       } else {
-        get_intersections_per_band_any (*mp_cpvector, current, future, y, yy, selects_edges);
+        //  the all-angle case depends on the cut points found so far
+        if (parallel_cell_handler.get ()) {
+          parallel_cell_handler->commit ();
+        }
+        get_intersections_per_band_any (*mp_cpvector, current, future, y, yy, selects_edges, filters);
       }
 
     }
@@ -1606,6 +2724,10 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
     
   }
 
+  if (parallel_cell_handler.get ()) {
+    parallel_cell_handler->commit ();
+  }
+
   //  step 3: create new edges from the ones with cutpoints
   //
   //  Hint: when we create the edges from the cutpoints we use the projection to sort the cutpoints along the
@@ -1616,6 +2738,21 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
   todo_next += (todo_max - todo) / 5;
 
   size_t n_work = mp_work_edges->size ();
+
+  //  in the multi-threaded case, sort the cut points in the worker threads
+  bool cut_points_sorted = false;
+  if (job.get ()) {
+
+    size_t chunk = n_work / (size_t (m_threads) * 4) + 1;
+    for (size_t n = 0; n < n_work; n += chunk) {
+      job->schedule (new EdgeProcessorCutPointSortTask (mp_work_edges->begin () + n, mp_work_edges->begin () + std::min (n_work, n + chunk), mp_cpvector));
+    }
+    job->run ();
+
+    cut_points_sorted = true;
+
+  }
+
   size_t nw = 0;
   for (size_t n = 0; n < n_work; ++n) {
 
@@ -1639,7 +2776,9 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
         db::Edge e = ew;
         property_type p = ew.prop;
-        std::sort (cut_points->cut_points.begin (), cut_points->cut_points.end (), ProjectionCompare (e));
+        if (! cut_points_sorted) {
+          std::sort (cut_points->cut_points.begin (), cut_points->cut_points.end (), ProjectionCompare (e));
+        }
 
         db::Point pll = e.p1 ();
         db::Point pl = e.p1 ();
@@ -1719,6 +2858,13 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
   
   es.start (); // call this as late as possible. This way, input containers can be identical with output containers ("clear" is done after the input is read)
 
+  //  in the multi-threaded case, the output is produced in a separate thread
+  std::auto_ptr<PipelinedEdgeSink> pipelined_sink;
+  if (m_threads > 0) {
+    pipelined_sink.reset (new PipelinedEdgeSink (es));
+  }
+  db::EdgeSink &sink = pipelined_sink.get () ? static_cast<db::EdgeSink &> (*pipelined_sink) : es;
+
   op.reset ();
   op.reserve (n_props);
 
@@ -1753,7 +2899,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
     }
 
     db::Coord ysl = y;
-    es.begin_scanline (y);
+    sink.begin_scanline (y);
 
     tl_assert (op.is_reset ()); // HINT: for development
 
@@ -1785,7 +2931,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
           tl_assert (c + skip <= future);
 
-          es.skip_n (skip_res);
+          sink.skip_n (skip_res);
 
           c->data = skip + new_skip_unit * skip_res;
 
@@ -1875,7 +3021,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
                 for (std::vector <WorkEdge>::iterator sc = cc0; sc != fc; ++sc) {
                   if (edge_ymin (*sc) == y && op.select_edge (sc->dy () == 0, sc->prop)) {
-                    es.put (*sc);
+                    sink.put (*sc);
 #ifdef DEBUG_EDGE_PROCESSOR
                     printf ("put(%s)\n", sc->to_string().c_str());
 #endif
@@ -1910,7 +3056,7 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
                   if (ho > 0) {
                     he.swap_points ();
                   }
-                  es.put (he);
+                  sink.put (he);
 #ifdef DEBUG_EDGE_PROCESSOR
                   printf ("put(%s)\n", he.to_string().c_str());
 #endif
@@ -1931,12 +3077,12 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
                 if (pn != 0) {
                   ++n_res;
                   if (edge_ymin (edge) == y) {
-                    es.put (edge);
+                    sink.put (edge);
 #ifdef DEBUG_EDGE_PROCESSOR
                     printf ("put(%s)\n", edge.to_string().c_str());
 #endif
                   } else {
-                    es.crossing_edge (edge);
+                    sink.crossing_edge (edge);
 #ifdef DEBUG_EDGE_PROCESSOR
                     printf ("xing(%s)\n", edge.to_string().c_str());
 #endif
@@ -2017,8 +3163,12 @@ EdgeProcessor::process (db::EdgeSink &es, EdgeEvaluatorBase &op)
 
     tl_assert (op.is_reset ()); // HINT: for development (second)
 
-    es.end_scanline (ysl);
+    sink.end_scanline (ysl);
+
+  }
 
+  if (pipelined_sink.get ()) {
+    pipelined_sink->finish ();
   }
 
   es.flush ();
@@ -30,6 +30,7 @@
 #include "dbTypes.h"
 #include "dbEdge.h"
 #include "dbPolygon.h"
+#include "tlObject.h"
 
 #include <vector>
 #include <set>
@@ -568,6 +569,86 @@ private:
   size_t m_zeroes;
 };
 
+/**
+ *  @brief A prepared operand for the edge processor
+ *
+ *  A prepared operand keeps the edges of one operand in the form the edge processor
+ *  works with: as work edges sorted by their lower y coordinate. Inserting a prepared
+ *  operand into an edge processor is cheaper than inserting the polygons again: the 
+ *  processor will only sort the other edges and merge them with the prepared ones.
+ *  This is useful when the same operand is used in many operations.
+ *
+ *  The properties of the edges are the ones given on "insert". An offset can be
+ *  added to them when the prepared operand is inserted into the edge processor.
+ */
+class DB_PUBLIC EdgeProcessorOperand
+  : public tl::Object
+{
+public:
+  typedef size_t property_type;
+
+  /**
+   *  @brief Default constructor
+   */
+  EdgeProcessorOperand ();
+
+  /**
+   *  @brief Copy constructor
+   */
+  EdgeProcessorOperand (const EdgeProcessorOperand &other);
+
+  /**
+   *  @brief Assignment
+   */
+  EdgeProcessorOperand &operator= (const EdgeProcessorOperand &other);
+
+  /**
+   *  @brief Destructor
+   */
+  ~EdgeProcessorOperand ();
+
+  /**
+   *  @brief Reserve space for at least n edges
+   */
+  void reserve (size_t n);
+
+  /**
+   *  @brief Insert an edge 
+   */
+  void insert (const db::Edge &e, property_type p = 0);
+
+  /**
+   *  @brief Insert a polygon 
+   */
+  void insert (const db::Polygon &q, property_type p = 0);
+
+  /**
+   *  @brief Clear all edges
+   */
+  void clear (); 
+
+  /**
+   *  @brief Gets the number of edges stored 
+   */
+  size_t size () const;
+
+  /**
+   *  @brief Returns true, if no edges are stored
+   */
+  bool empty () const
+  {
+    return size () == 0;
+  }
+
+private:
+  friend class EdgeProcessor;
+
+  mutable std::vector <WorkEdge> *mp_work_edges;
+  mutable bool m_sorted;
+
+  void ensure_sorted () const;
+};
+
 /**
  *  @brief The basic edge processor
  *
@@ -605,6 +686,60 @@ public:
    */
   void disable_progress ();
 
+  /**
+   *  @brief Sets the number of threads to use for processing
+   *
+   *  If this value is 0 (the default), the processing is done in the calling thread.
+   *  Otherwise, the intersection and cut point computations are distributed over the 
+   *  given number of threads and the production of the output (the edge sink) is run in 
+   *  a separate thread. The result is identical to the single-threaded case.
+   */
+  void set_threads (int n);
+
+  /**
+   *  @brief Gets the number of threads to use for processing
+   */
+  int threads () const
+  {
+    return m_threads;
+  }
+
+  /**
+   *  @brief Sets the number of edges collected for the worker threads before they are run
+   *
+   *  In multi-threaded mode, the intersection computation for the 90 degree bands is 
+   *  collected and executed in batches. Smaller batches need less memory, but synchronize
+   *  more often. The default is 1000000. This setting is intended for regression tests 
+   *  mainly.
+   */
+  void set_thread_batch_size (size_t n);
+
+  /**
+   *  @brief Gets the number of edges collected for the worker threads before they are run
+   */
+  size_t thread_batch_size () const
+  {
+    return m_thread_batch_size;
+  }
+
+  /**
+   *  @brief Selects the instruction set for the vectorized parts of the intersection computation
+   *
+   *  0 disables the candidate filters entirely, 1 is plain C++, 2 is SSE2 and 3 is AVX2. 
+   *  If the CPU does not support the requested level, the best available one is used. 
+   *  -1 selects the best available level, which is the default. 
+   *  This setting is intended for regression test and benchmark purposes mainly.
+   */
+  void set_simd_level (int level);
+
+  /**
+   *  @brief Gets the instruction set level for the vectorized parts
+   */
+  int simd_level () const
+  {
+    return m_simd_level;
+  }
+
   /**
    *  @brief Reserve space for at least n edges
    */
@@ -620,6 +755,15 @@ public:
    */
   void insert (const db::Polygon &q, property_type p = 0);
 
+  /**
+   *  @brief Insert the edges of a prepared operand
+   *
+   *  The offset is added to the properties of the prepared operand's edges.
+   *  The processor will take the edges in the sorted form. Hence inserting 
+   *  a prepared operand first is most efficient.
+   */
+  void insert (const EdgeProcessorOperand &op, property_type offset = 0);
+
   /**
    *  @brief Insert a sequence of edges
    *
@@ -940,8 +1084,12 @@ public:
 private:
   std::vector <WorkEdge> *mp_work_edges;
   std::vector <CutPoints> *mp_cpvector;
+  size_t m_presorted;
   bool m_report_progress;
   std::string m_progress_desc;
+  int m_threads;
+  size_t m_thread_batch_size;
+  int m_simd_level;
 
   static size_t count_edges (const db::Polygon &q) 
   {
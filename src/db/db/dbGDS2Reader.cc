@@ -29,10 +29,396 @@
 #include "tlException.h"
 #include "tlString.h"
 #include "tlClassRegistry.h"
+#include "tlThreadedWorkers.h"
+
+#include <memory>
+#include <limits>
 
 namespace db
 {
 
+// ---------------------------------------------------------------
+//  Parallel cell decoding
+
+/**
+ *  @brief A task decoding one cell
+ */
+class GDS2CellReaderTask
+  : public tl::Task
+{
+public:
+  GDS2CellReaderTask (size_t p, GDS2CellContents *c)
+    : pos (p), contents (c)
+  { }
+
+  size_t pos;
+  GDS2CellContents *contents;
+};
+
+/**
+ *  @brief The location of a cell in the file
+ *
+ *  "start" is the position of the STRNAME record, "end" the position behind the
+ *  ENDSTR record. "records" is the number of records following STRNAME.
+ */
+struct GDS2CellLocation
+{
+  GDS2CellLocation (size_t s, size_t e, size_t r)
+    : start (s), end (e), records (r)
+  { }
+
+  size_t start, end, records;
+};
+
+class GDS2ParallelCellReader;
+
+/**
+ *  @brief The worker decoding cells 
+ *
+ *  Each worker has its own reader and decodes the cells into a scratch layout. 
+ *  The scratch layout is replaced for every batch of cells.
+ */
+class GDS2CellReaderWorker
+  : public tl::Worker
+{
+public:
+  GDS2CellReaderWorker (const GDS2ParallelCellReader *parent);
+
+  void reset ();
+  virtual void perform_task (tl::Task *task);
+
+private:
+  const GDS2ParallelCellReader *mp_parent;
+  std::auto_ptr<db::Layout> mp_layout;
+  std::auto_ptr<tl::InputMemoryStream> mp_memory_stream;
+  std::auto_ptr<tl::InputStream> mp_stream;
+  std::auto_ptr<db::GDS2Reader> mp_reader;
+  db::PropertyMapper m_pm;
+
+  void init_reader ();
+};
+
+/**
+ *  @brief The job running the GDS2CellReaderWorker objects
+ */
+class GDS2CellReaderJob
+  : public tl::JobBase
+{
+public:
+  GDS2CellReaderJob (int nworkers, const GDS2ParallelCellReader *parent)
+    : tl::JobBase (nworkers), mp_parent (parent)
+  { }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new GDS2CellReaderWorker (mp_parent);
+  }
+
+  virtual void setup_worker (tl::Worker *worker)
+  {
+    //  the scratch layouts are replaced before a new batch is started
+    static_cast<GDS2CellReaderWorker *> (worker)->reset ();
+  }
+
+private:
+  const GDS2ParallelCellReader *mp_parent;
+};
+
+/**
+ *  @brief A batch of cells decoded by one job
+ *
+ *  Each batch has its own job and hence its own workers and scratch layouts. 
+ *  This way, one batch can be decoded while the cells of the other one are merged.
+ */
+struct GDS2CellBatch
+{
+  GDS2CellBatch (int nthreads, const GDS2ParallelCellReader *parent)
+    : job (nthreads, parent), running (false), next_pos (no_pos ())
+  { }
+
+  ~GDS2CellBatch ()
+  {
+    //  stop the workers before the results are deleted
+    job.terminate ();
+  }
+
+  static size_t no_pos ()
+  {
+    return std::numeric_limits<size_t>::max ();
+  }
+
+  GDS2CellReaderJob job;
+  //  NOTE: declared after the job, so the results are deleted before the scratch layouts
+  std::map<size_t, GDS2CellContents> results;
+  bool running;
+  //  the position of the first cell behind this batch or no_pos () if there is none
+  size_t next_pos;
+};
+
+/**
+ *  @brief The parallel cell reader
+ *
+ *  This object locates the cells by scanning the record headers of the file. 
+ *  The cell bodies are decoded in batches by the worker threads ahead of the 
+ *  sequential reader which then merges the decoded cells in file order.
+ *  While the cells of one batch are merged, the next batch is decoded already.
+ *  Cells which cannot be decoded by the workers are read sequentially.
+ */
+class GDS2ParallelCellReader
+{
+public:
+  GDS2ParallelCellReader (GDS2Reader *reader, int nthreads, bool editable);
+
+  bool init ();
+  const GDS2CellContents *fetch (size_t pos);
+
+  const GDS2Reader &reader () const
+  {
+    return *mp_reader;
+  }
+
+  const char *data () const
+  {
+    return mp_data;
+  }
+
+  size_t size () const
+  {
+    return m_size;
+  }
+
+  bool editable () const
+  {
+    return m_editable;
+  }
+
+private:
+  GDS2Reader *mp_reader;
+  int m_threads;
+  bool m_editable;
+  const char *mp_data;
+  size_t m_size;
+  //  the cells by the position behind the STRNAME record
+  std::map<size_t, GDS2CellLocation> m_cells;
+  //  the batch being merged and the one being decoded in the background
+  std::auto_ptr<GDS2CellBatch> mp_batches [2];
+  unsigned int m_current;
+
+  void start_batch (GDS2CellBatch &batch, std::map<size_t, GDS2CellLocation>::const_iterator c);
+  void finish_batch (GDS2CellBatch &batch);
+};
+
+//  The number of bytes and cells decoded per thread in one batch
+const size_t parallel_reader_batch_bytes = 16 * 1024 * 1024;
+const size_t parallel_reader_batch_cells = 256;
+
+GDS2CellReaderWorker::GDS2CellReaderWorker (const GDS2ParallelCellReader *parent)
+  : tl::Worker (), mp_parent (parent)
+{
+  //  .. nothing yet ..
+}
+
+void 
+GDS2CellReaderWorker::reset ()
+{
+  //  NOTE: this method is called from the main thread, so it is safe to access the parent reader
+  if (! mp_reader.get ()) {
+    init_reader ();
+  } else {
+    //  drops the layer map which refers to the previous scratch layout
+    mp_reader->init_cell_contents_reader (mp_parent->reader ());
+  }
+
+  mp_layout.reset (0);
+  mp_layout.reset (new db::Layout (mp_parent->editable ()));
+
+  m_pm = db::PropertyMapper ();
+  m_pm.set_source (*mp_layout);
+}
+
+void 
+GDS2CellReaderWorker::init_reader ()
+{
+  mp_memory_stream.reset (new tl::InputMemoryStream (mp_parent->data (), mp_parent->size ()));
+  mp_stream.reset (new tl::InputStream (*mp_memory_stream));
+  mp_reader.reset (new db::GDS2Reader (*mp_stream));
+
+  const GDS2Reader &parent_reader = mp_parent->reader ();
+
+  //  errors and warnings make the cell be read sequentially
+  mp_reader->set_warnings_as_errors (true);
+
+  mp_reader->m_options = parent_reader.m_options;
+  mp_reader->init_cell_contents_reader (parent_reader);
+}
+
+void 
+GDS2CellReaderWorker::perform_task (tl::Task *task)
+{
+  GDS2CellReaderTask *cell_task = dynamic_cast<GDS2CellReaderTask *> (task);
+  if (! cell_task) {
+    return;
+  }
+
+  GDS2CellContents &contents = *cell_task->contents;
+  contents.property_mapper = &m_pm;
+
+  try {
+
+    mp_stream->reset ();
+    mp_stream->get (cell_task->pos);
+    mp_reader->m_stored_rec = 0;
+
+    mp_reader->read_cell_contents (*mp_layout, contents);
+
+  } catch (tl::Exception &) {
+    //  the cell will be read sequentially
+    contents.ok = false;
+  }
+}
+
+GDS2ParallelCellReader::GDS2ParallelCellReader (GDS2Reader *reader, int nthreads, bool editable)
+  : mp_reader (reader), m_threads (nthreads), m_editable (editable), mp_data (0), m_size (0), m_current (0)
+{
+  mp_batches [0].reset (new GDS2CellBatch (nthreads, this));
+  mp_batches [1].reset (new GDS2CellBatch (nthreads, this));
+}
+
+bool 
+GDS2ParallelCellReader::init ()
+{
+  mp_data = mp_reader->m_stream.mapped_data (m_size);
+  if (! mp_data) {
+    return false;
+  }
+
+  //  scan the record headers for the cell bodies: this touches the headers only
+  size_t pos = 0;
+  size_t start = 0;
+  size_t records = 0;
+  bool in_cell = false;
+
+  while (pos + 4 <= m_size) {
+
+    const unsigned char *b = (const unsigned char *) mp_data + pos;
+    size_t l = (size_t (b [0]) << 8) | size_t (b [1]);
+    short rec_id = short ((b [2] << 8) | b [3]);
+
+    if (l < 4 || l % 2 != 0 || pos + l > m_size) {
+      //  leave the diagnostics to the sequential reader
+      return false;
+    }
+
+    if (rec_id == sENDLIB) {
+      break;
+    } else if (rec_id == sSTRNAME) {
+      start = pos;
+      records = 0;
+      in_cell = true;
+    } else if (in_cell) {
+      ++records;
+      if (rec_id == sENDSTR) {
+        size_t body_pos = start + ((size_t (mp_data [start] & 0xff) << 8) | size_t (mp_data [start + 1] & 0xff));
+        m_cells.insert (std::make_pair (body_pos, GDS2CellLocation (start, pos + l, records)));
+        in_cell = false;
+      }
+    }
+
+    pos += l;
+
+  }
+
+  return ! m_cells.empty ();
+}
+
+void
+GDS2ParallelCellReader::start_batch (GDS2CellBatch &batch, std::map<size_t, GDS2CellLocation>::const_iterator c)
+{
+  tl_assert (! batch.running);
+
+  batch.results.clear ();
+
+  size_t max_bytes = parallel_reader_batch_bytes * size_t (m_threads);
+  size_t max_cells = parallel_reader_batch_cells * size_t (m_threads);
+  size_t bytes = 0;
+  size_t cells = 0;
+
+  while (c != m_cells.end () && bytes < max_bytes && cells < max_cells) {
+
+    bytes += c->second.end - c->second.start;
+    ++cells;
+
+    GDS2CellContents &contents = batch.results [c->first];
+    contents.end_pos = c->second.end;
+    contents.records = c->second.records;
+    batch.job.schedule (new GDS2CellReaderTask (c->second.start, &contents));
+
+    ++c;
+
+  }
+
+  batch.next_pos = (c != m_cells.end () ? c->first : GDS2CellBatch::no_pos ());
+
+  batch.job.start ();
+  batch.running = true;
+}
+
+void
+GDS2ParallelCellReader::finish_batch (GDS2CellBatch &batch)
+{
+  if (batch.running) {
+    batch.job.wait ();
+    batch.running = false;
+  }
+}
+
+const GDS2CellContents *
+GDS2ParallelCellReader::fetch (size_t pos)
+{
+  GDS2CellBatch *current = mp_batches [m_current].get ();
+
+  std::map<size_t, GDS2CellContents>::const_iterator r = current->results.find (pos);
+  if (r == current->results.end ()) {
+
+    //  the cell is supposed to be in the batch decoded in the background
+    m_current = 1 - m_current;
+    current = mp_batches [m_current].get ();
+    finish_batch (*current);
+
+    r = current->results.find (pos);
+    if (r == current->results.end ()) {
+
+      //  not decoded yet (i.e. the first cell): decode a new batch starting with this cell
+
+      std::map<size_t, GDS2CellLocation>::const_iterator c = m_cells.find (pos);
+      if (c == m_cells.end ()) {
+        return 0;
+      }
+
+      start_batch (*current, c);
+      finish_batch (*current);
+
+      r = current->results.find (pos);
+      tl_assert (r != current->results.end ());
+
+    }
+
+    //  decode the next batch while the cells of the current one are merged
+    //  NOTE: this drops the results of the previous batch which have been merged already
+    if (current->next_pos != GDS2CellBatch::no_pos ()) {
+      start_batch (*mp_batches [1 - m_current], m_cells.find (current->next_pos));
+    }
+
+  }
+
+  if (r->second.ok) {
+    return &r->second;
+  } else {
+    return 0;
+  }
+}
+
 // ---------------------------------------------------------------
 //  GDS2Reader
 
@@ -43,7 +429,8 @@ GDS2Reader::GDS2Reader (tl::InputStream &s)
     m_recptr (0),
     mp_rec_buf (0),
     m_stored_rec (0),
-    m_progress (tl::to_string (QObject::tr ("Reading GDS2 file")), 10000)
+    m_progress (tl::to_string (QObject::tr ("Reading GDS2 file")), 10000),
+    mp_parallel_reader (0)
 {
   m_progress.set_format (tl::to_string (QObject::tr ("%.0f MB")));
   m_progress.set_unit (1024 * 1024);
@@ -64,7 +451,25 @@ GDS2Reader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
   --m_recnum;
   m_reclen = 0;
 
-  return basic_read (layout, m_common_options.layer_map, m_common_options.create_other_layers, m_common_options.enable_text_objects, m_common_options.enable_properties, m_options.allow_multi_xy_records, m_options.box_mode);
+  //  prepare the parallel cell decoder if requested and possible
+  std::auto_ptr<GDS2ParallelCellReader> parallel_reader;
+  if (m_options.read_threads > 0) {
+    parallel_reader.reset (new GDS2ParallelCellReader (this, m_options.read_threads, layout.is_editable ()));
+    if (! parallel_reader->init ()) {
+      parallel_reader.reset (0);
+    }
+  }
+
+  mp_parallel_reader = parallel_reader.get ();
+
+  try {
+    const LayerMap &lm = basic_read (layout, m_common_options.layer_map, m_common_options.create_other_layers, m_common_options.enable_text_objects, m_common_options.enable_properties, m_options.allow_multi_xy_records, m_options.box_mode);
+    mp_parallel_reader = 0;
+    return lm;
+  } catch (...) {
+    mp_parallel_reader = 0;
+    throw;
+  }
 }
 
 const LayerMap &
@@ -250,6 +655,31 @@ GDS2Reader::get_xy_data (unsigned int &length)
   return (GDS2XY *) mp_rec_buf;
 }
 
+bool
+GDS2Reader::read_prefetched_cell (db::Layout &layout, db::cell_index_type cell_index)
+{
+  if (! mp_parallel_reader || m_stored_rec) {
+    return false;
+  }
+
+  const GDS2CellContents *contents = mp_parallel_reader->fetch (m_stream.pos ());
+  if (! contents || contents->name != cellname ().c_str ()) {
+    return false;
+  }
+
+  merge_cell_contents (cell_index, layout, *contents);
+
+  //  continue behind the cell
+  size_t pos = m_stream.pos ();
+  if (contents->end_pos > pos) {
+    m_stream.get (contents->end_pos - pos);
+  }
+  m_recnum += contents->records;
+
+  m_progress.set (m_stream.pos ());
+  return true;
+}
+
 void  
 GDS2Reader::progress_checkpoint () 
 {
@@ -265,12 +695,16 @@ GDS2Reader::error (const std::string &msg)
 void 
 GDS2Reader::warn (const std::string &msg) 
 {
-  // TODO: compress
-  tl::warn << msg 
-           << tl::to_string (QObject::tr (" (position=")) << m_stream.pos ()
-           << tl::to_string (QObject::tr (", record number=")) << m_recnum
-           << tl::to_string (QObject::tr (", cell=")) << cellname ().c_str ()
-           << ")";
+  if (warnings_as_errors ()) {
+    error (msg);
+  } else {
+    // TODO: compress
+    tl::warn << msg 
+             << tl::to_string (QObject::tr (" (position=")) << m_stream.pos ()
+             << tl::to_string (QObject::tr (", record number=")) << m_recnum
+             << tl::to_string (QObject::tr (", cell=")) << cellname ().c_str ()
+             << ")";
+  }
 }
 
 }
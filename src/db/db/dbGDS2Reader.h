@@ -53,7 +53,8 @@ public:
   GDS2ReaderOptions ()
     : box_mode (1),
       allow_big_records (true),
-      allow_multi_xy_records (true)
+      allow_multi_xy_records (true),
+      read_threads (0)
   {
     //  .. nothing yet ..
   }
@@ -83,6 +84,17 @@ public:
    */
   bool allow_multi_xy_records;
 
+  /**
+   *  @brief The number of threads to use for decoding the cells
+   *
+   *  If this value is larger than 0, the reader will decode the cell bodies on
+   *  the given number of threads. This is possible if the file can be accessed
+   *  randomly (i.e. is an uncompressed local file). Otherwise the file is read
+   *  sequentially.
+   *  The default value is 0 (sequential reading).
+   */
+  int read_threads;
+
   /** 
    *  @brief Implementation of FormatSpecificReaderOptions
    */
@@ -113,6 +125,8 @@ public:
   { }
 };
 
+class GDS2ParallelCellReader;
+
 /**
  *  @brief The GDS2 format stream reader
  */
@@ -170,6 +184,9 @@ public:
   virtual const char *format () const { return "GDS2"; }
 
 private:
+  friend class GDS2CellReaderWorker;
+  friend class GDS2ParallelCellReader;
+
   tl::InputStream &m_stream;
   size_t m_recnum;
   size_t m_reclen;
@@ -180,6 +197,7 @@ private:
   db::GDS2ReaderOptions m_options;
   db::CommonReaderOptions m_common_options;
   tl::AbsoluteProgress m_progress;
+  GDS2ParallelCellReader *mp_parallel_reader;
 
   virtual void error (const std::string &txt);
   virtual void warn (const std::string &txt);
@@ -195,6 +213,7 @@ private:
   virtual void get_time (unsigned int *mod_time, unsigned int *access_time);
   virtual GDS2XY *get_xy_data (unsigned int &length);
   virtual void progress_checkpoint ();
+  virtual bool read_prefetched_cell (db::Layout &layout, db::cell_index_type cell_index);
 };
 
 }
@@ -73,7 +73,9 @@ GDS2ReaderBase::GDS2ReaderBase ()
     m_read_texts (true),
     m_read_properties (true),
     m_allow_multi_xy_records (false),
-    m_box_mode (0)
+    m_box_mode (0),
+    m_plain_shapes (false),
+    mp_cell_contents (0)
 {
   // .. nothing yet ..
 }
@@ -177,28 +179,24 @@ std::pair <bool, unsigned int>
 GDS2ReaderBase::open_dl (db::Layout &layout, const LDPair &dl, bool create) 
 {
   std::pair<bool, unsigned int> ll = m_layer_map.logical (dl);
-  if (ll.first) {
-
-    return ll;
-
-  } else if (! create) {
-
-    //  layer not mapped and no layer create is requested
-    return ll;
-
-  } else {
+  if (! ll.first && create) {
 
     //  and create the layer
     db::LayerProperties lp;
     lp.layer = dl.layer;
     lp.datatype = dl.datatype;
 
-    unsigned int ll = layout.insert_layer (lp);
-    m_layer_map.map (dl, ll, lp);
+    ll.first = true;
+    ll.second = layout.insert_layer (lp);
+    m_layer_map.map (dl, ll.second, lp);
 
-    return std::make_pair (true, ll);
+  }
 
+  if (ll.first && mp_cell_contents) {
+    mp_cell_contents->add_layer (ll.second);
   }
+
+  return ll;
 }
 
 inline db::Point 
@@ -238,6 +236,11 @@ GDS2ReaderBase::do_read (db::Layout &layout)
   m_cellname = "";
   m_libname = "";
 
+  //  When the cells are delivered to a cell sink, their content is released after they have
+  //  been written. Shapes stored in the layout's shape repository would not be released, hence
+  //  plain shapes are created in that case.
+  m_plain_shapes = (cell_sink () != 0);
+
   //  read header
   if (get_record () != sHEADER) {
     error (tl::to_string (QObject::tr ("HEADER record expected")));
@@ -373,92 +376,243 @@ GDS2ReaderBase::do_read (db::Layout &layout)
         }
       }
       
-      long attr = 0;
-      db::PropertiesRepository::properties_set cell_properties;
+      if (cell && read_prefetched_cell (layout, cell_index)) {
 
-      //  read cell content
-      while ((rec_id = get_record ()) != sENDSTR) { 
+        //  the cell body has been decoded in advance and is merged already
 
-        progress_checkpoint ();
-
-        if (cell == 0) {
+      } else {
 
-          //  ignore everything in proxy cells: these are created from the libraries or PCell's.
+        read_cell_body (layout, cell, instances, instances_with_props);
 
-        } else if (rec_id == sPROPATTR) {
+        //  insert all instances collected
+        if (cell && ! instances.empty ()) {
+          cell->insert (instances.begin (), instances.end ());
+        }
+        if (cell && ! instances_with_props.empty ()) {
+          cell->insert (instances_with_props.begin (), instances_with_props.end ());
+        }
 
-          attr = long (get_ushort ());
+      }
 
-        } else if (rec_id == sPROPVALUE) {
+      //  the cell is complete now
+      cell_finished (layout, cell_index);
 
-          const char *value = get_string ();
-          if (m_read_properties) {
-            cell_properties.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant (attr)), tl::Variant (value)));
-          }
+    }
 
-        } else if (rec_id == sBOUNDARY) {
+    m_cellname = "";
+    first_cell = false;
 
-          read_boundary (layout, *cell, false);
+  }
 
-        } else if (rec_id == sPATH) {
+  //  check, if the last record is a ENDLIB
+  if (rec_id != sENDLIB) {
+    error (tl::to_string (QObject::tr ("ENDLIB record expected")));
+  }
+}
 
-          read_path (layout, *cell);
+void
+GDS2ReaderBase::read_cell_body (db::Layout &layout, db::Cell *cell, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props)
+{
+  short rec_id = 0;
 
-        } else if (rec_id == sSREF || rec_id == sAREF) {
+  long attr = 0;
+  db::PropertiesRepository::properties_set cell_properties;
 
-          bool array = (rec_id == sAREF);
-          read_ref (layout, *cell, array, instances, instances_with_props);
+  //  read cell content
+  while ((rec_id = get_record ()) != sENDSTR) { 
 
-        } else if (rec_id == sTEXT) {
+    progress_checkpoint ();
 
-          read_text (layout, *cell);
+    if (cell == 0) {
 
-        } else if (rec_id == sBOX) {
+      //  ignore everything in proxy cells: these are created from the libraries or PCell's.
 
-          if (m_box_mode == 1) {
-            read_box (layout, *cell);
-          } else if (m_box_mode == 2) {
-            read_boundary (layout, *cell, true);
-          } else if (m_box_mode == 3) {
-            error (tl::to_string (QObject::tr ("BOX record encountered (reader is configured to produce an error in this case)")));
-          } else {
-            while (get_record () != sENDEL) { }
-          }
+    } else if (rec_id == sPROPATTR) {
 
-        } else if (rec_id == sNODE) {
+      attr = long (get_ushort ());
 
-          //  NODE records are ignored.
-          while (get_record () != sENDEL) { }
+    } else if (rec_id == sPROPVALUE) {
 
-        } else {
-          error (tl::to_string (QObject::tr ("Invalid record or data type")));
-        }
-      
+      const char *value = get_string ();
+      if (m_read_properties) {
+        cell_properties.insert (std::make_pair (layout.properties_repository ().prop_name_id (tl::Variant (attr)), tl::Variant (value)));
       }
 
-      //  insert all instances collected
-      if (! instances.empty ()) {
-        cell->insert (instances.begin (), instances.end ());
-      }
-      if (! instances_with_props.empty ()) {
-        cell->insert (instances_with_props.begin (), instances_with_props.end ());
-      }
+    } else if (rec_id == sBOUNDARY) {
+
+      read_boundary (layout, *cell, false);
+
+    } else if (rec_id == sPATH) {
+
+      read_path (layout, *cell);
+
+    } else if (rec_id == sSREF || rec_id == sAREF) {
+
+      bool array = (rec_id == sAREF);
+      read_ref (layout, *cell, array, instances, instances_with_props);
+
+    } else if (rec_id == sTEXT) {
 
-      //  set the cell properties
-      if (! cell_properties.empty ()) {
-        cell->prop_id (layout.properties_repository ().properties_id (cell_properties));
+      read_text (layout, *cell);
+
+    } else if (rec_id == sBOX) {
+
+      if (m_box_mode == 1) {
+        read_box (layout, *cell);
+      } else if (m_box_mode == 2) {
+        read_boundary (layout, *cell, true);
+      } else if (m_box_mode == 3) {
+        error (tl::to_string (QObject::tr ("BOX record encountered (reader is configured to produce an error in this case)")));
+      } else {
+        while (get_record () != sENDEL) { }
       }
 
+    } else if (rec_id == sNODE) {
+
+      //  NODE records are ignored.
+      while (get_record () != sENDEL) { }
+
+    } else {
+      error (tl::to_string (QObject::tr ("Invalid record or data type")));
     }
+  
+  }
 
-    m_cellname = "";
-    first_cell = false;
+  //  set the cell properties
+  if (cell && ! cell_properties.empty ()) {
+    cell->prop_id (layout.properties_repository ().properties_id (cell_properties));
+  }
+}
+
+void
+GDS2ReaderBase::init_cell_contents_reader (const GDS2ReaderBase &parent)
+{
+  m_dbu = parent.m_dbu;
+  m_dbuu = parent.m_dbuu;
+  m_read_texts = parent.m_read_texts;
+  m_read_properties = parent.m_read_properties;
+  m_allow_multi_xy_records = parent.m_allow_multi_xy_records;
+  m_box_mode = parent.m_box_mode;
+  m_plain_shapes = parent.m_plain_shapes;
+
+  //  the layers are mapped when the cell is merged into the target layout
+  m_layer_map = db::LayerMap ();
+  m_create_layers = true;
+}
 
+void
+GDS2ReaderBase::read_cell_contents (db::Layout &layout, GDS2CellContents &contents)
+{
+  contents.ok = false;
+
+  if (get_record () != sSTRNAME) {
+    error (tl::to_string (QObject::tr ("STRNAME record expected")));
   }
 
-  //  check, if the last record is a ENDLIB
-  if (rec_id != sENDLIB) {
-    error (tl::to_string (QObject::tr ("ENDLIB record expected")));
+  get_string (m_cellname);
+  contents.name = std::string (m_cellname.c_str ());
+
+  db::cell_index_type cell_index;
+
+  std::pair<bool, db::cell_index_type> c = layout.cell_by_name (m_cellname.c_str ());
+  if (c.first) {
+    //  a cell defined twice in the same batch can only be handled by the sequential reader
+    if (! layout.cell (c.second).is_ghost_cell ()) {
+      error (tl::to_string (QObject::tr ("Cell is defined multiple times")));
+    }
+    cell_index = c.second;
+    layout.cell (cell_index).set_ghost_cell (false);
+  } else {
+    cell_index = layout.add_cell (m_cellname.c_str ());
+  }
+
+  contents.layout = &layout;
+  contents.cell_index = cell_index;
+
+  mp_cell_contents = &contents;
+  try {
+    read_cell_body (layout, &layout.cell (cell_index), contents.instances, contents.instances_with_props);
+    mp_cell_contents = 0;
+  } catch (...) {
+    mp_cell_contents = 0;
+    throw;
+  }
+
+  m_cellname = "";
+  contents.ok = true;
+}
+
+void
+GDS2ReaderBase::merge_cell_contents (db::cell_index_type cell_index, db::Layout &layout, const GDS2CellContents &contents)
+{
+  const db::Layout &source_layout = *contents.layout;
+  const db::Cell &source_cell = source_layout.cell (contents.cell_index);
+
+  db::PropertyMapper &pm = *contents.property_mapper;
+  pm.set_target (layout);
+
+  //  resolve the cell references in the order they appear in the file
+  std::map<db::cell_index_type, db::cell_index_type> cell_map;
+  for (std::vector<db::cell_index_type>::const_iterator r = contents.references.begin (); r != contents.references.end (); ++r) {
+
+    const char *cn = source_layout.cell_name (*r);
+
+    db::cell_index_type ci;
+    std::pair<bool, db::cell_index_type> c = layout.cell_by_name (cn);
+    if (c.first) {
+      ci = c.second;
+    } else {
+      ci = layout.add_cell (cn);
+      //  mark this cell a "ghost cell" until it's actually read
+      layout.cell (ci).set_ghost_cell (true);
+    }
+
+    cell_map.insert (std::make_pair (*r, ci));
+
+  }
+
+  db::Cell &cell = layout.cell (cell_index);
+
+  //  take the shapes
+  for (std::vector<unsigned int>::const_iterator l = contents.layers.begin (); l != contents.layers.end (); ++l) {
+    const db::LayerProperties &lp = source_layout.get_properties (*l);
+    std::pair<bool, unsigned int> ll = open_dl (layout, LDPair (lp.layer, lp.datatype), m_create_layers);
+    if (ll.first) {
+      cell.shapes (ll.second).insert (source_cell.shapes (*l), pm);
+    }
+  }
+
+  if (source_cell.prop_id () != 0) {
+    cell.prop_id (pm (source_cell.prop_id ()));
+  }
+
+  //  take the instances
+  if (! contents.instances.empty ()) {
+
+    tl::vector<db::CellInstArray> instances;
+    instances.reserve (contents.instances.size ());
+
+    for (tl::vector<db::CellInstArray>::const_iterator i = contents.instances.begin (); i != contents.instances.end (); ++i) {
+      instances.push_back (db::CellInstArray (*i, i->in_repository () ? &layout.array_repository () : 0));
+      instances.back ().object () = db::CellInst (cell_map [i->object ().cell_index ()]);
+    }
+
+    cell.insert (instances.begin (), instances.end ());
+
+  }
+
+  if (! contents.instances_with_props.empty ()) {
+
+    tl::vector<db::CellInstArrayWithProperties> instances;
+    instances.reserve (contents.instances_with_props.size ());
+
+    for (tl::vector<db::CellInstArrayWithProperties>::const_iterator i = contents.instances_with_props.begin (); i != contents.instances_with_props.end (); ++i) {
+      instances.push_back (db::CellInstArrayWithProperties (db::CellInstArray (*i, i->in_repository () ? &layout.array_repository () : 0), pm (i->properties_id ())));
+      instances.back ().object () = db::CellInst (cell_map [i->object ().cell_index ()]);
+    }
+
+    cell.insert (instances.begin (), instances.end ());
+
   }
 }
 
@@ -649,7 +803,13 @@ GDS2ReaderBase::read_boundary (db::Layout &layout, db::Cell &cell, bool from_box
       } else {
         //  this will copy the polyon:
         std::pair<bool, db::properties_id_type> pp = finish_element (layout.properties_repository ());
-        if (pp.first) {
+        if (m_plain_shapes) {
+          if (pp.first) {
+            cell.shapes (ll.second).insert (db::SimplePolygonWithProperties (poly, pp.second));
+          } else {
+            cell.shapes (ll.second).insert (poly);
+          }
+        } else if (pp.first) {
           cell.shapes (ll.second).insert (db::SimplePolygonRefWithProperties (db::SimplePolygonRef (poly, layout.shape_repository ()), pp.second));
         } else {
           cell.shapes (ll.second).insert (db::SimplePolygonRef (poly, layout.shape_repository ()));
@@ -786,7 +946,13 @@ GDS2ReaderBase::read_path (db::Layout &layout, db::Cell &cell)
         warn (tl::to_string (QObject::tr ("PATH with less than two points encountered - interpretation may be different in other tools")));
       }
       std::pair<bool, db::properties_id_type> pp = finish_element (layout.properties_repository ());
-      if (pp.first) {
+      if (m_plain_shapes) {
+        if (pp.first) {
+          cell.shapes (ll.second).insert (db::PathWithProperties (path, pp.second));
+        } else {
+          cell.shapes (ll.second).insert (path);
+        }
+      } else if (pp.first) {
         cell.shapes (ll.second).insert (db::PathRefWithProperties (db::PathRef (path, layout.shape_repository ()), pp.second));
       } else {
         cell.shapes (ll.second).insert (db::PathRef (path, layout.shape_repository ()));
@@ -922,7 +1088,13 @@ GDS2ReaderBase::read_text (db::Layout &layout, db::Cell &cell)
     db::Text text (get_string (), t, size, font, ha, va);
 
     std::pair<bool, db::properties_id_type> pp = finish_element (layout.properties_repository ());
-    if (pp.first) {
+    if (m_plain_shapes) {
+      if (pp.first) {
+        cell.shapes (ll.second).insert (db::TextWithProperties (text, pp.second));
+      } else {
+        cell.shapes (ll.second).insert (text);
+      }
+    } else if (pp.first) {
       cell.shapes (ll.second).insert (db::TextRefWithProperties (db::TextRef (text, layout.shape_repository ()), pp.second));
     } else {
       cell.shapes (ll.second).insert (db::TextRef (text, layout.shape_repository ()));
@@ -1011,6 +1183,10 @@ GDS2ReaderBase::read_ref (db::Layout &layout, db::Cell & /*cell*/, bool array, t
     }
   }
 
+  if (mp_cell_contents) {
+    mp_cell_contents->add_reference (ci);
+  }
+
   bool mirror = false;
   int angle = 0;
   double angle_deg = 0.0;
@@ -34,6 +34,10 @@
 #include "dbReader.h"
 #include "tlStream.h"
 #include "dbStreamLayers.h"
+#include "dbLayoutUtils.h"
+
+#include <set>
+#include <algorithm>
 
 
 namespace db
@@ -45,6 +49,49 @@ struct GDS2XY
   unsigned char y[4];
 };
 
+/**
+ *  @brief The decoded body of a cell
+ *
+ *  This structure is used by the parallel reader: the shapes and the cell properties
+ *  are kept in a scratch layout. Layers, instances and references refer to this layout.
+ *  The references are listed in the order they first appear in the cell, so they can be
+ *  resolved in the same order than by the sequential reader. "end_pos" is the position
+ *  behind the ENDSTR record and "records" is the number of records of the cell body.
+ */
+struct GDS2CellContents
+{
+  GDS2CellContents ()
+    : ok (false), end_pos (0), records (0), layout (0), property_mapper (0), cell_index (0)
+  { }
+
+  void add_layer (unsigned int l)
+  {
+    if ((layers.empty () || layers.back () != l) && std::find (layers.begin (), layers.end (), l) == layers.end ()) {
+      layers.push_back (l);
+    }
+  }
+
+  void add_reference (db::cell_index_type ci)
+  {
+    if (referenced_cells.insert (ci).second) {
+      references.push_back (ci);
+    }
+  }
+
+  bool ok;
+  std::string name;
+  size_t end_pos;
+  size_t records;
+  const db::Layout *layout;
+  db::PropertyMapper *property_mapper;
+  db::cell_index_type cell_index;
+  std::vector<unsigned int> layers;
+  std::vector<db::cell_index_type> references;
+  std::set<db::cell_index_type> referenced_cells;
+  tl::vector<db::CellInstArray> instances;
+  tl::vector<db::CellInstArrayWithProperties> instances_with_props;
+};
+
 /**
  *  @brief The GDS2 format basic stream reader
  */
@@ -95,6 +142,42 @@ protected:
    */
   const tl::string &cellname () const { return m_cellname; }
 
+  /**
+   *  @brief Takes the reader configuration from another reader
+   *
+   *  This method prepares a reader for decoding cell bodies with "read_cell_contents".
+   *  The layer mapping is not taken - the layers are created on demand and mapped
+   *  when the cell is merged.
+   */
+  void init_cell_contents_reader (const GDS2ReaderBase &parent);
+
+  /**
+   *  @brief Decodes a cell body into a scratch layout
+   *
+   *  The stream must be positioned at the STRNAME record of the cell. The method
+   *  throws an exception if the cell cannot be decoded.
+   */
+  void read_cell_contents (db::Layout &layout, GDS2CellContents &contents);
+
+  /**
+   *  @brief Merges a cell decoded by "read_cell_contents" into the given cell
+   */
+  void merge_cell_contents (db::cell_index_type cell_index, db::Layout &layout, const GDS2CellContents &contents);
+
+  /**
+   *  @brief Reads a cell which has been decoded in advance
+   *
+   *  This method is called when the reader is positioned behind the STRNAME record of
+   *  a cell. If the cell body has been decoded already, the implementation is supposed
+   *  to merge the body into the given cell, to position the stream behind the ENDSTR
+   *  record and return true. The default implementation returns false, so the cell is
+   *  read sequentially.
+   */
+  virtual bool read_prefetched_cell (db::Layout & /*layout*/, db::cell_index_type /*cell_index*/)
+  {
+    return false;
+  }
+
 private:
   friend class GDS2ReaderLayerMapping;
 
@@ -107,10 +190,13 @@ private:
   bool m_read_properties;
   bool m_allow_multi_xy_records;
   unsigned int m_box_mode;
+  bool m_plain_shapes;
   std::map <tl::string, std::vector<std::string> > m_context_info;
   std::vector <db::Point> m_all_points;
+  GDS2CellContents *mp_cell_contents;
 
   void read_context_info_cell ();
+  void read_cell_body (db::Layout &layout, db::Cell *cell, tl::vector<db::CellInstArray> &instances, tl::vector<db::CellInstArrayWithProperties> &instances_with_props);
   void read_boundary (db::Layout &layout, db::Cell &cell, bool from_box_record);
   void read_path (db::Layout &layout, db::Cell &cell);
   void read_text (db::Layout &layout, db::Cell &cell);
@@ -46,8 +46,11 @@ namespace db
 //  GDS2WriterBase implementation
 
 GDS2WriterBase::GDS2WriterBase ()
+  : m_dbu (0.0), m_sf (1.0)
 {
-  // .. nothing yet ..
+  for (unsigned int i = 0; i < sizeof (m_time_data) / sizeof (m_time_data [0]); ++i) {
+    m_time_data [i] = 0;
+  }
 }
 
 static int safe_scale (double sf, int value)
@@ -72,69 +75,100 @@ inline int scale (double sf, int value)
 }
 
 void
-GDS2WriterBase::write (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options)
+GDS2WriterBase::init (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options)
 {
   set_stream (stream);
 
-  double dbu = (options.dbu () == 0.0) ? layout.dbu () : options.dbu ();
-  double sf = options.scale_factor () * (layout.dbu () / dbu);
-  if (fabs (sf - 1.0) < 1e-9) {
+  m_dbu = (options.dbu () == 0.0) ? layout.dbu () : options.dbu ();
+  m_sf = options.scale_factor () * (layout.dbu () / m_dbu);
+  if (fabs (m_sf - 1.0) < 1e-9) {
     //  to avoid rounding problems, set to 1.0 exactly if possible.
-    sf = 1.0;
+    m_sf = 1.0;
   }
 
-  db::GDS2WriterOptions gds2_options = options.get_options<db::GDS2WriterOptions> ();
-
-  layout.add_meta_info (MetaInfo ("dbuu", tl::to_string (QObject::tr ("Database unit in user units")), tl::to_string (dbu / std::max (1e-9, gds2_options.user_units))));
-  layout.add_meta_info (MetaInfo ("dbum", tl::to_string (QObject::tr ("Database unit in meter")), tl::to_string (dbu * 1e-6)));
-  layout.add_meta_info (MetaInfo ("libname", tl::to_string (QObject::tr ("Library name")), gds2_options.libname));
+  m_gds2_options = options.get_options<db::GDS2WriterOptions> ();
 
-  std::vector <std::pair <unsigned int, db::LayerProperties> > layers;
-  options.get_valid_layers (layout, layers, db::SaveLayoutOptions::LP_AssignNumber);
-
-  std::set <db::cell_index_type> cell_set;
-  options.get_cells (layout, cell_set, layers);
-
-  //  create a cell index vector sorted bottom-up
-  std::vector <db::cell_index_type> cells;
-  cells.reserve (cell_set.size ());
-
-  for (db::Layout::bottom_up_const_iterator cell = layout.begin_bottom_up (); cell != layout.end_bottom_up (); ++cell) {
-    if (cell_set.find (*cell) != cell_set.end ()) {
-      cells.push_back (*cell);
-    }
-  }
+  layout.add_meta_info (MetaInfo ("dbuu", tl::to_string (QObject::tr ("Database unit in user units")), tl::to_string (m_dbu / std::max (1e-9, m_gds2_options.user_units))));
+  layout.add_meta_info (MetaInfo ("dbum", tl::to_string (QObject::tr ("Database unit in meter")), tl::to_string (m_dbu * 1e-6)));
+  layout.add_meta_info (MetaInfo ("libname", tl::to_string (QObject::tr ("Library name")), m_gds2_options.libname));
 
   //  get current time
-  short time_data [6] = { 0, 0, 0, 0, 0, 0 };
-  if (gds2_options.write_timestamps) {
+  for (unsigned int i = 0; i < sizeof (m_time_data) / sizeof (m_time_data [0]); ++i) {
+    m_time_data [i] = 0;
+  }
+  if (m_gds2_options.write_timestamps) {
     time_t ti = 0;
     time (&ti);
     const struct tm *t = localtime (&ti);
     if (t) {
-      time_data[0] = t->tm_year + 1900;
-      time_data[1] = t->tm_mon + 1;
-      time_data[2] = t->tm_mday;
-      time_data[3] = t->tm_hour;
-      time_data[4] = t->tm_min;
-      time_data[5] = t->tm_sec;
+      m_time_data[0] = t->tm_year + 1900;
+      m_time_data[1] = t->tm_mon + 1;
+      m_time_data[2] = t->tm_mday;
+      m_time_data[3] = t->tm_hour;
+      m_time_data[4] = t->tm_min;
+      m_time_data[5] = t->tm_sec;
     }
   }
 
-  std::string str_time = tl::sprintf ("%d/%d/%d %d:%02d:%02d", time_data[1], time_data[2], time_data[0], time_data[3], time_data[4], time_data[5]); 
+  std::string str_time = tl::sprintf ("%d/%d/%d %d:%02d:%02d", m_time_data[1], m_time_data[2], m_time_data[0], m_time_data[3], m_time_data[4], m_time_data[5]); 
   layout.add_meta_info (MetaInfo ("mod_time", tl::to_string (QObject::tr ("Modification Time")), str_time));
   layout.add_meta_info (MetaInfo ("access_time", tl::to_string (QObject::tr ("Access Time")), str_time));
 
-  bool multi_xy = gds2_options.multi_xy_records;
-  size_t max_cellname_length = std::max (gds2_options.max_cellname_length, (unsigned int)8);
-  size_t max_vertex_count = std::max (gds2_options.max_vertex_count, (unsigned int)4);
-  bool no_zero_length_paths = gds2_options.no_zero_length_paths;
+  size_t max_cellname_length = std::max (m_gds2_options.max_cellname_length, (unsigned int)8);
 
   m_cell_name_map = db::WriterCellNameMap (max_cellname_length);
   m_cell_name_map.replacement ('$');
   m_cell_name_map.disallow_all ();
   //  TODO: restrict character set, i.e allow_standard and "$"
   m_cell_name_map.allow_all_printing ();
+}
+
+void
+GDS2WriterBase::write_header (const db::Layout &layout)
+{
+  write_record_size (6);
+  write_record (sHEADER);
+  write_short (600);
+
+  write_record_size (4 + 12 * 2);
+  write_record (sBGNLIB);
+  write_time (m_time_data);
+  write_time (m_time_data);
+
+  write_string_record (sLIBNAME, m_gds2_options.libname);
+
+  write_record_size (4 + 8 * 2);
+  write_record (sUNITS);
+  write_double (m_dbu / std::max (1e-9, m_gds2_options.user_units));
+  write_double (m_dbu * 1e-6);
+
+  //  layout properties 
+
+  if (m_gds2_options.write_file_properties && layout.prop_id () != 0) {
+    write_properties (layout, layout.prop_id ());
+  }
+}
+
+void
+GDS2WriterBase::write (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options)
+{
+  init (layout, stream, options);
+
+  std::vector <std::pair <unsigned int, db::LayerProperties> > layers;
+  options.get_valid_layers (layout, layers, db::SaveLayoutOptions::LP_AssignNumber);
+
+  std::set <db::cell_index_type> cell_set;
+  options.get_cells (layout, cell_set, layers);
+
+  //  create a cell index vector sorted bottom-up
+  std::vector <db::cell_index_type> cells;
+  cells.reserve (cell_set.size ());
+
+  for (db::Layout::bottom_up_const_iterator cell = layout.begin_bottom_up (); cell != layout.end_bottom_up (); ++cell) {
+    if (cell_set.find (*cell) != cell_set.end ()) {
+      cells.push_back (*cell);
+    }
+  }
 
   //  For keep instances we need to map all cells since all can be present as instances.
   //  We use top-down assignment to make "upper cells less modified".
@@ -152,27 +186,7 @@ GDS2WriterBase::write (db::Layout &layout, tl::OutputStream &stream, const db::S
 
   //  write header
 
-  write_record_size (6);
-  write_record (sHEADER);
-  write_short (600);
-
-  write_record_size (4 + 12 * 2);
-  write_record (sBGNLIB);
-  write_time (time_data);
-  write_time (time_data);
-
-  write_string_record (sLIBNAME, gds2_options.libname);
-
-  write_record_size (4 + 8 * 2);
-  write_record (sUNITS);
-  write_double (dbu / std::max (1e-9, gds2_options.user_units));
-  write_double (dbu * 1e-6);
-
-  //  layout properties 
-
-  if (gds2_options.write_file_properties && layout.prop_id () != 0) {
-    write_properties (layout, layout.prop_id ());
-  }
+  write_header (layout);
 
   //  write context info
   
@@ -191,8 +205,8 @@ GDS2WriterBase::write (db::Layout &layout, tl::OutputStream &stream, const db::S
 
     write_record_size (4 + 12 * 2);
     write_record (sBGNSTR);
-    write_time (time_data);
-    write_time (time_data);
+    write_time (m_time_data);
+    write_time (m_time_data);
 
     write_string_record (sSTRNAME, "$$$CONTEXT_INFO$$$");
 
@@ -247,6 +261,8 @@ GDS2WriterBase::write (db::Layout &layout, tl::OutputStream &stream, const db::S
 
   //  body
 
+  const std::set <db::cell_index_type> *inst_cell_set = options.keep_instances () ? 0 : &cell_set;
+
   for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
 
     progress_checkpoint ();
@@ -256,86 +272,136 @@ GDS2WriterBase::write (db::Layout &layout, tl::OutputStream &stream, const db::S
     //  don't write ghost cells unless they are not empty (any more)
     //  also don't write proxy cells which are not employed
     if ((! cref.is_ghost_cell () || ! cref.empty ()) && (! cref.is_proxy () || ! cref.is_top ())) {
+      write_cell_body (layout, cref, layers, inst_cell_set);
+    }
+
+  }
+
+  write_record_size (4);
+  write_record (sENDLIB);
 
-      //  cell header 
+  progress_checkpoint ();
+}
+
+void
+GDS2WriterBase::write_cell_body (const db::Layout &layout, const db::Cell &cref, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, const std::set <db::cell_index_type> *cell_set)
+{
+  bool multi_xy = m_gds2_options.multi_xy_records;
+  size_t max_vertex_count = std::max (m_gds2_options.max_vertex_count, (unsigned int)4);
+  bool no_zero_length_paths = m_gds2_options.no_zero_length_paths;
 
-      write_record_size (4 + 12 * 2);
-      write_record (sBGNSTR);
-      write_time (time_data);
-      write_time (time_data);
+  //  cell header 
 
-      write_string_record (sSTRNAME, m_cell_name_map.cell_name (*cell));
+  write_record_size (4 + 12 * 2);
+  write_record (sBGNSTR);
+  write_time (m_time_data);
+  write_time (m_time_data);
 
-      //  cell body 
+  write_string_record (sSTRNAME, m_cell_name_map.cell_name (cref.cell_index ()));
 
-      if (gds2_options.write_cell_properties && cref.prop_id () != 0) {
-        write_properties (layout, cref.prop_id ());
-      }
+  //  cell body 
 
-      //  instances
-      
-      for (db::Cell::const_iterator inst = cref.begin (); ! inst.at_end (); ++inst) {
+  if (m_gds2_options.write_cell_properties && cref.prop_id () != 0) {
+    write_properties (layout, cref.prop_id ());
+  }
 
-        //  write only instances to selected cells
-        if (options.keep_instances () || cell_set.find (inst->cell_index ()) != cell_set.end ()) {
+  //  instances
+  
+  for (db::Cell::const_iterator inst = cref.begin (); ! inst.at_end (); ++inst) {
 
-          progress_checkpoint ();
-          write_inst (sf, *inst, true /*normalize*/, layout, inst->prop_id ());
+    //  write only instances to selected cells
+    if (! cell_set || cell_set->find (inst->cell_index ()) != cell_set->end ()) {
 
-        }
+      progress_checkpoint ();
+      write_inst (m_sf, *inst, true /*normalize*/, layout, inst->prop_id ());
 
-      }
+    }
+
+  }
 
-      //  shapes
-
-      for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
-   
-        if (layout.is_valid_layer (l->first)) {
-
-          int layer = l->second.layer;
-          int datatype = l->second.datatype;
-
-          db::ShapeIterator shape (cref.shapes (l->first).begin (db::ShapeIterator::Boxes | db::ShapeIterator::Polygons | db::ShapeIterator::Edges | db::ShapeIterator::Paths | db::ShapeIterator::Texts));
-          while (! shape.at_end ()) {
-
-            progress_checkpoint ();
-
-            if (shape->is_text ()) {
-              write_text (layer, datatype, sf, dbu, *shape, layout, shape->prop_id ());
-            } else if (shape->is_polygon ()) {
-              write_polygon (layer, datatype, sf, *shape, multi_xy, max_vertex_count, layout, shape->prop_id ());
-            } else if (shape->is_edge ()) {
-              write_edge (layer, datatype, sf, *shape, layout, shape->prop_id ());
-            } else if (shape->is_path ()) {
-              if (no_zero_length_paths && (shape->path_length () - shape->path_extensions ().first - shape->path_extensions ().second) == 0) {
-                //  eliminate the zero-width path
-                db::Polygon poly;
-                shape->polygon (poly);
-                write_polygon (layer, datatype, sf, poly, multi_xy, max_vertex_count, layout, shape->prop_id (), false);
-              } else {
-                write_path (layer, datatype, sf, *shape, multi_xy, layout, shape->prop_id ());
-              }
-            } else if (shape->is_box ()) {
-              write_box (layer, datatype, sf, *shape, layout, shape->prop_id ());
-            }
-
-            ++shape;
+  //  shapes
 
-          }
+  for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
 
+    if (layout.is_valid_layer (l->first)) {
+
+      int layer = l->second.layer;
+      int datatype = l->second.datatype;
+
+      db::ShapeIterator shape (cref.shapes (l->first).begin (db::ShapeIterator::Boxes | db::ShapeIterator::Polygons | db::ShapeIterator::Edges | db::ShapeIterator::Paths | db::ShapeIterator::Texts));
+      while (! shape.at_end ()) {
+
+        progress_checkpoint ();
+
+        if (shape->is_text ()) {
+          write_text (layer, datatype, m_sf, m_dbu, *shape, layout, shape->prop_id ());
+        } else if (shape->is_polygon ()) {
+          write_polygon (layer, datatype, m_sf, *shape, multi_xy, max_vertex_count, layout, shape->prop_id ());
+        } else if (shape->is_edge ()) {
+          write_edge (layer, datatype, m_sf, *shape, layout, shape->prop_id ());
+        } else if (shape->is_path ()) {
+          if (no_zero_length_paths && (shape->path_length () - shape->path_extensions ().first - shape->path_extensions ().second) == 0) {
+            //  eliminate the zero-width path
+            db::Polygon poly;
+            shape->polygon (poly);
+            write_polygon (layer, datatype, m_sf, poly, multi_xy, max_vertex_count, layout, shape->prop_id (), false);
+          } else {
+            write_path (layer, datatype, m_sf, *shape, multi_xy, layout, shape->prop_id ());
+          }
+        } else if (shape->is_box ()) {
+          write_box (layer, datatype, m_sf, *shape, layout, shape->prop_id ());
         }
 
+        ++shape;
+
       }
 
-      //  end of cell
+    }
+
+  }
 
-      write_record_size (4);
-      write_record (sENDSTR);
+  //  end of cell
 
-    }
+  write_record_size (4);
+  write_record (sENDSTR);
+}
+
+void
+GDS2WriterBase::begin_cellwise (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options)
+{
+  init (layout, stream, options);
+  m_cellwise_options = options;
+
+  write_header (layout);
+}
+
+void
+GDS2WriterBase::write_cell (db::Layout &layout, db::cell_index_type cell_index)
+{
+  progress_checkpoint ();
+
+  const db::Cell &cref (layout.cell (cell_index));
 
+  //  cell names are assigned when needed - the cell itself comes first, then the child cells
+  if (! m_cell_name_map.has_cell (cell_index)) {
+    m_cell_name_map.insert (cell_index, layout.cell_name (cell_index));
   }
+  for (db::Cell::const_iterator inst = cref.begin (); ! inst.at_end (); ++inst) {
+    if (! m_cell_name_map.has_cell (inst->cell_index ())) {
+      m_cell_name_map.insert (inst->cell_index (), layout.cell_name (inst->cell_index ()));
+    }
+  }
+
+  //  new layers may appear while reading, so the layer list is updated for every cell
+  std::vector <std::pair <unsigned int, db::LayerProperties> > layers;
+  m_cellwise_options.get_valid_layers (layout, layers, db::SaveLayoutOptions::LP_AssignNumber);
 
+  write_cell_body (layout, cref, layers, 0);
+}
+
+void
+GDS2WriterBase::end_cellwise (db::Layout & /*layout*/)
+{
   write_record_size (4);
   write_record (sENDLIB);
 
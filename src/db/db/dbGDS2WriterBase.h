@@ -163,6 +163,29 @@ public:
    */
   void write (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options);
 
+  /**
+   *  @brief Cell-wise writing is supported by this writer
+   */
+  virtual bool supports_cellwise () const
+  {
+    return true;
+  }
+
+  /**
+   *  @brief Implementation of WriterBase::begin_cellwise
+   */
+  virtual void begin_cellwise (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options);
+
+  /**
+   *  @brief Implementation of WriterBase::write_cell
+   */
+  virtual void write_cell (db::Layout &layout, db::cell_index_type cell_index);
+
+  /**
+   *  @brief Implementation of WriterBase::end_cellwise
+   */
+  virtual void end_cellwise (db::Layout &layout);
+
 protected:
   /**
    *  @brief Write a byte
@@ -266,7 +289,14 @@ protected:
 
 private:
   db::WriterCellNameMap m_cell_name_map;
-
+  db::GDS2WriterOptions m_gds2_options;
+  db::SaveLayoutOptions m_cellwise_options;
+  double m_dbu, m_sf;
+  short m_time_data [6];
+
+  void init (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options);
+  void write_header (const db::Layout &layout);
+  void write_cell_body (const db::Layout &layout, const db::Cell &cref, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, const std::set <db::cell_index_type> *cell_set);
   void write_properties (const db::Layout &layout, db::properties_id_type prop_id);
 };
 
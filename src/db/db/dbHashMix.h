@@ -0,0 +1,126 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#ifndef HDR_dbHashMix
+#define HDR_dbHashMix
+
+#include "dbPoint.h"
+#include "dbVector.h"
+#include "dbPolygon.h"
+#include "dbTrans.h"
+
+#include <cmath>
+#include <stdint.h>
+
+namespace db
+{
+
+/**
+ *  @brief A 64 bit mixing function
+ *
+ *  Unlike the hash functions from dbHash.h, this function is supposed to 
+ *  provide good distribution so the hash values can be used as identity 
+ *  indicators - e.g. for cell content hashes or layer signatures.
+ */
+inline uint64_t hmix (uint64_t h, uint64_t v)
+{
+  h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ *  @brief Mixes a coordinate into the hash value
+ */
+inline uint64_t hmix (uint64_t h, db::Coord c)
+{
+  return hmix (h, uint64_t (int64_t (c)));
+}
+
+/**
+ *  @brief Mixes a floating-point value into the hash value
+ *
+ *  The value is rounded to db::epsilon to avoid hash differences due to rounding errors.
+ */
+inline uint64_t hmix (uint64_t h, double d)
+{
+  return hmix (h, uint64_t (int64_t (floor (0.5 + d / db::epsilon))));
+}
+
+/**
+ *  @brief Mixes a string into the hash value
+ */
+inline uint64_t hmix (uint64_t h, const char *cp)
+{
+  for ( ; *cp; ++cp) {
+    h = hmix (h, uint64_t (*cp));
+  }
+  return hmix (h, uint64_t (0));
+}
+
+/**
+ *  @brief Mixes a point into the hash value
+ */
+inline uint64_t hmix (uint64_t h, const db::Point &p)
+{
+  return hmix (hmix (h, p.x ()), p.y ());
+}
+
+/**
+ *  @brief Mixes a vector into the hash value
+ */
+inline uint64_t hmix (uint64_t h, const db::Vector &v)
+{
+  return hmix (hmix (h, v.x ()), v.y ());
+}
+
+/**
+ *  @brief Mixes a polygon contour into the hash value
+ */
+inline uint64_t hash_contour (uint64_t h, const db::Polygon::contour_type &ctr)
+{
+  h = hmix (h, uint64_t (ctr.size ()));
+  for (size_t i = 0; i < ctr.size (); ++i) {
+    h = hmix (h, ctr [i]);
+  }
+  return h;
+}
+
+/**
+ *  @brief Mixes a complex transformation into the hash value
+ */
+inline uint64_t hash_trans (uint64_t h, const db::ICplxTrans &t)
+{
+  h = hmix (h, t.angle ());
+  h = hmix (h, t.mag ());
+  h = hmix (h, uint64_t (t.is_mirror ()));
+  return hmix (h, t.disp ());
+}
+
+}
+
+#endif
+
@@ -31,11 +31,17 @@
 #include "dbLibraryProxy.h"
 #include "dbLibraryManager.h"
 #include "dbLibrary.h"
+#include "dbStatic.h"
+#include "dbHashMix.h"
 #include "tlTimer.h"
 #include "tlLog.h"
 #include "tlInternational.h"
 #include "tlProgress.h"
 #include "tlAssert.h"
+#include "tlThreadedWorkers.h"
+
+#include <map>
+#include <cstring>
 
 
 namespace db
@@ -263,7 +269,8 @@ Layout::Layout (db::Manager *manager)
     m_properties_repository (this),
     m_guiding_shape_layer (-1),
     m_waste_layer (-1),
-    m_editable (db::default_editable_mode ())
+    m_editable (db::default_editable_mode ()),
+    m_update_threads (0)
 {
   // .. nothing yet ..
 }
@@ -278,7 +285,8 @@ Layout::Layout (bool editable, db::Manager *manager)
     m_properties_repository (this),
     m_guiding_shape_layer (-1),
     m_waste_layer (-1),
-    m_editable (editable)
+    m_editable (editable),
+    m_update_threads (0)
 {
   // .. nothing yet ..
 }
@@ -295,7 +303,8 @@ Layout::Layout (const db::Layout &layout)
     m_properties_repository (this),
     m_guiding_shape_layer (-1),
     m_waste_layer (-1),
-    m_editable (layout.m_editable)
+    m_editable (layout.m_editable),
+    m_update_threads (layout.m_update_threads)
 {
   *this = layout;
 }
@@ -362,6 +371,7 @@ Layout::clear ()
 
   m_lib_proxy_map.clear ();
   m_meta_info.clear ();
+  invalidate_cell_hashes ();
 }
 
 Layout &
@@ -376,6 +386,7 @@ Layout::operator= (const Layout &d)
     m_guiding_shape_layer = d.m_guiding_shape_layer;
     m_waste_layer = d.m_waste_layer;
     m_editable = d.m_editable;
+    m_update_threads = d.m_update_threads;
 
     m_pcell_ids = d.m_pcell_ids;
     m_pcells.reserve (d.m_pcells.size ());
@@ -1079,6 +1090,9 @@ Layout::rename_cell (cell_index_type id, const char *name)
 
     m_cell_map.insert (std::make_pair (cp, id));
 
+    //  the cell names are part of the cell hashes
+    invalidate_cell_hashes ();
+
     //  to enforce a redraw and a rebuild
     cell_name_changed ();
 
@@ -1268,11 +1282,158 @@ Layout::update () const
   }
 }
 
+// -----------------------------------------------------------------
+//  Parallel implementation of the layout update
+
+/**
+ *  @brief A task performing one update step for a number of cells
+ *
+ *  NOTE: this class is not in the anonymous namespace as it is a friend of db::Cell.
+ */
+class LayoutUpdateTask
+  : public tl::Task
+{
+public:
+  enum Mode { UpdateBBox, SortShapes, SortInstances };
+
+  LayoutUpdateTask (Mode mode, unsigned int layers, std::vector<char> *bbox_changed)
+    : m_mode (mode), m_layers (layers), mp_bbox_changed (bbox_changed)
+  {
+    //  .. nothing yet ..
+  }
+
+  void add (db::Cell *cell)
+  {
+    m_cells.push_back (cell);
+  }
+
+  void perform ()
+  {
+    for (std::vector<db::Cell *>::const_iterator c = m_cells.begin (); c != m_cells.end (); ++c) {
+      if (m_mode == UpdateBBox) {
+        //  NOTE: each cell writes its own entry only
+        (*mp_bbox_changed) [(*c)->cell_index ()] = (*c)->update_bbox (m_layers);
+      } else if (m_mode == SortShapes) {
+        (*c)->sort_shapes ();
+      } else if (m_mode == SortInstances) {
+        (*c)->sort_inst_tree ();
+      }
+    }
+  }
+
+private:
+  Mode m_mode;
+  unsigned int m_layers;
+  std::vector<char> *mp_bbox_changed;
+  std::vector<db::Cell *> m_cells;
+};
+
+namespace
+{
+
+class LayoutUpdateWorker
+  : public tl::Worker
+{
+public:
+  LayoutUpdateWorker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    LayoutUpdateTask *lu_task = dynamic_cast<LayoutUpdateTask *> (task);
+    if (lu_task) {
+      lu_task->perform ();
+    }
+  }
+};
+
+/**
+ *  @brief The job executing the parallel parts of Layout::do_update
+ */
+class LayoutUpdateJob
+  : public tl::JobBase
+{
+public:
+  LayoutUpdateJob (int nworkers)
+    : tl::JobBase (nworkers)
+  { }
+
+  /**
+   *  @brief Performs the given update step on the given cells and waits for completion
+   */
+  void run (const std::vector<db::Cell *> &cells, LayoutUpdateTask::Mode mode, unsigned int layers = 0, std::vector<char> *bbox_changed = 0)
+  {
+    if (cells.empty ()) {
+      return;
+    }
+
+    //  small numbers of cells are not worth the overhead
+    if (cells.size () < 2) {
+      LayoutUpdateTask task (mode, layers, bbox_changed);
+      task.add (cells.front ());
+      task.perform ();
+      return;
+    }
+
+    //  a few chunks per worker for load balancing
+    size_t nchunks = std::min (cells.size (), size_t (num_workers ()) * 4);
+    for (size_t i = 0; i < nchunks; ++i) {
+      LayoutUpdateTask *task = new LayoutUpdateTask (mode, layers, bbox_changed);
+      for (size_t j = (i * cells.size ()) / nchunks; j < ((i + 1) * cells.size ()) / nchunks; ++j) {
+        task->add (cells [j]);
+      }
+      schedule (task);
+    }
+
+    start ();
+    wait ();
+
+    if (has_error ()) {
+      throw tl::Exception (tl::to_string (QObject::tr ("Errors occured during layout update. First error message says:\n")) + error_messages ().front ());
+    }
+  }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new LayoutUpdateWorker ();
+  }
+};
+
+}
+
+void
+Layout::compute_levels (std::vector<std::vector<cell_index_type> > &levels)
+{
+  levels.clear ();
+
+  std::vector<unsigned int> cell_levels (cells (), 0);
+
+  for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+
+    unsigned int l = 0;
+    for (cell_type::child_cell_iterator cc = cell (*c).begin_child_cells (); ! cc.at_end (); ++cc) {
+      l = std::max (l, cell_levels [*cc] + 1);
+    }
+
+    cell_levels [*c] = l;
+    if (l >= levels.size ()) {
+      levels.resize (l + 1);
+    }
+    levels [l].push_back (*c);
+
+  }
+}
+
 void 
 Layout::do_update ()
 {
   tl::SelfTimer timer (tl::verbosity () >= 21, tl::to_string (QObject::tr ("Sorting")));
 
+  //  the content has changed: invalidate the cell hashes
+  invalidate_cell_hashes ();
+
   //  establish a progress report since this operation can take some time.
   //  HINT: because of some gcc bug, automatic destruction of the tl::Progress
   //  object does not work. We overcome this problem by creating the object with new 
@@ -1297,9 +1458,18 @@ Layout::do_update ()
       }
     }
 
-    //  KLUDGE: a boolean vector (with size as determined by number of cells)
-    //  would probably be much faster!
-    std::set<cell_index_type> dirty_parents;
+    std::vector<bool> dirty_parents (cells (), false);
+    bool has_dirty_parents = false;
+
+    //  with multiple threads, the cells are processed level by level: the cells on one 
+    //  hierarchy level only depend on the cells of the levels below
+    int nthreads = m_update_threads;
+    std::auto_ptr<LayoutUpdateJob> job;
+    std::vector<std::vector<cell_index_type> > levels;
+    if (nthreads > 0 && m_cells_size > 1 && (bboxes_dirty () || hier_dirty ())) {
+      job.reset (new LayoutUpdateJob (nthreads));
+      compute_levels (levels);
+    }
 
     //  if something on the bboxes (either on shape level or on 
     //  cell bbox level - i.e. by child instances) has been changed,
@@ -1308,56 +1478,146 @@ Layout::do_update ()
     //  the bboxes are dirty.
     if (bboxes_dirty ()) {
 
-      {
-        tl::SelfTimer timer (tl::verbosity () >= 31, "Updating bounding boxes");
-        unsigned int layers = 0;
-        pr->set (0);
-        pr->set_desc (tl::to_string (QObject::tr ("Updating bounding boxes")));
-        for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
-          ++*pr;
-          cell_type &cp (cell (*c));
-          if (cp.is_shape_bbox_dirty () || dirty_parents.find (*c) != dirty_parents.end ()) {
-            if (cp.update_bbox (layers)) {
-              //  the bounding box has changed - need to insert parents into "dirty parents" list
-              for (cell_type::parent_cell_iterator p = cp.begin_parent_cells (); p != cp.end_parent_cells (); ++p) {
-                dirty_parents.insert (*p);
+      if (job.get ()) {
+
+        {
+          tl::SelfTimer timer (tl::verbosity () >= 31, "Updating bounding boxes");
+          unsigned int layers = 0;
+          size_t n = 0;
+          pr->set (0);
+          pr->set_desc (tl::to_string (QObject::tr ("Updating bounding boxes")));
+
+          std::vector<char> bbox_changed (cells (), 0);
+
+          for (std::vector<std::vector<cell_index_type> >::const_iterator l = levels.begin (); l != levels.end (); ++l) {
+
+            std::vector<cell_type *> todo;
+            for (std::vector<cell_index_type>::const_iterator c = l->begin (); c != l->end (); ++c) {
+              cell_type &cp (cell (*c));
+              if (cp.is_shape_bbox_dirty () || dirty_parents [*c]) {
+                todo.push_back (&cp);
+              }
+            }
+
+            job->run (todo, LayoutUpdateTask::UpdateBBox, layers, &bbox_changed);
+
+            for (std::vector<cell_index_type>::const_iterator c = l->begin (); c != l->end (); ++c) {
+              cell_type &cp (cell (*c));
+              if (bbox_changed [*c]) {
+                //  the bounding box has changed - need to insert parents into "dirty parents" list
+                for (cell_type::parent_cell_iterator p = cp.begin_parent_cells (); p != cp.end_parent_cells (); ++p) {
+                  dirty_parents [*p] = true;
+                  has_dirty_parents = true;
+                }
               }
-            } 
+            }
+
+            //  NOTE: the layer count must cover all cells of the levels below
+            for (std::vector<cell_index_type>::const_iterator c = l->begin (); c != l->end (); ++c) {
+              layers = std::max (layers, cell (*c).layers ());
+            }
+
+            n += l->size ();
+            pr->set (n);
+
           }
-          if (cp.layers () > layers) {
-            layers = cp.layers ();
+        }
+
+        {
+          tl::SelfTimer timer (tl::verbosity () >= 31, "Sorting shapes");
+          pr->set (0);
+          pr->set_desc (tl::to_string (QObject::tr ("Sorting shapes")));
+
+          //  shape sorting is independent for each cell
+          std::vector<cell_type *> todo;
+          for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+            todo.push_back (&cell (*c));
           }
+
+          job->run (todo, LayoutUpdateTask::SortShapes);
+          pr->set (todo.size ());
         }
-      }
 
-      {
-        tl::SelfTimer timer (tl::verbosity () >= 31, "Sorting shapes");
-        pr->set (0);
-        pr->set_desc (tl::to_string (QObject::tr ("Sorting shapes")));
-        for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
-          ++*pr;
-          cell_type &cp (cell (*c));
-          cp.sort_shapes ();
+      } else {
+
+        {
+          tl::SelfTimer timer (tl::verbosity () >= 31, "Updating bounding boxes");
+          unsigned int layers = 0;
+          pr->set (0);
+          pr->set_desc (tl::to_string (QObject::tr ("Updating bounding boxes")));
+          for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+            ++*pr;
+            cell_type &cp (cell (*c));
+            if (cp.is_shape_bbox_dirty () || dirty_parents [*c]) {
+              if (cp.update_bbox (layers)) {
+                //  the bounding box has changed - need to insert parents into "dirty parents" list
+                for (cell_type::parent_cell_iterator p = cp.begin_parent_cells (); p != cp.end_parent_cells (); ++p) {
+                  dirty_parents [*p] = true;
+                  has_dirty_parents = true;
+                }
+              } 
+            }
+            if (cp.layers () > layers) {
+              layers = cp.layers ();
+            }
+          }
         }
+
+        {
+          tl::SelfTimer timer (tl::verbosity () >= 31, "Sorting shapes");
+          pr->set (0);
+          pr->set_desc (tl::to_string (QObject::tr ("Sorting shapes")));
+          for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+            ++*pr;
+            cell_type &cp (cell (*c));
+            cp.sort_shapes ();
+          }
+        }
+
       }
+
     }
 
     //  sort the instance trees now, since we have computed the bboxes
-    if (hier_dirty () || ! dirty_parents.empty ()) {
+    if (hier_dirty () || has_dirty_parents) {
+
       tl::SelfTimer timer (tl::verbosity () >= 31, "Sorting instances");
-      size_t layers = 0;
       pr->set (0);
       pr->set_desc (tl::to_string (QObject::tr ("Sorting instances")));
-      for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
-        ++*pr;
-        cell_type &cp (cell (*c));
-        if (hier_dirty () || dirty_parents.find (*c) != dirty_parents.end ()) {
-          cp.sort_inst_tree ();
+
+      if (job.get ()) {
+
+        //  NOTE: sorting the instances also computes the hierarchy levels which depend
+        //  on the child cells, hence this needs to be done level by level too
+        size_t n = 0;
+        for (std::vector<std::vector<cell_index_type> >::const_iterator l = levels.begin (); l != levels.end (); ++l) {
+
+          std::vector<cell_type *> todo;
+          for (std::vector<cell_index_type>::const_iterator c = l->begin (); c != l->end (); ++c) {
+            if (hier_dirty () || dirty_parents [*c]) {
+              todo.push_back (&cell (*c));
+            }
+          }
+
+          job->run (todo, LayoutUpdateTask::SortInstances);
+
+          n += l->size ();
+          pr->set (n);
+
         }
-        if (cp.layers () > layers) {
-          layers = cp.layers ();
+
+      } else {
+
+        for (bottom_up_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+          ++*pr;
+          cell_type &cp (cell (*c));
+          if (hier_dirty () || dirty_parents [*c]) {
+            cp.sort_inst_tree ();
+          }
         }
+
       }
+
     }
 
   } catch (...) {
@@ -1368,6 +1628,277 @@ Layout::do_update ()
   delete pr;
 }
 
+// -----------------------------------------------------------------
+//  Cell content hashes
+
+namespace
+{
+
+uint64_t hash_variant (uint64_t h, const tl::Variant &v)
+{
+  //  NOTE: the values are hashed by type and value, not through their string representation
+  //  which is lossy for floating-point values and ambiguous for lists
+  h = hmix (h, uint64_t (v.type_code ()));
+
+  if (v.is_nil ()) {
+    return h;
+  } else if (v.is_double ()) {
+    double d = v.to_double ();
+    uint64_t bits = 0;
+    memcpy (&bits, &d, sizeof (bits) < sizeof (d) ? sizeof (bits) : sizeof (d));
+    return hmix (h, bits);
+  } else if (v.is_bool ()) {
+    return hmix (h, uint64_t (v.to_bool ()));
+  } else if (v.is_ulong () || v.is_ulonglong ()) {
+    return hmix (h, uint64_t (v.to_ulonglong ()));
+  } else if (v.is_char () || v.is_long () || v.is_longlong ()) {
+    return hmix (h, uint64_t (v.to_longlong ()));
+  } else if (v.is_list ()) {
+    h = hmix (h, uint64_t (v.end () - v.begin ()));
+    for (tl::Variant::const_iterator i = v.begin (); i != v.end (); ++i) {
+      h = hash_variant (h, *i);
+    }
+    return h;
+  } else {
+    return hmix (h, v.to_string ());
+  }
+}
+
+/**
+ *  @brief Provides the hash values for property IDs
+ *
+ *  The hash is computed from the property names and values, so it does not depend on the 
+ *  layout-specific IDs. The results are cached per ID.
+ */
+class PropertiesHasher
+{
+public:
+  PropertiesHasher (const db::PropertiesRepository &rep)
+    : mp_rep (&rep)
+  {
+    //  .. nothing yet ..
+  }
+
+  uint64_t operator() (db::properties_id_type prop_id)
+  {
+    if (prop_id == 0) {
+      return 0;
+    }
+
+    std::map<db::properties_id_type, uint64_t>::const_iterator c = m_cache.find (prop_id);
+    if (c != m_cache.end ()) {
+      return c->second;
+    }
+
+    //  NOTE: the property names ID's are layout specific, hence we combine the name/value
+    //  pairs in an order-independent fashion
+    uint64_t h = 0;
+    const db::PropertiesRepository::properties_set &props = mp_rep->properties (prop_id);
+    for (db::PropertiesRepository::properties_set::const_iterator p = props.begin (); p != props.end (); ++p) {
+      h += hash_variant (hash_variant (0, mp_rep->prop_name (p->first)), p->second);
+    }
+
+    h = hmix (h, uint64_t (props.size ()));
+    m_cache.insert (std::make_pair (prop_id, h));
+    return h;
+  }
+
+private:
+  const db::PropertiesRepository *mp_rep;
+  std::map<db::properties_id_type, uint64_t> m_cache;
+};
+
+uint64_t hash_shape (PropertiesHasher &prop_hasher, const db::Shape &shape)
+{
+  uint64_t h = 0;
+
+  if (shape.is_polygon ()) {
+
+    db::Polygon poly;
+    shape.polygon (poly);
+
+    h = hmix (h, uint64_t (1));
+    for (unsigned int c = 0; c <= poly.holes (); ++c) {
+      h = hash_contour (h, poly.contour (c));
+    }
+
+  } else if (shape.is_path ()) {
+
+    db::Path path;
+    shape.path (path);
+
+    h = hmix (h, uint64_t (2));
+    h = hmix (h, path.width ());
+    h = hmix (h, path.bgn_ext ());
+    h = hmix (h, path.end_ext ());
+    h = hmix (h, uint64_t (path.round ()));
+    for (db::Path::iterator p = path.begin (); p != path.end (); ++p) {
+      h = hmix (h, *p);
+    }
+
+  } else if (shape.is_box ()) {
+
+    db::Box box = shape.box ();
+
+    h = hmix (h, uint64_t (3));
+    h = hmix (h, box.p1 ());
+    h = hmix (h, box.p2 ());
+
+  } else if (shape.is_edge ()) {
+
+    db::Edge edge = shape.edge ();
+
+    h = hmix (h, uint64_t (4));
+    h = hmix (h, edge.p1 ());
+    h = hmix (h, edge.p2 ());
+
+  } else if (shape.is_text ()) {
+
+    db::Text text;
+    shape.text (text);
+
+    h = hmix (h, uint64_t (5));
+    h = hmix (h, text.string ());
+    h = hmix (h, uint64_t (text.trans ().rot ()));
+    h = hmix (h, text.trans ().disp ());
+    h = hmix (h, text.size ());
+    h = hmix (h, uint64_t (int64_t (text.font ())));
+    h = hmix (h, uint64_t (int64_t (text.halign ())));
+    h = hmix (h, uint64_t (int64_t (text.valign ())));
+
+  }
+
+  if (shape.has_prop_id ()) {
+    h = hmix (h, prop_hasher (shape.prop_id ()));
+  }
+
+  return h;
+}
+
+uint64_t hash_instance (const db::Layout &layout, PropertiesHasher &prop_hasher, const std::vector<uint64_t> &hashes, const db::Instance &inst)
+{
+  const db::CellInstArray &array = inst.cell_inst ();
+
+  //  NOTE: the child cell is represented by its name and content hash 
+  //  (cell indexes are layout specific)
+  uint64_t h = hmix (hashes [array.object ().cell_index ()], layout.cell_name (array.object ().cell_index ()));
+
+  h = hmix (h, uint64_t (array.is_complex ()));
+  h = hash_trans (h, array.complex_trans ());
+
+  db::Vector a, b;
+  unsigned long na = 1, nb = 1;
+  if (array.is_regular_array (a, b, na, nb)) {
+    h = hmix (h, a);
+    h = hmix (h, b);
+    h = hmix (h, uint64_t (na));
+    h = hmix (h, uint64_t (nb));
+  } else if (array.is_iterated_array ()) {
+    for (db::CellInstArray::iterator i = array.begin (); ! i.at_end (); ++i) {
+      h = hash_trans (h, array.complex_trans (*i));
+    }
+  }
+
+  if (inst.has_prop_id ()) {
+    h = hmix (h, prop_hasher (inst.prop_id ()));
+  }
+
+  return h;
+}
+
+}
+
+void
+Layout::compute_cell_hashes (std::vector<uint64_t> &hashes) const
+{
+  tl::SelfTimer timer (tl::verbosity () >= 31, "Computing cell hashes");
+
+  hashes.clear ();
+  hashes.resize (cells (), 0);
+
+  //  Shapes are combined in an order-independent way, so the hash does not depend on the 
+  //  shape order. The same is true for the layers and the instances.
+  unsigned int flags = db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes | db::ShapeIterator::Edges | db::ShapeIterator::Texts;
+
+  PropertiesHasher prop_hasher (properties_repository ());
+
+  for (bottom_up_const_iterator c = begin_bottom_up (); c != end_bottom_up (); ++c) {
+
+    const cell_type &cp = cell (*c);
+
+    uint64_t h = 0;
+
+    for (unsigned int l = 0; l < layers (); ++l) {
+
+      if (! is_valid_layer (l)) {
+        continue;
+      }
+
+      const db::Shapes &shapes = cp.shapes (l);
+      if (shapes.empty ()) {
+        continue;
+      }
+
+      uint64_t hl = 0;
+      size_t n = 0;
+      for (db::ShapeIterator s = shapes.begin (flags); ! s.at_end (); ++s, ++n) {
+        hl += hash_shape (prop_hasher, *s);
+      }
+
+      if (n > 0) {
+        const db::LayerProperties &lp = get_properties (l);
+        uint64_t hlp = hmix (hmix (hmix (uint64_t (0), db::Coord (lp.layer)), db::Coord (lp.datatype)), lp.name.c_str ());
+        h += hmix (hmix (hlp, uint64_t (n)), hl);
+      }
+
+    }
+
+    uint64_t hi = 0;
+    size_t n = 0;
+    for (cell_type::const_iterator i = cp.begin (); ! i.at_end (); ++i, ++n) {
+      hi += hash_instance (*this, prop_hasher, hashes, *i);
+    }
+
+    h = hmix (hmix (h, uint64_t (n)), hi);
+    h = hmix (h, prop_hasher (cp.prop_id ()));
+
+    hashes [*c] = h;
+
+  }
+}
+
+void
+Layout::invalidate_cell_hashes ()
+{
+  m_cell_hashes.clear ();
+}
+
+void
+Layout::do_prop_values_changed ()
+{
+  //  the property names and values are part of the cell hashes
+  invalidate_cell_hashes ();
+}
+
+uint64_t
+Layout::cell_hash (cell_index_type ci) const
+{
+  update ();
+
+  if (under_construction ()) {
+    //  don't cache while the layout is under construction - the state may change without notice
+    std::vector<uint64_t> hashes;
+    compute_cell_hashes (hashes);
+    return hashes [ci];
+  }
+
+  if (m_cell_hashes.size () != cells ()) {
+    compute_cell_hashes (m_cell_hashes);
+  }
+
+  return m_cell_hashes [ci];
+}
+
 void
 Layout::clear_meta ()
 {
@@ -1564,6 +2095,9 @@ Layout::set_properties (unsigned int i, const LayerProperties &props)
 
     m_layer_props [i] = props;
 
+    //  the layer properties are part of the cell hashes
+    invalidate_cell_hashes ();
+
     layer_properties_changed ();
 
   }
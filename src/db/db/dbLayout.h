@@ -1384,6 +1384,30 @@ public:
    */
   void force_update ();
 
+  /**
+   *  @brief Gets the content hash of the given cell
+   *
+   *  The content hash is a 64 bit hash value computed over the shapes (polygons, paths, boxes, edges
+   *  and texts), the instances and the properties of the cell and - through the child cells' hashes - 
+   *  over the whole subtree below this cell. The hash does not depend on layer indexes, cell indexes 
+   *  or property IDs but uses the layer properties, the names of the child cells and the property 
+   *  names and values instead. Hence the hashes can be compared between different layouts: 
+   *  cells with identical hashes are identical including their subtrees (except for the unlikely 
+   *  case of a hash collision).
+   *
+   *  The hashes are computed for all cells at once and cached until the layout changes.
+   */
+  uint64_t cell_hash (cell_index_type ci) const;
+
+  /**
+   *  @brief Invalidates the cached cell content hashes
+   *
+   *  Changes to the shapes and instances invalidate the hashes through the update mechanism. 
+   *  Changes which do not trigger an update (i.e. changing the properties of a cell) need to 
+   *  call this method.
+   */
+  void invalidate_cell_hashes ();
+
   /**
    *  @brief Cleans up the layout
    *
@@ -1535,6 +1559,26 @@ public:
     return m_editable;
   }
 
+  /**
+   *  @brief Sets the number of threads used for updating the layout
+   *
+   *  If this value is larger than 0, the bounding box computation and the sorting 
+   *  of the shape and instance trees in "update" are distributed over the 
+   *  given number of threads. The default is 0 (no threads).
+   */
+  void set_update_threads (int n)
+  {
+    m_update_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of threads used for updating the layout
+   */
+  int update_threads () const
+  {
+    return m_update_threads;
+  }
+
   /**
    *  @brief Delivers the meta information (begin iterator)
    *
@@ -1591,6 +1635,13 @@ protected:
    */
   virtual void do_update ();
 
+  /**
+   *  @brief Invalidates the cell hashes when property names or values change
+   *
+   *  This reimplements the LayoutStateModel interface.
+   */
+  virtual void do_prop_values_changed ();
+
 private:
   enum LayerState { Normal, Free, Special };
 
@@ -1618,7 +1669,9 @@ private:
   int m_guiding_shape_layer;
   int m_waste_layer;
   bool m_editable;
+  int m_update_threads;
   meta_info m_meta_info;
+  mutable std::vector<uint64_t> m_cell_hashes;
 
   /**
    *  @brief Sort the cells topologically
@@ -1637,6 +1690,18 @@ private:
    */
   bool topological_sort ();
 
+  /**
+   *  @brief Groups the cells by hierarchy levels
+   *
+   *  Level 0 are the leaf cells. Each other cell is on the level above the highest level of it's child cells.
+   */
+  void compute_levels (std::vector<std::vector<cell_index_type> > &levels);
+
+  /**
+   *  @brief Computes the content hashes of all cells
+   */
+  void compute_cell_hashes (std::vector<uint64_t> &hashes) const;
+
   /**
    *  @brief Register a cell name for the cell index 
    */
@@ -826,6 +826,12 @@ do_compare_layouts (const db::Layout &a, const db::Cell *top_a, const db::Layout
   std::vector <std::pair <db::Edge, db::properties_id_type> > edges_a;
   std::vector <std::pair <db::Edge, db::properties_id_type> > edges_b;
 
+  //  Cells with identical content hashes are identical including their subtrees and don't need to
+  //  be compared in detail. The content hashes use the cell names of the child cells, hence this
+  //  scheme can't be used with smart cell mapping.
+  bool use_cell_hashes = ! (flags & layout_diff::f_smart_cell_mapping);
+  size_t identical_cells = 0;
+
   for (unsigned int cci = 0; cci < common_cells.size (); ++cci) {
 
     const db::Cell *cell_a = &a.cell (common_cells_a [cci]);
@@ -837,6 +843,13 @@ do_compare_layouts (const db::Layout &a, const db::Cell *top_a, const db::Layout
 
     r.begin_cell (common_cells [cci], common_cells_a [cci], common_cells_b [cci]); 
 
+    if (use_cell_hashes && a.cell_hash (common_cells_a [cci]) == b.cell_hash (common_cells_b [cci])) {
+      ++identical_cells;
+      r.end_cell ();
+      ++progress;
+      continue;
+    }
+
     if (!verbose && cell_a->bbox () != cell_b->bbox ()) {
       differs = true;
       if (flags & layout_diff::f_silent) {
@@ -1060,6 +1073,10 @@ do_compare_layouts (const db::Layout &a, const db::Cell *top_a, const db::Layout
 
   }
 
+  if (tl::verbosity () >= 20) {
+    tl::info << "Layout diff - " << identical_cells << " of " << common_cells.size () << " cells skipped as identical";
+  }
+
   return ! differs;
 
 }
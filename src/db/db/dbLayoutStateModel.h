@@ -160,6 +160,14 @@ protected:
    */
   virtual void do_update () { }
 
+  /**
+   *  @brief Reimplement this method to update anything related to the property values
+   *
+   *  This method is called when the names or values behind existing property ID's 
+   *  have been changed. It is not called when new property ID's are created.
+   */
+  virtual void do_prop_values_changed () { }
+
   /**
    *  @brief Issue a "prop id's changed event"
    */
@@ -168,6 +176,15 @@ protected:
     prop_ids_changed_event ();
   }
 
+  /**
+   *  @brief Issue a "prop id's changed event" after the names or values of existing ID's have changed
+   */
+  void prop_values_changed ()
+  {
+    do_prop_values_changed ();
+    prop_ids_changed_event ();
+  }
+
   /**
    *  @brief Issue a "prop id's changed event"
    */
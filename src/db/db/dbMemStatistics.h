@@ -212,6 +212,22 @@ public:
 
   void print () const;
 
+  /**
+   *  @brief Gets the total number of bytes used
+   */
+  size_t used () const
+  {
+    return m_layout_info_used + m_cell_info_used + m_inst_trees_used + m_shapes_info_used + m_shapes_cache_used + m_shape_trees_used + m_instances_used;
+  }
+
+  /**
+   *  @brief Gets the total number of bytes required
+   */
+  size_t reqd () const
+  {
+    return m_layout_info_reqd + m_cell_info_reqd + m_inst_trees_reqd + m_shapes_info_reqd + m_shapes_cache_reqd + m_shape_trees_reqd + m_instances_reqd;
+  }
+
   void layout_info (size_t u, size_t r)
   {
     m_layout_info_used += u;
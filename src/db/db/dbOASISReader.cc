@@ -28,10 +28,15 @@
 #include "dbObjectWithProperties.h"
 #include "dbArray.h"
 #include "dbStatic.h"
+#include "dbLayoutUtils.h"
 
 #include "tlException.h"
 #include "tlString.h"
 #include "tlClassRegistry.h"
+#include "tlThreadedWorkers.h"
+
+#include <memory>
+#include <algorithm>
 
 namespace db
 {
@@ -67,6 +72,487 @@ private:
   bool m_create;
 };
 
+// ---------------------------------------------------------------
+//  Parallel cell decoding
+
+/**
+ *  @brief An explicit cell reference found in a cell body decoded by the parallel reader
+ */
+struct OASISCellReference
+{
+  OASISCellReference (db::cell_index_type c, unsigned long i)
+    : cell (c), by_name (false), id (i)
+  { }
+
+  OASISCellReference (db::cell_index_type c, const std::string &n)
+    : cell (c), by_name (true), id (0), name (n)
+  { }
+
+  db::cell_index_type cell;
+  bool by_name;
+  unsigned long id;
+  std::string name;
+};
+
+class OASISCellReaderWorker;
+
+/**
+ *  @brief The decoded body of a cell
+ *
+ *  The shapes and the cell properties are kept in the scratch layout of the worker.
+ *  Layers, instances and references refer to this layout. The references are listed
+ *  in the order of the file, so they can be resolved in the same order than by the
+ *  sequential reader. "limit" is the position of the next cell or table: a CBLOCK
+ *  starting there does not belong to the cell any longer.
+ */
+struct OASISCellContents
+{
+  OASISCellContents ()
+    : ok (false), id (0), cell_index (0), limit (0), end_pos (0), has_context (false), worker (0)
+  { }
+
+  void add_layer (unsigned int l)
+  {
+    if ((layers.empty () || layers.back () != l) && std::find (layers.begin (), layers.end (), l) == layers.end ()) {
+      layers.push_back (l);
+    }
+  }
+
+  bool ok;
+  unsigned long id;
+  db::cell_index_type cell_index;
+  size_t limit;
+  size_t end_pos;
+  std::vector<unsigned int> layers;
+  std::vector<OASISCellReference> references;
+  tl::vector<db::CellInstArray> instances;
+  tl::vector<db::CellInstArrayWithProperties> instances_with_props;
+  bool has_context;
+  std::vector<std::string> context_strings;
+  OASISCellReaderWorker *worker;
+};
+
+/**
+ *  @brief A task decoding one cell
+ */
+class OASISCellReaderTask
+  : public tl::Task
+{
+public:
+  OASISCellReaderTask (size_t p, unsigned long i, OASISCellContents *c)
+    : pos (p), id (i), contents (c)
+  { }
+
+  size_t pos;
+  unsigned long id;
+  OASISCellContents *contents;
+};
+
+class OASISParallelCellReader;
+
+/**
+ *  @brief The worker decoding cells 
+ *
+ *  Each worker has its own reader and decodes the cells into a scratch layout. 
+ *  The scratch layout is replaced for every batch of cells.
+ */
+class OASISCellReaderWorker
+  : public tl::Worker
+{
+public:
+  OASISCellReaderWorker (const OASISParallelCellReader *parent);
+
+  void reset ();
+  virtual void perform_task (tl::Task *task);
+
+  const db::Layout &layout () const
+  {
+    return *mp_layout;
+  }
+
+  db::PropertyMapper &property_mapper (db::Layout &target);
+
+private:
+  const OASISParallelCellReader *mp_parent;
+  std::auto_ptr<db::Layout> mp_layout;
+  std::auto_ptr<tl::InputMemoryStream> mp_memory_stream;
+  std::auto_ptr<tl::InputStream> mp_stream;
+  std::auto_ptr<db::OASISReader> mp_reader;
+  db::PropertyMapper m_pm;
+  db::Layout *mp_pm_target;
+
+  void init_reader ();
+  void update_property_names ();
+};
+
+/**
+ *  @brief The job running the OASISCellReaderWorker objects
+ */
+class OASISCellReaderJob
+  : public tl::JobBase
+{
+public:
+  OASISCellReaderJob (int nworkers, const OASISParallelCellReader *parent)
+    : tl::JobBase (nworkers), mp_parent (parent)
+  { }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new OASISCellReaderWorker (mp_parent);
+  }
+
+  virtual void setup_worker (tl::Worker *worker)
+  {
+    //  the scratch layouts are replaced before a new batch is started
+    static_cast<OASISCellReaderWorker *> (worker)->reset ();
+  }
+
+private:
+  const OASISParallelCellReader *mp_parent;
+};
+
+/**
+ *  @brief The parallel cell reader
+ *
+ *  This object collects the name tables and the cell offsets (S_CELL_OFFSET properties)
+ *  of a strict-mode file. The cell bodies are decoded in batches by the worker threads
+ *  ahead of the sequential reader which then merges the decoded cells in file order.
+ *  Cells which cannot be decoded by the workers (i.e. because they are not stored
+ *  in the way expected) are read sequentially.
+ */
+class OASISParallelCellReader
+{
+public:
+  OASISParallelCellReader (OASISReader *reader, int nthreads, bool editable);
+
+  bool init (bool table_offsets_at_end);
+  const OASISCellContents *fetch (size_t pos, unsigned long id);
+
+  const OASISReader &reader () const
+  {
+    return *mp_reader;
+  }
+
+  const char *data () const
+  {
+    return mp_data;
+  }
+
+  size_t size () const
+  {
+    return m_size;
+  }
+
+  bool editable () const
+  {
+    return m_editable;
+  }
+
+  const std::map<unsigned long, std::string> &cellnames () const { return m_cellnames; }
+  const std::map<unsigned long, std::string> &textstrings () const { return m_textstrings; }
+  const std::map<unsigned long, std::string> &propnames () const { return m_propnames; }
+  const std::map<unsigned long, std::string> &propstrings () const { return m_propstrings; }
+
+private:
+  OASISReader *mp_reader;
+  int m_threads;
+  bool m_editable;
+  const char *mp_data;
+  size_t m_size;
+  std::map<unsigned long, std::string> m_cellnames;
+  std::map<unsigned long, std::string> m_textstrings;
+  std::map<unsigned long, std::string> m_propnames;
+  std::map<unsigned long, std::string> m_propstrings;
+  std::map<size_t, unsigned long> m_cell_offsets;
+  std::set<size_t> m_table_offsets;
+  OASISCellReaderJob m_job;
+  //  NOTE: declared after the job, so the results are deleted before the scratch layouts
+  std::map<size_t, OASISCellContents> m_results;
+
+  bool read_table (unsigned char rec, size_t offset, std::map<unsigned long, std::string> &names, std::map<size_t, unsigned long> *cell_offsets);
+};
+
+//  The number of bytes and cells decoded per thread in one batch
+const size_t parallel_reader_batch_bytes = 16 * 1024 * 1024;
+const size_t parallel_reader_batch_cells = 256;
+
+OASISCellReaderWorker::OASISCellReaderWorker (const OASISParallelCellReader *parent)
+  : tl::Worker (), mp_parent (parent), mp_pm_target (0)
+{
+  //  .. nothing yet ..
+}
+
+void 
+OASISCellReaderWorker::reset ()
+{
+  if (mp_reader.get ()) {
+
+    //  clear the instances first since they may refer to the array repository of the scratch layout
+    mp_reader->m_instances.clear ();
+    mp_reader->m_instances_with_props.clear ();
+
+    mp_reader->m_cells_by_id.clear ();
+    mp_reader->m_cells_by_name.clear ();
+    mp_reader->m_forward_references.clear ();
+    mp_reader->m_text_forward_references.clear ();
+    mp_reader->m_propname_forward_references.clear ();
+    mp_reader->m_propvalue_forward_references.clear ();
+    mp_reader->m_layer_map = db::LayerMap ();
+    mp_reader->m_layers_created.clear ();
+
+  }
+
+  m_pm = db::PropertyMapper ();
+  mp_pm_target = 0;
+
+  mp_layout.reset (0);
+  mp_layout.reset (new db::Layout (mp_parent->editable ()));
+
+  update_property_names ();
+}
+
+void 
+OASISCellReaderWorker::update_property_names ()
+{
+  if (mp_reader.get () && mp_layout.get ()) {
+    mp_reader->m_s_gds_property_name_id = mp_layout->properties_repository ().prop_name_id ("S_GDS_PROPERTY");
+    mp_reader->m_klayout_context_property_name_id = mp_layout->properties_repository ().prop_name_id ("KLAYOUT_CONTEXT");
+  }
+}
+
+void 
+OASISCellReaderWorker::init_reader ()
+{
+  mp_memory_stream.reset (new tl::InputMemoryStream (mp_parent->data (), mp_parent->size ()));
+  mp_stream.reset (new tl::InputStream (*mp_memory_stream));
+  mp_reader.reset (new db::OASISReader (*mp_stream));
+
+  const OASISReader &parent_reader = mp_parent->reader ();
+
+  //  errors and warnings make the cell be read sequentially
+  mp_reader->set_warnings_as_errors (true);
+
+  mp_reader->m_dbu = parent_reader.m_dbu;
+  mp_reader->m_expect_strict_mode = parent_reader.m_expect_strict_mode;
+  mp_reader->m_read_texts = parent_reader.m_read_texts;
+  mp_reader->m_read_properties = parent_reader.m_read_properties;
+  mp_reader->m_read_all_properties = parent_reader.m_read_all_properties;
+  //  the layers are mapped when the cell is merged into the target layout
+  mp_reader->m_create_layers = true;
+
+  mp_reader->m_cellnames = mp_parent->cellnames ();
+  mp_reader->m_textstrings = mp_parent->textstrings ();
+  mp_reader->m_propnames = mp_parent->propnames ();
+  mp_reader->m_propstrings = mp_parent->propstrings ();
+
+  update_property_names ();
+}
+
+db::PropertyMapper &
+OASISCellReaderWorker::property_mapper (db::Layout &target)
+{
+  if (mp_pm_target != &target) {
+    m_pm = db::PropertyMapper (target, *mp_layout);
+    mp_pm_target = &target;
+  }
+  return m_pm;
+}
+
+void 
+OASISCellReaderWorker::perform_task (tl::Task *task)
+{
+  OASISCellReaderTask *cell_task = dynamic_cast<OASISCellReaderTask *> (task);
+  if (! cell_task) {
+    return;
+  }
+
+  OASISCellContents &contents = *cell_task->contents;
+  contents.worker = this;
+
+  try {
+
+    if (! mp_reader.get ()) {
+      init_reader ();
+    }
+
+    mp_stream->reset ();
+    mp_stream->get (cell_task->pos);
+
+    mp_reader->read_cell_contents (cell_task->id, *mp_layout, contents);
+
+  } catch (tl::Exception &) {
+
+    //  the cell will be read sequentially
+    contents.ok = false;
+
+    if (mp_reader.get ()) {
+      mp_reader->m_forward_references.clear ();
+      mp_reader->m_text_forward_references.clear ();
+      mp_reader->m_propname_forward_references.clear ();
+      mp_reader->m_propvalue_forward_references.clear ();
+    }
+
+  }
+}
+
+OASISParallelCellReader::OASISParallelCellReader (OASISReader *reader, int nthreads, bool editable)
+  : mp_reader (reader), m_threads (nthreads), m_editable (editable), mp_data (0), m_size (0), m_job (nthreads, this)
+{
+  //  .. nothing yet ..
+}
+
+bool 
+OASISParallelCellReader::read_table (unsigned char rec, size_t offset, std::map<unsigned long, std::string> &names, std::map<size_t, unsigned long> *cell_offsets)
+{
+  if (offset == 0) {
+    return true;
+  } else if (offset >= m_size) {
+    return false;
+  }
+
+  tl::InputMemoryStream ms (mp_data, m_size);
+  tl::InputStream is (ms);
+  is.get (offset);
+
+  //  the properties are needed to find the S_CELL_OFFSET values
+  db::Layout scratch;
+
+  OASISReader reader (is);
+  reader.set_warnings_as_errors (true);
+  reader.m_read_properties = true;
+  reader.m_propnames = m_propnames;
+  reader.m_propstrings = m_propstrings;
+  reader.m_s_gds_property_name_id = scratch.properties_repository ().prop_name_id ("S_GDS_PROPERTY");
+
+  reader.read_name_table (rec, names, cell_offsets, scratch.properties_repository ());
+
+  return true;
+}
+
+bool 
+OASISParallelCellReader::init (bool table_offsets_at_end)
+{
+  mp_data = mp_reader->m_stream.mapped_data (m_size);
+  if (! mp_data) {
+    return false;
+  }
+
+  try {
+
+    size_t table_cellname = mp_reader->m_table_cellname;
+    size_t table_textstring = mp_reader->m_table_textstring;
+    size_t table_propname = mp_reader->m_table_propname;
+    size_t table_propstring = mp_reader->m_table_propstring;
+    size_t table_layername = mp_reader->m_table_layername;
+    bool tables_strict = mp_reader->m_tables_strict;
+
+    if (table_offsets_at_end) {
+
+      //  the END record forms the last 256 bytes of the file
+      if (m_size < 256 || mp_data [m_size - 256] != 2 /*END*/) {
+        return false;
+      }
+
+      tl::InputMemoryStream ms (mp_data + m_size - 255, 255);
+      tl::InputStream is (ms);
+      OASISReader reader (is);
+      reader.set_warnings_as_errors (true);
+      reader.read_offset_table ();
+
+      table_cellname = reader.m_table_cellname;
+      table_textstring = reader.m_table_textstring;
+      table_propname = reader.m_table_propname;
+      table_propstring = reader.m_table_propstring;
+      table_layername = reader.m_table_layername;
+      tables_strict = reader.m_tables_strict;
+
+    }
+
+    if (! tables_strict || table_cellname == 0) {
+      return false;
+    }
+
+    //  the tables and the END record terminate the last cell
+    m_table_offsets.insert (table_cellname);
+    m_table_offsets.insert (table_textstring);
+    m_table_offsets.insert (table_propname);
+    m_table_offsets.insert (table_propstring);
+    m_table_offsets.insert (table_layername);
+    m_table_offsets.insert (m_size - 256);
+
+    //  NOTE: the property names are required to read the properties of the other tables
+    if (! read_table (7 /*PROPNAME*/, table_propname, m_propnames, 0) ||
+        ! read_table (9 /*PROPSTRING*/, table_propstring, m_propstrings, 0) ||
+        ! read_table (5 /*TEXTSTRING*/, table_textstring, m_textstrings, 0) ||
+        ! read_table (3 /*CELLNAME*/, table_cellname, m_cellnames, &m_cell_offsets)) {
+      return false;
+    }
+
+  } catch (tl::Exception &) {
+    return false;
+  }
+
+  return ! m_cell_offsets.empty ();
+}
+
+const OASISCellContents *
+OASISParallelCellReader::fetch (size_t pos, unsigned long id)
+{
+  std::map<size_t, OASISCellContents>::const_iterator r = m_results.find (pos);
+  if (r == m_results.end ()) {
+
+    std::map<size_t, unsigned long>::const_iterator c = m_cell_offsets.find (pos);
+    if (c == m_cell_offsets.end () || c->second != id) {
+      return 0;
+    }
+
+    //  decode a new batch of cells starting with this one
+
+    m_results.clear ();
+
+    size_t max_bytes = parallel_reader_batch_bytes * size_t (m_threads);
+    size_t max_cells = parallel_reader_batch_cells * size_t (m_threads);
+    size_t bytes = 0;
+    size_t cells = 0;
+
+    while (c != m_cell_offsets.end () && bytes < max_bytes && cells < max_cells) {
+
+      std::map<size_t, unsigned long>::const_iterator cn = c;
+      ++cn;
+      bytes += (cn != m_cell_offsets.end () ? cn->first : m_size) - c->first;
+      ++cells;
+
+      size_t limit = cn != m_cell_offsets.end () ? cn->first : m_size;
+      std::set<size_t>::const_iterator t = m_table_offsets.upper_bound (c->first);
+      if (t != m_table_offsets.end () && *t < limit) {
+        limit = *t;
+      }
+
+      OASISCellContents &contents = m_results [c->first];
+      contents.id = c->second;
+      contents.limit = limit;
+      m_job.schedule (new OASISCellReaderTask (c->first, c->second, &contents));
+
+      c = cn;
+
+    }
+
+    m_job.start ();
+    m_job.wait ();
+
+    r = m_results.find (pos);
+    tl_assert (r != m_results.end ());
+
+  }
+
+  if (r->second.ok && r->second.id == id) {
+    return &r->second;
+  } else {
+    return 0;
+  }
+}
+
 // ---------------------------------------------------------------
 //  OASISReader
 
@@ -75,6 +561,8 @@ OASISReader::OASISReader (tl::InputStream &s)
     m_progress (tl::to_string (QObject::tr ("Reading OASIS file")), 10000),
     m_dbu (0.001),
     m_expect_strict_mode (-1),
+    m_read_threads (0),
+    m_tables_strict (false),
     mm_repetition (this, "repetition"),
     mm_placement_cell (this, "placement-cell"),
     mm_placement_x (this, "playcement-x"),
@@ -106,7 +594,8 @@ OASISReader::OASISReader (tl::InputStream &s)
     m_read_properties (true),
     m_read_all_properties (false),
     m_s_gds_property_name_id (0),
-    m_klayout_context_property_name_id (0)
+    m_klayout_context_property_name_id (0),
+    mp_cell_contents (0)
 {
   m_progress.set_format (tl::to_string (QObject::tr ("%.0f MB")));
   m_progress.set_unit (1024 * 1024);
@@ -131,6 +620,7 @@ OASISReader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
   m_create_layers = common_options.create_other_layers;
   m_read_all_properties = oasis_options.read_all_properties;
   m_expect_strict_mode = oasis_options.expect_strict_mode;
+  m_read_threads = oasis_options.read_threads;
 
   layout.start_changes ();
   try {
@@ -535,6 +1025,11 @@ OASISReader::open_dl (db::Layout &layout, const LDPair &dl, bool create)
   std::pair<bool, unsigned int> ll = m_layer_map.logical (dl);
   if (ll.first) {
 
+    //  the parallel reader needs to know the order in which the layers are used
+    if (mp_cell_contents) {
+      mp_cell_contents->add_layer (ll.second);
+    }
+
     return ll;
 
   } else if (! create) {
@@ -562,6 +1057,10 @@ OASISReader::open_dl (db::Layout &layout, const LDPair &dl, bool create)
 
     m_layers_created.insert (ll);
 
+    if (mp_cell_contents) {
+      mp_cell_contents->add_layer (ll);
+    }
+
     return std::make_pair (true, ll);
 
   }
@@ -627,25 +1126,32 @@ OASISReader::read_offset_table ()
 {
   unsigned long of = 0;
 
+  //  the table-offsets are flagged strict if all name tables are complete
+  m_tables_strict = true;
+
   of = get_uint ();
+  m_tables_strict = m_tables_strict && of != 0;
   m_table_cellname = get_ulong ();
   if (m_table_cellname != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (QObject::tr ("CELLNAME offset table has unexpected strict mode")));
   }
 
   of = get_uint ();
+  m_tables_strict = m_tables_strict && of != 0;
   m_table_textstring = get_ulong ();
   if (m_table_textstring != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (QObject::tr ("TEXTSTRING offset table has unexpected strict mode")));
   }
 
   of = get_uint ();
+  m_tables_strict = m_tables_strict && of != 0;
   m_table_propname = get_ulong ();
   if (m_table_propname != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (QObject::tr ("PROPNAME offset table has unexpected strict mode")));
   }
 
   of = get_uint ();
+  m_tables_strict = m_tables_strict && of != 0;
   m_table_propstring = get_ulong ();
   if (m_table_propstring != 0 && m_expect_strict_mode >= 0 && ((of == 0) != (m_expect_strict_mode == 0))) {
     warn (tl::to_string (QObject::tr ("PROPSTRING offset table has unexpected strict mode")));
@@ -706,12 +1212,6 @@ OASISReader::do_read (db::Layout &layout)
   m_dbu = 1.0e-6 / res;
   layout.dbu (m_dbu * 1e6);
 
-  //  read over table offsets if required
-  bool table_offsets_at_end = get_uint ();
-  if (! table_offsets_at_end) {
-    read_offset_table ();
-  }
-
   //  reset the strict mode checking locations
   m_first_cellname = 0;
   m_first_propname = 0;
@@ -724,6 +1224,22 @@ OASISReader::do_read (db::Layout &layout)
   m_table_propstring = 0;
   m_table_textstring = 0;
   m_table_layername = 0;
+  m_tables_strict = false;
+
+  //  read over table offsets if required
+  bool table_offsets_at_end = get_uint ();
+  if (! table_offsets_at_end) {
+    read_offset_table ();
+  }
+
+  //  prepare the parallel cell decoder if requested and possible
+  std::auto_ptr<OASISParallelCellReader> parallel_reader;
+  if (m_read_threads > 0) {
+    parallel_reader.reset (new OASISParallelCellReader (this, m_read_threads, layout.is_editable ()));
+    if (! parallel_reader->init (table_offsets_at_end)) {
+      parallel_reader.reset (0);
+    }
+  }
 
   //  define the name id counters
   unsigned long cellname_id = 0;
@@ -1124,11 +1640,17 @@ OASISReader::do_read (db::Layout &layout)
 
       db::cell_index_type cell_index = 0;
 
+      //  the position of the CELL record (used by the parallel reader)
+      size_t cell_pos = m_stream.pos () - 1;
+      bool cell_in_cblock = m_stream.is_inflating ();
+      unsigned long cell_id = 0;
+
       //  read a cell
       if (r == 13) {
 
         unsigned long id = 0;
         get (id);
+        cell_id = id;
         if (! m_defined_cells_by_id.insert (id).second) {
           error (tl::sprintf (tl::to_string (QObject::tr ("A cell with id %ld is defined already")), id));
         }
@@ -1204,7 +1726,16 @@ OASISReader::do_read (db::Layout &layout)
       reset_modal_variables ();
       mark_start_table ();
 
-      do_read_cell (cell_index, layout);
+      const OASISCellContents *contents = 0;
+      if (parallel_reader.get () && r == 13 && ! cell_in_cblock) {
+        contents = parallel_reader->fetch (cell_pos, cell_id);
+      }
+
+      if (contents) {
+        merge_cell_contents (cell_index, layout, *contents);
+      } else {
+        do_read_cell (cell_index, layout);
+      }
 
     } else if (r == 34 /*CBLOCK*/) {
 
@@ -1462,6 +1993,12 @@ OASISReader::read_element_properties (db::PropertiesRepository &rep, bool ignore
      
     } else if (m == 34 /*CBLOCK*/) {
 
+      //  see do_read_cell
+      if (mp_cell_contents && ! m_stream.is_inflating () && m_stream.pos () > mp_cell_contents->limit) {
+        m_stream.unget (1);
+        break;
+      }
+
       unsigned int type = get_uint ();
       if (type != 0) {
         error (tl::sprintf (tl::to_string (QObject::tr ("Invalid CBLOCK compression type %d")), type));
@@ -1836,6 +2373,74 @@ OASISReader::read_repetition ()
 
 }
 
+db::cell_index_type
+OASISReader::cell_for_id (unsigned long id, db::Layout &layout)
+{
+  std::map <unsigned long, db::cell_index_type>::const_iterator cid = m_cells_by_id.find (id);
+  if (cid != m_cells_by_id.end ()) {
+    return cid->second;
+  }
+
+  db::cell_index_type ci;
+
+  //  create the cell
+  std::map <unsigned long, std::string>::const_iterator name = m_cellnames.find (id);
+  if (name == m_cellnames.end ()) {
+
+    ci = layout.add_cell ();
+    m_forward_references.insert (std::make_pair (id, ci));
+
+    //  temporarily mark as "ghost cell"
+    layout.cell (ci).set_ghost_cell (true);
+
+  } else {
+
+    std::pair<bool, db::cell_index_type> c = layout.cell_by_name (name->second.c_str ()); 
+    if (c.first) {
+      //  take existing cell
+      ci = c.second;
+    } else {
+      //  create the cell
+      ci = layout.add_cell (name->second.c_str ());
+      //  temporarily mark as "ghost cell"
+      layout.cell (ci).set_ghost_cell (true);
+    }
+
+    m_cells_by_name.insert (std::make_pair (name->second, ci));
+   
+  }
+
+  m_cells_by_id.insert (std::make_pair (id, ci));
+
+  return ci;
+}
+
+db::cell_index_type
+OASISReader::cell_for_name (const std::string &name, db::Layout &layout)
+{
+  std::map <std::string, db::cell_index_type>::const_iterator cid = m_cells_by_name.find (name);
+  if (cid != m_cells_by_name.end ()) {
+    return cid->second;
+  }
+
+  db::cell_index_type ci;
+
+  std::pair<bool, db::cell_index_type> c = layout.cell_by_name (name.c_str ()); 
+  if (c.first) {
+    //  take existing cell
+    ci = c.second;
+  } else {
+    //  create the cell
+    ci = layout.add_cell (name.c_str ());
+    //  temporarily mark as "ghost cell"
+    layout.cell (ci).set_ghost_cell (true);
+  }
+
+  m_cells_by_name.insert (std::make_pair (name, ci));
+
+  return ci;
+}
+
 void 
 OASISReader::do_read_placement (unsigned char r,
                                 bool xy_absolute,
@@ -1853,40 +2458,11 @@ OASISReader::do_read_placement (unsigned char r,
       //  cell by id
       unsigned long id;
       get (id);
-      std::map <unsigned long, db::cell_index_type>::const_iterator cid = m_cells_by_id.find (id);
-      if (cid == m_cells_by_id.end ()) {
-
-        //  create the cell
-        std::map <unsigned long, std::string>::const_iterator name = m_cellnames.find (id);
-        if (name == m_cellnames.end ()) {
-
-          mm_placement_cell = layout.add_cell ();
-          m_forward_references.insert (std::make_pair (id, mm_placement_cell.get ()));
-
-          //  temporarily mark as "ghost cell"
-          layout.cell (mm_placement_cell.get ()).set_ghost_cell (true);
+      mm_placement_cell = cell_for_id (id, layout);
 
-        } else {
-
-          std::pair<bool, db::cell_index_type> c = layout.cell_by_name (name->second.c_str ()); 
-          if (c.first) {
-            //  take existing cell
-            mm_placement_cell = c.second;
-          } else {
-            //  create the cell
-            mm_placement_cell = layout.add_cell (name->second.c_str ());
-            //  temporarily mark as "ghost cell"
-            layout.cell (mm_placement_cell.get ()).set_ghost_cell (true);
-          }
-
-          m_cells_by_name.insert (std::make_pair (name->second, mm_placement_cell.get ()));
-         
-        }
-
-        m_cells_by_id.insert (std::make_pair (id, mm_placement_cell.get ()));
-
-      } else {
-        mm_placement_cell = cid->second;
+      //  the parallel reader needs to resolve the references later
+      if (mp_cell_contents) {
+        mp_cell_contents->references.push_back (OASISCellReference (mm_placement_cell.get (), id));
       }
 
     } else {
@@ -1894,25 +2470,10 @@ OASISReader::do_read_placement (unsigned char r,
       //  cell by name
       std::string name;
       get_str (name);
+      mm_placement_cell = cell_for_name (name, layout);
 
-      std::map <std::string, db::cell_index_type>::const_iterator cid = m_cells_by_name.find (name);
-      if (cid == m_cells_by_name.end ()) {
-
-        std::pair<bool, db::cell_index_type> c = layout.cell_by_name (name.c_str ()); 
-        if (c.first) {
-          //  take existing cell
-          mm_placement_cell = c.second;
-        } else {
-          //  create the cell
-          mm_placement_cell = layout.add_cell (name.c_str ());
-          //  temporarily mark as "ghost cell"
-          layout.cell (mm_placement_cell.get ()).set_ghost_cell (true);
-        }
-
-        m_cells_by_name.insert (std::make_pair (name, mm_placement_cell.get ()));
-
-      } else {
-        mm_placement_cell = cid->second;
+      if (mp_cell_contents) {
+        mp_cell_contents->references.push_back (OASISCellReference (mm_placement_cell.get (), name));
       }
 
     }
@@ -3514,6 +4075,12 @@ OASISReader::do_read_cell (db::cell_index_type cell_index, db::Layout &layout)
 
     } else if (r == 34 /*CBLOCK*/) {
 
+      //  the parallel reader must not consume a CBLOCK which belongs to the next cell or table
+      if (mp_cell_contents && ! m_stream.is_inflating () && m_stream.pos () > mp_cell_contents->limit) {
+        m_stream.unget (1);
+        break;
+      }
+
       unsigned int type = get_uint ();
       if (type != 0) {
         error (tl::sprintf (tl::to_string (QObject::tr ("Invalid CBLOCK compression type %d")), type));
@@ -3537,6 +4104,20 @@ OASISReader::do_read_cell (db::cell_index_type cell_index, db::Layout &layout)
     layout.cell (cell_index).prop_id (layout.properties_repository ().properties_id (cell_properties));
   }
 
+  if (mp_cell_contents) {
+
+    //  parallel reading: the instances and the context are taken over when the cell
+    //  is merged into the target layout
+    mp_cell_contents->instances.swap (m_instances);
+    mp_cell_contents->instances_with_props.swap (m_instances_with_props);
+    mp_cell_contents->has_context = has_context;
+    mp_cell_contents->context_strings.swap (context_strings);
+
+    m_cellname = "";
+    return;
+
+  }
+
   //  insert all instances collected (inserting them once is 
   //  more effective than doing this every time)
   if (! m_instances.empty ()) {
@@ -3560,5 +4141,184 @@ OASISReader::do_read_cell (db::cell_index_type cell_index, db::Layout &layout)
   m_cellname = "";
 }
 
+void
+OASISReader::read_cell_contents (unsigned long id, db::Layout &layout, OASISCellContents &contents)
+{
+  contents.ok = false;
+
+  if (get_byte () != 13 /*CELL*/) {
+    error (tl::to_string (QObject::tr ("CELL record expected at cell offset")));
+  }
+
+  unsigned long cell_id = 0;
+  get (cell_id);
+  if (cell_id != id) {
+    error (tl::to_string (QObject::tr ("Cell offset does not point to the CELL record of this cell")));
+  }
+
+  contents.cell_index = cell_for_id (id, layout);
+
+  reset_modal_variables ();
+  mark_start_table ();
+
+  mp_cell_contents = &contents;
+  try {
+    do_read_cell (contents.cell_index, layout);
+    mp_cell_contents = 0;
+  } catch (...) {
+    mp_cell_contents = 0;
+    throw;
+  }
+
+  //  references which are not resolved by the name tables can only be handled by the sequential reader
+  if (! m_forward_references.empty () || ! m_text_forward_references.empty () || ! m_propname_forward_references.empty () || ! m_propvalue_forward_references.empty ()) {
+    error (tl::to_string (QObject::tr ("Unresolved forward references in cell")));
+  }
+
+  //  the cell must not end inside a CBLOCK, otherwise the stream can't be positioned behind the cell
+  if (m_stream.is_inflating ()) {
+    error (tl::to_string (QObject::tr ("Cell ends inside a CBLOCK")));
+  }
+
+  contents.end_pos = m_stream.pos ();
+  contents.ok = true;
+}
+
+void
+OASISReader::merge_cell_contents (db::cell_index_type cell_index, db::Layout &layout, const OASISCellContents &contents)
+{
+  m_cellname = layout.cell_name (cell_index);
+
+  const db::Layout &source_layout = contents.worker->layout ();
+  const db::Cell &source_cell = source_layout.cell (contents.cell_index);
+  db::PropertyMapper &pm = contents.worker->property_mapper (layout);
+
+  db::Cell &cell = layout.cell (cell_index);
+
+  //  resolve the cell references in the order they appear in the file
+  std::map<db::cell_index_type, db::cell_index_type> cell_map;
+  for (std::vector<OASISCellReference>::const_iterator r = contents.references.begin (); r != contents.references.end (); ++r) {
+    db::cell_index_type ci = r->by_name ? cell_for_name (r->name, layout) : cell_for_id (r->id, layout);
+    cell_map.insert (std::make_pair (r->cell, ci));
+  }
+
+  //  take the shapes
+  for (std::vector<unsigned int>::const_iterator l = contents.layers.begin (); l != contents.layers.end (); ++l) {
+    const db::LayerProperties &lp = source_layout.get_properties (*l);
+    std::pair<bool, unsigned int> ll = open_dl (layout, LDPair (lp.layer, lp.datatype), m_create_layers);
+    if (ll.first) {
+      cell.shapes (ll.second).insert (source_cell.shapes (*l), pm);
+    }
+  }
+
+  if (source_cell.prop_id () != 0) {
+    cell.prop_id (pm (source_cell.prop_id ()));
+  }
+
+  //  take the instances
+  if (! contents.instances.empty ()) {
+
+    tl::vector<db::CellInstArray> instances;
+    instances.reserve (contents.instances.size ());
+
+    for (tl::vector<db::CellInstArray>::const_iterator i = contents.instances.begin (); i != contents.instances.end (); ++i) {
+      instances.push_back (db::CellInstArray (*i, i->in_repository () ? &layout.array_repository () : 0));
+      instances.back ().object () = db::CellInst (cell_map [i->object ().cell_index ()]);
+    }
+
+    cell.insert (instances.begin (), instances.end ());
+
+  }
+
+  if (! contents.instances_with_props.empty ()) {
+
+    tl::vector<db::CellInstArrayWithProperties> instances;
+    instances.reserve (contents.instances_with_props.size ());
+
+    for (tl::vector<db::CellInstArrayWithProperties>::const_iterator i = contents.instances_with_props.begin (); i != contents.instances_with_props.end (); ++i) {
+      instances.push_back (db::CellInstArrayWithProperties (db::CellInstArray (*i, i->in_repository () ? &layout.array_repository () : 0), pm (i->properties_id ())));
+      instances.back ().object () = db::CellInst (cell_map [i->object ().cell_index ()]);
+    }
+
+    cell.insert (instances.begin (), instances.end ());
+
+  }
+
+  //  Restore proxy cell (link to PCell or Library)
+  if (contents.has_context) {
+    OASISReaderLayerMapping layer_mapping (this, &layout, m_create_layers);
+    layout.recover_proxy_as (cell_index, contents.context_strings.begin (), contents.context_strings.end (), &layer_mapping);
+  }
+
+  //  continue behind the cell
+  size_t pos = m_stream.pos ();
+  if (contents.end_pos > pos) {
+    m_stream.get (contents.end_pos - pos);
+  }
+  mark_start_table ();
+
+  m_progress.set (m_stream.pos ());
+  m_cellname = "";
+}
+
+void
+OASISReader::read_name_table (unsigned char rec, std::map<unsigned long, std::string> &names, std::map<size_t, unsigned long> *cell_offsets, db::PropertiesRepository &rep)
+{
+  db::property_names_id_type cell_offset_name_id = rep.prop_name_id (tl::Variant ("S_CELL_OFFSET"));
+  unsigned long next_id = 0;
+
+  while (true) {
+
+    unsigned char r = get_byte ();
+
+    if (r == 0 /*PAD*/) {
+
+      //  simply skip.
+
+    } else if (r == 34 /*CBLOCK*/) {
+
+      unsigned int type = get_uint ();
+      if (type != 0) {
+        error (tl::sprintf (tl::to_string (QObject::tr ("Invalid CBLOCK compression type %d")), type));
+      }
+
+      get_uint ();  // uncomp-byte-count - not needed
+      get_uint ();  // comp-byte-count - not needed
+
+      //  put the stream into deflating mode
+      m_stream.inflate ();
+
+    } else if (r == rec || r == rec + 1) {
+
+      std::string name = get_str ();
+
+      unsigned long id = next_id;
+      if (r == rec) {
+        ++next_id;
+      } else {
+        get (id);
+      }
+
+      names.insert (std::make_pair (id, name));
+
+      reset_modal_variables ();
+
+      std::pair<bool, db::properties_id_type> pp = read_element_properties (rep, false);
+      if (cell_offsets && pp.first) {
+        const db::PropertiesRepository::properties_set &props = rep.properties (pp.second);
+        db::PropertiesRepository::properties_set::const_iterator p = props.find (cell_offset_name_id);
+        if (p != props.end () && p->second.can_convert_to_ulong ()) {
+          cell_offsets->insert (std::make_pair (size_t (p->second.to_ulong ()), id));
+        }
+      }
+
+    } else {
+      //  end of table
+      break;
+    }
+
+  }
+}
+
 }
 
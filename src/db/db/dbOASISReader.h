@@ -44,6 +44,8 @@
 namespace db
 {
 
+struct OASISCellContents;
+
 /**
  *  @brief Generic base class of OASIS reader exceptions
  */
@@ -67,7 +69,7 @@ public:
    *  @brief The constructor
    */
   OASISReaderOptions ()
-    : read_all_properties (false), expect_strict_mode (-1)
+    : read_all_properties (false), expect_strict_mode (-1), read_threads (0)
   {
     //  .. nothing yet ..
   }
@@ -94,6 +96,18 @@ public:
    */
   int expect_strict_mode;
 
+  /**
+   *  @brief The number of threads to use for decoding the cells
+   *
+   *  If this value is larger than 0, the reader will decode the cell bodies on
+   *  the given number of threads. This is possible for strict-mode files which
+   *  provide S_CELL_OFFSET properties for the cells and if the file can be 
+   *  accessed randomly (i.e. is an uncompressed local file). Otherwise the file
+   *  is read sequentially.
+   *  The default value is 0 (sequential reading).
+   */
+  int read_threads;
+
   /**
    *  @brief Implementation of FormatSpecificReaderOptions
    */
@@ -188,6 +202,8 @@ public:
 
 private:
   friend class OASISReaderLayerMapping;
+  friend class OASISCellReaderWorker;
+  friend class OASISParallelCellReader;
 
   typedef db::coord_traits<db::Coord>::distance_type distance_type;
 
@@ -208,6 +224,7 @@ private:
   std::string m_cellname;
   double m_dbu;
   int m_expect_strict_mode;
+  int m_read_threads;
   size_t m_first_cellname;
   size_t m_first_propname;
   size_t m_first_propstring;
@@ -220,6 +237,7 @@ private:
   size_t m_table_textstring;
   size_t m_table_layername;
   size_t m_table_start;
+  bool m_tables_strict;
 
   modal_variable<Repetition> mm_repetition;
   modal_variable<db::cell_index_type> mm_placement_cell;
@@ -275,8 +293,15 @@ private:
   db::property_names_id_type m_s_gds_property_name_id;
   db::property_names_id_type m_klayout_context_property_name_id;
 
+  OASISCellContents *mp_cell_contents;
+
   void do_read (db::Layout &layout);
   void do_read_cell (db::cell_index_type cell_index, db::Layout &layout);
+  void read_cell_contents (unsigned long id, db::Layout &layout, OASISCellContents &contents);
+  void merge_cell_contents (db::cell_index_type cell_index, db::Layout &layout, const OASISCellContents &contents);
+  void read_name_table (unsigned char rec, std::map<unsigned long, std::string> &names, std::map<size_t, unsigned long> *cell_offsets, db::PropertiesRepository &rep);
+  db::cell_index_type cell_for_id (unsigned long id, db::Layout &layout);
+  db::cell_index_type cell_for_name (const std::string &name, db::Layout &layout);
 
   void do_read_placement (unsigned char r,
                           bool xy_absolute,
@@ -26,8 +26,12 @@
 
 #include "tlDeflate.h"
 #include "tlMath.h"
+#include "tlThreadedWorkers.h"
+#include "tlLog.h"
 
 #include <math.h>
+#include <list>
+#include <memory>
 
 namespace db
 {
@@ -655,6 +659,209 @@ Compressor<Obj>::flush (db::OASISWriter *writer)
   }
 }
 
+// ---------------------------------------------------------------------------------
+//  CBLOCK compression
+
+/**
+ *  @brief Deflates the raw data into the compressed buffer (RFC1951)
+ */
+static void
+deflate_cblock (const tl::OutputMemoryStream &raw, tl::OutputMemoryStream &compressed)
+{
+  compressed.clear ();
+  tl::OutputStream deflated_stream (compressed);
+  tl::DeflateFilter deflate (deflated_stream);
+
+  deflate.put (raw.data (), raw.size ());
+  deflate.flush ();
+}
+
+/**
+ *  @brief A segment of the output collected by OASISCBlockCompressor
+ *
+ *  A segment is either plain data written outside CBLOCKs or the data of a CBLOCK.
+ *  For the latter, the compressed data is produced by the worker threads.
+ */
+struct OASISCBlockSegment
+{
+  OASISCBlockSegment (bool _is_cblock)
+    : is_cblock (_is_cblock)
+  { }
+
+  bool is_cblock;
+  tl::OutputMemoryStream raw, compressed;
+  std::vector<std::pair<size_t, size_t *> > marks;
+};
+
+/**
+ *  @brief A task compressing one CBLOCK segment
+ */
+class OASISCBlockTask
+  : public tl::Task
+{
+public:
+  OASISCBlockTask (OASISCBlockSegment *segment)
+    : mp_segment (segment)
+  { }
+
+  void perform ()
+  {
+    deflate_cblock (mp_segment->raw, mp_segment->compressed);
+  }
+
+private:
+  OASISCBlockSegment *mp_segment;
+};
+
+/**
+ *  @brief The worker for OASISCBlockJob
+ */
+class OASISCBlockWorker
+  : public tl::Worker
+{
+public:
+  OASISCBlockWorker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    OASISCBlockTask *cblock_task = dynamic_cast<OASISCBlockTask *> (task);
+    if (cblock_task) {
+      cblock_task->perform ();
+    }
+  }
+};
+
+/**
+ *  @brief The job compressing the CBLOCKs
+ */
+class OASISCBlockJob
+  : public tl::JobBase
+{
+public:
+  OASISCBlockJob (int nworkers)
+    : tl::JobBase (nworkers)
+  { }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new OASISCBlockWorker ();
+  }
+};
+
+/**
+ *  @brief Collects the output of the writer while the CBLOCKs are compressed in the background
+ *
+ *  The writer's output is kept as a sequence of segments. CBLOCK segments are handed over to
+ *  the worker threads as soon as they are complete. The segments are emitted in their original
+ *  order once the compression has finished, so the output does not depend on the number of threads.
+ *  File positions requested while collecting (through "mark") are resolved on emission.
+ */
+class OASISCBlockCompressor
+{
+public:
+  typedef std::list<OASISCBlockSegment>::iterator iterator;
+
+  OASISCBlockCompressor (int nworkers)
+    : m_job (nworkers), m_nworkers (nworkers), m_pending (0)
+  { }
+
+  ~OASISCBlockCompressor ()
+  {
+    m_job.terminate ();
+  }
+
+  /**
+   *  @brief Adds plain data
+   */
+  void put_raw (const char *b, size_t n)
+  {
+    raw_segment ().raw.write (b, n);
+    m_pending += n;
+  }
+
+  /**
+   *  @brief Adds a CBLOCK
+   *
+   *  The buffer is taken over and cleared.
+   */
+  void put_cblock (tl::OutputMemoryStream &buffer)
+  {
+    m_pending += buffer.size ();
+
+    m_segments.push_back (OASISCBlockSegment (true));
+    m_segments.back ().raw.swap (buffer);
+
+    m_job.schedule (new OASISCBlockTask (&m_segments.back ()));
+    if (! m_job.is_running ()) {
+      m_job.start ();
+    }
+  }
+
+  /**
+   *  @brief Requests the file position of the next byte
+   *
+   *  The position will be stored in *pos, but only after the segments have been emitted.
+   */
+  void mark (size_t *pos)
+  {
+    OASISCBlockSegment &seg = raw_segment ();
+    seg.marks.push_back (std::make_pair (seg.raw.size (), pos));
+  }
+
+  /**
+   *  @brief Returns true, if enough data is collected to emit the segments
+   */
+  bool needs_flush () const
+  {
+    //  keep a few MB per thread in flight
+    return m_pending > size_t (m_nworkers) * 4 * 1024 * 1024;
+  }
+
+  /**
+   *  @brief Waits for the compression to finish
+   */
+  void wait ()
+  {
+    m_job.wait ();
+    if (m_job.has_error ()) {
+      throw tl::Exception (tl::to_string (QObject::tr ("Errors occured during CBLOCK compression. First error message says:\n")) + m_job.error_messages ().front ());
+    }
+  }
+
+  iterator begin ()
+  {
+    return m_segments.begin ();
+  }
+
+  iterator end ()
+  {
+    return m_segments.end ();
+  }
+
+  void clear ()
+  {
+    m_segments.clear ();
+    m_pending = 0;
+  }
+
+private:
+  OASISCBlockJob m_job;
+  int m_nworkers;
+  std::list<OASISCBlockSegment> m_segments;
+  size_t m_pending;
+
+  OASISCBlockSegment &raw_segment ()
+  {
+    if (m_segments.empty () || m_segments.back ().is_cblock) {
+      m_segments.push_back (OASISCBlockSegment (false));
+    }
+    return m_segments.back ();
+  }
+};
+
 // ---------------------------------------------------------------------------------
 //  OASISWriter implementation
 
@@ -665,12 +872,22 @@ OASISWriter::OASISWriter ()
     mp_cell (0),
     m_layer (0), m_datatype (0),
     m_in_cblock (false),
+    mp_cblock_compressor (0),
+    mp_cellwise_cblock_compressor (0),
     m_progress (tl::to_string (QObject::tr ("Writing OASIS file")), 10000)
 {
   m_progress.set_format (tl::to_string (QObject::tr ("%.0f MB")));
   m_progress.set_unit (1024 * 1024);
 }
 
+OASISWriter::~OASISWriter ()
+{
+  if (mp_cellwise_cblock_compressor) {
+    delete mp_cellwise_cblock_compressor;
+    mp_cellwise_cblock_compressor = 0;
+  }
+}
+
 // 1M CBLOCK buffer size
 const size_t cblock_buffer_size = 1024 * 1024;
 
@@ -683,6 +900,8 @@ OASISWriter::write_record_id (char b)
       begin_cblock ();
     } 
     m_cblock_buffer.write ((const char *) &b, 1);
+  } else if (mp_cblock_compressor) {
+    mp_cblock_compressor->put_raw ((const char *) &b, 1);
   } else {
     mp_stream->put ((const char *) &b, 1);
   }
@@ -693,6 +912,8 @@ OASISWriter::write_byte (char b)
 {
   if (m_in_cblock) {
     m_cblock_buffer.write ((const char *) &b, 1);
+  } else if (mp_cblock_compressor) {
+    mp_cblock_compressor->put_raw ((const char *) &b, 1);
   } else {
     mp_stream->put ((const char *) &b, 1);
   }
@@ -703,6 +924,8 @@ OASISWriter::write_bytes (const char *b, size_t n)
 {
   if (m_in_cblock) {
     m_cblock_buffer.write (b, n);
+  } else if (mp_cblock_compressor) {
+    mp_cblock_compressor->put_raw (b, n);
   } else {
     mp_stream->put (b, n);
   }
@@ -1061,34 +1284,85 @@ OASISWriter::end_cblock ()
 {
   tl_assert (m_in_cblock);
 
-  m_cblock_compressed.clear ();
-  tl::OutputStream deflated_stream (m_cblock_compressed);
-  tl::DeflateFilter deflate (deflated_stream);
+  m_in_cblock = false;
 
-  deflate.put (m_cblock_buffer.data (), m_cblock_buffer.size ());
-  deflate.flush ();
+  if (mp_cblock_compressor) {
+
+    //  compress in the background
+    mp_cblock_compressor->put_cblock (m_cblock_buffer);
+    if (mp_cblock_compressor->needs_flush ()) {
+      flush_cblocks ();
+    }
+
+  } else {
+
+    deflate_cblock (m_cblock_buffer, m_cblock_compressed);
+    write_cblock (m_cblock_buffer, m_cblock_compressed);
+
+    m_cblock_buffer.clear ();
+    m_cblock_compressed.clear ();
+
+  }
+}
 
+void
+OASISWriter::write_cblock (const tl::OutputMemoryStream &buffer, const tl::OutputMemoryStream &compressed)
+{
   const size_t compression_overhead = 4;
-  m_in_cblock = false;
 
-  if (m_cblock_buffer.size () > m_cblock_compressed.size () + compression_overhead) {
+  if (buffer.size () > compressed.size () + compression_overhead) {
 
     write_byte (34);  // CBLOCK
 
     //  RFC1951 compression:
     write_byte (0); 
 
-    write (m_cblock_buffer.size ());
-    write (m_cblock_compressed.size ());
+    write (buffer.size ());
+    write (compressed.size ());
 
-    write_bytes (m_cblock_compressed.data (), m_cblock_compressed.size ());
+    write_bytes (compressed.data (), compressed.size ());
 
   } else {
-    write_bytes (m_cblock_buffer.data (), m_cblock_buffer.size ());
+    write_bytes (buffer.data (), buffer.size ());
   }
+}
 
-  m_cblock_buffer.clear ();
-  m_cblock_compressed.clear ();
+void
+OASISWriter::flush_cblocks ()
+{
+  if (! mp_cblock_compressor) {
+    return;
+  }
+
+  //  write directly to the stream while emitting the segments
+  OASISCBlockCompressor *compressor = mp_cblock_compressor;
+  mp_cblock_compressor = 0;
+
+  try {
+
+    compressor->wait ();
+
+    for (OASISCBlockCompressor::iterator s = compressor->begin (); s != compressor->end (); ++s) {
+      if (s->is_cblock) {
+        write_cblock (s->raw, s->compressed);
+      } else {
+        for (std::vector<std::pair<size_t, size_t *> >::const_iterator m = s->marks.begin (); m != s->marks.end (); ++m) {
+          *m->second = mp_stream->pos () + m->first;
+        }
+        write_bytes (s->raw.data (), s->raw.size ());
+      }
+    }
+
+    compressor->clear ();
+
+  } catch (...) {
+    mp_cblock_compressor = compressor;
+    throw;
+  }
+
+  mp_cblock_compressor = compressor;
+
+  m_progress.set (mp_stream->pos ());
 }
 
 void 
@@ -1151,6 +1425,7 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
   m_layer = m_datatype = 0;
   m_in_cblock = false;
   m_cblock_buffer.clear ();
+  mp_cblock_compressor = 0;
 
   m_options = options.get_options<OASISWriterOptions> ();
   mp_stream = &stream;
@@ -1567,92 +1842,32 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
 
   }
 
-  std::vector <std::string> context_prop_strings;
+  //  with multiple threads, the cell's CBLOCKs are compressed in the background
+  std::auto_ptr<OASISCBlockCompressor> cblock_compressor;
+  if (m_options.write_cblocks && m_options.cblock_threads > 0) {
+    cblock_compressor.reset (new OASISCBlockCompressor (m_options.cblock_threads));
+    mp_cblock_compressor = cblock_compressor.get ();
+  }
 
   for (std::vector<db::cell_index_type>::const_iterator cell = cells.begin (); cell != cells.end (); ++cell) {
 
     m_progress.set (mp_stream->pos ());
 
-    //  cell body 
     const db::Cell &cref (layout.cell (*cell));
-    mp_cell = &cref;
 
     //  don't write ghost cells unless they are not empty (any more)
     //  also don't write proxy cells which are not employed
     if ((! cref.is_ghost_cell () || ! cref.empty ()) && (! cref.is_proxy () || ! cref.is_top ())) {
-
-      //  cell header 
-
-      cell_positions.insert (std::make_pair (*cell, mp_stream->pos ()));
-
-      write_record_id (13);  // CELL
-      write ((unsigned long) *cell);
-
-      reset_modal_variables ();
-
-      if (m_options.write_cblocks) {
-        begin_cblock ();
-      }
-
-      //  context information as property named KLAYOUT_CONTEXT
-      if (cref.is_proxy ()) {
-
-        context_prop_strings.clear ();
-
-        if (layout.get_context_info (*cell, context_prop_strings)) {
-
-          write_record_id (28);
-          write_byte (char (0xf6)); 
-          std::map <std::string, unsigned long>::const_iterator pni = m_propnames.find (klayout_context_name);
-          tl_assert (pni != m_propnames.end ());
-          write (pni->second);
-
-          write ((unsigned long) context_prop_strings.size ());
-
-          for (std::vector <std::string>::const_iterator c = context_prop_strings.begin (); c != context_prop_strings.end (); ++c) {
-            write_byte (14); // b-string by reference number
-            std::map <std::string, unsigned long>::const_iterator psi = m_propstrings.find (*c);
-            tl_assert (psi != m_propstrings.end ());
-            write (psi->second);
-          }
-
-          mm_last_property_name = klayout_context_name;
-          mm_last_property_is_sprop = false;
-          mm_last_value_list.reset ();
-
-        }
-
-      }
-
-      if (cref.prop_id () != 0) {
-        write_props (cref.prop_id ());
-      }
-
-      //  instances
-      if (cref.cell_instances () > 0) {
-        write_insts (cell_set);
-      }
-
-      //  shapes
-      for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
-        const db::Shapes &shapes = cref.shapes (l->first);
-        if (! shapes.empty ()) {
-          write_shapes (l->second, shapes);
-          m_progress.set (mp_stream->pos ());
-        }
-      }
-
-      //  end CBLOCK if required
-      if (m_options.write_cblocks) {
-        end_cblock ();
-      } 
-
-      //  end of cell
-
+      size_t &cell_pos = cell_positions.insert (std::make_pair (*cell, size_t (0))).first->second;
+      write_cell_body (*cell, cell_pos, &cell_set, layers, true);
     }
 
   }
 
+  flush_cblocks ();
+  mp_cblock_compressor = 0;
+  cblock_compressor.reset (0);
+
   //  write cell table at the end in strict mode (in that mode we need the cell positions
   //  for the S_CELL_OFFSET properties)
   
@@ -1751,6 +1966,12 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
 
   } 
 
+  finish_end_record (end_record_pos);
+}
+
+void
+OASISWriter::finish_end_record (size_t end_record_pos)
+{
   //  write a b-string to pad up to 255 bytes
   //  (this bstring consists of a "long zero" and no characters
   while (mp_stream->pos () < end_record_pos + 254) {
@@ -1764,6 +1985,280 @@ OASISWriter::write (db::Layout &layout, tl::OutputStream &stream, const db::Save
   m_progress.set (mp_stream->pos ());
 }
 
+void
+OASISWriter::write_cell_body (db::cell_index_type cell_index, size_t &cell_pos, const std::set <db::cell_index_type> *cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, bool with_context)
+{
+  const db::Cell &cref (mp_layout->cell (cell_index));
+  mp_cell = &cref;
+
+  //  cell header 
+
+  if (mp_cblock_compressor) {
+    mp_cblock_compressor->mark (&cell_pos);
+  } else {
+    cell_pos = mp_stream->pos ();
+  }
+
+  write_record_id (13);  // CELL
+  write ((unsigned long) cell_index);
+
+  reset_modal_variables ();
+
+  if (m_options.write_cblocks) {
+    begin_cblock ();
+  }
+
+  //  context information as property named KLAYOUT_CONTEXT
+  if (with_context && cref.is_proxy ()) {
+
+    std::vector <std::string> context_prop_strings;
+
+    if (mp_layout->get_context_info (cell_index, context_prop_strings)) {
+
+      write_record_id (28);
+      write_byte (char (0xf6)); 
+      std::map <std::string, unsigned long>::const_iterator pni = m_propnames.find (klayout_context_name);
+      tl_assert (pni != m_propnames.end ());
+      write (pni->second);
+
+      write ((unsigned long) context_prop_strings.size ());
+
+      for (std::vector <std::string>::const_iterator c = context_prop_strings.begin (); c != context_prop_strings.end (); ++c) {
+        write_byte (14); // b-string by reference number
+        std::map <std::string, unsigned long>::const_iterator psi = m_propstrings.find (*c);
+        tl_assert (psi != m_propstrings.end ());
+        write (psi->second);
+      }
+
+      mm_last_property_name = klayout_context_name;
+      mm_last_property_is_sprop = false;
+      mm_last_value_list.reset ();
+
+    }
+
+  }
+
+  if (cref.prop_id () != 0) {
+    write_props (cref.prop_id ());
+  }
+
+  //  instances
+  if (cref.cell_instances () > 0) {
+    write_insts (cell_set);
+  }
+
+  //  shapes
+  for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+    const db::Shapes &shapes = cref.shapes (l->first);
+    if (! shapes.empty ()) {
+      write_shapes (l->second, shapes);
+      m_progress.set (mp_stream->pos ());
+    }
+  }
+
+  //  end CBLOCK if required
+  if (m_options.write_cblocks) {
+    end_cblock ();
+  } 
+
+  //  end of cell
+}
+
+void
+OASISWriter::begin_cellwise (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options)
+{
+  typedef db::coord_traits<db::Coord>::distance_type coord_distance_type;
+
+  mp_layout = &layout;
+  mp_cell = 0;
+  m_layer = m_datatype = 0;
+  m_in_cblock = false;
+  m_cblock_buffer.clear ();
+  mp_cblock_compressor = 0;
+
+  m_cellwise_options = options;
+  m_options = options.get_options<OASISWriterOptions> ();
+  mp_stream = &stream;
+
+  //  The name tables are written before each cell as required. Hence there are no
+  //  contiguous tables which rules out strict mode. The top cells are not known in
+  //  advance, nor are the bounding boxes.
+  if (m_options.strict_mode) {
+    tl::warn << tl::to_string (QObject::tr ("Strict mode is not supported for cell-wise OASIS writing - strict mode is disabled"));
+    m_options.strict_mode = false;
+  }
+  if (m_options.write_std_properties > 1) {
+    m_options.write_std_properties = 1;
+  }
+
+  double dbu = (options.dbu () == 0.0) ? layout.dbu () : options.dbu ();
+  m_sf = options.scale_factor () * (layout.dbu () / dbu);
+  if (fabs (m_sf - 1.0) < 1e-9) {
+    //  to avoid rounding problems, set to 1.0 exactly if possible.
+    m_sf = 1.0;
+  }
+
+  //  write header
+
+  char magic[] = "%SEMI-OASIS\015\012";
+  write_bytes (magic, sizeof (magic) - 1);
+
+  //  START record
+  write_record_id (1); 
+  write_bstring ("1.0");
+  write (1.0 / dbu);
+  write_byte (0);  //  offset-flag (non-strict mode: at the beginning)
+
+  //  offset table:
+  for (unsigned int i = 0; i < 12; ++i) {
+    write_byte (0);
+  }
+
+  reset_modal_variables ();
+
+  m_textstrings.clear ();
+  m_propnames.clear ();
+  m_propstrings.clear ();
+  m_propstring_id = m_propname_id = 0;
+  m_proptables_written = false;
+
+  m_cellwise_cellnames.clear ();
+  m_cellwise_layers.clear ();
+  m_cellwise_prop_ids.clear ();
+  m_cell_positions.clear ();
+
+  if (m_options.write_std_properties > 0) {
+    write_property_def (s_max_signed_integer_width_name, tl::Variant (sizeof (db::Coord)), true);
+    write_property_def (s_max_unsigned_integer_width_name, tl::Variant (sizeof (coord_distance_type)), true);
+  }
+
+  if (layout.prop_id () != 0) {
+    write_props (layout.prop_id ());
+  }
+
+  if (m_options.write_cblocks && m_options.cblock_threads > 0) {
+    mp_cellwise_cblock_compressor = new OASISCBlockCompressor (m_options.cblock_threads);
+    mp_cblock_compressor = mp_cellwise_cblock_compressor;
+  }
+}
+
+void
+OASISWriter::write_cell (db::Layout &layout, db::cell_index_type cell_index)
+{
+  tl_assert (mp_layout == &layout);
+
+  m_progress.set (mp_stream->pos ());
+
+  const db::Cell &cref (layout.cell (cell_index));
+
+  //  new layers may appear while reading, so the layer list is updated for every cell
+  std::vector <std::pair <unsigned int, db::LayerProperties> > layers;
+  m_cellwise_options.get_valid_layers (layout, layers, db::SaveLayoutOptions::LP_AssignNumber);
+
+  //  emit the names required by this cell before the cell itself
+
+  if (m_cellwise_cellnames.insert (cell_index).second) {
+    write_record_id (4);
+    write_nstring (layout.cell_name (cell_index));
+    write ((unsigned long) cell_index);
+  }
+
+  for (db::Cell::const_iterator inst = cref.begin (); ! inst.at_end (); ++inst) {
+    db::cell_index_type ci = inst->cell_index ();
+    if (m_cellwise_cellnames.insert (ci).second) {
+      write_record_id (4);
+      write_nstring (layout.cell_name (ci));
+      write ((unsigned long) ci);
+    }
+  }
+
+  for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+
+    if (! l->second.name.empty () && m_cellwise_layers.insert (l->first).second) {
+
+      write_record_id (11);
+      write_nstring (l->second.name.c_str ());
+      write_byte (3);
+      write ((unsigned long) l->second.layer);
+      write_byte (3);
+      write ((unsigned long) l->second.datatype);
+
+      write_record_id (12);
+      write_nstring (l->second.name.c_str ());
+      write_byte (3);
+      write ((unsigned long) l->second.layer);
+      write_byte (3);
+      write ((unsigned long) l->second.datatype);
+
+    }
+
+  }
+
+  std::set <db::properties_id_type> prop_ids;
+
+  if (cref.prop_id () != 0) {
+    prop_ids.insert (cref.prop_id ());
+  }
+
+  for (db::Cell::const_iterator inst = cref.begin (); ! inst.at_end (); ++inst) {
+    if (inst->has_prop_id () && inst->prop_id () != 0) {
+      prop_ids.insert (inst->prop_id ());
+    }
+  }
+
+  for (std::vector <std::pair <unsigned int, db::LayerProperties> >::const_iterator l = layers.begin (); l != layers.end (); ++l) {
+
+    db::ShapeIterator shape (cref.shapes (l->first).begin (db::ShapeIterator::Properties | db::ShapeIterator::Boxes | db::ShapeIterator::Polygons | db::ShapeIterator::Edges | db::ShapeIterator::Paths | db::ShapeIterator::Texts));
+    while (! shape.at_end ()) {
+      if (shape->has_prop_id () && shape->prop_id () != 0) {
+        prop_ids.insert (shape->prop_id ());
+      }
+      shape.finish_array ();
+    }
+
+    shape = cref.shapes (l->first).begin (db::ShapeIterator::Texts);
+    while (! shape.at_end ()) {
+      if (m_textstrings.insert (std::make_pair (shape->text_string (), (unsigned long) m_textstrings.size ())).second) {
+        write_record_id (5);
+        write_astring (shape->text_string ());
+      }
+      ++shape;
+    }
+
+  }
+
+  for (std::set <db::properties_id_type>::const_iterator p = prop_ids.begin (); p != prop_ids.end (); ++p) {
+    if (m_cellwise_prop_ids.insert (*p).second) {
+      emit_propname_def (*p);
+      emit_propstring_def (*p);
+    }
+  }
+
+  //  the cell itself
+
+  size_t &cell_pos = m_cell_positions.insert (std::make_pair (cell_index, size_t (0))).first->second;
+  write_cell_body (cell_index, cell_pos, 0, layers, false);
+}
+
+void
+OASISWriter::end_cellwise (db::Layout & /*layout*/)
+{
+  flush_cblocks ();
+  mp_cblock_compressor = 0;
+  if (mp_cellwise_cblock_compressor) {
+    delete mp_cellwise_cblock_compressor;
+    mp_cellwise_cblock_compressor = 0;
+  }
+
+  //  END record
+
+  size_t end_record_pos = mp_stream->pos ();
+
+  write_record_id (2);
+
+  finish_end_record (end_record_pos);
+}
+
 void 
 OASISWriter::write (const Repetition &rep)
 {
@@ -1973,7 +2468,7 @@ OASISWriter::write (const db::CellInstArray &inst, db::properties_id_type prop_i
 }
 
 void 
-OASISWriter::write_insts (const std::set <db::cell_index_type> &cell_set)
+OASISWriter::write_insts (const std::set <db::cell_index_type> *cell_set)
 {
   int level = m_options.compression_level;
 
@@ -1987,7 +2482,7 @@ OASISWriter::write_insts (const std::set <db::cell_index_type> &cell_set)
   //  Collect all instances 
   for (db::Cell::const_iterator inst_iterator = mp_cell->begin (); ! inst_iterator.at_end (); ++inst_iterator) {
 
-    if (cell_set.find (inst_iterator->cell_index ()) != cell_set.end ()) {
+    if (! cell_set || cell_set->find (inst_iterator->cell_index ()) != cell_set->end ()) {
 
       db::properties_id_type prop_id = inst_iterator->prop_id ();
 
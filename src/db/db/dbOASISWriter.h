@@ -45,6 +45,7 @@ namespace db
 class Layout;
 class SaveLayoutOptions;
 class OASISWriter;
+class OASISCBlockCompressor;
 
 /**
  *  @brief Structure that holds the OASIS specific options for the Writer
@@ -57,7 +58,7 @@ public:
    *  @brief The constructor
    */
   OASISWriterOptions ()
-    : compression_level (2), write_cblocks (false), strict_mode (false), recompress (false), write_std_properties (1), subst_char ("*")
+    : compression_level (2), write_cblocks (false), cblock_threads (0), strict_mode (false), recompress (false), write_std_properties (1), subst_char ("*")
   {
     //  .. nothing yet ..
   }
@@ -80,6 +81,16 @@ public:
    */
   bool write_cblocks;
 
+  /**
+   *  @brief The number of threads to use for CBLOCK compression
+   *
+   *  If this value is larger than 0 and CBLOCK compression is enabled, the 
+   *  cell bodies are compressed by the given number of worker threads. 
+   *  The output is identical to the one produced without threads.
+   *  The default value is 0 (compression in the writer's thread).
+   */
+  int cblock_threads;
+
   /**
    *  @brief Strict mode
    *
@@ -189,11 +200,43 @@ public:
    */
   OASISWriter ();
 
+  /**
+   *  @brief Destructor
+   */
+  ~OASISWriter ();
+
   /**
    *  @brief Write the layout object
    */
   void write (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options);
 
+  /**
+   *  @brief Cell-wise writing is supported by this writer
+   *
+   *  In cell-wise mode, the name records are written before each cell as needed.
+   *  Hence, strict mode and the S_TOP_CELL and S_BOUNDING_BOX standard properties
+   *  are not available in this mode.
+   */
+  virtual bool supports_cellwise () const
+  {
+    return true;
+  }
+
+  /**
+   *  @brief Implementation of WriterBase::begin_cellwise
+   */
+  virtual void begin_cellwise (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options);
+
+  /**
+   *  @brief Implementation of WriterBase::write_cell
+   */
+  virtual void write_cell (db::Layout &layout, db::cell_index_type cell_index);
+
+  /**
+   *  @brief Implementation of WriterBase::end_cellwise
+   */
+  virtual void end_cellwise (db::Layout &layout);
+
   void write (const db::CellInstArray &inst_array, const db::Repetition &rep)
   {
     write (inst_array, 0, rep);
@@ -289,6 +332,13 @@ private:
   tl::OutputMemoryStream m_cblock_buffer;
   tl::OutputMemoryStream m_cblock_compressed;
   bool m_in_cblock;
+  OASISCBlockCompressor *mp_cblock_compressor;
+  OASISCBlockCompressor *mp_cellwise_cblock_compressor;
+  db::SaveLayoutOptions m_cellwise_options;
+  std::set <db::cell_index_type> m_cellwise_cellnames;
+  std::set <unsigned int> m_cellwise_layers;
+  std::set <db::properties_id_type> m_cellwise_prop_ids;
+  std::map <db::cell_index_type, size_t> m_cell_positions;
   unsigned long m_propname_id;
   unsigned long m_propstring_id;
   bool m_proptables_written;
@@ -372,6 +422,8 @@ private:
 
   void begin_cblock ();
   void end_cblock ();
+  void write_cblock (const tl::OutputMemoryStream &buffer, const tl::OutputMemoryStream &compressed);
+  void flush_cblocks ();
 
   void begin_table (size_t &pos);
   void end_table (size_t pos);
@@ -380,7 +432,9 @@ private:
 
   void emit_propname_def (db::properties_id_type prop_id);
   void emit_propstring_def (db::properties_id_type prop_id);
-  void write_insts (const std::set <db::cell_index_type> &cell_set);
+  void write_insts (const std::set <db::cell_index_type> *cell_set);
+  void write_cell_body (db::cell_index_type cell_index, size_t &cell_pos, const std::set <db::cell_index_type> *cell_set, const std::vector <std::pair <unsigned int, db::LayerProperties> > &layers, bool with_context);
+  void finish_end_record (size_t end_record_pos);
 
   void write_shapes (const db::LayerProperties &lprops, const db::Shapes &shapes);
 
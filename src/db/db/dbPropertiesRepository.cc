@@ -115,7 +115,7 @@ PropertiesRepository::change_properties (property_names_id_type id, const proper
     //  signal the change of the properties ID's. This way for example, the layer views
     //  can recompute the property selectors
     if (mp_state_model) {
-      mp_state_model->prop_ids_changed ();
+      mp_state_model->prop_values_changed ();
     }
 
   }
@@ -129,6 +129,10 @@ PropertiesRepository::change_name (property_names_id_type id, const tl::Variant
   pi->second = new_name;
 
   m_propname_ids_by_name.insert (std::make_pair (new_name, id));
+
+  if (mp_state_model) {
+    mp_state_model->prop_values_changed ();
+  }
 }
 
 const tl::Variant &
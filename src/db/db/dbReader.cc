@@ -23,6 +23,8 @@
 
 #include "dbReader.h"
 #include "dbStream.h"
+#include "dbCommonReader.h"
+#include "dbLayout.h"
 #include "tlClassRegistry.h"
 
 namespace db
@@ -32,7 +34,7 @@ namespace db
 //  ReaderBase implementation
 
 ReaderBase::ReaderBase () 
-  : m_warnings_as_errors (false)
+  : m_warnings_as_errors (false), mp_cell_sink (0)
 { 
 }
 
@@ -74,5 +76,17 @@ Reader::~Reader ()
   }
 }
 
+const db::LayerMap &
+Reader::read (db::Layout &layout, const db::LoadLayoutOptions &options)
+{
+  //  the update threads are a property of the target layout
+  int update_threads = options.get_options<db::CommonReaderOptions> ().update_threads;
+  if (update_threads > 0) {
+    layout.set_update_threads (update_threads);
+  }
+
+  return mp_actual_reader->read (layout, options);
+}
+
 }
 
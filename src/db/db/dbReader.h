@@ -26,6 +26,7 @@
 #define HDR_dbReader
 
 #include "dbCommon.h"
+#include "dbTypes.h"
 
 #include "tlException.h"
 #include "tlInternational.h"
@@ -42,6 +43,38 @@ namespace db
 class Layout;
 class ReaderBase;
 
+/**
+ *  @brief A receiver for cells which have been read completely
+ *
+ *  A reader which supports this feature will call "cell_finished" once a cell
+ *  has been read entirely, i.e. no more shapes or instances will be added to
+ *  this cell. The receiver may use this information to write the cell to 
+ *  another stream and to release the cell's content.
+ *  Readers are not obliged to support this feature. Readers which don't will
+ *  never call the receiver.
+ */
+class DB_PUBLIC ReaderCellSink
+{
+public:
+  /**
+   *  @brief Constructor
+   */
+  ReaderCellSink () { }
+
+  /**
+   *  @brief Destructor
+   */
+  virtual ~ReaderCellSink () { }
+
+  /**
+   *  @brief Indicates that the given cell has been read completely
+   *
+   *  This method is called while the reader is still active. Hence the layout
+   *  is in "under construction" state.
+   */
+  virtual void cell_finished (db::Layout &layout, db::cell_index_type cell_index) = 0;
+};
+
 /**
  *  @brief Generic base class of reader exceptions
  */
@@ -81,8 +114,40 @@ public:
     return m_warnings_as_errors;
   }
 
+  /**
+   *  @brief Sets the cell sink
+   *
+   *  If a cell sink is set, readers supporting this feature will report cells 
+   *  read completely to this sink. The sink is not owned by the reader.
+   *  Set the sink to 0 to disable this feature.
+   */
+  void set_cell_sink (ReaderCellSink *sink)
+  {
+    mp_cell_sink = sink;
+  }
+
+  /**
+   *  @brief Gets the cell sink
+   */
+  ReaderCellSink *cell_sink () const
+  {
+    return mp_cell_sink;
+  }
+
+protected:
+  /**
+   *  @brief Reports a cell finished to the cell sink (if there is one)
+   */
+  void cell_finished (db::Layout &layout, db::cell_index_type cell_index)
+  {
+    if (mp_cell_sink) {
+      mp_cell_sink->cell_finished (layout, cell_index);
+    }
+  }
+
 private:
   bool m_warnings_as_errors;
+  ReaderCellSink *mp_cell_sink;
 };
 
 /**
@@ -125,10 +190,7 @@ public:
    *  @param layout The layout object to write to
    *  @param options The LayerMap object
    */
-  const db::LayerMap &read (db::Layout &layout, const db::LoadLayoutOptions &options) 
-  {
-    return mp_actual_reader->read (layout, options);
-  }
+  const db::LayerMap &read (db::Layout &layout, const db::LoadLayoutOptions &options);
 
   /** 
    *  @brief The basic read method (without mapping)
@@ -173,6 +235,15 @@ public:
     return mp_actual_reader->warnings_as_errors ();
   }
 
+  /**
+   *  @brief Sets the cell sink
+   *  See ReaderBase::set_cell_sink for details.
+   */
+  void set_cell_sink (ReaderCellSink *sink)
+  {
+    mp_actual_reader->set_cell_sink (sink);
+  }
+
 private:
   ReaderBase *mp_actual_reader;
   tl::InputStream &m_stream;
@@ -426,6 +426,25 @@ public:
     }
   }
 
+  /**
+   *  @brief Gets the minimum hierarchy depth to search for
+   */
+  int min_depth () const
+  {
+    return m_min_depth;
+  }
+
+  /**
+   *  @brief Returns true, if a cell selection is present
+   *
+   *  A cell selection is present if select_cells, unselect_cells, select_all_cells 
+   *  or unselect_all_cells has been used and no reset_selection was issued since then.
+   */
+  bool has_cell_selection () const
+  {
+    return ! m_start.empty () || ! m_stop.empty ();
+  }
+
   /**
    *  @brief Specify the shape selection flags
    *
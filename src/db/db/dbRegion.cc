@@ -33,9 +33,11 @@
 #include "dbPolygonTools.h"
 
 #include "tlVariant.h"
+#include "tlThreadedWorkers.h"
 
 #include <sstream>
 #include <set>
+#include <limits>
 
 namespace db
 {
@@ -126,6 +128,21 @@ Region::set_strict_handling (bool f)
   m_strict_handling = f;
 }
 
+void 
+Region::set_boolean_operand_cache (bool f)
+{
+  m_boolean_operand_cache = f;
+  if (! f) {
+    mp_prepared_operand.reset (0);
+  }
+}
+
+void 
+Region::set_threads (int n)
+{
+  m_threads = n;
+}
+
 void 
 Region::set_merged_semantics (bool f)
 {
@@ -333,11 +350,14 @@ Region::swap (Region &other)
   std::swap (m_merged_semantics, other.m_merged_semantics);
   std::swap (m_strict_handling, other.m_strict_handling);
   std::swap (m_merge_min_coherence, other.m_merge_min_coherence);
+  std::swap (m_threads, other.m_threads);
   m_polygons.swap (other.m_polygons);
   m_merged_polygons.swap (other.m_merged_polygons);
   std::swap (m_bbox, other.m_bbox);
   std::swap (m_bbox_valid, other.m_bbox_valid);
   std::swap (m_merged_polygons_valid, other.m_merged_polygons_valid);
+  std::swap (m_boolean_operand_cache, other.m_boolean_operand_cache);
+  std::swap (mp_prepared_operand, other.mp_prepared_operand);
   std::swap (m_iter, other.m_iter);
   std::swap (m_iter_trans, other.m_iter_trans);
 }
@@ -351,6 +371,7 @@ Region::merge ()
 
       m_polygons.swap (m_merged_polygons);
       m_merged_polygons.clear ();
+      mp_prepared_operand.reset (0);
       m_is_merged = true;
 
     } else {
@@ -383,6 +404,7 @@ Region::merge (bool min_coherence, unsigned int min_wc)
     invalidate_cache ();
 
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -463,6 +485,7 @@ Region::size (Region::coord_type dx, Region::coord_type dy, unsigned int mode)
 
     //  Generic case - the size operation will merge first
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -564,30 +587,13 @@ Region::operator&= (const Region &other)
 
   } else {
 
-    invalidate_cache ();
-
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
-    //  count edges and reserve memory
-    size_t n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    ep.reserve (n);
+    insert_boolean_operands (ep, other);
 
-    //  insert the polygons into the processor
-    n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
-    n = 1;
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
+    invalidate_cache ();
 
     db::BooleanOp op (db::BooleanOp::And);
     db::ShapeGenerator pc (m_polygons, true /*clear*/);
@@ -620,30 +626,13 @@ Region::operator-= (const Region &other)
 
   } else {
 
-    invalidate_cache ();
-
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
-    //  count edges and reserve memory
-    size_t n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    ep.reserve (n);
+    insert_boolean_operands (ep, other);
 
-    //  insert the polygons into the processor
-    n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
-    n = 1;
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
+    invalidate_cache ();
 
     db::BooleanOp op (db::BooleanOp::ANotB);
     db::ShapeGenerator pc (m_polygons, true /*clear*/);
@@ -677,30 +666,13 @@ Region::operator^= (const Region &other)
 
   } else {
 
-    invalidate_cache ();
-
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
-    //  count edges and reserve memory
-    size_t n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    ep.reserve (n);
+    insert_boolean_operands (ep, other);
 
-    //  insert the polygons into the processor
-    n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
-    n = 1;
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
+    invalidate_cache ();
 
     db::BooleanOp op (db::BooleanOp::Xor);
     db::ShapeGenerator pc (m_polygons, true /*clear*/);
@@ -734,30 +706,13 @@ Region::operator|= (const Region &other)
 
   } else {
 
-    invalidate_cache ();
-
     //  Generic case
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
-    //  count edges and reserve memory
-    size_t n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
-      n += p->vertices ();
-    }
-    ep.reserve (n);
+    insert_boolean_operands (ep, other);
 
-    //  insert the polygons into the processor
-    n = 0;
-    for (const_iterator p = begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
-    n = 1;
-    for (const_iterator p = other.begin (); ! p.at_end (); ++p, n += 2) {
-      ep.insert (*p, n);
-    }
+    invalidate_cache ();
 
     db::BooleanOp op (db::BooleanOp::Or);
     db::ShapeGenerator pc (m_polygons, true /*clear*/);
@@ -826,6 +781,7 @@ Region
 Region::selected_interacting_generic (const Region &other, int mode, bool touching, bool inverse) const
 {
   db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+  ep.set_threads (m_threads);
 
   //  shortcut
   if (empty () || other.empty ()) {
@@ -887,6 +843,7 @@ Region::select_interacting_generic (const Region &other, int mode, bool touching
   }
 
   db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+  ep.set_threads (m_threads);
 
   for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
     if (p->box ().touches (bbox ())) {
@@ -1054,6 +1011,7 @@ Region::selected_interacting_generic (const Edges &other, bool inverse) const
   }
 
   db::box_scanner<char, size_t> scanner (m_report_progress, m_progress_desc);
+  scanner.set_threads (m_threads);
   scanner.reserve (size () + other.size ());
 
   ensure_valid_polygons ();
@@ -1095,6 +1053,7 @@ Region::select_interacting_generic (const Edges &other, bool inverse)
   }
 
   db::box_scanner<char, size_t> scanner (m_report_progress, m_progress_desc);
+  scanner.set_threads (m_threads);
   scanner.reserve (size () + other.size ());
 
   ensure_valid_polygons ();
@@ -1322,6 +1281,8 @@ Region::init ()
   m_strict_handling = false;
   m_merge_min_coherence = false;
   m_merged_polygons_valid = false;
+  m_boolean_operand_cache = false;
+  m_threads = 0;
 }
 
 void 
@@ -1343,6 +1304,88 @@ Region::invalidate_cache ()
   m_bbox_valid = false;
   m_merged_polygons.clear ();
   m_merged_polygons_valid = false;
+  mp_prepared_operand.reset (0);
+}
+
+const db::EdgeProcessorOperand *
+Region::prepared_operand () const
+{
+  if (! m_boolean_operand_cache) {
+    return 0;
+  }
+
+  if (! mp_prepared_operand.get ()) {
+
+    db::EdgeProcessorOperand *op = new db::EdgeProcessorOperand ();
+
+    //  count edges and reserve memory
+    size_t n = 0;
+    for (const_iterator p = begin (); ! p.at_end (); ++p) {
+      n += p->vertices ();
+    }
+    op->reserve (n);
+
+    //  use the properties of the first operand - the second operand will be inserted with an offset of 1
+    n = 0;
+    for (const_iterator p = begin (); ! p.at_end (); ++p, n += 2) {
+      op->insert (*p, n);
+    }
+
+    mp_prepared_operand.reset (op);
+
+  }
+
+  return mp_prepared_operand.get ();
+}
+
+void 
+Region::insert_boolean_operands (db::EdgeProcessor &ep, const Region &other) const
+{
+  //  this region's operand is used only if it is there already: the in-place operators 
+  //  invalidate it right after, so building it would be wasted effort. The const operators
+  //  prepare it before they copy the region.
+  const db::EdgeProcessorOperand *prep_a = m_boolean_operand_cache ? mp_prepared_operand.get () : 0;
+  const db::EdgeProcessorOperand *prep_b = other.prepared_operand ();
+
+  //  count edges and reserve memory
+  size_t n = 0;
+  if (prep_a) {
+    n += prep_a->size ();
+  } else {
+    for (const_iterator p = begin (); ! p.at_end (); ++p) {
+      n += p->vertices ();
+    }
+  }
+  if (prep_b) {
+    n += prep_b->size ();
+  } else {
+    for (const_iterator p = other.begin (); ! p.at_end (); ++p) {
+      n += p->vertices ();
+    }
+  }
+  ep.reserve (n);
+
+  //  insert the prepared operands first, so their edges don't need to be sorted again
+  if (prep_a) {
+    ep.insert (*prep_a, 0);
+  }
+  if (prep_b) {
+    ep.insert (*prep_b, 1);
+  }
+
+  //  insert the polygons into the processor
+  if (! prep_a) {
+    n = 0;
+    for (const_iterator p = begin (); ! p.at_end (); ++p, n += 2) {
+      ep.insert (*p, n);
+    }
+  }
+  if (! prep_b) {
+    n = 1;
+    for (const_iterator p = other.begin (); ! p.at_end (); ++p, n += 2) {
+      ep.insert (*p, n);
+    }
+  }
 }
 
 void
@@ -1385,6 +1428,7 @@ void
 Region::set_valid_polygons ()
 {
   m_iter = db::RecursiveShapeIterator ();
+  mp_prepared_operand.reset (0);
 }
 
 void 
@@ -1439,6 +1483,7 @@ Region::ensure_merged_polygons_valid () const
     m_merged_polygons.clear ();
 
     db::EdgeProcessor ep (m_report_progress, m_progress_desc);
+    ep.set_threads (m_threads);
 
     //  count edges and reserve memory
     size_t n = 0;
@@ -1532,6 +1577,7 @@ Region::clear ()
   m_is_merged = true;
   m_merged_polygons.clear ();
   m_merged_polygons_valid = true;
+  mp_prepared_operand.reset (0);
   m_iter = db::RecursiveShapeIterator ();
   m_iter_trans = db::ICplxTrans ();
 }
@@ -1547,9 +1593,24 @@ class Edge2EdgeCheck
 public:
   Edge2EdgeCheck (const EdgeRelationFilter &check, EdgePairs &output, bool different_polygons, bool requires_different_layers)
     : mp_check (&check), mp_output (&output), m_requires_different_layers (requires_different_layers), m_different_polygons (different_polygons), 
-      m_pass (0)
+      m_pass (0), m_has_stripe (false), m_x1 (0), m_x2 (0), m_key_check (check)
   {
     m_distance = check.distance ();
+    m_key_check.set_whole_edges (false);
+  }
+
+  /**
+   *  @brief Restricts the edge pairs produced to a stripe
+   *
+   *  With a stripe, only those edge pairs are produced whose left coordinate is inside
+   *  the interval [x1, x2). With "whole edges", the left coordinate of the violating 
+   *  parts is taken. Hence every edge pair is produced by exactly one stripe.
+   */
+  void set_stripe (db::Coord x1, db::Coord x2)
+  {
+    m_has_stripe = true;
+    m_x1 = x1;
+    m_x2 = x2;
   }
 
   bool prepare_next_pass ()
@@ -1594,7 +1655,7 @@ public:
         int l2 = int (p2 & size_t (1));
 
         db::EdgePair ep;
-        if (mp_check->check (l1 <= l2 ? *o1 : *o2, l1 <= l2 ? *o2 : *o1, &ep)) {
+        if (mp_check->check (l1 <= l2 ? *o1 : *o2, l1 <= l2 ? *o2 : *o1, &ep) && in_stripe (ep, l1 <= l2 ? *o1 : *o2, l1 <= l2 ? *o2 : *o1)) {
 
           //  found a violation: store inside the local buffer for now. In the second
           //  pass we will eliminate those which are shielded completely.
@@ -1709,6 +1770,28 @@ private:
   std::multimap<std::pair<db::Edge, size_t>, size_t> m_e2ep;
   std::vector<bool> m_ep_discarded;
   unsigned int m_pass;
+  bool m_has_stripe;
+  db::Coord m_x1, m_x2;
+  EdgeRelationFilter m_key_check;
+
+  bool in_stripe (const db::EdgePair &ep, const db::Edge &e1, const db::Edge &e2) const
+  {
+    if (! m_has_stripe) {
+      return true;
+    }
+
+    db::Coord l = ep.bbox ().left ();
+    if (mp_check->whole_edges ()) {
+      //  use the violating parts, not the whole edges: the whole edges may extend beyond the 
+      //  window of the stripe
+      db::EdgePair key;
+      if (m_key_check.check (e1, e2, &key)) {
+        l = key.bbox ().left ();
+      }
+    }
+
+    return l >= m_x1 && l < m_x2;
+  }
 };
 
 /**
@@ -1719,10 +1802,22 @@ class Poly2PolyCheck
 {
 public:
   Poly2PolyCheck (Edge2EdgeCheck &output)
-    : mp_output (&output)
+    : mp_output (&output), m_has_window (false), m_wl (0), m_wr (0)
   {
     //  .. nothing yet ..
   }
+
+  /**
+   *  @brief Restricts the edges taken from the polygons to a window [l, r] in x direction
+   *
+   *  The edges are not clipped, but edges entirely outside the window are skipped.
+   */
+  void set_window (db::Coord l, db::Coord r)
+  {
+    m_has_window = true;
+    m_wl = l;
+    m_wr = r;
+  }
   
   void finish (const db::Polygon *o, size_t p)
   { 
@@ -1737,11 +1832,13 @@ public:
       m_edges.reserve (o->vertices ());
 
       for (db::Polygon::polygon_edge_iterator e = o->begin_edge (); ! e.at_end (); ++e) {
-        m_edges.push_back (*e);
-        m_scanner.insert (& m_edges.back (), p);
+        if (in_window (*e)) {
+          m_edges.push_back (*e);
+          m_scanner.insert (& m_edges.back (), p);
+        }
       }
 
-      tl_assert (m_edges.size () == o->vertices ());
+      tl_assert (m_edges.size () <= o->vertices ());
 
       m_scanner.process (*mp_output, mp_output->distance (), db::box_convert<db::Edge> ()); 
 
@@ -1759,16 +1856,20 @@ public:
       m_edges.reserve (o1->vertices () + o2->vertices ());
 
       for (db::Polygon::polygon_edge_iterator e = o1->begin_edge (); ! e.at_end (); ++e) {
-        m_edges.push_back (*e);
-        m_scanner.insert (& m_edges.back (), p1);
+        if (in_window (*e)) {
+          m_edges.push_back (*e);
+          m_scanner.insert (& m_edges.back (), p1);
+        }
       }
 
       for (db::Polygon::polygon_edge_iterator e = o2->begin_edge (); ! e.at_end (); ++e) {
-        m_edges.push_back (*e);
-        m_scanner.insert (& m_edges.back (), p2);
+        if (in_window (*e)) {
+          m_edges.push_back (*e);
+          m_scanner.insert (& m_edges.back (), p2);
+        }
       }
 
-      tl_assert (m_edges.size () == o1->vertices () + o2->vertices ());
+      tl_assert (m_edges.size () <= o1->vertices () + o2->vertices ());
 
       //  temporarily disable intra-polygon check in that step .. we do that later in finish()
       //  if required (#650).
@@ -1786,8 +1887,315 @@ private:
   db::box_scanner<db::Edge, size_t> m_scanner;
   Edge2EdgeCheck *mp_output;
   std::vector<db::Edge> m_edges;
+  bool m_has_window;
+  db::Coord m_wl, m_wr;
+
+  bool in_window (const db::Edge &e) const
+  {
+    return ! m_has_window || (std::max (e.p1 ().x (), e.p2 ().x ()) >= m_wl && std::min (e.p1 ().x (), e.p2 ().x ()) <= m_wr);
+  }
+};
+
+// -------------------------------------------------------------------------------
+//  Multi-threading support for the checks
+
+//  The minimum number of polygons per stripe or chunk
+const size_t parallel_check_min_polygons = 1000;
+
+//  The number of stripes or chunks per thread
+const size_t parallel_check_tasks_per_thread = 4;
+
+/**
+ *  @brief A polygon taking part in a multi-threaded check
+ */
+struct CheckPolygon
+{
+  CheckPolygon (const db::Polygon *p, size_t n)
+    : polygon (p), prop (n), box (p->box ())
+  { }
+
+  const db::Polygon *polygon;
+  size_t prop;
+  db::Box box;
+};
+
+/**
+ *  @brief Compares CheckPolygon objects by the left edge of the bounding box
+ */
+struct CheckPolygonLeftCompare
+{
+  bool operator() (const CheckPolygon &a, const CheckPolygon &b) const
+  {
+    return a.box.left () < b.box.left ();
+  }
+
+  bool operator() (const CheckPolygon &a, db::Coord x) const
+  {
+    return a.box.left () < x;
+  }
+
+  bool operator() (db::Coord x, const CheckPolygon &b) const
+  {
+    return x < b.box.left ();
+  }
+};
+
+/**
+ *  @brief The data shared between the tasks of a multi-threaded check
+ */
+struct CheckContext
+{
+  CheckContext (const EdgeRelationFilter &c, bool dp, bool rdl)
+    : check (&c), different_polygons (dp), requires_different_layers (rdl)
+  { }
+
+  const EdgeRelationFilter *check;
+  bool different_polygons;
+  bool requires_different_layers;
+  std::vector<CheckPolygon> polygons;
+};
+
+/**
+ *  @brief The base class for the tasks of the CheckJob
+ */
+class CheckTask
+  : public tl::Task
+{
+public:
+  CheckTask (const CheckContext *context, EdgePairs *result)
+    : mp_context (context), mp_result (result)
+  { }
+
+  virtual void perform () = 0;
+
+protected:
+  const CheckContext *mp_context;
+  EdgePairs *mp_result;
+};
+
+/**
+ *  @brief A task performing the check for the edge pairs starting inside a vertical stripe
+ *
+ *  The task produces the edge pairs whose left coordinate is inside the stripe [x1, x2). 
+ *  The stripes cover the whole plane, hence every edge pair is produced by exactly one stripe.
+ *
+ *  All edges contributing to such edge pairs - including the shielding ones - are within
+ *  the check distance from the stripe. Hence the task only takes the polygons and the 
+ *  edges touching the stripe enlarged by the check distance. The edges are not clipped, 
+ *  so the edge pairs are identical to the ones of the single-threaded check.
+ */
+class StripeCheckTask
+  : public CheckTask
+{
+public:
+  StripeCheckTask (const CheckContext *context, EdgePairs *result, db::Coord x1, db::Coord x2)
+    : CheckTask (context, result), m_x1 (x1), m_x2 (x2)
+  { }
+
+  virtual void perform ()
+  {
+    typedef db::coord_traits<db::Coord>::area_type wide_coord;
+
+    const std::vector<CheckPolygon> &polygons = mp_context->polygons;
+    wide_coord d = wide_coord (mp_context->check->distance ()) + 1;
+
+    //  the window: the stripe enlarged by the check distance
+    db::Coord wl = db::Coord (std::max (wide_coord (m_x1) - d, wide_coord (std::numeric_limits<db::Coord>::min ())));
+    db::Coord wr = db::Coord (std::min (wide_coord (m_x2) + d, wide_coord (std::numeric_limits<db::Coord>::max ())));
+
+    db::box_scanner<db::Polygon, size_t> scanner;
+
+    //  NOTE: the polygons are sorted by their left coordinate
+    std::vector<CheckPolygon>::const_iterator pe = std::upper_bound (polygons.begin (), polygons.end (), wr, CheckPolygonLeftCompare ());
+    for (std::vector<CheckPolygon>::const_iterator p = polygons.begin (); p != pe; ++p) {
+      if (p->box.right () >= wl) {
+        scanner.insert (p->polygon, p->prop);
+      }
+    }
+
+    Edge2EdgeCheck edge_check (*mp_context->check, *mp_result, mp_context->different_polygons, mp_context->requires_different_layers);
+    edge_check.set_stripe (m_x1, m_x2);
+    Poly2PolyCheck poly_check (edge_check);
+    poly_check.set_window (wl, wr);
+
+    do {
+      scanner.process (poly_check, mp_context->check->distance (), db::box_convert<db::Polygon> ());
+    } while (edge_check.prepare_next_pass ());
+  }
+
+private:
+  db::Coord m_x1, m_x2;
+};
+
+/**
+ *  @brief A task performing the single-polygon check for a range of polygons
+ */
+class SinglePolygonCheckTask
+  : public CheckTask
+{
+public:
+  SinglePolygonCheckTask (const CheckContext *context, EdgePairs *result, size_t from, size_t to)
+    : CheckTask (context, result), m_from (from), m_to (to)
+  { }
+
+  virtual void perform ()
+  {
+    Edge2EdgeCheck edge_check (*mp_context->check, *mp_result, false, false);
+    Poly2PolyCheck poly_check (edge_check);
+
+    do {
+      for (size_t i = m_from; i < m_to; ++i) {
+        const CheckPolygon &p = mp_context->polygons [i];
+        poly_check.finish (p.polygon, p.prop);
+      }
+    } while (edge_check.prepare_next_pass ());
+  }
+
+private:
+  size_t m_from, m_to;
+};
+
+/**
+ *  @brief The worker for the CheckJob
+ */
+class CheckWorker
+  : public tl::Worker
+{
+public:
+  CheckWorker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    CheckTask *check_task = dynamic_cast<CheckTask *> (task);
+    if (check_task) {
+      check_task->perform ();
+    }
+  }
+};
+
+/**
+ *  @brief The job executing the multi-threaded checks
+ */
+class CheckJob
+  : public tl::JobBase
+{
+public:
+  CheckJob (int nworkers)
+    : tl::JobBase (nworkers)
+  { }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new CheckWorker ();
+  }
 };
 
+/**
+ *  @brief Runs the check tasks and collects the results in the order of the tasks
+ *
+ *  The tasks deliver their results into "results" which needs to be sized accordingly. 
+ *  The job takes over the tasks.
+ */
+static void 
+run_check_tasks (int threads, const std::vector<CheckTask *> &tasks, std::vector<EdgePairs> &results, EdgePairs &result)
+{
+  CheckJob job (threads);
+
+  for (std::vector<CheckTask *>::const_iterator t = tasks.begin (); t != tasks.end (); ++t) {
+    job.schedule (*t);
+  }
+
+  job.start ();
+  job.wait ();
+
+  if (job.has_error ()) {
+    throw tl::Exception (tl::to_string (QObject::tr ("Errors occured during processing. First error message says:\n")) + job.error_messages ().front ());
+  }
+
+  size_t n = 0;
+  for (std::vector<EdgePairs>::const_iterator r = results.begin (); r != results.end (); ++r) {
+    n += r->size ();
+  }
+  result.reserve (n);
+
+  for (std::vector<EdgePairs>::const_iterator r = results.begin (); r != results.end (); ++r) {
+    for (EdgePairs::const_iterator ep = r->begin (); ep != r->end (); ++ep) {
+      result.insert (*ep);
+    }
+  }
+}
+
+/**
+ *  @brief Runs a two-polygon check on multiple threads
+ *
+ *  The polygons are distributed over vertical stripes with roughly the same number
+ *  of polygons. Returns false if there are not enough polygons to make this worthwhile.
+ */
+static bool
+run_stripe_check (int threads, CheckContext &context, EdgePairs &result)
+{
+  std::vector<CheckPolygon> &polygons = context.polygons;
+
+  size_t nstripes = std::min (size_t (threads) * parallel_check_tasks_per_thread, polygons.size () / parallel_check_min_polygons);
+  if (nstripes < 2) {
+    return false;
+  }
+
+  std::sort (polygons.begin (), polygons.end (), CheckPolygonLeftCompare ());
+
+  //  stripe boundaries with roughly the same number of polygons starting in each stripe
+  std::vector<db::Coord> xb;
+  xb.push_back (std::numeric_limits<db::Coord>::min ());
+  for (size_t i = 1; i < nstripes; ++i) {
+    db::Coord x = polygons [i * polygons.size () / nstripes].box.left ();
+    if (x > xb.back ()) {
+      xb.push_back (x);
+    }
+  }
+  xb.push_back (std::numeric_limits<db::Coord>::max ());
+
+  std::vector<EdgePairs> results (xb.size () - 1);
+  std::vector<CheckTask *> tasks;
+  for (size_t i = 0; i + 1 < xb.size (); ++i) {
+    tasks.push_back (new StripeCheckTask (&context, &results [i], xb [i], xb [i + 1]));
+  }
+
+  run_check_tasks (threads, tasks, results, result);
+  return true;
+}
+
+/**
+ *  @brief Runs a single-polygon check on multiple threads
+ *
+ *  Returns false if there are not enough polygons to make this worthwhile.
+ */
+static bool
+run_single_polygon_check_mt (int threads, CheckContext &context, EdgePairs &result)
+{
+  const std::vector<CheckPolygon> &polygons = context.polygons;
+
+  size_t nchunks = std::min (size_t (threads) * parallel_check_tasks_per_thread, polygons.size () / parallel_check_min_polygons);
+  if (nchunks < 2) {
+    return false;
+  }
+
+  std::vector<EdgePairs> results (nchunks);
+  std::vector<CheckTask *> tasks;
+
+  size_t from = 0;
+  for (size_t i = 0; i < nchunks; ++i) {
+    size_t to = (i + 1) * polygons.size () / nchunks;
+    tasks.push_back (new SinglePolygonCheckTask (&context, &results [i], from, to));
+    from = to;
+  }
+
+  run_check_tasks (threads, tasks, results, result);
+  return true;
+}
+
 }
 
 EdgePairs 
@@ -1795,10 +2203,46 @@ Region::run_check (db::edge_relation_type rel, bool different_polygons, const Re
 {
   EdgePairs result;
 
+  EdgeRelationFilter check (rel, d, metrics);
+  check.set_include_zero (other != 0);
+  check.set_whole_edges (whole_edges);
+  check.set_ignore_angle (ignore_angle);
+  check.set_min_projection (min_projection);
+  check.set_max_projection (max_projection);
+
+  ensure_valid_merged_polygons ();
+  if (other) {
+    other->ensure_valid_merged_polygons ();
+  }
+
+  if (m_threads > 0) {
+
+    CheckContext context (check, different_polygons, other != 0);
+    context.polygons.reserve (size () + (other ? other->size () : 0));
+
+    size_t n = 0;
+    for (const_iterator p = begin_merged (); ! p.at_end (); ++p) {
+      context.polygons.push_back (CheckPolygon (&*p, n));
+      n += 2;
+    }
+
+    if (other) {
+      n = 1;
+      for (const_iterator p = other->begin_merged (); ! p.at_end (); ++p) {
+        context.polygons.push_back (CheckPolygon (&*p, n));
+        n += 2;
+      }
+    }
+
+    if (run_stripe_check (m_threads, context, result)) {
+      return result;
+    }
+
+  }
+
   db::box_scanner<db::Polygon, size_t> scanner (m_report_progress, m_progress_desc);
   scanner.reserve (size () + (other ? other->size () : 0));
 
-  ensure_valid_merged_polygons ();
   size_t n = 0;
   for (const_iterator p = begin_merged (); ! p.at_end (); ++p) {
     scanner.insert (&*p, n); 
@@ -1806,7 +2250,6 @@ Region::run_check (db::edge_relation_type rel, bool different_polygons, const Re
   }
 
   if (other) {
-    other->ensure_valid_merged_polygons ();
     n = 1;
     for (const_iterator p = other->begin_merged (); ! p.at_end (); ++p) {
       scanner.insert (&*p, n); 
@@ -1814,13 +2257,6 @@ Region::run_check (db::edge_relation_type rel, bool different_polygons, const Re
     }
   }
 
-  EdgeRelationFilter check (rel, d, metrics);
-  check.set_include_zero (other != 0);
-  check.set_whole_edges (whole_edges);
-  check.set_ignore_angle (ignore_angle);
-  check.set_min_projection (min_projection);
-  check.set_max_projection (max_projection);
-
   Edge2EdgeCheck edge_check (check, result, different_polygons, other != 0);
   Poly2PolyCheck poly_check (edge_check);
 
@@ -1842,6 +2278,23 @@ Region::run_single_polygon_check (db::edge_relation_type rel, db::Coord d, bool
   check.set_min_projection (min_projection);
   check.set_max_projection (max_projection);
 
+  if (m_threads > 0) {
+
+    CheckContext context (check, false, false);
+    context.polygons.reserve (size ());
+
+    size_t n = 0;
+    for (const_iterator p = begin_merged (); ! p.at_end (); ++p) {
+      context.polygons.push_back (CheckPolygon (&*p, n));
+      n += 2;
+    }
+
+    if (run_single_polygon_check_mt (m_threads, context, result)) {
+      return result;
+    }
+
+  }
+
   Edge2EdgeCheck edge_check (check, result, false, false);
   Poly2PolyCheck poly_check (edge_check);
 
@@ -657,6 +657,42 @@ public:
     return m_strict_handling;
   }
 
+  /**
+   *  @brief Enables or disables the boolean operand cache
+   *
+   *  With the cache enabled, the region keeps its edges in the form the edge processor
+   *  needs them once it has been used as an operand of a boolean operation (AND, NOT, XOR, OR).
+   *  Further boolean operations with this region will only have to sort in the edges of 
+   *  the other operand. This is useful if one region is combined with many others.
+   *  The cache needs additional memory. It is dropped when the region is modified.
+   *  The cache is disabled by default.
+   */
+  void set_boolean_operand_cache (bool f);
+
+  /**
+   *  @brief Gets a flag indicating whether the boolean operand cache is enabled
+   */
+  bool boolean_operand_cache () const
+  {
+    return m_boolean_operand_cache;
+  }
+
+  /**
+   *  @brief Sets the number of threads to use for operations which support multi-threading
+   *
+   *  Currently, the boolean, merge and sizing operations and the DRC checks make use of 
+   *  multiple threads. A value of 0 (the default) means single-threaded operation.
+   */
+  void set_threads (int n);
+
+  /**
+   *  @brief Gets the number of threads to use
+   */
+  int threads () const
+  {
+    return m_threads;
+  }
+
   /**
    *  @brief Returns true if the region is a single box
    *
@@ -728,6 +764,7 @@ public:
     }
     m_polygons.get_layer<db::Polygon, db::unstable_layer_tag> ().erase (pw, m_polygons.get_layer<db::Polygon, db::unstable_layer_tag> ().end ());
     m_merged_polygons.clear ();
+    mp_prepared_operand.reset (0);
     m_is_merged = m_merged_semantics;
     m_iter = db::RecursiveShapeIterator ();
     return *this;
@@ -928,6 +965,7 @@ public:
       }
       m_iter_trans = db::ICplxTrans (trans) * m_iter_trans;
       m_bbox_valid = false;
+      mp_prepared_operand.reset (0);
     }
     return *this;
   }
@@ -1113,6 +1151,8 @@ public:
    */
   Region operator& (const Region &other) const
   {
+    //  makes the copy share the prepared operand if the boolean operand cache is enabled
+    prepared_operand ();
     Region d (*this);
     d &= other;
     return d;
@@ -1131,6 +1171,8 @@ public:
    */
   Region operator- (const Region &other) const
   {
+    //  makes the copy share the prepared operand if the boolean operand cache is enabled
+    prepared_operand ();
     Region d (*this);
     d -= other;
     return d;
@@ -1149,6 +1191,8 @@ public:
    */
   Region operator^ (const Region &other) const
   {
+    //  makes the copy share the prepared operand if the boolean operand cache is enabled
+    prepared_operand ();
     Region d (*this);
     d ^= other;
     return d;
@@ -1169,6 +1213,8 @@ public:
    */
   Region operator| (const Region &other) const
   {
+    //  makes the copy share the prepared operand if the boolean operand cache is enabled
+    prepared_operand ();
     Region d (*this);
     d |= other;
     return d;
@@ -1566,11 +1612,14 @@ private:
   bool m_merged_semantics;
   bool m_strict_handling;
   bool m_merge_min_coherence;
+  bool m_boolean_operand_cache;
+  int m_threads;
   mutable db::Shapes m_polygons;
   mutable db::Shapes m_merged_polygons;
   mutable db::Box m_bbox;
   mutable bool m_bbox_valid;
   mutable bool m_merged_polygons_valid;
+  mutable tl::shared_ptr<db::EdgeProcessorOperand> mp_prepared_operand;
   mutable db::RecursiveShapeIterator m_iter;
   db::ICplxTrans m_iter_trans;
   bool m_report_progress;
@@ -1581,6 +1630,8 @@ private:
   void set_valid_polygons ();
   void ensure_bbox_valid () const;
   void ensure_merged_polygons_valid () const;
+  const db::EdgeProcessorOperand *prepared_operand () const;
+  void insert_boolean_operands (db::EdgeProcessor &ep, const Region &other) const;
   EdgePairs run_check (db::edge_relation_type rel, bool different_polygons, const Region *other, db::Coord d, bool whole_edges, metrics_type metrics, double ignore_angle, distance_type min_projection, distance_type max_projection) const;
   EdgePairs run_single_polygon_check (db::edge_relation_type rel, db::Coord d, bool whole_edges, metrics_type metrics, double ignore_angle, distance_type min_projection, distance_type max_projection) const;
   void select_interacting_generic (const Region &other, int mode, bool touching, bool inverse);
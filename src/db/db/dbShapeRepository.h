@@ -31,7 +31,10 @@
 #include "dbBox.h"
 #include "dbMemStatistics.h"
 
+#include <QMutex>
+
 #include <set>
+#include <iterator>
 
 namespace db {
 
@@ -42,12 +45,164 @@ template <class C> class edge;
 template <class C> class text;
 template <class C> class user_object;
 
+/**
+ *  @brief Computes the shard key for a shape inside a repository
+ *
+ *  The key is derived from the shape's bounding box. Identical shapes
+ *  deliver identical keys, so the deduplication property of the
+ *  repository is maintained per shard.
+ */
+template <class Sh>
+inline size_t repository_shard_key (const Sh &shape)
+{
+  db::box<typename Sh::coord_type> b = shape.box ();
+  size_t h = 0;
+  if (! b.empty ()) {
+    h = size_t (b.left ());
+    h = (h << 4) ^ (h >> 4) ^ size_t (b.bottom ());
+    h = (h << 4) ^ (h >> 4) ^ size_t (b.right ());
+    h = (h << 4) ^ (h >> 4) ^ size_t (b.top ());
+  }
+  return h;
+}
+
+/**
+ *  @brief Computes the shard key for a text
+ *
+ *  Texts are usually stored in the repository without displacement,
+ *  hence the key is derived from the string.
+ */
+template <class C>
+inline size_t repository_shard_key (const db::text<C> &text)
+{
+  size_t h = size_t (text.size ());
+  for (const char *cp = text.string (); *cp; ++cp) {
+    h = (h << 4) ^ (h >> 4) ^ size_t ((unsigned char) *cp);
+  }
+  return h;
+}
+
+/**
+ *  @brief One partition of a repository
+ *
+ *  A shard is a set of shapes protected by a lock. The lock is not copied.
+ */
+template <class Sh>
+struct repository_shard
+{
+  typedef std::set<Sh> set_type;
+
+  repository_shard ()
+    : set ()
+  {
+    //  .. nothing yet ..
+  }
+
+  repository_shard (const repository_shard<Sh> &d)
+    : set (d.set)
+  {
+    //  .. nothing yet ..
+  }
+
+  repository_shard<Sh> &operator= (const repository_shard<Sh> &d)
+  {
+    if (&d != this) {
+      set = d.set;
+    }
+    return *this;
+  }
+
+  set_type set;
+  QMutex lock;
+};
+
+/**
+ *  @brief The iterator for the repository
+ *
+ *  This iterator delivers the shapes of all shards of a repository.
+ */
+template <class Sh>
+class repository_iterator
+{
+public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef Sh value_type;
+  typedef const Sh &reference;
+  typedef const Sh *pointer;
+  typedef ptrdiff_t difference_type;
+  typedef typename repository_shard<Sh>::set_type::const_iterator set_iterator;
+
+  repository_iterator ()
+    : mp_shards (0), m_shard (0), m_nshards (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  repository_iterator (const repository_shard<Sh> *shards, size_t shard, size_t nshards)
+    : mp_shards (shards), m_shard (shard), m_nshards (nshards)
+  {
+    if (m_shard < m_nshards) {
+      m_iter = mp_shards [m_shard].set.begin ();
+      validate ();
+    }
+  }
+
+  bool operator== (const repository_iterator<Sh> &d) const
+  {
+    return m_shard == d.m_shard && (m_shard >= m_nshards || m_iter == d.m_iter);
+  }
+
+  bool operator!= (const repository_iterator<Sh> &d) const
+  {
+    return ! operator== (d);
+  }
+
+  repository_iterator<Sh> &operator++ ()
+  {
+    ++m_iter;
+    validate ();
+    return *this;
+  }
+
+  const Sh &operator* () const
+  {
+    return *m_iter;
+  }
+
+  const Sh *operator-> () const
+  {
+    return m_iter.operator-> ();
+  }
+
+private:
+  const repository_shard<Sh> *mp_shards;
+  size_t m_shard, m_nshards;
+  set_iterator m_iter;
+
+  void validate ()
+  {
+    while (m_iter == mp_shards [m_shard].set.end ()) {
+      if (++m_shard == m_nshards) {
+        break;
+      }
+      m_iter = mp_shards [m_shard].set.begin ();
+    }
+  }
+};
+
 /**
  *  @brief A repository for a certain shape type
  *
  *  The repository is basically a set of shapes that
  *  can be used to store duplicates of shapes in an
  *  efficient way.
+ *
+ *  The repository is partitioned into shards by a key computed from
+ *  the shape (see repository_shard_key). Each shard has its own lock,
+ *  so "insert" can be called from multiple threads concurrently (for
+ *  example by parallel readers or tile workers) without serializing on
+ *  a single lock. The pointers delivered by "insert" remain valid
+ *  while other threads insert further shapes.
  */
 
 template <class Sh>
@@ -55,14 +210,16 @@ class repository
 {
 public:
   typedef typename Sh::coord_type coord_type;
-  typedef std::set<Sh> set_type;
-  typedef typename set_type::const_iterator iterator;
+  typedef repository_shard<Sh> shard_type;
+  typedef typename shard_type::set_type set_type;
+  typedef repository_iterator<Sh> iterator;
+
+  enum { num_shards = 16 };
 
   /** 
    *  @brief The standard constructor
    */
   repository ()
-    : m_set ()
   {
     //  .. nothing yet ..
   }
@@ -71,21 +228,37 @@ public:
    *  @brief The copy constructor
    */
   repository (const repository<Sh> &d)
-    : m_set (d.m_set)
   {
-    //  .. nothing yet ..
+    for (size_t i = 0; i < size_t (num_shards); ++i) {
+      m_shards [i] = d.m_shards [i];
+    }
+  }
+
+  /** 
+   *  @brief Assignment
+   */
+  repository<Sh> &operator= (const repository<Sh> &d)
+  {
+    if (&d != this) {
+      for (size_t i = 0; i < size_t (num_shards); ++i) {
+        m_shards [i] = d.m_shards [i];
+      }
+    }
+    return *this;
   }
 
   /**
    *  @brief Insert a shape into the repository
    *
-   *  Inserts a shape into the repository.
+   *  Inserts a shape into the repository. This method is thread-safe.
    *
    *  @return A pointer to the instance of the identical shape
    */
   const Sh *insert (const Sh &shape)
   {
-    typename std::set<Sh>::iterator f = m_set.insert (shape).first;
+    shard_type &shard = m_shards [repository_shard_key (shape) % size_t (num_shards)];
+    QMutexLocker locker (&shard.lock);
+    typename set_type::iterator f = shard.set.insert (shape).first;
     return &(*f);
   }
 
@@ -94,7 +267,11 @@ public:
    */
   size_t size () const
   {
-    return m_set.size ();
+    size_t n = 0;
+    for (size_t i = 0; i < size_t (num_shards); ++i) {
+      n += m_shards [i].set.size ();
+    }
+    return n;
   }
 
   /**
@@ -102,7 +279,7 @@ public:
    */
   iterator begin () const
   {
-    return m_set.begin ();
+    return iterator (m_shards, 0, size_t (num_shards));
   }
 
   /**
@@ -110,21 +287,29 @@ public:
    */
   iterator end () const
   {
-    return m_set.end ();
+    return iterator (m_shards, size_t (num_shards), size_t (num_shards));
   }
 
   size_t mem_used () const
   {
-    return db::mem_used (m_set);
+    size_t m = 0;
+    for (size_t i = 0; i < size_t (num_shards); ++i) {
+      m += db::mem_used (m_shards [i].set) + sizeof (QMutex);
+    }
+    return m;
   }
 
   size_t mem_reqd () const
   {
-    return db::mem_reqd (m_set);
+    size_t m = 0;
+    for (size_t i = 0; i < size_t (num_shards); ++i) {
+      m += db::mem_reqd (m_shards [i].set) + sizeof (QMutex);
+    }
+    return m;
   }
 
 private:
-  set_type m_set;
+  shard_type m_shards [num_shards];
 };
 
 template <class Sh>
@@ -735,9 +735,9 @@ public:
           (*l)->deref_into (this, pm_delegate);
         }
       } else {
-        //  translate and transform into this
+        //  translate into this
         for (tl::vector<LayerBase *>::const_iterator l = d.m_layers.begin (); l != d.m_layers.end (); ++l) {
-          (*l)->transform_into (this, shape_repository (), array_repository (), pm_delegate);
+          (*l)->translate_into (this, shape_repository (), array_repository (), pm_delegate);
         }
       }
 
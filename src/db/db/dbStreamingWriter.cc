@@ -0,0 +1,150 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#include "dbStreamingWriter.h"
+#include "dbLayout.h"
+#include "dbMemStatistics.h"
+#include "tlStream.h"
+#include "tlTimer.h"
+#include "tlLog.h"
+
+namespace db
+{
+
+// ---------------------------------------------------------------
+//  StreamingWriter implementation
+
+StreamingWriter::StreamingWriter (const db::SaveLayoutOptions &options, tl::OutputStream &stream, size_t memory_budget)
+  : m_writer (options), mp_stream (&stream), m_memory_budget (memory_budget), m_pending_memory (0), m_started (false), m_cells_written (0)
+{
+  if (! m_writer.supports_cellwise ()) {
+    throw tl::Exception (tl::to_string (QObject::tr ("Format does not support streaming: %s")), options.format ());
+  }
+}
+
+StreamingWriter::~StreamingWriter ()
+{
+  //  .. nothing yet ..
+}
+
+bool
+StreamingWriter::supports (const db::SaveLayoutOptions &options)
+{
+  try {
+    db::Writer writer (options);
+    return writer.supports_cellwise ();
+  } catch (...) {
+    return false;
+  }
+}
+
+void 
+StreamingWriter::start (db::Layout &layout)
+{
+  if (! m_started) {
+    m_writer.begin_cellwise (layout, *mp_stream);
+    m_started = true;
+  }
+}
+
+void 
+StreamingWriter::cell_finished (db::Layout &layout, db::cell_index_type cell_index)
+{
+  //  NOTE: the header is written when the first cell arrives - at this point the reader has
+  //  delivered the database unit and the file properties.
+  start (layout);
+
+  m_pending.push_back (cell_index);
+
+  if (m_memory_budget > 0) {
+    db::MemStatistics ms;
+    layout.cell (cell_index).collect_mem_stat (ms);
+    m_pending_memory += ms.used ();
+  }
+
+  if (m_pending_memory >= m_memory_budget) {
+    flush (layout);
+  }
+}
+
+void 
+StreamingWriter::write (db::Layout &layout, db::cell_index_type cell_index)
+{
+  m_writer.write_cell (layout, cell_index);
+  ++m_cells_written;
+
+  if (m_written.size () <= size_t (cell_index)) {
+    m_written.resize (cell_index + 1, false);
+  }
+  m_written [cell_index] = true;
+
+  //  release the cell's content - proxy cells are kept since their content is 
+  //  managed by the library or PCell
+  db::Cell &cell = layout.cell (cell_index);
+  if (! cell.is_proxy ()) {
+    cell.clear_shapes ();
+    cell.clear_insts ();
+  }
+}
+
+void 
+StreamingWriter::flush (db::Layout &layout)
+{
+  for (std::vector<db::cell_index_type>::const_iterator c = m_pending.begin (); c != m_pending.end (); ++c) {
+    write (layout, *c);
+  }
+
+  m_pending.clear ();
+  m_pending_memory = 0;
+}
+
+void 
+StreamingWriter::finish (db::Layout &layout)
+{
+  tl::SelfTimer timer (tl::verbosity () >= 21, "Finishing streaming write");
+
+  start (layout);
+  flush (layout);
+
+  //  write the cells not reported by the reader
+  for (db::Layout::const_iterator c = layout.begin (); c != layout.end (); ++c) {
+
+    db::cell_index_type ci = c->cell_index ();
+    if (size_t (ci) < m_written.size () && m_written [ci]) {
+      continue;
+    }
+
+    //  don't write ghost cells unless they are not empty (any more)
+    //  also don't write proxy cells which are not employed
+    if ((! c->is_ghost_cell () || ! c->empty ()) && (! c->is_proxy () || ! c->is_top ())) {
+      write (layout, ci);
+    }
+
+  }
+
+  m_writer.end_cellwise (layout);
+}
+
+}
+
@@ -0,0 +1,140 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_dbStreamingWriter
+#define HDR_dbStreamingWriter
+
+#include "dbCommon.h"
+
+#include "dbReader.h"
+#include "dbWriter.h"
+#include "dbSaveLayoutOptions.h"
+
+#include <vector>
+
+namespace tl
+{
+  class OutputStream;
+}
+
+namespace db
+{
+
+class Layout;
+
+/**
+ *  @brief A reader cell sink which writes the cells to a stream as soon as they are read
+ *
+ *  This object implements a "read-process-write" pipeline: installed as the cell sink 
+ *  of a reader (see db::Reader::set_cell_sink), it receives the cells once they are read
+ *  completely and writes them to the output stream using the cell-wise mode of the 
+ *  writer (see db::WriterBase::begin_cellwise). After a cell has been written, its 
+ *  shapes and instances are removed from the layout. Hence the memory required is 
+ *  limited to the cells not written yet and the layout does not need to be held in 
+ *  memory entirely. For this, readers delivering cells to a sink create plain shapes 
+ *  rather than shape references - the layout's shape repository would keep the shapes 
+ *  otherwise.
+ *
+ *  Cells are collected until the memory they occupy exceeds the memory budget. Then
+ *  they are written and released. With a budget of 0, every cell is written immediately.
+ *
+ *  After the reader has finished, "finish" must be called. This will write the cells
+ *  not delivered by the reader (e.g. because the reader does not support the cell sink
+ *  feature) and finish the file. 
+ *
+ *  Cell selection, dropping of empty cells and context information are not supported
+ *  in this mode. Library and PCell proxies are written as normal cells.
+ *
+ *  Usage:
+ *
+ *  @code
+ *  db::StreamingWriter sw (save_options, out_stream);
+ *  db::Reader reader (in_stream);
+ *  reader.set_cell_sink (&sw);
+ *  reader.read (layout, load_options);
+ *  sw.finish (layout);
+ *  @endcode
+ */
+class DB_PUBLIC StreamingWriter
+  : public db::ReaderCellSink
+{
+public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param options The writer options. The format must support cell-wise writing (see supports).
+   *  @param stream The stream to write to
+   *  @param memory_budget The memory budget in bytes for cells waiting to be written
+   */
+  StreamingWriter (const db::SaveLayoutOptions &options, tl::OutputStream &stream, size_t memory_budget = 0);
+
+  /**
+   *  @brief Destructor
+   */
+  ~StreamingWriter ();
+
+  /**
+   *  @brief Returns true, if the format of the given options supports streaming
+   */
+  static bool supports (const db::SaveLayoutOptions &options);
+
+  /**
+   *  @brief Implementation of ReaderCellSink
+   */
+  virtual void cell_finished (db::Layout &layout, db::cell_index_type cell_index);
+
+  /**
+   *  @brief Writes the remaining cells and finishes the file
+   *
+   *  This method must be called after the reader has finished.
+   */
+  void finish (db::Layout &layout);
+
+  /**
+   *  @brief Gets the number of cells written so far
+   */
+  size_t cells_written () const
+  {
+    return m_cells_written;
+  }
+
+private:
+  db::Writer m_writer;
+  tl::OutputStream *mp_stream;
+  size_t m_memory_budget;
+  size_t m_pending_memory;
+  bool m_started;
+  size_t m_cells_written;
+  std::vector<db::cell_index_type> m_pending;
+  std::vector<bool> m_written;
+
+  void start (db::Layout &layout);
+  void flush (db::Layout &layout);
+  void write (db::Layout &layout, db::cell_index_type cell_index);
+};
+
+}
+
+#endif
+
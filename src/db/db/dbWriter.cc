@@ -30,6 +30,30 @@
 namespace db
 {
 
+// ---------------------------------------------------------------
+//  WriterBase implementation
+
+void 
+WriterBase::begin_cellwise (db::Layout & /*layout*/, tl::OutputStream & /*stream*/, const db::SaveLayoutOptions & /*options*/)
+{
+  throw tl::Exception (tl::to_string (QObject::tr ("Cell-wise writing is not supported for this format")));
+}
+
+void 
+WriterBase::write_cell (db::Layout & /*layout*/, db::cell_index_type /*cell_index*/)
+{
+  throw tl::Exception (tl::to_string (QObject::tr ("Cell-wise writing is not supported for this format")));
+}
+
+void 
+WriterBase::end_cellwise (db::Layout & /*layout*/)
+{
+  throw tl::Exception (tl::to_string (QObject::tr ("Cell-wise writing is not supported for this format")));
+}
+
+// ---------------------------------------------------------------
+//  Writer implementation
+
 Writer::Writer (const db::SaveLayoutOptions &options)
   : mp_writer (0), m_options (options)
 {
@@ -58,5 +82,25 @@ Writer::write (db::Layout &layout, tl::OutputStream &stream)
   mp_writer->write (layout, stream, m_options);
 }
 
+void 
+Writer::begin_cellwise (db::Layout &layout, tl::OutputStream &stream)
+{
+  tl_assert (mp_writer != 0);
+  mp_writer->begin_cellwise (layout, stream, m_options);
+}
+
+void 
+Writer::write_cell (db::Layout &layout, db::cell_index_type cell_index)
+{
+  tl_assert (mp_writer != 0);
+  mp_writer->write_cell (layout, cell_index);
 }
 
+void 
+Writer::end_cellwise (db::Layout &layout)
+{
+  tl_assert (mp_writer != 0);
+  mp_writer->end_cellwise (layout);
+}
+
+}
@@ -61,6 +61,40 @@ public:
    *  The layout is non-const since the writer may modify the meta information of the layout.
    */
   virtual void write (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options) = 0;
+
+  /**
+   *  @brief Returns true, if the writer supports cell-wise writing
+   *
+   *  In cell-wise mode, the writer does not require the full layout. Instead, it 
+   *  writes the cells one by one in the order they are delivered (see begin_cellwise,
+   *  write_cell and end_cellwise). Cell selection and context information are not 
+   *  supported in this mode.
+   */
+  virtual bool supports_cellwise () const 
+  {
+    return false;
+  }
+
+  /**
+   *  @brief Starts cell-wise writing
+   *
+   *  This method writes the file header. The layout needs to provide the database unit
+   *  and the file properties at this point. 
+   */
+  virtual void begin_cellwise (db::Layout &layout, tl::OutputStream &stream, const db::SaveLayoutOptions &options);
+
+  /**
+   *  @brief Writes the given cell in cell-wise mode
+   *
+   *  The cell is written with all its shapes and instances. Child cells are referred to 
+   *  by name and may be written before or later.
+   */
+  virtual void write_cell (db::Layout &layout, db::cell_index_type cell_index);
+
+  /**
+   *  @brief Finishes cell-wise writing
+   */
+  virtual void end_cellwise (db::Layout &layout);
 };
 
 /**
@@ -88,6 +122,33 @@ public:
    */
   void write (db::Layout &layout, tl::OutputStream &stream);
 
+  /**
+   *  @brief Returns true, if the writer supports cell-wise writing
+   *  See WriterBase::supports_cellwise for details.
+   */
+  bool supports_cellwise () const
+  {
+    return mp_writer && mp_writer->supports_cellwise ();
+  }
+
+  /**
+   *  @brief Starts cell-wise writing
+   *  See WriterBase::begin_cellwise for details.
+   */
+  void begin_cellwise (db::Layout &layout, tl::OutputStream &stream);
+
+  /**
+   *  @brief Writes the given cell in cell-wise mode
+   *  See WriterBase::write_cell for details.
+   */
+  void write_cell (db::Layout &layout, db::cell_index_type cell_index);
+
+  /**
+   *  @brief Finishes cell-wise writing
+   *  See WriterBase::end_cellwise for details.
+   */
+  void end_cellwise (db::Layout &layout);
+
   /**
    *  @brief True, if for this format a valid writer is provided
    */
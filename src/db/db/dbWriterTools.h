@@ -126,6 +126,14 @@ public:
    */
   const std::string &cell_name (db::cell_index_type id) const;
 
+  /**
+   *  @brief Returns true, if a name has already been assigned for the given cell id
+   */
+  bool has_cell (db::cell_index_type id) const
+  {
+    return m_map.find (id) != m_map.end ();
+  }
+
 private:
   std::map <db::cell_index_type, std::string> m_map;
   std::set <std::string> m_cell_names;
@@ -0,0 +1,181 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "gsiDecl.h"
+
+#include "dbDeepRegion.h"
+
+namespace gsi
+{
+
+// ---------------------------------------------------------------------------------
+//  DeepShapeStore binding
+
+static db::DeepShapeStore *new_dss (const db::Layout *layout, db::cell_index_type cell_index)
+{
+  return new db::DeepShapeStore (*layout, cell_index);
+}
+
+Class<db::DeepShapeStore> decl_DeepShapeStore ("DeepShapeStore",
+  constructor ("new", &new_dss, gsi::arg ("layout"), gsi::arg ("cell_index"),
+    "@brief Creates a store for the cell tree below the given cell of the given layout\n"
+    "\n"
+    "The store takes a copy of the cell tree. It does not keep a reference to the layout."
+  ) +
+  method ("is_flat?", &db::DeepShapeStore::is_flat,
+    "@brief Returns true, if the store keeps the shapes flat\n"
+    "\n"
+    "This is the case if the cell tree contains instances with arbitrary angles or magnifications."
+  ),
+  "@brief A container for hierarchical shape data\n"
+  "\n"
+  "The deep shape store provides the hierarchy for \\DeepRegion objects. Deep regions can only be "
+  "combined if they live in the same store. The store must be kept alive as long as the deep regions "
+  "are used.\n"
+  "\n"
+  "This class has been introduced in version 0.25."
+);
+
+// ---------------------------------------------------------------------------------
+//  DeepRegion binding
+
+static db::DeepRegion *new_dr_si (db::DeepShapeStore *store, const db::RecursiveShapeIterator &si)
+{
+  return new db::DeepRegion (*store, si);
+}
+
+static db::DeepRegion *new_dr_si2 (db::DeepShapeStore *store, const db::RecursiveShapeIterator &si, const db::ICplxTrans &trans)
+{
+  return new db::DeepRegion (*store, si, trans);
+}
+
+static std::string dr_to_string0 (const db::DeepRegion *r)
+{
+  return r->to_string ();
+}
+
+static std::string dr_to_string1 (const db::DeepRegion *r, size_t n)
+{
+  return r->to_string (n);
+}
+
+static void insert_into (const db::DeepRegion *r, db::Layout *layout, db::cell_index_type cell_index, unsigned int layer)
+{
+  r->insert_into (layout, cell_index, layer);
+}
+
+Class<db::DeepRegion> decl_DeepRegion ("DeepRegion",
+  constructor ("new", &new_dr_si, gsi::arg ("store"), gsi::arg ("shape_iterator"),
+    "@brief Creates a deep region from the shapes delivered by a recursive shape iterator\n"
+    "\n"
+    "If the shape iterator starts at the layout and cell the store was created for and does not "
+    "employ a search region or cell selection, the shapes are taken over with the hierarchy. "
+    "Otherwise they are taken over flat.\n"
+  ) +
+  constructor ("new", &new_dr_si2, gsi::arg ("store"), gsi::arg ("shape_iterator"), gsi::arg ("trans"),
+    "@brief Creates a deep region from the shapes delivered by a recursive shape iterator with a transformation\n"
+    "\n"
+    "The shapes are taken over flat unless the transformation is a unit transformation.\n"
+  ) +
+  method ("&", &db::DeepRegion::operator&, gsi::arg ("other"),
+    "@brief Returns the boolean AND between self and the other deep region\n"
+    "\n"
+    "The computation is done hierarchically. Both regions must belong to the same store."
+  ) +
+  method ("-", &db::DeepRegion::operator-, gsi::arg ("other"),
+    "@brief Returns the boolean NOT between self and the other deep region\n"
+    "\n"
+    "The computation is done hierarchically. Both regions must belong to the same store."
+  ) +
+  method ("^", &db::DeepRegion::operator^, gsi::arg ("other"),
+    "@brief Returns the boolean XOR between self and the other deep region\n"
+    "\n"
+    "The computation is done hierarchically. Both regions must belong to the same store."
+  ) +
+  method ("|", &db::DeepRegion::operator|, gsi::arg ("other"),
+    "@brief Returns the boolean OR between self and the other deep region\n"
+    "\n"
+    "The polygons of both regions are merged inside each cell, but not across the hierarchy."
+  ) +
+  method ("+", &db::DeepRegion::operator+, gsi::arg ("other"),
+    "@brief Returns the combined polygons of self and the other deep region\n"
+  ) +
+  method ("merged", &db::DeepRegion::merged,
+    "@brief Returns the deep region with the polygons merged inside each cell\n"
+    "\n"
+    "Polygons from different cells are not merged. Hence the result may still contain "
+    "overlapping or touching polygons."
+  ) +
+  method ("flattened", &db::DeepRegion::flattened,
+    "@brief Returns a flat \\Region object with the same content\n"
+  ) +
+  method_ext ("insert_into", &insert_into, gsi::arg ("layout"), gsi::arg ("cell_index"), gsi::arg ("layer"),
+    "@brief Inserts the polygons into the given layout, cell and layer\n"
+    "\n"
+    "If the layout and cell are the ones the store was created from, the polygons are written into "
+    "the original cells. Otherwise the cell tree is reproduced below the given cell."
+  ) +
+  method ("bbox", &db::DeepRegion::bbox,
+    "@brief Returns the bounding box of the region\n"
+  ) +
+  method ("is_empty?", &db::DeepRegion::empty,
+    "@brief Returns true if the region is empty\n"
+  ) +
+  method ("size", &db::DeepRegion::size,
+    "@brief Returns the number of polygons in the flat view of the region\n"
+    "\n"
+    "This number is computed from the hierarchy without actually flattening the region."
+  ) +
+  method ("hier_size", &db::DeepRegion::hier_size,
+    "@brief Returns the number of polygons stored inside the hierarchy\n"
+  ) +
+  method_ext ("to_s", &dr_to_string0,
+    "@brief Converts the region to a string\n"
+    "The length of the output is limited to 20 polygons to avoid giant strings on large regions. "
+    "For full output use \"to_s\" with a maximum count parameter.\n"
+  ) +
+  method_ext ("to_s", &dr_to_string1, gsi::arg ("max_count"),
+    "@brief Converts the region to a string\n"
+    "This version allows specification of the maximum number of polygons contained in the string."
+  ),
+  "@brief A hierarchical region\n"
+  "\n"
+  "In contrast to \\Region, a deep region does not flatten the polygons but keeps them inside "
+  "the cells of a \\DeepShapeStore. The boolean operations are computed hierarchically: cells "
+  "are evaluated once per distinct surrounding they are used in. For regular structures like "
+  "memory arrays, this requires far less memory and time than flat processing.\n"
+  "\n"
+  "The results are exact in terms of the area covered, but polygons are not merged across "
+  "the hierarchy.\n"
+  "\n"
+  "@code\n"
+  "store = RBA::DeepShapeStore::new(layout, cell.cell_index)\n"
+  "a = RBA::DeepRegion::new(store, layout.begin_shapes(cell, la))\n"
+  "b = RBA::DeepRegion::new(store, layout.begin_shapes(cell, lb))\n"
+  "(a - b).insert_into(layout, cell.cell_index, lout)\n"
+  "@/code\n"
+  "\n"
+  "This class has been introduced in version 0.25."
+);
+
+}
+
@@ -585,6 +585,21 @@ Class<db::EdgeProcessor> decl_EdgeProcessor ("EdgeProcessor",
     "\n"
     "This method has been introduced in version 0.23.\n"
   ) +
+  method ("threads=", &db::EdgeProcessor::set_threads,
+    "@brief Sets the number of threads to use\n"
+    "@args n\n"
+    "If this value is larger than 0, the edge processor will distribute the intersection computation over the given "
+    "number of threads and produce the output in a separate thread. The results are identical to the single-threaded "
+    "operation. A value of 0 (the default) means single-threaded operation.\n"
+    "\n"
+    "This method has been introduced in version 0.25.\n"
+  ) +
+  method ("threads", &db::EdgeProcessor::threads,
+    "@brief Gets the number of threads to use\n"
+    "See \\threads= for a description of this attribute.\n"
+    "\n"
+    "This method has been introduced in version 0.25.\n"
+  ) +
   method ("ModeAnd|#mode_and", &gsi::mode_and, "@brief boolean method's mode value for AND operation") +
   method ("ModeOr|#mode_or", &gsi::mode_or, "@brief boolean method's mode value for OR operation") +
   method ("ModeXor|#mode_xor", &gsi::mode_xor, "@brief boolean method's mode value for XOR operation") +
@@ -2348,6 +2348,38 @@ Class<db::Region> decl_Region ("Region",
     "@brief Disable progress reporting\n"
     "Calling this method will disable progress reporting. See \\enable_progress.\n"
   ) +
+  method ("threads=", &db::Region::set_threads,
+    "@brief Sets the number of threads to use for operations which support multi-threading\n"
+    "@args n\n"
+    "Currently, the boolean, merge and sizing operations and the checks (i.e. \\width_check or \\space_check) "
+    "can make use of multiple threads. The results are identical to the single-threaded operation, except "
+    "for the order of the edge pairs delivered by the checks. A value of 0 (the default) means single-threaded operation.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
+  method ("threads", &db::Region::threads,
+    "@brief Gets the number of threads to use for operations which support multi-threading\n"
+    "See \\threads= for a description of this attribute.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
+  method ("boolean_operand_cache=", &db::Region::set_boolean_operand_cache,
+    "@brief Enables or disables the boolean operand cache\n"
+    "@args f\n"
+    "If the cache is enabled, the region keeps its edges prepared for the boolean operations once it "
+    "has been used as an operand of AND, NOT, XOR or OR. Further boolean operations involving this region "
+    "will be faster because only the other operand's edges need to be prepared. This is useful if "
+    "one region is combined with many others. The cache needs additional memory. "
+    "It is dropped when the region is modified. The cache is disabled by default.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
+  method ("boolean_operand_cache?", &db::Region::boolean_operand_cache,
+    "@brief Gets a flag indicating whether the boolean operand cache is enabled\n"
+    "See \\boolean_operand_cache= for a description of this attribute.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
   method ("Euclidian", &euclidian_metrics,
     "@brief Specifies Euclidian metrics for the check functions\n"
     "This value can be used for the metrics parameter in the check functions, i.e. \\width_check. "
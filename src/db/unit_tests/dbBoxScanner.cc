@@ -555,6 +555,126 @@ TEST(11)
   // run_test11(_this, 10000, 2, 10000);
 }
 
+void run_test12 (tl::TestBase *_this, size_t n, int threads, db::Coord spread, bool touch = true)
+{
+  std::vector<db::Box> bb;
+  for (size_t i = 0; i < n; ++i) {
+    db::Coord x = rand () % spread;
+    db::Coord y = rand () % spread;
+    //  some tall boxes reaching over several partitions
+    db::Coord h = (i % 100 == 0 ? spread / 10 : 100);
+    bb.push_back (db::Box (x, y, x + 100, y + h));
+  }
+
+  db::box_convert<db::Box> bc;
+
+  BoxScannerTestRecorder2 tr_st;
+  std::set<std::set<size_t> > clusters_st;
+  {
+    db::box_scanner<db::Box, size_t> bs;
+    for (std::vector<db::Box>::const_iterator b = bb.begin (); b != bb.end (); ++b) {
+      bs.insert (&*b, b - bb.begin ());
+    }
+
+    {
+      tl::SelfTimer timer ("box-scanner (single-threaded)");
+      bs.process (tr_st, touch ? 1 : 0, bc);
+    }
+
+    TestCluster clt (&clusters_st);
+    db::cluster_collector<db::Box, size_t, TestCluster> coll (clt);
+    bs.process (coll, touch ? 1 : 0, bc);
+  }
+
+  BoxScannerTestRecorder2 tr_mt;
+  std::set<std::set<size_t> > clusters_mt;
+  {
+    db::box_scanner<db::Box, size_t> bs;
+    bs.set_threads (threads);
+    for (std::vector<db::Box>::const_iterator b = bb.begin (); b != bb.end (); ++b) {
+      bs.insert (&*b, b - bb.begin ());
+    }
+
+    {
+      tl::SelfTimer timer ("box-scanner (multi-threaded)");
+      bs.process (tr_mt, touch ? 1 : 0, bc);
+    }
+
+    TestCluster clt (&clusters_mt);
+    db::cluster_collector<db::Box, size_t, TestCluster> coll (clt);
+    bs.process (coll, touch ? 1 : 0, bc);
+  }
+
+  EXPECT_EQ (tr_st.interactions.size (), tr_mt.interactions.size ());
+  EXPECT_EQ (tr_st.interactions == tr_mt.interactions, true);
+  EXPECT_EQ (clusters_st.size (), clusters_mt.size ());
+  EXPECT_EQ (clusters_st == clusters_mt, true);
+}
+
+TEST(12)
+{
+  //  multi-threaded vs. single-threaded
+  run_test12(_this, 100000, 1, 30000);
+  run_test12(_this, 100000, 4, 30000);
+  run_test12(_this, 100000, 4, 30000, false);
+  run_test12(_this, 30000, 3, 10000);
+  run_test12(_this, 100000, 8, 100000);
+}
+
+struct BoxScannerCountingRecorder
+{
+  BoxScannerCountingRecorder () : interactions (0), finished (0) { }
+
+  void finish (const db::Box *, size_t) { ++finished; }
+  void add (const db::Box *, size_t, const db::Box *, size_t) { ++interactions; }
+
+  size_t interactions, finished;
+};
+
+TEST(13)
+{
+  //  performance benchmark: scaling with the number of threads on 10M boxes
+  test_is_long_runner ();
+
+  const size_t n = 10000000;
+  const db::Coord spread = 2000000;
+
+  std::vector<db::Box> bb;
+  bb.reserve (n);
+  for (size_t i = 0; i < n; ++i) {
+    db::Coord x = (rand () % 10000) * (spread / 10000) + rand () % (spread / 10000);
+    db::Coord y = (rand () % 10000) * (spread / 10000) + rand () % (spread / 10000);
+    bb.push_back (db::Box (x, y, x + 500, y + 500));
+  }
+
+  db::box_convert<db::Box> bc;
+  size_t interactions_st = 0;
+
+  for (int threads = 0; threads <= 8; threads = (threads == 0 ? 1 : threads * 2)) {
+
+    db::box_scanner<db::Box, size_t> bs;
+    bs.set_threads (threads);
+    bs.reserve (bb.size ());
+    for (std::vector<db::Box>::const_iterator b = bb.begin (); b != bb.end (); ++b) {
+      bs.insert (&*b, b - bb.begin ());
+    }
+
+    BoxScannerCountingRecorder rec;
+    {
+      tl::SelfTimer timer ("box-scanner with " + tl::to_string (threads) + " thread(s)");
+      bs.process (rec, 1, bc);
+    }
+
+    if (threads == 0) {
+      interactions_st = rec.interactions;
+    } else {
+      EXPECT_EQ (rec.interactions, interactions_st);
+    }
+    EXPECT_EQ (rec.finished, n);
+
+  }
+}
+
 
 #include "tlStream.h"
 #include "dbReader.h"
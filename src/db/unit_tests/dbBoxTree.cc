@@ -85,7 +85,7 @@ void print_tree (const Tree &t, db::Box bbox)
 }
 
 template <class Box, class Tree>
-void print_unstable_tree_node (const Tree *tree, const Box &bbox, size_t pos, db::box_tree_node<Tree> *node, const std::string &in)
+void print_unstable_tree_node (const Tree *tree, const Box &bbox, size_t pos, const typename Tree::box_tree_node *node, const std::string &in)
 {
   std::cout << in << "x [\n";
   if (! node) { 
@@ -992,3 +992,67 @@ TEST(6U)
 }
 
 
+
+TEST(7U)
+{
+  Box2BoxCmplx conv;
+  UnstableTestTreeCmplx t;
+
+  int n = 2000;
+  for (int i = 0; i < n; ++i) {
+    t.insert (rbox ());
+  }
+  t.sort (conv);
+
+  //  the nodes are packed in depth-first order: children follow their parent and
+  //  cover consecutive object ranges
+  const UnstableTestTreeCmplx::node_vector_type &nodes = t.nodes ();
+  EXPECT_EQ (nodes.empty (), false);
+  EXPECT_EQ (t.root () == &nodes.front (), true);
+  EXPECT_EQ (t.root ()->parent () == 0, true);
+  for (UnstableTestTreeCmplx::node_vector_type::const_iterator n = nodes.begin (); n != nodes.end (); ++n) {
+    for (int q = 0; q < 4; ++q) {
+      const UnstableTestTreeCmplx::box_tree_node *c = n->child (q);
+      if (c) {
+        EXPECT_EQ (c > &*n, true);
+        EXPECT_EQ (c->parent () == &*n, true);
+        EXPECT_EQ (c->quad (), q);
+        size_t nc = 0;
+        for (int qq = -1; qq < 4; ++qq) {
+          nc += c->lenq (qq);
+        }
+        EXPECT_EQ (nc, n->lenq (q));
+      }
+    }
+  }
+
+  //  copies carry the packed nodes
+  UnstableTestTreeCmplx tc (t);
+  UnstableTestTreeCmplx ta;
+  ta = t;
+  EXPECT_EQ (tc.nodes ().size (), nodes.size ());
+  EXPECT_EQ (ta.nodes ().size (), nodes.size ());
+
+  for (int i = 0; i < 100; ++i) {
+    db::Box b (rbox ().enlarged (db::Vector (500, 500)));
+    test_tree_overlap (_this, t, b, conv);
+    test_tree_touching (_this, t, b, conv);
+    test_tree_overlap (_this, tc, b, conv);
+    test_tree_touching (_this, tc, b, conv);
+    test_tree_overlap (_this, ta, b, conv);
+    test_tree_touching (_this, ta, b, conv);
+  }
+
+  //  sorting again rebuilds the nodes
+  t.insert (rbox ());
+  t.sort (conv);
+  for (int i = 0; i < 100; ++i) {
+    db::Box b (rbox ().enlarged (db::Vector (500, 500)));
+    test_tree_overlap (_this, t, b, conv);
+    test_tree_touching (_this, t, b, conv);
+  }
+
+  t.clear ();
+  EXPECT_EQ (t.root () == 0, true);
+  EXPECT_EQ (t.nodes ().empty (), true);
+}
@@ -0,0 +1,227 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "tlUnitTest.h"
+
+#include "dbDeepRegion.h"
+#include "dbLayout.h"
+
+namespace
+{
+
+/**
+ *  @brief Creates a memory-like test layout
+ *
+ *  "BIT" is arrayed 10x10 inside "MID". "MID" is placed twice inside "TOP", one time
+ *  rotated and mirrored. Shapes of layer B reach into the neighbor bits, so the bits at
+ *  the array boundary see a different context than the ones inside the array.
+ */
+void make_layout (db::Layout &ly, unsigned int la, unsigned int lb)
+{
+  db::cell_index_type top = ly.add_cell ("TOP");
+  db::cell_index_type mid = ly.add_cell ("MID");
+  db::cell_index_type bit = ly.add_cell ("BIT");
+
+  ly.cell (bit).shapes (la).insert (db::Box (0, 0, 80, 80));
+  ly.cell (bit).shapes (lb).insert (db::Box (60, 30, 130, 50));
+
+  ly.cell (mid).insert (db::CellInstArray (db::CellInst (bit), db::Trans (), db::Vector (100, 0), db::Vector (0, 100), 10, 10));
+  ly.cell (mid).shapes (la).insert (db::Box (-50, -50, 1050, -20));
+  ly.cell (mid).shapes (lb).insert (db::Box (-20, -40, 20, 1040));
+
+  ly.cell (top).insert (db::CellInstArray (db::CellInst (mid), db::Trans ()));
+  ly.cell (top).insert (db::CellInstArray (db::CellInst (mid), db::Trans (db::Trans::m45, db::Vector (2000, 0))));
+  ly.cell (top).shapes (lb).insert (db::Box (250, 250, 2450, 270));
+  ly.cell (top).shapes (la).insert (db::Box (1100, 100, 1900, 200));
+}
+
+bool same_area (const db::Region &a, const db::Region &b)
+{
+  return (a ^ b).empty ();
+}
+
+}
+
+TEST(1_Basic)
+{
+  db::Layout ly;
+  unsigned int la = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int lb = ly.insert_layer (db::LayerProperties (2, 0));
+  make_layout (ly, la, lb);
+
+  db::cell_index_type top = ly.cell_by_name ("TOP").second;
+
+  db::DeepShapeStore dss (ly, top);
+  EXPECT_EQ (dss.is_flat (), false);
+
+  db::DeepRegion a (dss, db::RecursiveShapeIterator (ly, ly.cell (top), la));
+  db::DeepRegion b (dss, db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+
+  db::Region ra (db::RecursiveShapeIterator (ly, ly.cell (top), la));
+  db::Region rb (db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+
+  EXPECT_EQ (a.hier_size (), size_t (3));
+  EXPECT_EQ (a.size (), size_t (203));
+  EXPECT_EQ (a.bbox ().to_string (), ra.bbox ().to_string ());
+  EXPECT_EQ (a.empty (), false);
+  EXPECT_EQ (db::DeepRegion ().empty (), true);
+
+  EXPECT_EQ (same_area (a.flattened (), ra), true);
+  EXPECT_EQ (same_area (b.flattened (), rb), true);
+
+  db::DeepRegion r_and = a & b;
+  EXPECT_EQ (same_area (r_and.flattened (), ra & rb), true);
+  //  the result stays hierarchical
+  EXPECT_EQ (r_and.hier_size () < r_and.size (), true);
+
+  db::DeepRegion r_not = a - b;
+  EXPECT_EQ (same_area (r_not.flattened (), ra - rb), true);
+  EXPECT_EQ (r_not.hier_size () < r_not.size (), true);
+
+  db::DeepRegion r_not2 = b - a;
+  EXPECT_EQ (same_area (r_not2.flattened (), rb - ra), true);
+
+  db::DeepRegion r_xor = a ^ b;
+  EXPECT_EQ (same_area (r_xor.flattened (), ra ^ rb), true);
+
+  db::DeepRegion r_or = a | b;
+  EXPECT_EQ (same_area (r_or.flattened (), ra | rb), true);
+
+  db::DeepRegion r_join = a + b;
+  EXPECT_EQ (r_join.size (), a.size () + b.size ());
+  EXPECT_EQ (same_area (r_join.flattened (), ra | rb), true);
+
+  EXPECT_EQ (same_area (a.merged ().flattened (), ra), true);
+
+  //  operations with empty deep regions
+  EXPECT_EQ ((a & db::DeepRegion ()).empty (), true);
+  EXPECT_EQ (same_area ((a - db::DeepRegion ()).flattened (), ra), true);
+  EXPECT_EQ (same_area ((db::DeepRegion () ^ b).flattened (), rb), true);
+}
+
+TEST(2_Output)
+{
+  db::Layout ly;
+  unsigned int la = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int lb = ly.insert_layer (db::LayerProperties (2, 0));
+  make_layout (ly, la, lb);
+
+  db::cell_index_type top = ly.cell_by_name ("TOP").second;
+
+  db::DeepShapeStore dss (ly, top);
+  db::DeepRegion a (dss, db::RecursiveShapeIterator (ly, ly.cell (top), la));
+  db::DeepRegion b (dss, db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+
+  db::Region ref = db::Region (db::RecursiveShapeIterator (ly, ly.cell (top), la)) - db::Region (db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+
+  //  output into the original hierarchy
+  unsigned int lo = ly.insert_layer (db::LayerProperties (10, 0));
+  (a - b).insert_into (&ly, top, lo);
+  EXPECT_EQ (same_area (db::Region (db::RecursiveShapeIterator (ly, ly.cell (top), lo)), ref), true);
+  EXPECT_EQ (ly.cell (top).shapes (lo).size () < ref.size (), true);
+
+  //  output into a different layout
+  db::Layout ly2;
+  unsigned int lo2 = ly2.insert_layer (db::LayerProperties (10, 0));
+  db::cell_index_type top2 = ly2.add_cell ("TOP");
+  (a - b).insert_into (&ly2, top2, lo2);
+  EXPECT_EQ (same_area (db::Region (db::RecursiveShapeIterator (ly2, ly2.cell (top2), lo2)), ref), true);
+  EXPECT_EQ (ly2.cell_by_name ("BIT").first, true);
+}
+
+TEST(3_FlatFallback)
+{
+  db::Layout ly;
+  unsigned int la = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int lb = ly.insert_layer (db::LayerProperties (2, 0));
+  make_layout (ly, la, lb);
+
+  db::cell_index_type top = ly.cell_by_name ("TOP").second;
+
+  //  a search region makes the import flat
+  db::DeepShapeStore dss (ly, top);
+  db::DeepRegion a (dss, db::RecursiveShapeIterator (ly, ly.cell (top), la, db::Box (0, 0, 500, 500)));
+  db::DeepRegion b (dss, db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+  EXPECT_EQ (a.hier_size (), a.size ());
+
+  db::Region ra (db::RecursiveShapeIterator (ly, ly.cell (top), la, db::Box (0, 0, 500, 500)));
+  db::Region rb (db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+  EXPECT_EQ (same_area ((a & b).flattened (), ra & rb), true);
+  EXPECT_EQ (same_area ((b - a).flattened (), rb - ra), true);
+
+  //  complex instances make the store flat
+  db::cell_index_type c = ly.add_cell ("CPLX");
+  ly.cell (c).insert (db::CellInstArray (db::CellInst (top), db::ICplxTrans (2.0)));
+
+  db::DeepShapeStore dss2 (ly, c);
+  EXPECT_EQ (dss2.is_flat (), true);
+
+  db::DeepRegion a2 (dss2, db::RecursiveShapeIterator (ly, ly.cell (c), la));
+  db::DeepRegion b2 (dss2, db::RecursiveShapeIterator (ly, ly.cell (c), lb));
+  db::Region ra2 (db::RecursiveShapeIterator (ly, ly.cell (c), la));
+  db::Region rb2 (db::RecursiveShapeIterator (ly, ly.cell (c), lb));
+  EXPECT_EQ (same_area ((a2 ^ b2).flattened (), ra2 ^ rb2), true);
+
+  //  regions from different stores cannot be combined
+  bool error = false;
+  try {
+    db::DeepRegion x = a & a2;
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+}
+
+
+TEST(4_LargeArray)
+{
+  //  a large regular array: the interior members share one context, the members
+  //  at the border and the ones touched by the top cell's shapes have individual ones
+  db::Layout ly;
+  unsigned int la = ly.insert_layer (db::LayerProperties (1, 0));
+  unsigned int lb = ly.insert_layer (db::LayerProperties (2, 0));
+
+  db::cell_index_type top = ly.add_cell ("TOP");
+  db::cell_index_type bit = ly.add_cell ("BIT");
+
+  ly.cell (bit).shapes (la).insert (db::Box (0, 0, 80, 80));
+  ly.cell (bit).shapes (lb).insert (db::Box (60, 30, 130, 50));
+
+  ly.cell (top).insert (db::CellInstArray (db::CellInst (bit), db::Trans (), db::Vector (100, 0), db::Vector (0, 100), 200, 150));
+  ly.cell (top).shapes (lb).insert (db::Box (5000, -100, 5020, 20000));
+  ly.cell (top).shapes (lb).insert (db::Box (7010, 7010, 7020, 7020));
+
+  db::DeepShapeStore dss (ly, top);
+  db::DeepRegion a (dss, db::RecursiveShapeIterator (ly, ly.cell (top), la));
+  db::DeepRegion b (dss, db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+
+  db::Region ra (db::RecursiveShapeIterator (ly, ly.cell (top), la));
+  db::Region rb (db::RecursiveShapeIterator (ly, ly.cell (top), lb));
+
+  db::DeepRegion r_not = a - b;
+  EXPECT_EQ (same_area (r_not.flattened (), ra - rb), true);
+  EXPECT_EQ (r_not.hier_size () < r_not.size () / 10, true);
+
+  db::DeepRegion r_and = a & b;
+  EXPECT_EQ (same_area (r_and.flattened (), ra & rb), true);
+}
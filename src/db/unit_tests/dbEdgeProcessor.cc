@@ -2244,3 +2244,329 @@ TEST(100)
   db::compare_layouts (_this, lr, au_fn);
 }
 
+
+static std::vector<db::Polygon> random_polygons (unsigned int &seed, size_t n, bool any_angle)
+{
+  std::vector<db::Polygon> polygons;
+
+  for (size_t i = 0; i < n; ++i) {
+
+    seed = seed * 1103515245 + 12345;
+    db::Coord x = db::Coord ((seed >> 8) % 100000);
+    seed = seed * 1103515245 + 12345;
+    db::Coord y = db::Coord ((seed >> 8) % 100000);
+    seed = seed * 1103515245 + 12345;
+    db::Coord w = db::Coord ((seed >> 8) % 2000 + 1);
+    seed = seed * 1103515245 + 12345;
+    db::Coord h = db::Coord ((seed >> 8) % 2000 + 1);
+
+    if (any_angle && (i % 3) == 0) {
+      db::Point pts[] = { db::Point (x, y), db::Point (x + w, y + h / 3), db::Point (x + w / 2, y + h) };
+      db::Polygon poly;
+      poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+      polygons.push_back (poly);
+    } else {
+      polygons.push_back (db::Polygon (db::Box (x, y, x + w, y + h)));
+    }
+
+  }
+
+  return polygons;
+}
+
+//  tall vertical bars spanning all bands and horizontal bars crossing them. Every 10th row
+//  carries diagonal triangles, so 90 degree and all-angle bands alternate.
+static std::vector<db::Polygon> grid_polygons (db::Coord offset)
+{
+  std::vector<db::Polygon> polygons;
+
+  //  a lone bar far left which does not interact with anything
+  polygons.push_back (db::Polygon (db::Box (-5000 + offset, offset, -4950 + offset, 100000 + offset)));
+
+  for (db::Coord i = 1; i <= 50; ++i) {
+    polygons.push_back (db::Polygon (db::Box (i * 1000 + offset, offset, i * 1000 + 100 + offset, 100000 + offset)));
+  }
+
+  for (db::Coord j = 0; j < 100; ++j) {
+    polygons.push_back (db::Polygon (db::Box (500 + offset, j * 1000 + offset, 50500 + offset, j * 1000 + 100 + offset)));
+    if ((j % 10) == 0) {
+      for (db::Coord i = 1; i <= 50; i += 7) {
+        db::Point pts[] = { db::Point (i * 1000 + 300 + offset, j * 1000 + 300 + offset), db::Point (i * 1000 + 800 + offset, j * 1000 + 400 + offset), db::Point (i * 1000 + 500 + offset, j * 1000 + 700 + offset) };
+        db::Polygon poly;
+        poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+        polygons.push_back (poly);
+      }
+    }
+  }
+
+  return polygons;
+}
+
+static void run_test_threads (tl::TestBase *_this, const std::vector<db::Polygon> &a, const std::vector<db::Polygon> &b, size_t batch_size)
+{
+  db::EdgeProcessor ep_st;
+  db::EdgeProcessor ep_mt;
+  ep_mt.set_threads (4);
+  EXPECT_EQ (ep_mt.threads (), 4);
+  ep_mt.set_thread_batch_size (batch_size);
+  EXPECT_EQ (ep_mt.thread_batch_size (), batch_size);
+
+  std::vector<db::Polygon> out_st, out_mt;
+
+  ep_st.merge (a, out_st, 0, false, true);
+  ep_mt.merge (a, out_mt, 0, false, true);
+  EXPECT_EQ (out_st.size () > 0, true);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  ep_st.merge (a, out_st, 1, true, false);
+  ep_mt.merge (a, out_mt, 1, true, false);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  ep_st.boolean (a, b, out_st, db::BooleanOp::And, true, true);
+  ep_mt.boolean (a, b, out_mt, db::BooleanOp::And, true, true);
+  EXPECT_EQ (out_st.size () > 0, true);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  ep_st.boolean (a, b, out_st, db::BooleanOp::Xor, false, false);
+  ep_mt.boolean (a, b, out_mt, db::BooleanOp::Xor, false, false);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  ep_st.size (a, 100, 50, out_st, 2, true, true);
+  ep_mt.size (a, 100, 50, out_mt, 2, true, true);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  ep_st.size (a, -30, -30, out_st, 2, false, false);
+  ep_mt.size (a, -30, -30, out_mt, 2, false, false);
+  EXPECT_EQ (out_st == out_mt, true);
+
+  std::vector<db::Edge> edges_st, edges_mt;
+  ep_st.boolean (a, b, edges_st, db::BooleanOp::ANotB);
+  ep_mt.boolean (a, b, edges_mt, db::BooleanOp::ANotB);
+  EXPECT_EQ (edges_st.size () > 0, true);
+  EXPECT_EQ (edges_st == edges_mt, true);
+}
+
+static void run_test_threads (tl::TestBase *_this, bool any_angle, size_t batch_size)
+{
+  unsigned int seed = 17;
+  std::vector<db::Polygon> a = random_polygons (seed, 5000, any_angle);
+  std::vector<db::Polygon> b = random_polygons (seed, 5000, any_angle);
+  run_test_threads (_this, a, b, batch_size);
+}
+
+//  multi-threaded mode delivers the same results than single-threaded mode
+TEST(50)
+{
+  run_test_threads (_this, false, 1000000);
+}
+
+TEST(51)
+{
+  run_test_threads (_this, true, 1000000);
+}
+
+//  small batches: the worker threads are run in the middle of the band walk
+TEST(52)
+{
+  run_test_threads (_this, false, 10);
+  run_test_threads (_this, true, 10);
+  run_test_threads (_this, true, 1);
+}
+
+//  90 degree and all-angle bands with edges spanning many bands
+TEST(53)
+{
+  std::vector<db::Polygon> a = grid_polygons (0);
+  std::vector<db::Polygon> b = grid_polygons (250);
+  run_test_threads (_this, a, b, 1000000);
+  run_test_threads (_this, a, b, 10);
+  run_test_threads (_this, a, b, 1);
+}
+
+static void run_test_prepared (tl::TestBase *_this, bool any_angle)
+{
+  unsigned int seed = 42;
+  std::vector<db::Polygon> a = random_polygons (seed, 5000, any_angle);
+  std::vector<db::Polygon> b = random_polygons (seed, 5000, any_angle);
+
+  db::EdgeProcessorOperand prep_a, prep_b;
+  size_t n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = a.begin (); p != a.end (); ++p, n += 2) {
+    prep_a.insert (*p, n);
+  }
+  n = 0;
+  for (std::vector<db::Polygon>::const_iterator p = b.begin (); p != b.end (); ++p, n += 2) {
+    prep_b.insert (*p, n);
+  }
+  EXPECT_EQ (prep_a.empty (), false);
+
+  int modes[] = { db::BooleanOp::And, db::BooleanOp::ANotB, db::BooleanOp::BNotA, db::BooleanOp::Xor, db::BooleanOp::Or };
+
+  for (unsigned int m = 0; m < sizeof (modes) / sizeof (modes [0]); ++m) {
+
+    db::EdgeProcessor ep;
+
+    std::vector<db::Polygon> out_ref;
+    ep.boolean (a, b, out_ref, modes [m], false, false);
+    EXPECT_EQ (out_ref.size () > 0, true);
+
+    //  prepared first operand, second operand as polygons
+    {
+      std::vector<db::Polygon> out;
+      ep.clear ();
+      ep.insert (prep_a, 0);
+      n = 1;
+      for (std::vector<db::Polygon>::const_iterator p = b.begin (); p != b.end (); ++p, n += 2) {
+        ep.insert (*p, n);
+      }
+      db::BooleanOp op ((db::BooleanOp::BoolOp) modes [m]);
+      db::PolygonContainer pc (out);
+      db::PolygonGenerator pg (pc, false, false);
+      ep.process (pg, op);
+      EXPECT_EQ (out == out_ref, true);
+    }
+
+    //  prepared second operand, first operand as polygons
+    {
+      std::vector<db::Polygon> out;
+      ep.clear ();
+      ep.insert (prep_b, 1);
+      n = 0;
+      for (std::vector<db::Polygon>::const_iterator p = a.begin (); p != a.end (); ++p, n += 2) {
+        ep.insert (*p, n);
+      }
+      db::BooleanOp op ((db::BooleanOp::BoolOp) modes [m]);
+      db::PolygonContainer pc (out);
+      db::PolygonGenerator pg (pc, false, false);
+      ep.process (pg, op);
+      EXPECT_EQ (out == out_ref, true);
+    }
+
+    //  both operands prepared
+    {
+      std::vector<db::Polygon> out;
+      ep.clear ();
+      ep.insert (prep_a, 0);
+      ep.insert (prep_b, 1);
+      db::BooleanOp op ((db::BooleanOp::BoolOp) modes [m]);
+      db::PolygonContainer pc (out);
+      db::PolygonGenerator pg (pc, false, false);
+      ep.process (pg, op);
+      EXPECT_EQ (out == out_ref, true);
+    }
+
+  }
+}
+
+//  prepared operands deliver the same results than plain ones
+TEST(60)
+{
+  run_test_prepared (_this, false);
+}
+
+TEST(61)
+{
+  run_test_prepared (_this, true);
+}
+
+//  parallel diagonal lines with a few crossing ones: gives dense cells with few intersections
+static std::vector<db::Polygon> diagonal_bus (size_t n, db::Coord len)
+{
+  std::vector<db::Polygon> polygons;
+
+  for (size_t i = 0; i < n; ++i) {
+    db::Coord o = db::Coord (i * 40);
+    db::Point pts[] = { db::Point (o, 0), db::Point (o + 20, 0), db::Point (o + 20 + len, len), db::Point (o + len, len) };
+    db::Polygon poly;
+    poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+    polygons.push_back (poly);
+  }
+
+  for (size_t i = 0; i < n / 50; ++i) {
+    db::Coord o = db::Coord (i * 50 * 40 + 17);
+    db::Point pts[] = { db::Point (o, len), db::Point (o + 30, len), db::Point (o + 30 + len / 3, 0), db::Point (o + len / 3, 0) };
+    db::Polygon poly;
+    poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+    polygons.push_back (poly);
+  }
+
+  return polygons;
+}
+
+static void run_test_simd_level (tl::TestBase *_this, const std::vector<db::Polygon> &a, const std::vector<db::Polygon> &b)
+{
+  std::vector<db::Polygon> merged_ref, and_ref, xor_ref;
+
+  //  level 0 (no filters) is the reference
+  for (int level = 0; level <= 3; ++level) {
+
+    db::EdgeProcessor ep;
+    ep.set_simd_level (level);
+    std::vector<db::Polygon> merged, and_res, xor_res;
+
+    ep.merge (a, merged, 0, false, false);
+    ep.boolean (a, b, and_res, db::BooleanOp::And, false, false);
+    ep.boolean (a, b, xor_res, db::BooleanOp::Xor, false, false);
+
+    if (level == 0) {
+      merged_ref.swap (merged);
+      and_ref.swap (and_res);
+      xor_ref.swap (xor_res);
+      EXPECT_EQ (merged_ref.size () > 0, true);
+      EXPECT_EQ (and_ref.size () > 0, true);
+    } else {
+      EXPECT_EQ (merged == merged_ref, true);
+      EXPECT_EQ (and_res == and_ref, true);
+      EXPECT_EQ (xor_res == xor_ref, true);
+    }
+
+  }
+
+}
+
+//  filters of all levels deliver the same results than the unfiltered implementation
+TEST(70)
+{
+  unsigned int seed = 17;
+  std::vector<db::Polygon> a = random_polygons (seed, 5000, true);
+  std::vector<db::Polygon> b = random_polygons (seed, 5000, true);
+  run_test_simd_level (_this, a, b);
+}
+
+TEST(71)
+{
+  std::vector<db::Polygon> a = diagonal_bus (100, 5000);
+  std::vector<db::Polygon> b;
+  b.push_back (db::Polygon (db::Box (0, 1000, 10000, 1500)));
+  b.push_back (db::Polygon (db::Box (1500, 0, 1800, 5000)));
+  run_test_simd_level (_this, a, b);
+}
+
+TEST(72)
+{
+  //  performance benchmark: intersection computation for the different instruction sets
+  test_is_long_runner ();
+
+  std::vector<db::Polygon> a = diagonal_bus (400, 20000);
+  std::vector<db::Polygon> merged_ref;
+
+  //  level 0 (no filters) is the reference
+  for (int level = 0; level <= 3; ++level) {
+
+    db::EdgeProcessor ep;
+    ep.set_simd_level (level);
+    std::vector<db::Polygon> merged;
+    {
+      tl::SelfTimer timer ("merge with SIMD level " + tl::to_string (level));
+      ep.merge (a, merged, 0, false, false);
+    }
+
+    if (level == 0) {
+      merged_ref.swap (merged);
+    } else {
+      EXPECT_EQ (merged == merged_ref, true);
+    }
+
+  }
+
+}
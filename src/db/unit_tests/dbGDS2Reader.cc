@@ -347,3 +347,55 @@ TEST(2)
   }
 }
 
+
+static void run_parallel_read_test (tl::TestBase *_this, const char *file)
+{
+  std::string fn (tl::testsrc ());
+  fn += "/testdata/gds/";
+  fn += file;
+
+  db::Manager m;
+
+  db::Layout layout (&m);
+  {
+    tl::InputStream stream (fn);
+    db::GDS2Reader reader (stream);
+    reader.read (layout);
+  }
+
+  db::Layout layout_mt (&m);
+  {
+    tl::InputStream stream (fn);
+    db::GDS2Reader reader (stream);
+    db::LoadLayoutOptions options;
+    db::GDS2ReaderOptions gds2_options;
+    gds2_options.read_threads = 4;
+    options.set_options (gds2_options);
+    reader.read (layout_mt, options);
+  }
+
+  //  the layers and cells are created in the same order
+  EXPECT_EQ (layout_mt.layers (), layout.layers ());
+  for (unsigned int l = 0; l < layout.layers () && l < layout_mt.layers (); ++l) {
+    EXPECT_EQ (layout_mt.get_properties (l).to_string (), layout.get_properties (l).to_string ());
+  }
+  EXPECT_EQ (layout_mt.cells (), layout.cells ());
+  for (db::cell_index_type c = 0; c < layout.cells () && c < layout_mt.cells (); ++c) {
+    EXPECT_EQ (std::string (layout_mt.cell_name (c)), std::string (layout.cell_name (c)));
+  }
+
+  bool equal = db::compare_layouts (layout, layout_mt, db::layout_diff::f_verbose, 0);
+  if (! equal) {
+    _this->raise (tl::sprintf ("Compare failed (multi-threaded read) for %s\n", fn));
+  }
+}
+
+TEST(3)
+{
+  //  multi-threaded reading
+  run_parallel_read_test (_this, "arefs.gds");
+  run_parallel_read_test (_this, "t10.gds");
+  run_parallel_read_test (_this, "lib_test.gds");
+  run_parallel_read_test (_this, "pcell_test.gds");
+}
+
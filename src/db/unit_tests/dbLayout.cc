@@ -23,6 +23,7 @@
 
 
 #include "dbLayout.h"
+#include "dbStatic.h"
 #include "tlString.h"
 #include "tlUnitTest.h"
 
@@ -464,3 +465,167 @@ TEST(4)
   prop_id = g.properties_repository ().properties_id (ps);
   EXPECT_EQ (el.property_ids_dirty, true);
 }
+
+TEST(5)
+{
+  //  Cell hashes
+
+  db::Layout g1;
+  unsigned int l11 = g1.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l12 = g1.insert_layer (db::LayerProperties (2, 0));
+  db::cell_index_type top1 = g1.add_cell ("TOP");
+  db::cell_index_type a1 = g1.add_cell ("A");
+  g1.cell (a1).shapes (l11).insert (db::Box (0, 0, 100, 200));
+  g1.cell (a1).shapes (l12).insert (db::Polygon (db::Box (10, 20, 30, 40)));
+  g1.cell (a1).shapes (l12).insert (db::Text ("T", db::Trans (db::Vector (5, 6))));
+  g1.cell (top1).insert (db::CellInstArray (db::CellInst (a1), db::Trans (db::Vector (1000, 0))));
+  g1.cell (top1).insert (db::CellInstArray (db::CellInst (a1), db::Trans (db::Vector (0, 1000))));
+
+  //  same layout, but different layer and cell order and different shape and instance order
+  db::Layout g2;
+  unsigned int l22 = g2.insert_layer (db::LayerProperties (2, 0));
+  unsigned int l21 = g2.insert_layer (db::LayerProperties (1, 0));
+  db::cell_index_type a2 = g2.add_cell ("A");
+  db::cell_index_type top2 = g2.add_cell ("TOP");
+  g2.cell (a2).shapes (l22).insert (db::Text ("T", db::Trans (db::Vector (5, 6))));
+  g2.cell (a2).shapes (l22).insert (db::Polygon (db::Box (10, 20, 30, 40)));
+  g2.cell (a2).shapes (l21).insert (db::Box (0, 0, 100, 200));
+  g2.cell (top2).insert (db::CellInstArray (db::CellInst (a2), db::Trans (db::Vector (0, 1000))));
+  g2.cell (top2).insert (db::CellInstArray (db::CellInst (a2), db::Trans (db::Vector (1000, 0))));
+
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), true);
+  EXPECT_EQ (g1.cell_hash (top1) == g2.cell_hash (top2), true);
+  EXPECT_EQ (g1.cell_hash (top1) == g1.cell_hash (a1), false);
+
+  //  a change in the child cell propagates to the parent
+  g2.cell (a2).shapes (l21).insert (db::Box (0, 0, 100, 100));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+  EXPECT_EQ (g1.cell_hash (top1) == g2.cell_hash (top2), false);
+
+  g1.cell (a1).shapes (l11).insert (db::Box (0, 0, 100, 100));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), true);
+  EXPECT_EQ (g1.cell_hash (top1) == g2.cell_hash (top2), true);
+
+  //  layer properties are part of the hash
+  g2.set_properties (l21, db::LayerProperties (1, 1));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+  g2.set_properties (l21, db::LayerProperties (1, 0));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), true);
+
+  //  child cell names are part of the parent's hash
+  g2.rename_cell (a2, "B");
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), true);
+  EXPECT_EQ (g1.cell_hash (top1) == g2.cell_hash (top2), false);
+  g2.rename_cell (a2, "A");
+  EXPECT_EQ (g1.cell_hash (top1) == g2.cell_hash (top2), true);
+
+  //  properties are part of the hash
+  db::PropertiesRepository::properties_set ps;
+  ps.insert (std::make_pair (g2.properties_repository ().prop_name_id (tl::Variant (1)), tl::Variant ("XYZ")));
+  db::properties_id_type prop_id = g2.properties_repository ().properties_id (ps);
+  g2.cell (a2).shapes (l21).insert (db::BoxWithProperties (db::Box (0, 0, 10, 10), prop_id));
+  g1.cell (a1).shapes (l11).insert (db::Box (0, 0, 10, 10));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+
+  //  property values are hashed, not the ID's - changing the values behind an ID changes the hash
+  g2.properties_repository ().change_properties (prop_id, db::PropertiesRepository::properties_set ());
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+
+  ps.clear ();
+  ps.insert (std::make_pair (g1.properties_repository ().prop_name_id (tl::Variant (1)), tl::Variant ("XYZ")));
+  db::properties_id_type prop_id1 = g1.properties_repository ().properties_id (ps);
+  ps.clear ();
+  ps.insert (std::make_pair (g2.properties_repository ().prop_name_id (tl::Variant (1)), tl::Variant ("XYZ")));
+  g2.properties_repository ().change_properties (prop_id, ps);
+  g1.cell (a1).shapes (l11).clear ();
+  g1.cell (a1).shapes (l11).insert (db::Box (0, 0, 100, 200));
+  g1.cell (a1).shapes (l11).insert (db::Box (0, 0, 100, 100));
+  g1.cell (a1).shapes (l11).insert (db::BoxWithProperties (db::Box (0, 0, 10, 10), prop_id1));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), true);
+
+  //  cell properties are part of the hash
+  g2.cell (a2).prop_id (prop_id);
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+  g1.cell (a1).prop_id (prop_id1);
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), true);
+  g2.cell (a2).prop_id (0);
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+  g1.cell (a1).prop_id (0);
+
+  //  floating-point values are hashed by value, not through their string representation
+  ps.clear ();
+  ps.insert (std::make_pair (g1.properties_repository ().prop_name_id (tl::Variant (1)), tl::Variant (1.0)));
+  g1.cell (a1).prop_id (g1.properties_repository ().properties_id (ps));
+  ps.clear ();
+  ps.insert (std::make_pair (g2.properties_repository ().prop_name_id (tl::Variant (1)), tl::Variant (1.0 + 1e-14)));
+  g2.cell (a2).prop_id (g2.properties_repository ().properties_id (ps));
+  EXPECT_EQ (g1.cell_hash (a1) == g2.cell_hash (a2), false);
+}
+
+static void build_hier_layout (db::Layout &g)
+{
+  unsigned int l1 = g.insert_layer (db::LayerProperties (1, 0));
+  unsigned int l2 = g.insert_layer (db::LayerProperties (2, 0));
+
+  db::cell_index_type top = g.add_cell ("TOP");
+
+  std::vector<db::cell_index_type> leafs;
+  for (int i = 0; i < 20; ++i) {
+    db::cell_index_type ci = g.add_cell (("L" + tl::to_string (i)).c_str ());
+    g.cell (ci).shapes ((i % 2) == 0 ? l1 : l2).insert (db::Box (0, 0, 100 + i * 10, 200));
+    leafs.push_back (ci);
+  }
+
+  for (int i = 0; i < 5; ++i) {
+    db::cell_index_type ci = g.add_cell (("M" + tl::to_string (i)).c_str ());
+    for (int j = 0; j < 4; ++j) {
+      g.cell (ci).insert (db::CellInstArray (db::CellInst (leafs [i * 4 + j]), db::Trans (db::Vector (j * 1000, i * 100))));
+    }
+    g.cell (ci).insert (db::CellInstArray (db::CellInst (leafs [i]), db::Trans (db::Vector (-500, 0)), db::Vector (0, 300), db::Vector (300, 0), 3, 4));
+    g.cell (top).insert (db::CellInstArray (db::CellInst (ci), db::Trans (db::Trans::r90, db::Vector (0, i * 10000))));
+  }
+
+  g.cell (top).insert (db::CellInstArray (db::CellInst (leafs [19]), db::Trans (db::Vector (-20000, 0))));
+}
+
+static std::string dump_bboxes (const db::Layout &g)
+{
+  std::string s;
+  for (db::Layout::top_down_const_iterator c = g.begin_top_down (); c != g.end_top_down (); ++c) {
+    const db::Cell &cell = g.cell (*c);
+    s += std::string (g.cell_name (*c)) + ":" + cell.bbox ().to_string () + "," + cell.bbox (0).to_string () + "," + cell.bbox (1).to_string () + "," + tl::to_string (cell.hierarchy_levels ()) + "\n";
+  }
+  return s;
+}
+
+TEST(6)
+{
+  //  Multi-threaded update
+
+  db::Layout g1;
+  build_hier_layout (g1);
+  std::string ref = dump_bboxes (g1);
+
+  db::Layout g2;
+  g2.set_update_threads (4);
+  build_hier_layout (g2);
+  EXPECT_EQ (dump_bboxes (g2), ref);
+
+  //  changes deep down in the hierarchy
+  g1.cell (g1.cell_by_name ("L3").second).shapes (0).insert (db::Box (-1000, -1000, 0, 0));
+  g2.cell (g2.cell_by_name ("L3").second).shapes (0).insert (db::Box (-1000, -1000, 0, 0));
+  EXPECT_EQ (dump_bboxes (g2), dump_bboxes (g1));
+
+  //  the shape trees are sorted
+  size_t n = 0;
+  const db::Cell &l3 = g2.cell (g2.cell_by_name ("L3").second);
+  for (db::ShapeIterator s = l3.shapes (0).begin_touching (db::Box (-10, -10, -5, -5), db::ShapeIterator::All); ! s.at_end (); ++s) {
+    ++n;
+  }
+  EXPECT_EQ (n, size_t (1));
+
+  //  the number of update threads is a property of the layout
+  EXPECT_EQ (g1.update_threads (), 0);
+  db::Layout g3 (g2);
+  EXPECT_EQ (g3.update_threads (), 4);
+}
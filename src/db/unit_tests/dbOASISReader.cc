@@ -4125,3 +4125,81 @@ TEST(100)
   EXPECT_EQ (std::string (os.string ()), std::string (expected))
 }
 
+//  Reads a strict mode file with the given number of threads and delivers the layout 
+//  as text or the error message
+static std::string read_strict_mode (const char *file, int threads, bool warnings_as_errors)
+{
+  db::Manager m;
+  db::Layout layout (&m);
+
+  std::string fn (tl::testsrc ());
+  fn += "/testdata/oasis/";
+  fn += file;
+
+  try {
+
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.set_warnings_as_errors (warnings_as_errors);
+
+    db::LoadLayoutOptions options;
+    db::OASISReaderOptions oasis_options;
+    oasis_options.expect_strict_mode = 1;
+    oasis_options.read_threads = threads;
+    options.set_options (oasis_options);
+
+    reader.read (layout, options);
+
+  } catch (tl::Exception &ex) {
+    return "ERROR: " + ex.msg ();
+  }
+
+  tl::OutputStringStream os;
+  tl::OutputStream ostream (os);
+  db::TextWriter writer (ostream);
+  writer.write (layout);
+  return std::string (os.string ());
+}
+
+//  Strict mode: the multi-threaded reader delivers the same results than the single-threaded one
+
+//  name tables behind the cells, table offsets in START
+TEST(15_1)
+{
+  std::string st = read_strict_mode ("t15.1.oas", 0, true);
+  EXPECT_EQ (st.find ("ERROR") == std::string::npos, true);
+  EXPECT_EQ (st.find ("begin_cell {A}") != std::string::npos, true);
+  EXPECT_EQ (st.find ("T1") != std::string::npos, true);
+  EXPECT_EQ (read_strict_mode ("t15.1.oas", 4, true), st);
+}
+
+//  name tables behind the cells, table offsets in END
+TEST(15_2)
+{
+  std::string st = read_strict_mode ("t15.2.oas", 0, true);
+  EXPECT_EQ (st.find ("ERROR") == std::string::npos, true);
+  EXPECT_EQ (read_strict_mode ("t15.2.oas", 4, true), st);
+  EXPECT_EQ (read_strict_mode ("t15.1.oas", 0, true), st);
+}
+
+//  cells ending inside a CBLOCK
+TEST(15_3)
+{
+  std::string st = read_strict_mode ("t15.3.oas", 0, true);
+  EXPECT_EQ (st.find ("ERROR") == std::string::npos, true);
+  EXPECT_EQ (st.find ("begin_cell {D}") != std::string::npos, true);
+  EXPECT_EQ (read_strict_mode ("t15.3.oas", 4, true), st);
+  EXPECT_EQ (read_strict_mode ("t15.3.oas", 1, true), st);
+}
+
+//  warnings inside a cell decoded by a worker thread
+TEST(15_4)
+{
+  std::string st = read_strict_mode ("t15.4.oas", 0, false);
+  EXPECT_EQ (st.find ("ERROR") == std::string::npos, true);
+  EXPECT_EQ (read_strict_mode ("t15.4.oas", 4, false), st);
+
+  st = read_strict_mode ("t15.4.oas", 0, true);
+  EXPECT_EQ (st.find ("ERROR: PROPERTY strings must be references to PROPSTRING ids in strict mode") == 0, true);
+  EXPECT_EQ (read_strict_mode ("t15.4.oas", 4, true), st);
+}
@@ -135,6 +135,56 @@ void run_test (tl::TestBase *_this, const char *file, bool scaling_test, int com
       _this->raise (tl::sprintf ("Compare failed - see %s vs %s\n", fn, tmp_file));
     }
 
+    //  strict mode files can be read with multiple threads
+    db::Layout layout3 (&m);
+
+    {
+      tl::InputStream stream3 (tmp_file);
+      db::Reader reader3 (stream3);
+      db::LoadLayoutOptions options;
+      db::OASISReaderOptions oasis_options;
+      oasis_options.expect_strict_mode = 1;
+      oasis_options.read_threads = 4;
+      options.set_options (oasis_options);
+      reader3.set_warnings_as_errors (true);
+      reader3.read (layout3, options);
+    }
+
+    CHECKPOINT ();
+    equal = db::compare_layouts (layout, layout3, db::layout_diff::f_verbose | db::layout_diff::f_flatten_array_insts, 0);
+    if (! equal) {
+      _this->raise (tl::sprintf ("Compare failed (multi-threaded read) - see %s vs %s\n", fn, tmp_file));
+    }
+
+    //  multi-threaded CBLOCK compression must produce the same file
+    std::string tmp_file_mt = _this->tmp_file ("tmp_2mt.oas");
+
+    {
+      tl::OutputStream stream (tmp_file_mt);
+      db::OASISWriter writer;
+      db::SaveLayoutOptions options;
+      db::OASISWriterOptions oasis_options;
+      oasis_options.write_cblocks = true;
+      oasis_options.strict_mode = true;
+      oasis_options.cblock_threads = 4;
+      options.set_options (oasis_options);
+      writer.write (layout, stream, options);
+    }
+
+    std::string data, data_mt;
+    {
+      tl::InputStream s (tmp_file);
+      data = s.read_all ();
+    }
+    {
+      tl::InputStream s (tmp_file_mt);
+      data_mt = s.read_all ();
+    }
+
+    if (data != data_mt) {
+      _this->raise (tl::sprintf ("Files differ (multi-threaded CBLOCK compression) - see %s vs %s\n", tmp_file, tmp_file_mt));
+    }
+
   }
 
   {
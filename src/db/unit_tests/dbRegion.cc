@@ -1228,3 +1228,147 @@ TEST(30c)
   EXPECT_EQ (r.to_string (), "(-100,-100;-100,0;0,0;0,200;100,200;100,0;0,0;0,-100)");
 }
 
+
+static std::vector<db::EdgePair> sorted_edge_pairs (const db::EdgePairs &ep)
+{
+  //  NOTE: the order of the edges is not defined for checks on a single layer
+  std::vector<db::EdgePair> res;
+  for (db::EdgePairs::const_iterator e = ep.begin (); e != ep.end (); ++e) {
+    res.push_back (std::min (*e, db::EdgePair (e->second (), e->first ())));
+  }
+  std::sort (res.begin (), res.end ());
+  return res;
+}
+
+TEST(31)
+{
+  //  multi-threaded checks deliver the same results than single-threaded ones
+
+  db::Region r1, r2;
+
+  unsigned int seed = 17;
+  for (int i = 0; i < 80; ++i) {
+    for (int j = 0; j < 60; ++j) {
+
+      seed = seed * 1103515245 + 12345;
+      db::Coord w = 50 + db::Coord ((seed >> 16) % 100);
+      seed = seed * 1103515245 + 12345;
+      db::Coord h = 50 + db::Coord ((seed >> 16) % 200);
+      seed = seed * 1103515245 + 12345;
+      db::Coord dx = db::Coord ((seed >> 16) % 40);
+
+      db::Point p (i * 250 + dx, j * 300);
+      r1.insert (db::Box (p, p + db::Vector (w, h)));
+
+      //  L shapes to produce notches and shielded edge pairs
+      if ((seed >> 20) % 3 == 0) {
+        r1.insert (db::Box (p, p + db::Vector (w * 3, 40)));
+      }
+
+      //  long shapes spanning many stripes
+      if (j % 20 == 0 && i == 0) {
+        r1.insert (db::Box (db::Point (-50, j * 300 - 45), db::Point (80 * 250, j * 300 - 40)));
+      }
+
+      r2.insert (db::Box (p + db::Vector (-30, 20), p + db::Vector (w / 2, h / 2)));
+
+    }
+  }
+
+  db::Region r1mt (r1), r2mt (r2);
+  r1mt.set_threads (4);
+  r2mt.set_threads (4);
+
+  EXPECT_EQ (r1.width_check (60).size () > 0, true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.width_check (60)) == sorted_edge_pairs (r1.width_check (60)), true);
+  EXPECT_EQ (r1.space_check (80).size () > 0, true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.space_check (80)) == sorted_edge_pairs (r1.space_check (80)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.space_check (80, true)) == sorted_edge_pairs (r1.space_check (80, true)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.space_check (80, false, db::Projection)) == sorted_edge_pairs (r1.space_check (80, false, db::Projection)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.notch_check (80)) == sorted_edge_pairs (r1.notch_check (80)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.isolated_check (80)) == sorted_edge_pairs (r1.isolated_check (80)), true);
+  EXPECT_EQ (r1.separation_check (r2, 50).size () > 0, true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.separation_check (r2, 50)) == sorted_edge_pairs (r1.separation_check (r2, 50)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.enclosing_check (r2, 50)) == sorted_edge_pairs (r1.enclosing_check (r2, 50)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.overlap_check (r2, 50)) == sorted_edge_pairs (r1.overlap_check (r2, 50)), true);
+  EXPECT_EQ (sorted_edge_pairs (r1mt.inside_check (r2, 50)) == sorted_edge_pairs (r1.inside_check (r2, 50)), true);
+}
+
+TEST(32)
+{
+  //  the boolean operand cache does not change the results
+
+  db::Region r1, r2, r3;
+
+  unsigned int seed = 17;
+  for (int i = 0; i < 40; ++i) {
+    for (int j = 0; j < 40; ++j) {
+
+      seed = seed * 1103515245 + 12345;
+      db::Coord w = 50 + db::Coord ((seed >> 16) % 150);
+      seed = seed * 1103515245 + 12345;
+      db::Coord h = 50 + db::Coord ((seed >> 16) % 150);
+
+      db::Point p (i * 200, j * 200);
+      r1.insert (db::Box (p, p + db::Vector (w, h)));
+      r2.insert (db::Box (p + db::Vector (h / 2, w / 2), p + db::Vector (h + 100, w + 100)));
+      if ((i + j) % 3 == 0) {
+        r3.insert (db::Box (p + db::Vector (-20, 20), p + db::Vector (w, h / 3)));
+      }
+
+    }
+  }
+
+  db::Region r1c (r1);
+  EXPECT_EQ (r1c.boolean_operand_cache (), false);
+  r1c.set_boolean_operand_cache (true);
+  EXPECT_EQ (r1c.boolean_operand_cache (), true);
+
+  //  r1c as first and second operand and repeated use
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ ((r1c & r2).to_string (1000000) == (r1 & r2).to_string (1000000), true);
+    EXPECT_EQ ((r1c - r2).to_string (1000000) == (r1 - r2).to_string (1000000), true);
+    EXPECT_EQ ((r1c ^ r3).to_string (1000000) == (r1 ^ r3).to_string (1000000), true);
+    EXPECT_EQ ((r1c | r3).to_string (1000000) == (r1 | r3).to_string (1000000), true);
+    EXPECT_EQ ((r2 & r1c).to_string (1000000) == (r2 & r1).to_string (1000000), true);
+    EXPECT_EQ ((r2 - r1c).to_string (1000000) == (r2 - r1).to_string (1000000), true);
+    EXPECT_EQ ((r1c & r1c).to_string (1000000) == (r1 & r1).to_string (1000000), true);
+  }
+
+  //  both operands cached
+  db::Region r2c (r2);
+  r2c.set_boolean_operand_cache (true);
+  EXPECT_EQ ((r1c & r2c).to_string (1000000) == (r1 & r2).to_string (1000000), true);
+  EXPECT_EQ ((r2c - r1c).to_string (1000000) == (r2 - r1).to_string (1000000), true);
+
+  //  the cache is dropped when the region is modified
+  r1.insert (db::Box (0, 0, 10000, 100));
+  r1c.insert (db::Box (0, 0, 10000, 100));
+  EXPECT_EQ ((r1c & r2).to_string (1000000) == (r1 & r2).to_string (1000000), true);
+  EXPECT_EQ ((r2 - r1c).to_string (1000000) == (r2 - r1).to_string (1000000), true);
+
+  r1.transform (db::Trans (db::Vector (10, 20)));
+  r1c.transform (db::Trans (db::Vector (10, 20)));
+  EXPECT_EQ ((r1c & r2).to_string (1000000) == (r1 & r2).to_string (1000000), true);
+
+  r1 &= r3;
+  r1c &= r3;
+  EXPECT_EQ ((r1c ^ r2).to_string (1000000) == (r1 ^ r2).to_string (1000000), true);
+
+  r1.merge ();
+  r1c.merge ();
+  EXPECT_EQ ((r2 - r1c).to_string (1000000) == (r2 - r1).to_string (1000000), true);
+
+  //  in-place operators on a cached region, with and without a prepared operand present
+  db::Region r4 (r2), r4c (r2);
+  r4c.set_boolean_operand_cache (true);
+  r4 -= r1;
+  r4c -= r1c;
+  EXPECT_EQ (r4c.to_string (1000000) == r4.to_string (1000000), true);
+  r4 |= r3;
+  r4c |= r3;
+  EXPECT_EQ ((r4c ^ r1c).to_string (1000000) == (r4 ^ r1).to_string (1000000), true);
+  r4 ^= r1;
+  r4c ^= r1c;
+  EXPECT_EQ (r4c.to_string (1000000) == r4.to_string (1000000), true);
+}
@@ -32,6 +32,7 @@
 #include "dbEdge.h"
 #include "dbUserObject.h"
 #include "tlUnitTest.h"
+#include "tlThreadedWorkers.h"
 
 
 TEST(1) 
@@ -408,3 +409,118 @@ TEST(4)
 
 }
 
+
+namespace
+{
+
+class RepositoryInsertTask
+  : public tl::Task
+{
+public:
+  RepositoryInsertTask (size_t from, size_t to)
+    : m_from (from), m_to (to)
+  { }
+
+  size_t m_from, m_to;
+};
+
+class RepositoryInsertJob;
+
+class RepositoryInsertWorker
+  : public tl::Worker
+{
+public:
+  RepositoryInsertWorker (RepositoryInsertJob *job)
+    : tl::Worker (), mp_job (job)
+  { }
+
+protected:
+  void perform_task (tl::Task *task);
+
+private:
+  RepositoryInsertJob *mp_job;
+};
+
+class RepositoryInsertJob
+  : public tl::JobBase
+{
+public:
+  RepositoryInsertJob (int nworkers, db::GenericRepository &rep, const std::vector<db::SimplePolygon> &polygons)
+    : tl::JobBase (nworkers), mp_rep (&rep), mp_polygons (&polygons), m_results (polygons.size (), (const db::SimplePolygon *) 0)
+  { }
+
+  virtual tl::Worker *create_worker ()
+  {
+    return new RepositoryInsertWorker (this);
+  }
+
+  db::GenericRepository *mp_rep;
+  const std::vector<db::SimplePolygon> *mp_polygons;
+  std::vector<const db::SimplePolygon *> m_results;
+};
+
+void RepositoryInsertWorker::perform_task (tl::Task *task)
+{
+  RepositoryInsertTask *t = dynamic_cast<RepositoryInsertTask *> (task);
+  for (size_t i = t->m_from; i < t->m_to; ++i) {
+    mp_job->m_results [i] = mp_job->mp_rep->repository (db::SimplePolygon::tag ()).insert ((*mp_job->mp_polygons) [i]);
+  }
+}
+
+}
+
+//  concurrent insertion into the (sharded) repository
+TEST(5)
+{
+  std::vector<db::SimplePolygon> polygons;
+  for (int i = 0; i < 20000; ++i) {
+    //  every polygon is present several times
+    int n = (i * 7) % 1000;
+    db::Point pts[] = { db::Point (0, 0), db::Point (0, 10 + n), db::Point (10 + n % 17, 10 + n), db::Point (20 + n, 0) };
+    db::SimplePolygon p;
+    p.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+    polygons.push_back (p);
+  }
+
+  db::GenericRepository ref_rep;
+  std::vector<const db::SimplePolygon *> ref;
+  for (std::vector<db::SimplePolygon>::const_iterator p = polygons.begin (); p != polygons.end (); ++p) {
+    ref.push_back (ref_rep.repository (db::SimplePolygon::tag ()).insert (*p));
+  }
+  EXPECT_EQ (ref_rep.repository (db::SimplePolygon::tag ()).size (), size_t (1000));
+
+  //  the iterator delivers every shape once
+  size_t n = 0;
+  for (db::repository<db::SimplePolygon>::iterator i = ref_rep.repository (db::SimplePolygon::tag ()).begin (); i != ref_rep.repository (db::SimplePolygon::tag ()).end (); ++i) {
+    EXPECT_EQ (ref_rep.repository (db::SimplePolygon::tag ()).insert (*i) == &*i, true);
+    ++n;
+  }
+  EXPECT_EQ (n, size_t (1000));
+
+  db::GenericRepository rep;
+
+  RepositoryInsertJob job (4, rep, polygons);
+  for (size_t i = 0; i < polygons.size (); i += 100) {
+    job.schedule (new RepositoryInsertTask (i, std::min (polygons.size (), i + 100)));
+  }
+  job.start ();
+  job.wait ();
+
+  EXPECT_EQ (job.has_error (), false);
+  EXPECT_EQ (rep.repository (db::SimplePolygon::tag ()).size (), size_t (1000));
+
+  //  identical shapes must resolve to the same entry regardless of the thread inserting them
+  for (size_t i = 0; i < polygons.size (); ++i) {
+    EXPECT_EQ (*job.m_results [i] == polygons [i], true);
+    for (size_t j = 0; j < i && j < 1000; ++j) {
+      if (ref [i] == ref [j]) {
+        EXPECT_EQ (job.m_results [i] == job.m_results [j], true);
+      }
+    }
+  }
+
+  //  copies are independent
+  db::GenericRepository rep2 (rep);
+  EXPECT_EQ (rep2.repository (db::SimplePolygon::tag ()).size (), size_t (1000));
+  EXPECT_EQ (rep2.repository (db::SimplePolygon::tag ()).insert (polygons [0]) != job.m_results [0], true);
+}
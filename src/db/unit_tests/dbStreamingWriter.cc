@@ -0,0 +1,195 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "dbStreamingWriter.h"
+#include "dbReader.h"
+#include "dbWriter.h"
+#include "dbLayoutDiff.h"
+#include "dbMemStatistics.h"
+#include "tlUnitTest.h"
+
+static void read_layout (db::Layout &layout, const std::string &fn)
+{
+  tl::InputStream stream (fn);
+  db::Reader reader (stream);
+  reader.read (layout);
+}
+
+static void run_test (tl::TestBase *_this, const char *file, const std::string &format, size_t memory_budget)
+{
+  std::string fn (tl::testsrc ());
+  fn += "/testdata/gds/";
+  fn += file;
+
+  db::SaveLayoutOptions options;
+  options.set_format (format);
+
+  std::string ext = (format == "OASIS" ? ".oas" : ".gds");
+
+  //  reference: normal read and write
+  std::string tmp_file_ref = _this->tmp_file ("ref" + ext);
+  {
+    db::Layout layout_org;
+    read_layout (layout_org, fn);
+
+    tl::OutputStream stream (tmp_file_ref);
+    db::Writer writer (options);
+    writer.write (layout_org, stream);
+  }
+
+  //  streaming read and write
+  std::string tmp_file = _this->tmp_file ("tmp" + ext);
+  {
+    tl::OutputStream out_stream (tmp_file);
+    db::StreamingWriter sw (options, out_stream, memory_budget);
+
+    db::Layout layout;
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.set_cell_sink (&sw);
+    reader.read (layout);
+
+    //  the cells have been delivered by the GDS2 reader already
+    EXPECT_EQ (sw.cells_written () > 0, true);
+
+    sw.finish (layout);
+  }
+
+  db::Layout layout_ref, layout_read;
+  read_layout (layout_ref, tmp_file_ref);
+  read_layout (layout_read, tmp_file);
+
+  bool equal = db::compare_layouts (layout_read, layout_ref, db::layout_diff::f_verbose, 0);
+  if (! equal) {
+    _this->raise (tl::sprintf ("Compare failed - see %s vs %s\n", tmp_file, tmp_file_ref));
+  }
+}
+
+TEST(1)
+{
+  run_test (_this, "t10.gds", "GDS2", 0);
+}
+
+TEST(2)
+{
+  run_test (_this, "t10.gds", "GDS2", 100000);
+}
+
+TEST(3)
+{
+  run_test (_this, "t10.gds", "OASIS", 0);
+}
+
+TEST(4)
+{
+  run_test (_this, "t10.gds", "OASIS", 100000);
+}
+
+TEST(5)
+{
+  run_test (_this, "arefs.gds", "GDS2", 0);
+}
+
+TEST(6)
+{
+  run_test (_this, "arefs.gds", "OASIS", 0);
+}
+
+//  formats without cell-wise writing are rejected
+TEST(10)
+{
+  db::SaveLayoutOptions options;
+  options.set_format ("CIF");
+  EXPECT_EQ (db::StreamingWriter::supports (options), false);
+
+  options.set_format ("GDS2");
+  EXPECT_EQ (db::StreamingWriter::supports (options), true);
+
+  options.set_format ("OASIS");
+  EXPECT_EQ (db::StreamingWriter::supports (options), true);
+}
+
+static size_t layout_memory (const db::Layout &layout)
+{
+  db::MemStatistics ms;
+  layout.collect_mem_stat (ms);
+  return ms.used ();
+}
+
+//  the memory of the cells written is released
+TEST(11)
+{
+  //  many cells with many distinct polygons
+  db::Layout layout_org;
+  unsigned int l1 = layout_org.insert_layer (db::LayerProperties (1, 0));
+  db::cell_index_type top = layout_org.add_cell ("TOP");
+  for (int c = 0; c < 100; ++c) {
+    db::cell_index_type ci = layout_org.add_cell (("C" + tl::to_string (c)).c_str ());
+    for (int i = 0; i < 500; ++i) {
+      db::Point pts [] = { db::Point (0, 0), db::Point (0, 100 + i), db::Point (100 + c, 200 + i), db::Point (100 + c, 0) };
+      db::SimplePolygon poly;
+      poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts [0]));
+      layout_org.cell (ci).shapes (l1).insert (poly.moved (db::Vector (i * 1000, 0)));
+    }
+    layout_org.cell (top).insert (db::CellInstArray (db::CellInst (ci), db::Trans (db::Vector (0, c * 1000))));
+  }
+
+  std::string fn = _this->tmp_file ("in.gds");
+  {
+    tl::OutputStream stream (fn);
+    db::SaveLayoutOptions options;
+    options.set_format ("GDS2");
+    db::Writer writer (options);
+    writer.write (layout_org, stream);
+  }
+
+  db::Layout layout_ref;
+  read_layout (layout_ref, fn);
+  size_t mem_ref = layout_memory (layout_ref);
+
+  db::SaveLayoutOptions options;
+  options.set_format ("GDS2");
+
+  std::string tmp_file = _this->tmp_file ("tmp.gds");
+  {
+    tl::OutputStream out_stream (tmp_file);
+    db::StreamingWriter sw (options, out_stream, 0);
+
+    db::Layout layout;
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.set_cell_sink (&sw);
+    reader.read (layout);
+
+    //  after reading, the cells have been written and released: neither the shapes 
+    //  nor the shape repository hold the polygons
+    size_t mem = layout_memory (layout);
+    EXPECT_EQ (mem < mem_ref / 10, true);
+
+    sw.finish (layout);
+  }
+
+  db::Layout layout_read;
+  read_layout (layout_read, tmp_file);
+  EXPECT_EQ (db::compare_layouts (layout_read, layout_ref, db::layout_diff::f_verbose, 0), true);
+}
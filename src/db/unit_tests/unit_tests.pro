@@ -17,6 +17,7 @@ SOURCES = \
   dbCellMapping.cc \
   dbCIFReader.cc \
   dbClip.cc \
+  dbDeepRegion.cc \
   dbDXFReader.cc \
   dbExpression.cc \
   dbEdge.cc \
@@ -53,6 +54,7 @@ SOURCES = \
   dbShapeRepository.cc \
   dbShapes.cc \
   dbStreamLayers.cc \
+  dbStreamingWriter.cc \
   dbText.cc \
   dbTilingProcessor.cc \
   dbTrans.cc \
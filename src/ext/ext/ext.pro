@@ -16,6 +16,8 @@ HEADERS += \
   extLEFDEFImportDialogs.h \
   extLEFDEFImporter.h \
   extLEFImporter.h \
+  extNetClusters.h \
+  extNetExtractor.h \
   extNetTracer.h \
   extNetTracerConfig.h \
   extNetTracerDialog.h \
@@ -57,6 +59,8 @@ SOURCES += \
   extLEFDEFImportDialogs.cc \
   extLEFDEFImporter.cc \
   extLEFImporter.cc \
+  extNetClusters.cc \
+  extNetExtractor.cc \
   extNetTracer.cc \
   extNetTracerConfig.cc \
   extNetTracerDialog.cc \
@@ -147,6 +147,301 @@ struct Group
   std::vector<tl::GlobPattern> comp_match;
 };
 
+// -----------------------------------------------------------------------------------
+//  Compact routing support
+
+/**
+ *  @brief Describes a regular pattern of displacements: d + i * a + j * b (i < na, j < nb)
+ */
+struct RegularPattern
+{
+  RegularPattern (const db::Vector &_d, const db::Vector &_a, unsigned long _na, const db::Vector &_b, unsigned long _nb)
+    : d (_d), a (_a), b (_b), na (_na), nb (_nb)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::Vector d, a, b;
+  unsigned long na, nb;
+};
+
+/**
+ *  @brief Decomposes a set of displacements into regular patterns
+ *
+ *  Displacements with the same y coordinate form rows with a constant pitch. Rows
+ *  with the same start, pitch and length are stacked to two-dimensional patterns if
+ *  they are equally spaced. Single displacements are one-element rows, so equally 
+ *  spaced displacements with the same x coordinate become columns.
+ */
+static void
+make_regular_patterns (std::vector<db::Vector> &disp, std::vector<RegularPattern> &patterns)
+{
+  //  sorts by y, then x
+  std::sort (disp.begin (), disp.end ());
+
+  //  (x, pitch, n) -> y values of the rows
+  typedef std::map<std::pair<std::pair<db::Coord, db::Coord>, unsigned long>, std::vector<db::Coord> > row_map;
+  row_map rows;
+
+  for (size_t i = 0; i < disp.size (); ) {
+
+    size_t j = i + 1;
+    db::Coord pitch = 0;
+
+    if (j < disp.size () && disp [j].y () == disp [i].y () && disp [j].x () > disp [i].x ()) {
+      pitch = disp [j].x () - disp [i].x ();
+      while (j + 1 < disp.size () && disp [j + 1].y () == disp [i].y () && disp [j + 1].x () - disp [j].x () == pitch) {
+        ++j;
+      }
+      ++j;
+    }
+
+    rows [std::make_pair (std::make_pair (disp [i].x (), pitch), (unsigned long) (j - i))].push_back (disp [i].y ());
+    i = j;
+
+  }
+
+  for (row_map::const_iterator r = rows.begin (); r != rows.end (); ++r) {
+
+    db::Vector a (r->first.first.second, 0);
+    unsigned long na = r->first.second;
+    const std::vector<db::Coord> &y = r->second;
+
+    for (size_t i = 0; i < y.size (); ) {
+
+      size_t j = i + 1;
+      db::Coord pitch = 0;
+
+      if (j < y.size () && y [j] > y [i]) {
+        pitch = y [j] - y [i];
+        while (j + 1 < y.size () && y [j + 1] - y [j] == pitch) {
+          ++j;
+        }
+        ++j;
+      }
+
+      patterns.push_back (RegularPattern (db::Vector (r->first.first.first, y [i]), a, na, db::Vector (0, pitch), (unsigned long) (j - i)));
+      i = j;
+
+    }
+
+  }
+}
+
+template <class Sh> struct shape_ref_types;
+
+template <> 
+struct shape_ref_types<db::Path>
+{
+  typedef db::PathRef ref_type;
+  typedef db::PathPtr ptr_type;
+};
+
+template <> 
+struct shape_ref_types<db::Polygon>
+{
+  typedef db::PolygonRef ref_type;
+  typedef db::PolygonPtr ptr_type;
+};
+
+/**
+ *  @brief Inserts a shape from the layout's shape repository at the given displacements
+ *
+ *  Regular patterns are inserted as shape arrays (in non-editable mode), single 
+ *  shapes as shape references.
+ */
+template <class Sh>
+static void
+insert_shape_patterns (db::Layout &layout, db::Shapes &shapes, const Sh *sh, std::vector<db::Vector> &disp, db::properties_id_type prop_id)
+{
+  typedef typename shape_ref_types<Sh>::ref_type ref_type;
+  typedef typename shape_ref_types<Sh>::ptr_type ptr_type;
+
+  std::vector<RegularPattern> patterns;
+  make_regular_patterns (disp, patterns);
+
+  for (std::vector<RegularPattern>::const_iterator p = patterns.begin (); p != patterns.end (); ++p) {
+
+    if (p->na * p->nb > 1 && ! layout.is_editable ()) {
+
+      db::array<ptr_type, db::Disp> array (ptr_type (sh, db::UnitTrans ()), db::Disp (p->d), layout.array_repository (), p->a, p->b, p->na, p->nb);
+      if (prop_id != 0) {
+        shapes.insert (db::object_with_properties<db::array<ptr_type, db::Disp> > (array, prop_id));
+      } else {
+        shapes.insert (array);
+      }
+
+    } else {
+
+      for (unsigned long i = 0; i < p->na; ++i) {
+        for (unsigned long j = 0; j < p->nb; ++j) {
+          ref_type r (sh, db::Disp (p->d + p->a * long (i) + p->b * long (j)));
+          if (prop_id != 0) {
+            shapes.insert (db::object_with_properties<ref_type> (r, prop_id));
+          } else {
+            shapes.insert (r);
+          }
+        }
+      }
+
+    }
+
+  }
+}
+
+/**
+ *  @brief Receives the wires and vias of the NETS and SPECIALNETS sections
+ *
+ *  In normal mode, shapes and vias are inserted into the cell immediately. In compact mode,
+ *  the collector enters the shapes (normalized to the origin) into the layout's shape 
+ *  repository and groups the displacements by layer, net and shape - i.e. wires of the same 
+ *  width and track shape end up in one group. The groups are emitted on "flush": 
+ *  identical shapes become shared shape references and regular patterns become arrays. 
+ *  As the net identity is kept as properties, only shapes of the same net are combined.
+ *  To limit the memory footprint, the collector flushes itself after a certain number 
+ *  of shapes.
+ */
+class RoutingCollector
+{
+public:
+  //  the number of shapes and vias after which the collector flushes itself
+  static const size_t max_pending = 100000;
+
+  RoutingCollector (db::Layout &layout, db::Cell &cell, bool compact)
+    : mp_layout (&layout), mp_cell (&cell), m_compact (compact), m_pending (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  void insert (unsigned int layer, const db::Path &path, db::properties_id_type prop_id)
+  {
+    if (! m_compact || path.begin () == path.end ()) {
+      if (prop_id != 0) {
+        mp_cell->shapes (layer).insert (db::object_with_properties<db::Path> (path, prop_id));
+      } else {
+        mp_cell->shapes (layer).insert (path);
+      }
+    } else {
+      db::PathRef ref (path, mp_layout->shape_repository ());
+      m_paths.add (std::make_pair (layer, prop_id), ref.ptr (), ref.trans ().disp ());
+      count_pending ();
+    }
+  }
+
+  void insert (unsigned int layer, const db::Polygon &poly, db::properties_id_type prop_id)
+  {
+    if (! m_compact) {
+      if (prop_id != 0) {
+        mp_cell->shapes (layer).insert (db::object_with_properties<db::Polygon> (poly, prop_id));
+      } else {
+        mp_cell->shapes (layer).insert (poly);
+      }
+    } else {
+      db::PolygonRef ref (poly, mp_layout->shape_repository ());
+      m_polygons.add (std::make_pair (layer, prop_id), ref.ptr (), ref.trans ().disp ());
+      count_pending ();
+    }
+  }
+
+  void insert_via (db::cell_index_type ci, const db::Trans &trans)
+  {
+    if (! m_compact) {
+      mp_cell->insert (db::CellInstArray (db::CellInst (ci), trans));
+    } else {
+      m_vias [std::make_pair (ci, trans.rot ())].push_back (trans.disp ());
+      count_pending ();
+    }
+  }
+
+  void flush ()
+  {
+    for (ShapeGroups<db::Path>::iterator g = m_paths.begin (); g != m_paths.end (); ++g) {
+      insert_shape_patterns (*mp_layout, mp_cell->shapes (g->first.first.first), g->first.second, g->second, g->first.first.second);
+    }
+    m_paths.clear ();
+
+    for (ShapeGroups<db::Polygon>::iterator g = m_polygons.begin (); g != m_polygons.end (); ++g) {
+      insert_shape_patterns (*mp_layout, mp_cell->shapes (g->first.first.first), g->first.second, g->second, g->first.first.second);
+    }
+    m_polygons.clear ();
+
+    for (via_map::iterator v = m_vias.begin (); v != m_vias.end (); ++v) {
+      std::vector<RegularPattern> patterns;
+      make_regular_patterns (v->second, patterns);
+      for (std::vector<RegularPattern>::const_iterator p = patterns.begin (); p != patterns.end (); ++p) {
+        db::Trans t (int (v->first.second), p->d);
+        if (p->na * p->nb > 1) {
+          mp_cell->insert (db::CellInstArray (db::CellInst (v->first.first), t, p->a, p->b, p->na, p->nb));
+        } else {
+          mp_cell->insert (db::CellInstArray (db::CellInst (v->first.first), t));
+        }
+      }
+    }
+    m_vias.clear ();
+
+    m_pending = 0;
+  }
+
+private:
+  typedef std::pair<unsigned int, db::properties_id_type> layer_key;
+  typedef std::map<std::pair<db::cell_index_type, unsigned int>, std::vector<db::Vector> > via_map;
+
+  /**
+   *  @brief The displacements per layer, net and shape
+   *
+   *  The shapes are given by their pointers into the shape repository. The groups
+   *  are kept in the order of their creation, so the output does not depend on 
+   *  the memory layout.
+   */
+  template <class Sh>
+  class ShapeGroups
+  {
+  public:
+    typedef std::pair<layer_key, const Sh *> key_type;
+    typedef std::vector<std::pair<key_type, std::vector<db::Vector> > > group_list;
+    typedef typename group_list::iterator iterator;
+
+    void add (const layer_key &lk, const Sh *sh, const db::Vector &d)
+    {
+      key_type key (lk, sh);
+      typename std::map<key_type, size_t>::const_iterator i = m_index.find (key);
+      if (i == m_index.end ()) {
+        i = m_index.insert (std::make_pair (key, m_groups.size ())).first;
+        m_groups.push_back (std::make_pair (key, std::vector<db::Vector> ()));
+      }
+      m_groups [i->second].second.push_back (d);
+    }
+
+    iterator begin () { return m_groups.begin (); }
+    iterator end () { return m_groups.end (); }
+
+    void clear ()
+    {
+      m_index.clear ();
+      m_groups.clear ();
+    }
+
+  private:
+    std::map<key_type, size_t> m_index;
+    group_list m_groups;
+  };
+
+  db::Layout *mp_layout;
+  db::Cell *mp_cell;
+  bool m_compact;
+  size_t m_pending;
+  ShapeGroups<db::Path> m_paths;
+  ShapeGroups<db::Polygon> m_polygons;
+  via_map m_vias;
+
+  void count_pending ()
+  {
+    if (++m_pending >= max_pending) {
+      flush ();
+    }
+  }
+};
+
 void 
 DEFImporter::do_read (db::Layout &layout)
 {
@@ -437,6 +732,8 @@ DEFImporter::do_read (db::Layout &layout)
       get_long ();
       expect (";");
 
+      RoutingCollector routing (layout, design, compact_routing ());
+
       while (test ("-")) {
 
         std::string net = get ();
@@ -667,11 +964,7 @@ DEFImporter::do_read (db::Layout &layout)
                           if (pt - pt0 > 1) {
 
                             db::Path p (pt0, pt, w, pt0 == pts.begin () ? e : 0, pt == pts.end () ? e : 0, false);
-                            if (prop_id != 0) {
-                              design.shapes (dl.second).insert (db::object_with_properties<db::Path> (p, prop_id));
-                            } else {
-                              design.shapes (dl.second).insert (p);
-                            }
+                            routing.insert (dl.second, p, prop_id);
 
                             if (pt == pts.end ()) {
                               break;
@@ -699,11 +992,7 @@ DEFImporter::do_read (db::Layout &layout)
                             k.assign_hull (octagon, octagon + sizeof (octagon) / sizeof (octagon[0]));
 
                             db::Polygon p = db::minkowsky_sum (k, db::Edge (*pt0, *pt));
-                            if (prop_id != 0) {
-                              design.shapes (dl.second).insert (db::object_with_properties<db::Polygon> (p, prop_id));
-                            } else {
-                              design.shapes (dl.second).insert (p);
-                            }
+                            routing.insert (dl.second, p, prop_id);
 
                           }
 
@@ -713,11 +1002,7 @@ DEFImporter::do_read (db::Layout &layout)
 
                         for (size_t i = 0; i < pts.size () - 1; ++i) {
                           db::Polygon p = db::minkowsky_sum (*style, db::Edge (pts [i], pts [i + 1]));
-                          if (prop_id != 0) {
-                            design.shapes (dl.second).insert (db::object_with_properties<db::Polygon> (p, prop_id));
-                          } else {
-                            design.shapes (dl.second).insert (p);
-                          }
+                          routing.insert (dl.second, p, prop_id);
                         }
 
                       }
@@ -734,7 +1019,7 @@ DEFImporter::do_read (db::Layout &layout)
 
                   std::map<std::string, ViaDesc>::const_iterator vd = via_desc.find (vn);
                   if (vd != via_desc.end () && ! pts.empty ()) {
-                    design.insert (db::CellInstArray (db::CellInst (vd->second.cell->cell_index ()), db::Trans (ft.rot (), db::Vector (pts.back ()))));
+                    routing.insert_via (vd->second.cell->cell_index (), db::Trans (ft.rot (), db::Vector (pts.back ())));
                     if (ln == vd->second.m1) {
                       ln = vd->second.m2;
                     } else if (ln == vd->second.m2) {
@@ -772,11 +1057,7 @@ DEFImporter::do_read (db::Layout &layout)
 
             std::pair <bool, unsigned int> dl = open_layer (layout, ln, Routing);
             if (dl.first) {
-              if (prop_id != 0) {
-                design.shapes (dl.second).insert (db::object_with_properties<db::Polygon> (p, prop_id));
-              } else {
-                design.shapes (dl.second).insert (p);
-              }
+              routing.insert (dl.second, p, prop_id);
             }
 
           } else if (test ("RECT")) {
@@ -788,11 +1069,7 @@ DEFImporter::do_read (db::Layout &layout)
 
             std::pair <bool, unsigned int> dl = open_layer (layout, ln, Routing);
             if (dl.first) {
-              if (prop_id != 0) {
-                design.shapes (dl.second).insert (db::object_with_properties<db::Polygon> (p, prop_id));
-              } else {
-                design.shapes (dl.second).insert (p);
-              }
+              routing.insert (dl.second, p, prop_id);
             }
 
           } else {
@@ -805,8 +1082,15 @@ DEFImporter::do_read (db::Layout &layout)
 
         expect (";");
 
+        //  with net properties, shapes of different nets are not combined anyway
+        if (prop_id != 0) {
+          routing.flush ();
+        }
+
       }
 
+      routing.flush ();
+
       test ("END");
       if (specialnets) {
         test ("SPECIALNETS");
@@ -28,6 +28,7 @@
 #include "tlProgress.h"
 
 #include <cctype>
+#include <cmath>
 
 #include <QFileInfo>
 
@@ -67,7 +68,8 @@ LEFDEFReaderOptions::LEFDEFReaderOptions ()
     m_labels_datatype (1),
     m_produce_routing (true),
     m_routing_suffix (""),
-    m_routing_datatype (0)
+    m_routing_datatype (0),
+    m_compact_routing (false)
 {
   //  .. nothing yet ..
 }
@@ -104,6 +106,7 @@ LEFDEFReaderOptions::LEFDEFReaderOptions (const LEFDEFReaderOptions &d)
     m_produce_routing (d.m_produce_routing),
     m_routing_suffix (d.m_routing_suffix),
     m_routing_datatype (d.m_routing_datatype),
+    m_compact_routing (d.m_compact_routing),
     m_lef_files (d.m_lef_files)
 {
   //  .. nothing yet ..
@@ -358,9 +361,11 @@ LEFDEFLayerDelegate::finish (db::Layout &layout)
 //  LEFDEFImporter implementation
 
 LEFDEFImporter::LEFDEFImporter ()
-  : mp_progress (0), mp_stream (0), mp_layer_delegate (0),
+  : mp_progress (0), mp_stream (0), mp_bptr (0), mp_bend (0), m_line (1), m_next_line (1),
+    mp_layer_delegate (0),
     m_produce_net_props (false), m_net_prop_name_id (0),
-    m_produce_inst_props (false), m_inst_prop_name_id (0)
+    m_produce_inst_props (false), m_inst_prop_name_id (0),
+    m_compact_routing (false)
 {
   //  .. nothing yet ..
 }
@@ -396,20 +401,25 @@ LEFDEFImporter::read (tl::InputStream &stream, db::Layout &layout, LEFDEFLayerDe
     m_inst_prop_name_id = layout.properties_repository ().prop_name_id (ld.tech_comp ()->inst_property_name ());
   }
 
+  m_compact_routing = (ld.tech_comp () && ld.tech_comp ()->compact_routing ());
+
+  m_last_token.clear ();
+  m_buffer.clear ();
+  mp_bptr = mp_bend = 0;
+  m_line = m_next_line = 1;
+
   try {
 
     mp_progress = &progress;
     mp_layer_delegate = &ld;
-    mp_stream = new tl::TextInputStream (stream);
+    mp_stream = &stream;
 
     do_read (layout); 
 
-    delete mp_stream;
     mp_stream = 0;
     mp_progress = 0;
 
   } catch (...) {
-    delete mp_stream;
     mp_stream = 0;
     mp_progress = 0;
     throw;
@@ -419,14 +429,14 @@ LEFDEFImporter::read (tl::InputStream &stream, db::Layout &layout, LEFDEFLayerDe
 void 
 LEFDEFImporter::error (const std::string &msg)
 {
-  throw LEFDEFReaderException (msg, mp_stream->line_number (), m_cellname, m_fn);
+  throw LEFDEFReaderException (msg, int (m_line), m_cellname, m_fn);
 }
 
 void 
 LEFDEFImporter::warn (const std::string &msg)
 {
   tl::warn << msg 
-           << tl::to_string (QObject::tr (" (line=")) << mp_stream->line_number ()
+           << tl::to_string (QObject::tr (" (line=")) << m_line
            << tl::to_string (QObject::tr (", cell=")) << m_cellname
            << tl::to_string (QObject::tr (", file=")) << m_fn
            << ")";
@@ -443,8 +453,14 @@ LEFDEFImporter::at_end ()
   return false;
 }
 
+static inline char
+upcase (char c)
+{
+  return (c >= 'a' && c <= 'z') ? char (c - 'a' + 'A') : c;
+}
+
 bool  
-LEFDEFImporter::peek (const std::string &token)
+LEFDEFImporter::peek (const char *token)
 {
   if (m_last_token.empty ()) {
     if (next ().empty ()) {
@@ -452,10 +468,11 @@ LEFDEFImporter::peek (const std::string &token)
     }
   }
 
+  //  NOTE: keywords are ASCII, so a simple case folding is sufficient
   const char *a = m_last_token.c_str ();
-  const char *b = token.c_str ();
+  const char *b = token;
   while (*a && *b) {
-    if (std::toupper (*a) != std::toupper (*b)) {
+    if (*a != *b && upcase (*a) != upcase (*b)) {
       return false;
     }
     ++a, ++b;
@@ -464,7 +481,7 @@ LEFDEFImporter::peek (const std::string &token)
 }
 
 bool  
-LEFDEFImporter::test (const std::string &token)
+LEFDEFImporter::test (const char *token)
 {
   if (peek (token)) {
     //  consume when successful
@@ -476,11 +493,114 @@ LEFDEFImporter::test (const std::string &token)
 }
 
 void  
-LEFDEFImporter::expect (const std::string &token)
+LEFDEFImporter::expect (const char *token)
 {
   if (! test (token)) {
-    error ("Expected token: " + token);
+    error (std::string ("Expected token: ") + token);
+  }
+}
+
+namespace
+{
+
+/**
+ *  @brief A table of negative powers of 10 as computed by pow (10.0, -n)
+ */
+struct NegativePowersOf10
+{
+  enum { size = 32 };
+
+  NegativePowersOf10 ()
+  {
+    for (int i = 0; i < int (size); ++i) {
+      v [i] = pow (10.0, -i);
+    }
+  }
+
+  double v [size];
+};
+
+static NegativePowersOf10 s_neg_pow10;
+
+}
+
+/**
+ *  @brief Converts plain decimal numbers such as "-12" or "0.25" without tl::from_string
+ *
+ *  This function delivers exactly the same values than tl::from_string. It returns false
+ *  for all strings requiring the general conversion (exponents, expressions etc.).
+ */
+static bool 
+fast_string_to_double (const std::string &s, double &v)
+{
+  const char *cp = s.c_str ();
+
+  double sign = 1.0;
+  if (*cp == '-') {
+    sign = -1.0;
+    ++cp;
+  }
+
+  if (*cp < '0' || *cp > '9') {
+    return false;
+  }
+
+  int exponent = 0;
+  double mant = 0.0;
+  while (*cp >= '0' && *cp <= '9') {
+    mant = mant * 10.0 + double (*cp - '0');
+    ++cp;
   }
+
+  if (*cp == '.') {
+    ++cp;
+    while (*cp >= '0' && *cp <= '9') {
+      mant = mant * 10.0 + double (*cp - '0');
+      ++cp;
+      --exponent;
+    }
+  }
+
+  if (*cp || -exponent >= int (NegativePowersOf10::size)) {
+    return false;
+  }
+
+  v = sign * mant * s_neg_pow10.v [-exponent];
+  return true;
+}
+
+/**
+ *  @brief Converts plain decimal integers such as "-12" without tl::from_string
+ *
+ *  Like fast_string_to_double, this function returns false for all strings requiring
+ *  the general conversion.
+ */
+static bool 
+fast_string_to_long (const std::string &s, long &v)
+{
+  const char *cp = s.c_str ();
+
+  bool neg = false;
+  if (*cp == '-') {
+    neg = true;
+    ++cp;
+  }
+
+  //  up to 15 digits fit safely into the mantissa of a double, hence tl::from_string would
+  //  deliver the exact value as well
+  const char *cp0 = cp;
+  long l = 0;
+  while (*cp >= '0' && *cp <= '9' && cp - cp0 < 15) {
+    l = l * 10 + long (*cp - '0');
+    ++cp;
+  }
+
+  if (*cp || cp == cp0) {
+    return false;
+  }
+
+  v = neg ? -l : l;
+  return true;
 }
 
 double  
@@ -493,10 +613,12 @@ LEFDEFImporter::get_double ()
   }
 
   double d = 0;
-  try {
-    tl::from_string (m_last_token, d);
-  } catch (...) {
-    error ("Not a floating-point value: " + m_last_token);
+  if (! fast_string_to_double (m_last_token, d)) {
+    try {
+      tl::from_string (m_last_token, d);
+    } catch (...) {
+      error ("Not a floating-point value: " + m_last_token);
+    }
   }
 
   m_last_token.clear ();
@@ -514,10 +636,12 @@ LEFDEFImporter::get_long ()
   }
 
   long l = 0;
-  try {
-    tl::from_string (m_last_token, l);
-  } catch (...) {
-    error ("Not an integer value: " + m_last_token);
+  if (! fast_string_to_long (m_last_token, l)) {
+    try {
+      tl::from_string (m_last_token, l);
+    } catch (...) {
+      error ("Not an integer value: " + m_last_token);
+    }
   }
 
   m_last_token.clear ();
@@ -544,15 +668,38 @@ LEFDEFImporter::get ()
       error ("Unexpected end of file");
     }
   }
-  std::string r;
-  r.swap (m_last_token);
+  //  NOTE: we don't swap the token out, so m_last_token keeps its capacity
+  std::string r (m_last_token);
+  m_last_token.clear ();
   return r;
 }
 
+bool
+LEFDEFImporter::fill_buffer ()
+{
+  const size_t chunk = 65536;
+
+  if (! mp_stream) {
+    return false;
+  }
+
+  m_buffer = mp_stream->read_all (chunk);
+  mp_bptr = m_buffer.c_str ();
+  mp_bend = mp_bptr + m_buffer.size ();
+  return mp_bptr != mp_bend;
+}
+
+static inline bool
+is_space (char c)
+{
+  //  same as isspace in the C locale
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
 const std::string &
 LEFDEFImporter::next ()
 {
-  unsigned int last_line = mp_stream->line_number ();
+  size_t last_line = m_line;
 
   m_last_token.clear ();
 
@@ -560,21 +707,21 @@ LEFDEFImporter::next ()
 
   do {
 
-    while ((c = mp_stream->get_char ()) != 0 && isspace (c)) 
+    while ((c = get_char ()) != 0 && is_space (c)) 
       ;
 
     if (c == '#') {
 
-      while ((c = mp_stream->get_char ()) != 0 && (c != '\015' && c != '\012')) 
+      while ((c = get_char ()) != 0 && (c != '\015' && c != '\012')) 
         ;
 
     } else if (c == '\'' || c == '"') {
 
       char quot = c;
 
-      while ((c = mp_stream->get_char ()) != 0 && c != quot) {
+      while ((c = get_char ()) != 0 && c != quot) {
         if (c == '\\') {
-          c = mp_stream->get_char ();
+          c = get_char ();
         }
         if (c) {
           m_last_token += c;
@@ -587,13 +734,30 @@ LEFDEFImporter::next ()
 
       m_last_token += c; 
 
-      while ((c = mp_stream->get_char ()) != 0 && ! isspace (c)) {
+      while (true) {
+
+        //  bulk copy of the plain characters available in the buffer
+        const char *cp = mp_bptr;
+        while (cp != mp_bend && *cp && *cp != '\\' && ! is_space (*cp)) {
+          ++cp;
+        }
+        if (cp != mp_bptr) {
+          m_last_token.append (mp_bptr, cp - mp_bptr);
+          mp_bptr = cp;
+        }
+
+        if ((c = get_char ()) == 0 || is_space (c)) {
+          break;
+        }
+
+        //  not a plain character: must be a backslash
         if (c == '\\') {
-          c = mp_stream->get_char ();
+          c = get_char ();
         }
         if (c) {
           m_last_token += c;
         }
+
       }
 
       break;
@@ -602,7 +766,7 @@ LEFDEFImporter::next ()
 
   } while (c);
 
-  if (mp_stream->line_number () != last_line) {
+  if (m_line != last_line) {
     ++*mp_progress;
   }
 
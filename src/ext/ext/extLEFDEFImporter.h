@@ -386,6 +386,22 @@ public:
     m_routing_datatype = s;
   }
 
+  /**
+   *  @brief Gets a flag indicating whether the routing is stored in compact form
+   *
+   *  In compact mode, the DEF reader emits identical wire shapes as shared shape
+   *  references and regular patterns of wire segments and vias as arrays.
+   */
+  bool compact_routing () const
+  {
+    return m_compact_routing;
+  }
+
+  void set_compact_routing (bool f) 
+  {
+    m_compact_routing = f;
+  }
+
   void clear_lef_files ()
   {
     m_lef_files.clear ();
@@ -448,6 +464,7 @@ private:
   bool m_produce_routing;
   std::string m_routing_suffix;
   int m_routing_datatype;
+  bool m_compact_routing;
   std::vector<std::string> m_lef_files;
 };
 
@@ -582,18 +599,44 @@ protected:
 
   /**
    *  @brief Test whether the next token matches the given one and consume it in that case
+   *
+   *  The comparison is case insensitive.
+   */
+  bool test (const char *token);
+
+  /**
+   *  @brief Test whether the next token matches the given one and consume it in that case (std::string version)
    */
-  bool test (const std::string &token);
+  bool test (const std::string &token)
+  {
+    return test (token.c_str ());
+  }
 
   /**
    *  @brief Test whether the next token matches the given one, but don't consume it
    */
-  bool peek (const std::string &token);
+  bool peek (const char *token);
+
+  /**
+   *  @brief Test whether the next token matches the given one, but don't consume it (std::string version)
+   */
+  bool peek (const std::string &token)
+  {
+    return peek (token.c_str ());
+  }
 
   /**
    *  @brief Test whether the next token matches the given one and raise an error if it does not
    */
-  void expect (const std::string &token);
+  void expect (const char *token);
+
+  /**
+   *  @brief Test whether the next token matches the given one and raise an error if it does not (std::string version)
+   */
+  void expect (const std::string &token)
+  {
+    expect (token.c_str ());
+  }
 
   /**
    *  @brief Gets the next token
@@ -679,6 +722,14 @@ protected:
     return m_inst_prop_name_id;
   }
 
+  /**
+   *  @brief Gets a flag indicating whether the routing shall be stored in compact form
+   */
+  bool compact_routing () const
+  {
+    return m_compact_routing;
+  }
+
 protected:
   void create_generated_via (std::vector<db::Polygon> &bottom,
                              std::vector<db::Polygon> &cut,
@@ -693,7 +744,10 @@ protected:
 
 private:
   tl::AbsoluteProgress *mp_progress;
-  tl::TextInputStream *mp_stream;
+  tl::InputStream *mp_stream;
+  std::string m_buffer;
+  const char *mp_bptr, *mp_bend;
+  size_t m_line, m_next_line;
   LEFDEFLayerDelegate *mp_layer_delegate;
   std::string m_cellname;
   std::string m_fn;
@@ -702,8 +756,23 @@ private:
   db::property_names_id_type m_net_prop_name_id;
   bool m_produce_inst_props;
   db::property_names_id_type m_inst_prop_name_id;
+  bool m_compact_routing;
 
   const std::string &next ();
+  bool fill_buffer ();
+
+  char get_char ()
+  {
+    m_line = m_next_line;
+    if (mp_bptr == mp_bend && ! fill_buffer ()) {
+      return 0;
+    }
+    char c = *mp_bptr++;
+    if (c == '\n') {
+      ++m_next_line;
+    }
+    return c;
+  }
 };
 
 }
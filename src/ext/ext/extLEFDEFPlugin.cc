@@ -297,6 +297,7 @@ public:
       tl::make_member (&LEFDEFReaderOptions::produce_routing, &LEFDEFReaderOptions::set_produce_routing, "produce-routing") +
       tl::make_member (&LEFDEFReaderOptions::routing_suffix, &LEFDEFReaderOptions::set_routing_suffix, "routing-suffix") +
       tl::make_member (&LEFDEFReaderOptions::routing_datatype, &LEFDEFReaderOptions::set_routing_datatype, "routing-datatype") +
+      tl::make_member (&LEFDEFReaderOptions::compact_routing, &LEFDEFReaderOptions::set_compact_routing, "compact-routing") +
       tl::make_member (&LEFDEFReaderOptions::begin_lef_files, &LEFDEFReaderOptions::end_lef_files, &LEFDEFReaderOptions::push_lef_file, "lef-files")
     );
   }
@@ -592,6 +593,19 @@ gsi::Class<LEFDEFReaderOptions> decl_lefdef_config ("LEFDEFReaderConfiguration",
     "@brief Sets the routing layer datatype value.\n"
     "See \\produce_via_geometry for details about the layer production rules."
   ) +
+  gsi::method ("compact_routing?", &LEFDEFReaderOptions::compact_routing,
+    "@brief Gets a value indicating whether the routing is stored in compact form.\n"
+    "See \\compact_routing= for details."
+  ) +
+  gsi::method ("compact_routing=", &LEFDEFReaderOptions::set_compact_routing, gsi::arg ("flag"),
+    "@brief Sets a value indicating whether the routing is stored in compact form.\n"
+    "In compact mode, the DEF reader stores identical wire shapes as shared shape references and "
+    "regular patterns of wires and vias as shape or instance arrays. The geometry is the same, but the "
+    "memory footprint of large designs is reduced. Shapes of different nets are not combined if net names "
+    "are produced as properties.\n"
+    "\n"
+    "This attribute has been added in version 0.25."
+  ) +
   gsi::method ("lef_files", &LEFDEFReaderOptions::lef_files,
     "@brief Gets the list technology LEF files to additionally import\n"
     "Returns a list of path names for technology LEF files to read in addition to the primary file. "
@@ -0,0 +1,960 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "extNetClusters.h"
+#include "extNetTracer.h"
+
+#include "dbBoxScanner.h"
+#include "dbBoxConvert.h"
+#include "dbPolygonTools.h"
+#include "tlProgress.h"
+#include "tlTimer.h"
+#include "tlLog.h"
+#include "tlThreadedWorkers.h"
+
+#include <limits>
+
+namespace ext
+{
+
+// -----------------------------------------------------------------------------------
+//  UnionFind implementation
+
+UnionFind::UnionFind ()
+{
+  //  .. nothing yet ..
+}
+
+size_t
+UnionFind::add ()
+{
+  size_t n = m_parent.size ();
+  m_parent.push_back (n);
+  m_rank.push_back (0);
+  return n;
+}
+
+size_t
+UnionFind::find (size_t i)
+{
+  while (m_parent [i] != i) {
+    m_parent [i] = m_parent [m_parent [i]];
+    i = m_parent [i];
+  }
+  return i;
+}
+
+void
+UnionFind::join (size_t a, size_t b)
+{
+  a = find (a);
+  b = find (b);
+  if (a == b) {
+    return;
+  }
+
+  if (m_rank [a] < m_rank [b]) {
+    std::swap (a, b);
+  }
+  m_parent [b] = a;
+  if (m_rank [a] == m_rank [b]) {
+    ++m_rank [a];
+  }
+}
+
+// -----------------------------------------------------------------------------------
+//  NetCellClusters implementation
+
+NetCellClusters::NetCellClusters ()
+{
+  //  .. nothing yet ..
+}
+
+// -----------------------------------------------------------------------------------
+//  Helpers
+
+/**
+ *  @brief Gets the polygon for a local shape
+ */
+static db::Polygon
+polygon_of (const NetClusterShape &s)
+{
+  db::Polygon p;
+  if (s.shape.is_box ()) {
+    p = db::Polygon (s.bbox);
+  } else {
+    s.shape.polygon (p);
+  }
+  return p;
+}
+
+/**
+ *  @brief A receiver for the box scanner joining the local shapes of a cell
+ */
+class LocalClusterReceiver
+  : public db::box_scanner_receiver<NetClusterShape, size_t>
+{
+public:
+  LocalClusterReceiver (const NetClusters &clusters, UnionFind &uf)
+    : mp_clusters (&clusters), mp_uf (&uf)
+  {
+    //  .. nothing yet ..
+  }
+
+  void add (const NetClusterShape *s1, size_t p1, const NetClusterShape *s2, size_t p2)
+  {
+    if (! mp_clusters->is_connected (s1->layer, s2->layer) || mp_uf->find (p1) == mp_uf->find (p2)) {
+      return;
+    }
+
+    bool interact = false;
+    if (s1->shape.is_box () && s2->shape.is_box ()) {
+      interact = s1->bbox.touches (s2->bbox);
+    } else {
+      interact = db::interact (polygon_of (*s1), polygon_of (*s2));
+    }
+
+    if (interact) {
+      mp_uf->join (p1, p2);
+    }
+  }
+
+private:
+  const NetClusters *mp_clusters;
+  UnionFind *mp_uf;
+};
+
+/**
+ *  @brief Lifts a child cluster reference into the context of the parent cell
+ *
+ *  If the child cluster is connected to a cluster of the parent cell, the
+ *  reference is normalized to this cluster.
+ */
+static NetClusterRef
+lifted_ref (const NetCellClusters &cc, size_t inst_index, const db::Trans &trans, const NetClusterRef &child)
+{
+  NetClusterRef ref (inst_index, trans, child);
+  size_t c = 0;
+  if (cc.find_connection (ref, c)) {
+    return NetClusterRef (c);
+  } else {
+    return ref;
+  }
+}
+
+// -----------------------------------------------------------------------------------
+//  Parallel implementation of the cluster build
+
+/**
+ *  @brief A task building the clusters for a number of cells
+ *
+ *  NOTE: this class is not in the anonymous namespace as it is a friend of NetClusters.
+ */
+class NetClusterBuildTask
+  : public tl::Task
+{
+public:
+  NetClusterBuildTask (NetClusters *clusters)
+    : mp_clusters (clusters)
+  {
+    //  .. nothing yet ..
+  }
+
+  void add (db::cell_index_type ci)
+  {
+    m_cells.push_back (ci);
+  }
+
+  void perform ()
+  {
+    //  NOTE: each cell writes its own entry only and reads the ones of the (finished) child cells.
+    //  The instance interaction cache is private to the task.
+    NetClusters::interaction_cache cache;
+    for (std::vector<db::cell_index_type>::const_iterator c = m_cells.begin (); c != m_cells.end (); ++c) {
+      mp_clusters->build_cell (*c, cache);
+    }
+  }
+
+private:
+  NetClusters *mp_clusters;
+  std::vector<db::cell_index_type> m_cells;
+};
+
+namespace
+{
+
+class NetClusterBuildWorker
+  : public tl::Worker
+{
+public:
+  NetClusterBuildWorker ()
+    : tl::Worker ()
+  { }
+
+  virtual void perform_task (tl::Task *task)
+  {
+    NetClusterBuildTask *nc_task = dynamic_cast<NetClusterBuildTask *> (task);
+    if (nc_task) {
+      nc_task->perform ();
+    }
+  }
+};
+
+/**
+ *  @brief The job building the cells of one hierarchy level in parallel
+ */
+class NetClusterBuildJob
+  : public tl::JobBase
+{
+public:
+  NetClusterBuildJob (int nworkers)
+    : tl::JobBase (nworkers)
+  { }
+
+  /**
+   *  @brief Builds the given cells and waits for completion
+   */
+  void run (NetClusters *clusters, const std::vector<db::cell_index_type> &cells)
+  {
+    if (cells.empty ()) {
+      return;
+    }
+
+    //  a single cell is not worth the overhead
+    if (cells.size () < 2) {
+      NetClusterBuildTask task (clusters);
+      task.add (cells.front ());
+      task.perform ();
+      return;
+    }
+
+    //  a few chunks per worker for load balancing
+    size_t nchunks = std::min (cells.size (), size_t (num_workers ()) * 4);
+    for (size_t i = 0; i < nchunks; ++i) {
+      NetClusterBuildTask *task = new NetClusterBuildTask (clusters);
+      for (size_t j = (i * cells.size ()) / nchunks; j < ((i + 1) * cells.size ()) / nchunks; ++j) {
+        task->add (cells [j]);
+      }
+      schedule (task);
+    }
+
+    start ();
+    wait ();
+
+    if (has_error ()) {
+      throw tl::Exception (tl::to_string (QObject::tr ("Errors occured while building the net clusters. First error message says:\n")) + error_messages ().front ());
+    }
+  }
+
+protected:
+  virtual tl::Worker *create_worker ()
+  {
+    return new NetClusterBuildWorker ();
+  }
+};
+
+}
+
+// -----------------------------------------------------------------------------------
+//  NetClusters implementation
+
+NetClusters::NetClusters ()
+  : mp_layout (0), m_cell_index (0), m_nlayers (0), m_threads (0)
+{
+  //  .. nothing yet ..
+}
+
+bool
+NetClusters::is_supported (const NetTracerData &data)
+{
+  return ! data.is_empty () && ! data.has_computed_layers ();
+}
+
+std::map<unsigned int, std::set<unsigned int> >
+NetClusters::connectivity_from (const NetTracerData &data)
+{
+  std::map<unsigned int, std::set<unsigned int> > connectivity;
+
+  std::set<unsigned int> ol = data.original_layers ();
+  for (std::set<unsigned int>::const_iterator o = ol.begin (); o != ol.end (); ++o) {
+    std::set<unsigned int> &c = connectivity [*o];
+    std::set<unsigned int> ll = data.log_layers_for (*o);
+    for (std::set<unsigned int>::const_iterator l = ll.begin (); l != ll.end (); ++l) {
+      const std::set<unsigned int> &cl = data.connections (*l);
+      c.insert (cl.begin (), cl.end ());
+    }
+  }
+
+  return connectivity;
+}
+
+bool
+NetClusters::is_valid_for (const db::Layout &layout, const db::Cell &cell, const NetTracerData &data) const
+{
+  return mp_layout == &layout && m_cell_index == cell.cell_index () && m_connectivity == connectivity_from (data);
+}
+
+void
+NetClusters::clear ()
+{
+  mp_layout = 0;
+  m_cell_index = 0;
+  m_cells.clear ();
+  m_connectivity.clear ();
+  m_connected.clear ();
+  m_nlayers = 0;
+}
+
+void
+NetClusters::build (const db::Layout &layout, const db::Cell &cell, const NetTracerData &data)
+{
+  build (layout, cell, connectivity_from (data));
+}
+
+void
+NetClusters::build (const db::Layout &layout, const db::Cell &cell, const std::map<unsigned int, std::set<unsigned int> > &connectivity)
+{
+  clear ();
+
+  tl::SelfTimer timer (tl::verbosity () >= 21, tl::to_string (QObject::tr ("Building net clusters")));
+
+  mp_layout = &layout;
+  m_cell_index = cell.cell_index ();
+  m_connectivity = connectivity;
+
+  m_nlayers = 0;
+  for (std::map<unsigned int, std::set<unsigned int> >::const_iterator c = connectivity.begin (); c != connectivity.end (); ++c) {
+    m_nlayers = std::max (m_nlayers, c->first + 1);
+    if (! c->second.empty ()) {
+      m_nlayers = std::max (m_nlayers, *c->second.rbegin () + 1);
+    }
+  }
+
+  m_connected.resize (size_t (m_nlayers) * size_t (m_nlayers), false);
+  for (std::map<unsigned int, std::set<unsigned int> >::const_iterator c = connectivity.begin (); c != connectivity.end (); ++c) {
+    for (std::set<unsigned int>::const_iterator l = c->second.begin (); l != c->second.end (); ++l) {
+      m_connected [c->first * m_nlayers + *l] = true;
+    }
+  }
+
+  //  NOTE: the cell clusters hold pointers to their own members, hence the vector must not be resized later
+  m_cells.resize (layout.cells ());
+
+  std::set<db::cell_index_type> called;
+  cell.collect_called_cells (called);
+  called.insert (cell.cell_index ());
+
+  tl::RelativeProgress progress (tl::to_string (QObject::tr ("Building net clusters")), called.size (), 1);
+
+  try {
+
+    if (m_threads > 0 && called.size () > 1) {
+
+      //  with multiple threads, the cells are built level by level: the cells on one
+      //  hierarchy level only depend on the cells of the levels below
+      std::vector<unsigned int> cell_levels (layout.cells (), 0);
+      std::vector<std::vector<db::cell_index_type> > levels;
+
+      for (db::Layout::bottom_up_const_iterator c = layout.begin_bottom_up (); c != layout.end_bottom_up (); ++c) {
+
+        if (called.find (*c) == called.end ()) {
+          continue;
+        }
+
+        unsigned int l = 0;
+        for (db::Cell::child_cell_iterator cc = layout.cell (*c).begin_child_cells (); ! cc.at_end (); ++cc) {
+          l = std::max (l, cell_levels [*cc] + 1);
+        }
+
+        cell_levels [*c] = l;
+        if (l >= levels.size ()) {
+          levels.resize (l + 1);
+        }
+        levels [l].push_back (*c);
+
+      }
+
+      NetClusterBuildJob job (m_threads);
+
+      size_t n = 0;
+      for (std::vector<std::vector<db::cell_index_type> >::const_iterator l = levels.begin (); l != levels.end (); ++l) {
+        job.run (this, *l);
+        n += l->size ();
+        progress.set (n);
+      }
+
+    } else {
+
+      interaction_cache cache;
+
+      for (db::Layout::bottom_up_const_iterator c = layout.begin_bottom_up (); c != layout.end_bottom_up (); ++c) {
+        if (called.find (*c) != called.end ()) {
+          build_cell (*c, cache);
+          ++progress;
+        }
+      }
+
+    }
+
+  } catch (...) {
+    clear ();
+    throw;
+  }
+}
+
+std::vector<bool>
+NetClusters::connected_layers (unsigned int layer) const
+{
+  std::vector<bool> layers (m_nlayers, false);
+  if (layer < m_nlayers) {
+    for (unsigned int l = 0; l < m_nlayers; ++l) {
+      layers [l] = m_connected [layer * m_nlayers + l];
+    }
+  }
+  return layers;
+}
+
+bool
+NetClusters::interact (const db::Polygon &a, unsigned int la, const db::Polygon &b, unsigned int lb) const
+{
+  if (! is_connected (la, lb)) {
+    return false;
+  } else if (a.is_box () && b.is_box ()) {
+    return a.box ().touches (b.box ());
+  } else {
+    return db::interact (a, b);
+  }
+}
+
+void
+NetClusters::collect_hits (db::cell_index_type ci, const db::Box &region, const db::ICplxTrans &trans, const std::vector<bool> *layers, std::vector<NetClusterHit> &hits) const
+{
+  const NetCellClusters &cc = m_cells [ci];
+
+  for (NetCellClusters::shape_tree_type::touching_iterator s = cc.m_shape_tree.begin_touching (region, NetClusterShapeBoxConverter ()); ! s.at_end (); ++s) {
+    const NetClusterShape *shape = *s;
+    if (! layers || (shape->layer < layers->size () && (*layers) [shape->layer])) {
+      hits.push_back (NetClusterHit (polygon_of (*shape).transformed (trans), shape->layer, NetClusterRef (cc.m_cluster_of_shape [shape - &cc.m_shapes.front ()])));
+    }
+  }
+
+  db::box_convert<db::CellInst> bc (*mp_layout);
+
+  for (NetCellClusters::inst_tree_type::touching_iterator i = cc.m_inst_tree.begin_touching (region, NetClusterInstBoxConverter ()); ! i.at_end (); ++i) {
+
+    const NetClusterInst *inst = *i;
+    size_t inst_index = inst - &cc.m_insts.front ();
+    db::cell_index_type child_ci = inst->array.object ().cell_index ();
+
+    for (db::CellInstArray::iterator m = inst->array.begin_touching (region, bc); ! m.at_end (); ++m) {
+
+      db::ICplxTrans tm = inst->array.complex_trans (*m);
+
+      size_t n0 = hits.size ();
+      collect_hits (child_ci, region.transformed (tm.inverted ()), trans * tm, layers, hits);
+
+      //  lift the child references into this cell
+      for (std::vector<NetClusterHit>::iterator h = hits.begin () + n0; h != hits.end (); ++h) {
+        NetClusterRef ref (inst_index, *m, h->ref);
+        size_t c = 0;
+        if (cc.find_connection (ref, c)) {
+          h->ref = NetClusterRef (c);
+        } else {
+          h->ref = ref;
+        }
+      }
+
+    }
+
+  }
+}
+
+void
+NetClusters::shape_interactions (const db::Polygon &poly, unsigned int layer, db::cell_index_type ci, const db::ICplxTrans &trans, bool with_local, std::set<NetClusterRef> &refs) const
+{
+  const NetCellClusters &cc = m_cells [ci];
+  db::Box region = poly.box ().transformed (trans.inverted ());
+
+  if (with_local) {
+
+    for (NetCellClusters::shape_tree_type::touching_iterator s = cc.m_shape_tree.begin_touching (region, NetClusterShapeBoxConverter ()); ! s.at_end (); ++s) {
+
+      const NetClusterShape *shape = *s;
+      if (! is_connected (layer, shape->layer)) {
+        continue;
+      }
+
+      NetClusterRef ref (cc.m_cluster_of_shape [shape - &cc.m_shapes.front ()]);
+      if (refs.find (ref) == refs.end () && interact (poly, layer, polygon_of (*shape).transformed (trans), shape->layer)) {
+        refs.insert (ref);
+      }
+
+    }
+
+  }
+
+  db::box_convert<db::CellInst> bc (*mp_layout);
+
+  for (NetCellClusters::inst_tree_type::touching_iterator i = cc.m_inst_tree.begin_touching (region, NetClusterInstBoxConverter ()); ! i.at_end (); ++i) {
+
+    const NetClusterInst *inst = *i;
+    size_t inst_index = inst - &cc.m_insts.front ();
+    db::cell_index_type child_ci = inst->array.object ().cell_index ();
+
+    for (db::CellInstArray::iterator m = inst->array.begin_touching (region, bc); ! m.at_end (); ++m) {
+
+      std::set<NetClusterRef> child_refs;
+      shape_interactions (poly, layer, child_ci, trans * inst->array.complex_trans (*m), true, child_refs);
+
+      for (std::set<NetClusterRef>::const_iterator r = child_refs.begin (); r != child_refs.end (); ++r) {
+        refs.insert (lifted_ref (cc, inst_index, *m, *r));
+      }
+
+    }
+
+  }
+}
+
+const NetClusters::interaction_list &
+NetClusters::inst_interactions (db::cell_index_type ci1, db::cell_index_type ci2, const db::ICplxTrans &t12, interaction_cache &cache) const
+{
+  interaction_key key (std::make_pair (ci1, ci2), t12);
+  interaction_cache::const_iterator c = cache.find (key);
+  if (c != cache.end ()) {
+    return c->second;
+  }
+
+  //  NOTE: the cache is a map, so this reference stays valid while the recursion below adds entries
+  interaction_list &interactions = cache [key];
+
+  //  the overlap region in the coordinates of the first cell
+  db::box_convert<db::CellInst> bc (*mp_layout);
+  db::Box region = bc (db::CellInst (ci1)) & db::Box (bc (db::CellInst (ci2)).transformed (t12));
+  if (region.empty ()) {
+    return interactions;
+  }
+
+  const NetCellClusters &cc1 = m_cells [ci1];
+  const NetCellClusters &cc2 = m_cells [ci2];
+  db::ICplxTrans t21 = t12.inverted ();
+  db::Box region2 = region.transformed (t21);
+
+  std::set<std::pair<NetClusterRef, NetClusterRef> > found;
+
+  //  local shapes of the first cell vs. the shapes of the second cell and below
+
+  for (NetCellClusters::shape_tree_type::touching_iterator s = cc1.m_shape_tree.begin_touching (region, NetClusterShapeBoxConverter ()); ! s.at_end (); ++s) {
+
+    const NetClusterShape *shape = *s;
+    NetClusterRef ref1 (cc1.m_cluster_of_shape [shape - &cc1.m_shapes.front ()]);
+
+    std::set<NetClusterRef> refs;
+    shape_interactions (polygon_of (*shape), shape->layer, ci2, t12, true, refs);
+    for (std::set<NetClusterRef>::const_iterator r = refs.begin (); r != refs.end (); ++r) {
+      found.insert (std::make_pair (ref1, *r));
+    }
+
+  }
+
+  //  local shapes of the second cell vs. the child cells of the first cell
+
+  if (! cc1.m_insts.empty ()) {
+
+    for (NetCellClusters::shape_tree_type::touching_iterator s = cc2.m_shape_tree.begin_touching (region2, NetClusterShapeBoxConverter ()); ! s.at_end (); ++s) {
+
+      const NetClusterShape *shape = *s;
+      NetClusterRef ref2 (cc2.m_cluster_of_shape [shape - &cc2.m_shapes.front ()]);
+
+      std::set<NetClusterRef> refs;
+      shape_interactions (polygon_of (*shape).transformed (t12), shape->layer, ci1, db::ICplxTrans (), false, refs);
+      for (std::set<NetClusterRef>::const_iterator r = refs.begin (); r != refs.end (); ++r) {
+        found.insert (std::make_pair (*r, ref2));
+      }
+
+    }
+
+  }
+
+  //  child cells vs. child cells: derived from the (cached) interactions of the child cells
+
+  for (NetCellClusters::inst_tree_type::touching_iterator i1 = cc1.m_inst_tree.begin_touching (region, NetClusterInstBoxConverter ()); ! i1.at_end (); ++i1) {
+
+    const NetClusterInst *inst1 = *i1;
+    size_t inst_index1 = inst1 - &cc1.m_insts.front ();
+    db::cell_index_type child1 = inst1->array.object ().cell_index ();
+
+    for (db::CellInstArray::iterator m1 = inst1->array.begin_touching (region, bc); ! m1.at_end (); ++m1) {
+
+      db::ICplxTrans tm1 = inst1->array.complex_trans (*m1);
+      db::Box box1 = (bc (db::CellInst (child1)).transformed (tm1) & region).transformed (t21);
+      if (box1.empty ()) {
+        continue;
+      }
+
+      db::ICplxTrans tm1i = tm1.inverted ();
+
+      for (NetCellClusters::inst_tree_type::touching_iterator i2 = cc2.m_inst_tree.begin_touching (box1, NetClusterInstBoxConverter ()); ! i2.at_end (); ++i2) {
+
+        const NetClusterInst *inst2 = *i2;
+        size_t inst_index2 = inst2 - &cc2.m_insts.front ();
+        db::cell_index_type child2 = inst2->array.object ().cell_index ();
+
+        for (db::CellInstArray::iterator m2 = inst2->array.begin_touching (box1, bc); ! m2.at_end (); ++m2) {
+
+          const interaction_list &il = inst_interactions (child1, child2, tm1i * t12 * inst2->array.complex_trans (*m2), cache);
+          for (interaction_list::const_iterator ii = il.begin (); ii != il.end (); ++ii) {
+            found.insert (std::make_pair (lifted_ref (cc1, inst_index1, *m1, ii->first), lifted_ref (cc2, inst_index2, *m2, ii->second)));
+          }
+
+        }
+
+      }
+
+    }
+
+  }
+
+  interactions.insert (interactions.end (), found.begin (), found.end ());
+  return interactions;
+}
+
+void
+NetClusters::build_cell (db::cell_index_type ci, interaction_cache &cache)
+{
+  const db::Cell &cell = mp_layout->cell (ci);
+  NetCellClusters &cc = m_cells [ci];
+
+  //  collect the local shapes
+
+  for (std::map<unsigned int, std::set<unsigned int> >::const_iterator l = m_connectivity.begin (); l != m_connectivity.end (); ++l) {
+    if (mp_layout->is_valid_layer (l->first)) {
+      for (db::ShapeIterator s = cell.shapes (l->first).begin (db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Boxes); ! s.at_end (); ++s) {
+        cc.m_shapes.push_back (NetClusterShape (*s, l->first));
+      }
+    }
+  }
+
+  //  collect the instances of cells with shapes on the connected layers
+
+  db::box_convert<db::CellInst> bc (*mp_layout);
+
+  for (db::Cell::const_iterator i = cell.begin (); ! i.at_end (); ++i) {
+    const db::CellInstArray &array = i->cell_inst ();
+    if (! m_cells [array.object ().cell_index ()].empty ()) {
+      cc.m_insts.push_back (NetClusterInst (array, array.bbox (bc)));
+    }
+  }
+
+  for (std::vector<NetClusterShape>::const_iterator s = cc.m_shapes.begin (); s != cc.m_shapes.end (); ++s) {
+    cc.m_shape_tree.insert (&*s);
+  }
+  cc.m_shape_tree.sort (NetClusterShapeBoxConverter ());
+
+  for (std::vector<NetClusterInst>::const_iterator i = cc.m_insts.begin (); i != cc.m_insts.end (); ++i) {
+    cc.m_inst_tree.insert (&*i);
+  }
+  cc.m_inst_tree.sort (NetClusterInstBoxConverter ());
+
+  //  one union-find element per local shape and one per connected child cluster
+
+  UnionFind uf;
+  uf.reserve (cc.m_shapes.size ());
+  for (size_t i = 0; i < cc.m_shapes.size (); ++i) {
+    uf.add ();
+  }
+
+  std::map<NetClusterRef, size_t> nodes;
+
+  //  local shape to local shape interactions
+
+  if (cc.m_shapes.size () > 1) {
+
+    db::box_scanner<NetClusterShape, size_t> scanner;
+    scanner.reserve (cc.m_shapes.size ());
+    for (std::vector<NetClusterShape>::const_iterator s = cc.m_shapes.begin (); s != cc.m_shapes.end (); ++s) {
+      scanner.insert (&*s, size_t (s - cc.m_shapes.begin ()));
+    }
+
+    LocalClusterReceiver rec (*this, uf);
+    scanner.process (rec, 1, NetClusterShapeBoxConverter ());
+
+  }
+
+  //  local shape to instance interactions
+
+  if (! cc.m_insts.empty ()) {
+
+    for (std::vector<NetClusterShape>::const_iterator s = cc.m_shapes.begin (); s != cc.m_shapes.end (); ++s) {
+
+      NetCellClusters::inst_tree_type::touching_iterator i = cc.m_inst_tree.begin_touching (s->bbox, NetClusterInstBoxConverter ());
+      if (i.at_end ()) {
+        continue;
+      }
+
+      db::Polygon poly = polygon_of (*s);
+
+      for ( ; ! i.at_end (); ++i) {
+
+        const NetClusterInst *inst = *i;
+        size_t inst_index = inst - &cc.m_insts.front ();
+
+        for (db::CellInstArray::iterator m = inst->array.begin_touching (s->bbox, bc); ! m.at_end (); ++m) {
+
+          std::set<NetClusterRef> refs;
+          shape_interactions (poly, s->layer, inst->array.object ().cell_index (), inst->array.complex_trans (*m), true, refs);
+
+          for (std::set<NetClusterRef>::const_iterator r = refs.begin (); r != refs.end (); ++r) {
+            NetClusterRef ref (inst_index, *m, *r);
+            std::map<NetClusterRef, size_t>::const_iterator n = nodes.find (ref);
+            if (n == nodes.end ()) {
+              n = nodes.insert (std::make_pair (ref, uf.add ())).first;
+            }
+            uf.join (size_t (s - cc.m_shapes.begin ()), n->second);
+          }
+
+        }
+
+      }
+
+    }
+
+  }
+
+  //  instance to instance interactions
+
+  for (std::vector<NetClusterInst>::const_iterator i1 = cc.m_insts.begin (); i1 != cc.m_insts.end (); ++i1) {
+
+    db::cell_index_type ci1 = i1->array.object ().cell_index ();
+    db::Box cell_box1 = bc (db::CellInst (ci1));
+    size_t inst_index1 = i1 - cc.m_insts.begin ();
+
+    for (db::CellInstArray::iterator m1 = i1->array.begin (); ! m1.at_end (); ++m1) {
+
+      db::ICplxTrans t1 = i1->array.complex_trans (*m1);
+      db::ICplxTrans t1i = t1.inverted ();
+      db::Box box1 = cell_box1.transformed (t1);
+
+      for (NetCellClusters::inst_tree_type::touching_iterator i = cc.m_inst_tree.begin_touching (box1, NetClusterInstBoxConverter ()); ! i.at_end (); ++i) {
+
+        const NetClusterInst *i2 = *i;
+        size_t inst_index2 = i2 - &cc.m_insts.front ();
+        if (inst_index2 < inst_index1) {
+          continue;
+        }
+
+        db::cell_index_type ci2 = i2->array.object ().cell_index ();
+
+        for (db::CellInstArray::iterator m2 = i2->array.begin_touching (box1, bc); ! m2.at_end (); ++m2) {
+
+          //  consider each pair of instances once
+          if (inst_index2 == inst_index1 && ! (*m1 < *m2)) {
+            continue;
+          }
+
+          db::ICplxTrans t2 = i2->array.complex_trans (*m2);
+          if (! box1.touches (bc (db::CellInst (ci2)).transformed (t2))) {
+            continue;
+          }
+
+          const interaction_list &il = inst_interactions (ci1, ci2, t1i * t2, cache);
+          for (interaction_list::const_iterator ii = il.begin (); ii != il.end (); ++ii) {
+
+            NetClusterRef ref1 (inst_index1, *m1, ii->first);
+            std::map<NetClusterRef, size_t>::const_iterator n1 = nodes.find (ref1);
+            if (n1 == nodes.end ()) {
+              n1 = nodes.insert (std::make_pair (ref1, uf.add ())).first;
+            }
+
+            NetClusterRef ref2 (inst_index2, *m2, ii->second);
+            std::map<NetClusterRef, size_t>::const_iterator n2 = nodes.find (ref2);
+            if (n2 == nodes.end ()) {
+              n2 = nodes.insert (std::make_pair (ref2, uf.add ())).first;
+            }
+
+            uf.join (n1->second, n2->second);
+
+          }
+
+        }
+
+      }
+
+    }
+
+  }
+
+  //  form the clusters
+
+  std::vector<size_t> cluster_of_root (uf.size (), std::numeric_limits<size_t>::max ());
+
+  cc.m_cluster_of_shape.reserve (cc.m_shapes.size ());
+  for (size_t i = 0; i < cc.m_shapes.size (); ++i) {
+    size_t r = uf.find (i);
+    if (cluster_of_root [r] == std::numeric_limits<size_t>::max ()) {
+      cluster_of_root [r] = cc.m_clusters.size ();
+      cc.m_clusters.push_back (NetCellClusters::Cluster ());
+    }
+    cc.m_cluster_of_shape.push_back (cluster_of_root [r]);
+    cc.m_clusters [cluster_of_root [r]].shapes.push_back (i);
+  }
+
+  for (std::map<NetClusterRef, size_t>::const_iterator n = nodes.begin (); n != nodes.end (); ++n) {
+    size_t r = uf.find (n->second);
+    if (cluster_of_root [r] == std::numeric_limits<size_t>::max ()) {
+      cluster_of_root [r] = cc.m_clusters.size ();
+      cc.m_clusters.push_back (NetCellClusters::Cluster ());
+    }
+    cc.m_clusters [cluster_of_root [r]].connections.push_back (n->first);
+    cc.m_connections.insert (std::make_pair (n->first, cluster_of_root [r]));
+  }
+}
+
+void
+NetClusters::find_clusters (const db::Polygon &seed, unsigned int layer, std::set<NetClusterRef> &clusters) const
+{
+  if (! mp_layout) {
+    return;
+  }
+
+  std::vector<bool> layers = connected_layers (layer);
+
+  std::vector<NetClusterHit> hits;
+  collect_hits (m_cell_index, seed.box (), db::ICplxTrans (), &layers, hits);
+
+  for (std::vector<NetClusterHit>::const_iterator h = hits.begin (); h != hits.end (); ++h) {
+    if (clusters.find (h->ref) == clusters.end () && interact (seed, layer, h->polygon, h->layer)) {
+      clusters.insert (h->ref);
+    }
+  }
+}
+
+void
+NetClusters::collect_shapes (const NetClusterRef &ref, std::vector<NetTracerShape> &shapes) const
+{
+  if (! mp_layout) {
+    return;
+  }
+
+  //  resolves a reference into a cell, a cluster and a transformation
+  struct Entry
+  {
+    Entry (db::cell_index_type _ci, size_t _cluster, const db::ICplxTrans &_trans)
+      : ci (_ci), cluster (_cluster), trans (_trans)
+    { }
+
+    db::cell_index_type ci;
+    size_t cluster;
+    db::ICplxTrans trans;
+  };
+
+  std::vector<Entry> todo;
+
+  db::cell_index_type ci = m_cell_index;
+  db::ICplxTrans t;
+  for (NetClusterRef::path_type::const_iterator p = ref.path ().begin (); p != ref.path ().end (); ++p) {
+    const db::CellInstArray &array = m_cells [ci].inst (p->first);
+    t = t * array.complex_trans (p->second);
+    ci = array.object ().cell_index ();
+  }
+  todo.push_back (Entry (ci, ref.cluster (), t));
+
+  while (! todo.empty ()) {
+
+    Entry e = todo.back ();
+    todo.pop_back ();
+
+    const NetCellClusters &cc = m_cells [e.ci];
+    const NetCellClusters::Cluster &cluster = cc.cluster (e.cluster);
+
+    for (std::vector<size_t>::const_iterator s = cluster.shapes.begin (); s != cluster.shapes.end (); ++s) {
+      const NetClusterShape &shape = cc.shape (*s);
+      shapes.push_back (NetTracerShape (e.trans, shape.shape, shape.layer, e.ci));
+    }
+
+    for (std::vector<NetClusterRef>::const_iterator c = cluster.connections.begin (); c != cluster.connections.end (); ++c) {
+      db::cell_index_type cci = e.ci;
+      db::ICplxTrans ct = e.trans;
+      for (NetClusterRef::path_type::const_iterator p = c->path ().begin (); p != c->path ().end (); ++p) {
+        const db::CellInstArray &array = m_cells [cci].inst (p->first);
+        ct = ct * array.complex_trans (p->second);
+        cci = array.object ().cell_index ();
+      }
+      todo.push_back (Entry (cci, c->cluster (), ct));
+    }
+
+  }
+}
+
+const std::vector<NetClusterRef> &
+NetClusters::nets_of_cell (db::cell_index_type ci, std::map<db::cell_index_type, std::vector<NetClusterRef> > &cache) const
+{
+  std::map<db::cell_index_type, std::vector<NetClusterRef> >::const_iterator c = cache.find (ci);
+  if (c != cache.end ()) {
+    return c->second;
+  }
+
+  std::vector<NetClusterRef> &nets = cache [ci];
+
+  const NetCellClusters &cc = m_cells [ci];
+
+  for (size_t i = 0; i < cc.size (); ++i) {
+    nets.push_back (NetClusterRef (i));
+  }
+
+  //  child nets not connected in this cell are nets of their own
+  for (size_t i = 0; i < cc.inst_count (); ++i) {
+
+    const db::CellInstArray &array = cc.inst (i);
+    const std::vector<NetClusterRef> &child_nets = nets_of_cell (array.object ().cell_index (), cache);
+    if (child_nets.empty ()) {
+      continue;
+    }
+
+    for (db::CellInstArray::iterator m = array.begin (); ! m.at_end (); ++m) {
+      for (std::vector<NetClusterRef>::const_iterator n = child_nets.begin (); n != child_nets.end (); ++n) {
+        NetClusterRef ref (i, *m, *n);
+        size_t cluster = 0;
+        if (! cc.find_connection (ref, cluster)) {
+          nets.push_back (ref);
+        }
+      }
+    }
+
+  }
+
+  return nets;
+}
+
+void
+NetClusters::collect_nets (std::vector<NetClusterRef> &nets) const
+{
+  if (! mp_layout) {
+    return;
+  }
+
+  std::map<db::cell_index_type, std::vector<NetClusterRef> > cache;
+  const std::vector<NetClusterRef> &top_nets = nets_of_cell (m_cell_index, cache);
+  nets.insert (nets.end (), top_nets.begin (), top_nets.end ());
+}
+
+}
@@ -0,0 +1,569 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_extNetClusters
+#define HDR_extNetClusters
+
+#include "extCommon.h"
+
+#include "dbLayout.h"
+#include "dbCell.h"
+#include "dbBoxTree.h"
+#include "dbPolygon.h"
+#include "dbTrans.h"
+
+#include <vector>
+#include <map>
+#include <set>
+
+namespace ext
+{
+
+class NetTracerData;
+class NetTracerShape;
+
+/**
+ *  @brief A union-find (disjoint set) structure
+ *
+ *  The elements are consecutive numbers starting from 0. Initially, each element
+ *  forms a set of its own. "join" combines two sets and "find" delivers the
+ *  representative of the set an element belongs to.
+ *  The implementation uses union by rank and path halving.
+ */
+class EXT_PUBLIC UnionFind
+{
+public:
+  /**
+   *  @brief Constructor: creates an empty structure
+   */
+  UnionFind ();
+
+  /**
+   *  @brief Adds a new element and returns its number
+   */
+  size_t add ();
+
+  /**
+   *  @brief Gets the representative for the set the given element belongs to
+   */
+  size_t find (size_t i);
+
+  /**
+   *  @brief Joins the sets of the given elements
+   */
+  void join (size_t a, size_t b);
+
+  /**
+   *  @brief Gets the number of elements
+   */
+  size_t size () const
+  {
+    return m_parent.size ();
+  }
+
+  /**
+   *  @brief Reserves memory for n elements
+   */
+  void reserve (size_t n)
+  {
+    m_parent.reserve (n);
+    m_rank.reserve (n);
+  }
+
+private:
+  std::vector<size_t> m_parent;
+  std::vector<unsigned char> m_rank;
+};
+
+/**
+ *  @brief A reference to a cluster in the context of a cell
+ *
+ *  A cluster reference describes a cluster of the cell itself (the path is empty) or
+ *  a cluster of a child cell. In the latter case, the path describes the instances
+ *  leading to the child cell. Each element of the path is the index of the instance
+ *  (see NetCellClusters::inst) and the transformation of the array member.
+ *
+ *  Cluster references are normalized: a child cluster connected to other shapes in a
+ *  parent cell is represented by the parent's cluster. Hence, a path is only present
+ *  if the child cluster is not connected to anything on the levels above.
+ */
+class EXT_PUBLIC NetClusterRef
+{
+public:
+  typedef std::pair<size_t, db::Trans> path_element;
+  typedef std::vector<path_element> path_type;
+
+  /**
+   *  @brief Default constructor: creates a reference to cluster 0 of the cell
+   */
+  NetClusterRef ()
+    : m_cluster (0)
+  {
+    //  .. nothing yet ..
+  }
+
+  /**
+   *  @brief Creates a reference to a cluster of the cell itself
+   */
+  NetClusterRef (size_t cluster)
+    : m_cluster (cluster)
+  {
+    //  .. nothing yet ..
+  }
+
+  /**
+   *  @brief Creates a reference to a child cluster through the given instance
+   *
+   *  "child" is the reference in the context of the child cell.
+   */
+  NetClusterRef (size_t inst, const db::Trans &trans, const NetClusterRef &child)
+    : m_cluster (child.m_cluster)
+  {
+    m_path.reserve (child.m_path.size () + 1);
+    m_path.push_back (path_element (inst, trans));
+    m_path.insert (m_path.end (), child.m_path.begin (), child.m_path.end ());
+  }
+
+  /**
+   *  @brief Gets the path
+   */
+  const path_type &path () const
+  {
+    return m_path;
+  }
+
+  /**
+   *  @brief Gets the index of the cluster inside the cell the path leads to
+   */
+  size_t cluster () const
+  {
+    return m_cluster;
+  }
+
+  /**
+   *  @brief Returns true, if the reference points to a cluster of the cell itself
+   */
+  bool is_local () const
+  {
+    return m_path.empty ();
+  }
+
+  /**
+   *  @brief Equality
+   */
+  bool operator== (const NetClusterRef &other) const
+  {
+    return m_cluster == other.m_cluster && m_path == other.m_path;
+  }
+
+  /**
+   *  @brief Less operator
+   */
+  bool operator< (const NetClusterRef &other) const
+  {
+    if (m_cluster != other.m_cluster) {
+      return m_cluster < other.m_cluster;
+    }
+    return m_path < other.m_path;
+  }
+
+private:
+  path_type m_path;
+  size_t m_cluster;
+};
+
+/**
+ *  @brief A shape inside the cluster database
+ */
+struct EXT_PUBLIC NetClusterShape
+{
+  NetClusterShape (const db::Shape &s, unsigned int l)
+    : shape (s), layer (l), bbox (s.bbox ())
+  {
+    //  .. nothing yet ..
+  }
+
+  db::Shape shape;
+  unsigned int layer;
+  db::Box bbox;
+};
+
+/**
+ *  @brief A box converter for the NetClusterShape
+ */
+struct NetClusterShapeBoxConverter
+{
+  typedef db::Box box_type;
+  typedef db::simple_bbox_tag complexity;
+
+  db::Box operator() (const NetClusterShape &s) const
+  {
+    return s.bbox;
+  }
+
+  db::Box operator() (const NetClusterShape *s) const
+  {
+    return s->bbox;
+  }
+};
+
+/**
+ *  @brief An instance inside the cluster database
+ */
+struct EXT_PUBLIC NetClusterInst
+{
+  NetClusterInst (const db::CellInstArray &a, const db::Box &b)
+    : array (a), bbox (b)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::CellInstArray array;
+  db::Box bbox;
+};
+
+/**
+ *  @brief A box converter for the NetClusterInst
+ */
+struct NetClusterInstBoxConverter
+{
+  typedef db::Box box_type;
+  typedef db::simple_bbox_tag complexity;
+
+  db::Box operator() (const NetClusterInst *i) const
+  {
+    return i->bbox;
+  }
+};
+
+/**
+ *  @brief The clusters of one cell
+ *
+ *  A cluster is a set of connected shapes. The clusters of a cell include the
+ *  shapes of the child cells: a cluster consists of local shapes and of child clusters
+ *  (the "connections"). A child cluster which is not connected to anything in the cell
+ *  is not a cluster of the cell - it is referred to through a NetClusterRef with a path.
+ */
+class EXT_PUBLIC NetCellClusters
+{
+public:
+  /**
+   *  @brief Describes a cluster
+   */
+  struct Cluster
+  {
+    std::vector<size_t> shapes;
+    std::vector<NetClusterRef> connections;
+  };
+
+  /**
+   *  @brief Constructor
+   */
+  NetCellClusters ();
+
+  /**
+   *  @brief Gets the number of clusters
+   */
+  size_t size () const
+  {
+    return m_clusters.size ();
+  }
+
+  /**
+   *  @brief Gets the cluster with the given index
+   */
+  const Cluster &cluster (size_t i) const
+  {
+    return m_clusters [i];
+  }
+
+  /**
+   *  @brief Gets the number of local shapes
+   */
+  size_t shape_count () const
+  {
+    return m_shapes.size ();
+  }
+
+  /**
+   *  @brief Gets the local shape with the given index
+   */
+  const NetClusterShape &shape (size_t i) const
+  {
+    return m_shapes [i];
+  }
+
+  /**
+   *  @brief Gets the index of the cluster the given local shape belongs to
+   */
+  size_t cluster_of_shape (size_t i) const
+  {
+    return m_cluster_of_shape [i];
+  }
+
+  /**
+   *  @brief Gets the number of instances
+   */
+  size_t inst_count () const
+  {
+    return m_insts.size ();
+  }
+
+  /**
+   *  @brief Gets the instance with the given index
+   *
+   *  Only instances of cells with shapes on connected layers are stored.
+   */
+  const db::CellInstArray &inst (size_t i) const
+  {
+    return m_insts [i].array;
+  }
+
+  /**
+   *  @brief Finds the cluster a child cluster is connected to
+   *
+   *  Returns false if the child cluster is not connected to anything in this cell.
+   */
+  bool find_connection (const NetClusterRef &ref, size_t &cluster) const
+  {
+    std::map<NetClusterRef, size_t>::const_iterator c = m_connections.find (ref);
+    if (c != m_connections.end ()) {
+      cluster = c->second;
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  /**
+   *  @brief Returns true, if there are no shapes in this cell and below
+   */
+  bool empty () const
+  {
+    return m_shapes.empty () && m_insts.empty ();
+  }
+
+private:
+  friend class NetClusters;
+
+  typedef db::box_tree<db::Box, const NetClusterShape *, NetClusterShapeBoxConverter> shape_tree_type;
+  typedef db::box_tree<db::Box, const NetClusterInst *, NetClusterInstBoxConverter> inst_tree_type;
+
+  std::vector<NetClusterShape> m_shapes;
+  std::vector<size_t> m_cluster_of_shape;
+  std::vector<NetClusterInst> m_insts;
+  std::vector<Cluster> m_clusters;
+  std::map<NetClusterRef, size_t> m_connections;
+  shape_tree_type m_shape_tree;
+  inst_tree_type m_inst_tree;
+};
+
+/**
+ *  @brief A shape hit by a region query on the cluster database
+ */
+struct EXT_PUBLIC NetClusterHit
+{
+  NetClusterHit (const db::Polygon &p, unsigned int l, const NetClusterRef &r)
+    : polygon (p), layer (l), ref (r)
+  {
+    //  .. nothing yet ..
+  }
+
+  db::Polygon polygon;
+  unsigned int layer;
+  NetClusterRef ref;
+};
+
+/**
+ *  @brief The hierarchical cluster database for the net tracer
+ *
+ *  The cluster database stores the connectivity of the shapes of a cell tree.
+ *  It is built bottom-up once: for each cell, the local shapes and the child clusters
+ *  are joined into clusters using a union-find structure. Interactions between local
+ *  shapes are determined with a box scanner, interactions with child cells and between
+ *  child cells are derived from the clusters of the child cells.
+ *
+ *  Once built, a net is obtained by looking up the clusters at the seed and collecting
+ *  the shapes of these clusters.
+ *
+ *  The cluster database supports connections between original layers only (including
+ *  aliases). Layers computed by boolean operations require the flood fill of the NetTracer.
+ *  The database holds references to the shapes of the layout, so it must be cleared
+ *  when the layout changes.
+ */
+class EXT_PUBLIC NetClusters
+{
+public:
+  /**
+   *  @brief Constructor: creates an empty database
+   */
+  NetClusters ();
+
+  /**
+   *  @brief Returns true, if the given tracer data can be used for building the cluster database
+   */
+  static bool is_supported (const NetTracerData &data);
+
+  /**
+   *  @brief Sets the number of worker threads used for building the database
+   *
+   *  The cells of one hierarchy level are built in parallel. With 0 threads (the default),
+   *  the database is built in the calling thread.
+   */
+  void set_threads (int n)
+  {
+    m_threads = n;
+  }
+
+  /**
+   *  @brief Gets the number of worker threads used for building the database
+   */
+  int threads () const
+  {
+    return m_threads;
+  }
+
+  /**
+   *  @brief Builds the cluster database for the given cell and the connections of the tracer data
+   *
+   *  The layout needs to be updated (valid bounding boxes and hierarchy).
+   */
+  void build (const db::Layout &layout, const db::Cell &cell, const NetTracerData &data);
+
+  /**
+   *  @brief Builds the cluster database for the given cell and the given layer connectivity
+   *
+   *  The connectivity lists the connected layers for each layer. It needs to be symmetric.
+   *  A layer is connected to itself only if it is listed in its own set.
+   */
+  void build (const db::Layout &layout, const db::Cell &cell, const std::map<unsigned int, std::set<unsigned int> > &connectivity);
+
+  /**
+   *  @brief Returns true, if the database has been built for the given cell and tracer data
+   */
+  bool is_valid_for (const db::Layout &layout, const db::Cell &cell, const NetTracerData &data) const;
+
+  /**
+   *  @brief Clears the database
+   */
+  void clear ();
+
+  /**
+   *  @brief Returns true, if the database has not been built
+   */
+  bool empty () const
+  {
+    return mp_layout == 0;
+  }
+
+  /**
+   *  @brief Gets the layout the database was built for
+   */
+  const db::Layout &layout () const
+  {
+    return *mp_layout;
+  }
+
+  /**
+   *  @brief Gets the cell the database was built for
+   */
+  const db::Cell &cell () const
+  {
+    return mp_layout->cell (m_cell_index);
+  }
+
+  /**
+   *  @brief Gets the clusters for the given cell
+   */
+  const NetCellClusters &cell_clusters (db::cell_index_type ci) const
+  {
+    return m_cells [ci];
+  }
+
+  /**
+   *  @brief Returns true, if the given layers are connected
+   */
+  bool is_connected (unsigned int la, unsigned int lb) const
+  {
+    return la < m_nlayers && lb < m_nlayers && m_connected [la * m_nlayers + lb];
+  }
+
+  /**
+   *  @brief Finds the clusters of the top cell interacting with the given seed on the layers connected to "layer"
+   */
+  void find_clusters (const db::Polygon &seed, unsigned int layer, std::set<NetClusterRef> &clusters) const;
+
+  /**
+   *  @brief Collects the shapes of the given cluster of the top cell
+   *
+   *  The shapes are delivered with the transformation into the top cell.
+   */
+  void collect_shapes (const NetClusterRef &ref, std::vector<NetTracerShape> &shapes) const;
+
+  /**
+   *  @brief Collects the shapes inside the given region of the given cell together with their clusters
+   *
+   *  The region is given in the coordinates of the cell. The polygons delivered are transformed
+   *  with "trans" and the cluster references are given in the context of the cell.
+   *  If "layers" is not null, only shapes on layers with a true value in this vector are considered.
+   */
+  void collect_hits (db::cell_index_type ci, const db::Box &region, const db::ICplxTrans &trans, const std::vector<bool> *layers, std::vector<NetClusterHit> &hits) const;
+
+  /**
+   *  @brief Collects the references for all nets of the top cell
+   *
+   *  Each net is represented by one reference: either a cluster of the top cell or a
+   *  child cluster not connected to anything above. Every instance of a child cluster
+   *  delivers a separate net.
+   */
+  void collect_nets (std::vector<NetClusterRef> &nets) const;
+
+private:
+  friend class NetClusterBuildTask;
+
+  typedef std::vector<std::pair<NetClusterRef, NetClusterRef> > interaction_list;
+  typedef std::pair<std::pair<db::cell_index_type, db::cell_index_type>, db::ICplxTrans> interaction_key;
+  typedef std::map<interaction_key, interaction_list> interaction_cache;
+
+  const db::Layout *mp_layout;
+  db::cell_index_type m_cell_index;
+  std::vector<NetCellClusters> m_cells;
+  std::map<unsigned int, std::set<unsigned int> > m_connectivity;
+  std::vector<bool> m_connected;
+  unsigned int m_nlayers;
+  int m_threads;
+
+  void build_cell (db::cell_index_type ci, interaction_cache &cache);
+  const interaction_list &inst_interactions (db::cell_index_type ci1, db::cell_index_type ci2, const db::ICplxTrans &t12, interaction_cache &cache) const;
+  void shape_interactions (const db::Polygon &poly, unsigned int layer, db::cell_index_type ci, const db::ICplxTrans &trans, bool with_local, std::set<NetClusterRef> &refs) const;
+  std::vector<bool> connected_layers (unsigned int layer) const;
+  bool interact (const db::Polygon &a, unsigned int la, const db::Polygon &b, unsigned int lb) const;
+  static std::map<unsigned int, std::set<unsigned int> > connectivity_from (const NetTracerData &data);
+  const std::vector<NetClusterRef> &nets_of_cell (db::cell_index_type ci, std::map<db::cell_index_type, std::vector<NetClusterRef> > &cache) const;
+};
+
+}
+
+#endif
+
@@ -0,0 +1,281 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "extNetExtractor.h"
+#include "extNetTracer.h"
+
+#include "dbRecursiveShapeIterator.h"
+#include "dbPolygonTools.h"
+#include "rdb.h"
+#include "tlTimer.h"
+#include "tlLog.h"
+#include "tlString.h"
+
+namespace ext
+{
+
+// -----------------------------------------------------------------------------------
+//  NetExtractor implementation
+
+NetExtractor::NetExtractor ()
+  : m_label_depth (0)
+{
+  //  .. nothing yet ..
+}
+
+void
+NetExtractor::clear ()
+{
+  m_clusters.clear ();
+  m_nets.clear ();
+  m_names.clear ();
+  m_labels.clear ();
+}
+
+void
+NetExtractor::extract (const db::Layout &layout, const db::Cell &cell, const NetTracerData &data)
+{
+  clear ();
+
+  if (! NetClusters::is_supported (data)) {
+    throw tl::Exception (tl::to_string (QObject::tr ("Net extraction requires connections and does not support computed layers")));
+  }
+
+  tl::SelfTimer timer (tl::verbosity () >= 11, tl::to_string (QObject::tr ("Net extraction")));
+
+  m_clusters.build (layout, cell, data);
+  m_clusters.collect_nets (m_nets);
+
+  m_names.resize (m_nets.size ());
+  m_labels.resize (m_nets.size ());
+
+  assign_labels ();
+}
+
+void
+NetExtractor::assign_labels ()
+{
+  const db::Layout &layout = m_clusters.layout ();
+
+  std::map<NetClusterRef, size_t> net_index;
+  for (size_t i = 0; i < m_nets.size (); ++i) {
+    net_index.insert (std::make_pair (m_nets [i], i));
+  }
+
+  std::set<unsigned int> layers;
+  for (db::Layout::layer_iterator l = layout.begin_layers (); l != layout.end_layers (); ++l) {
+    if (m_clusters.is_connected ((*l).first, (*l).first)) {
+      layers.insert ((*l).first);
+    }
+  }
+
+  std::vector<int> name_depth (m_nets.size (), -1);
+
+  if (! layers.empty ()) {
+
+    db::RecursiveShapeIterator texts (layout, m_clusters.cell (), layers);
+    texts.shape_flags (db::ShapeIterator::Texts);
+
+    std::vector<NetClusterHit> hits;
+
+    for ( ; ! texts.at_end (); ++texts) {
+
+      db::Box text_box = texts.shape ().bbox ().transformed (texts.trans ());
+      unsigned int text_layer = texts.layer ();
+      int depth = int (texts.depth ());
+
+      hits.clear ();
+      m_clusters.collect_hits (m_clusters.cell ().cell_index (), text_box, db::ICplxTrans (), 0, hits);
+
+      std::set<size_t> seen;
+
+      for (std::vector<NetClusterHit>::const_iterator h = hits.begin (); h != hits.end (); ++h) {
+
+        if (! m_clusters.is_connected (h->layer, text_layer)) {
+          continue;
+        }
+
+        bool interact = false;
+        if (h->polygon.is_box ()) {
+          interact = h->polygon.box ().touches (text_box);
+        } else {
+          interact = db::interact (h->polygon, text_box);
+        }
+
+        std::map<NetClusterRef, size_t>::const_iterator n = net_index.find (h->ref);
+        if (interact && n != net_index.end () && seen.insert (n->second).second) {
+
+          std::string text = texts.shape ().text_string ();
+
+          //  only labels up to the given depth are checked for shorts and opens
+          if (m_label_depth < 0 || depth <= m_label_depth) {
+            m_labels [n->second].insert (text);
+          }
+
+          //  the label closest to the top cell gives the name
+          if (name_depth [n->second] < 0 || name_depth [n->second] > depth) {
+            m_names [n->second] = text;
+            name_depth [n->second] = depth;
+          }
+
+        }
+
+      }
+
+    }
+
+  }
+
+  for (size_t i = 0; i < m_nets.size (); ++i) {
+    if (name_depth [i] < 0) {
+      m_names [i] = "$" + tl::to_string (i + 1);
+    }
+  }
+}
+
+void
+NetExtractor::net_shapes (size_t i, std::vector<NetTracerShape> &shapes) const
+{
+  m_clusters.collect_shapes (m_nets [i], shapes);
+}
+
+void
+NetExtractor::write_rdb (rdb::Database &rdb) const
+{
+  if (m_clusters.empty ()) {
+    return;
+  }
+
+  const db::Layout &layout = m_clusters.layout ();
+  db::CplxTrans dbu_trans (layout.dbu ());
+
+  rdb.set_top_cell_name (layout.cell_name (m_clusters.cell ().cell_index ()));
+  rdb::Cell *rdb_cell = rdb.create_cell (rdb.top_cell_name ());
+
+  rdb::Category *nets_cat = rdb.create_category ("Nets");
+  nets_cat->set_description (tl::to_string (QObject::tr ("Extracted nets")));
+
+  rdb::Category *shorts_cat = rdb.create_category ("Shorts");
+  shorts_cat->set_description (tl::to_string (QObject::tr ("Nets with more than one label")));
+
+  rdb::Category *opens_cat = rdb.create_category ("Opens");
+  opens_cat->set_description (tl::to_string (QObject::tr ("Labels attached to more than one net")));
+
+  std::map<std::string, std::vector<size_t> > nets_by_label;
+  std::vector<NetTracerShape> shapes;
+
+  for (size_t i = 0; i < m_nets.size (); ++i) {
+
+    rdb::Item *item = rdb.create_item (rdb_cell->id (), nets_cat->id ());
+    item->values ().add (new rdb::Value <std::string> (m_names [i]));
+
+    shapes.clear ();
+    net_shapes (i, shapes);
+
+    for (std::vector<NetTracerShape>::const_iterator s = shapes.begin (); s != shapes.end (); ++s) {
+      db::Polygon p;
+      if (s->shape ().polygon (p)) {
+        item->values ().add (new rdb::Value <db::DPolygon> (p.transformed (dbu_trans * s->trans ())));
+      }
+    }
+
+    const std::set<std::string> &labels = m_labels [i];
+    for (std::set<std::string>::const_iterator l = labels.begin (); l != labels.end (); ++l) {
+      nets_by_label [*l].push_back (i);
+    }
+
+    if (labels.size () > 1) {
+      rdb::Item *short_item = rdb.create_item (rdb_cell->id (), shorts_cat->id ());
+      short_item->values ().add (new rdb::Value <std::string> (tl::sprintf (tl::to_string (QObject::tr ("Net %s has labels: %s")), m_names [i], tl::join (std::vector<std::string> (labels.begin (), labels.end ()), ", "))));
+    }
+
+  }
+
+  for (std::map<std::string, std::vector<size_t> >::const_iterator l = nets_by_label.begin (); l != nets_by_label.end (); ++l) {
+    if (l->second.size () > 1) {
+      rdb::Item *open_item = rdb.create_item (rdb_cell->id (), opens_cat->id ());
+      open_item->values ().add (new rdb::Value <std::string> (tl::sprintf (tl::to_string (QObject::tr ("Label %s is attached to %d nets")), l->first, int (l->second.size ()))));
+    }
+  }
+}
+
+void
+NetExtractor::write_layers (db::Layout &layout, db::Cell &cell) const
+{
+  if (m_clusters.empty ()) {
+    return;
+  }
+
+  const db::Layout &source = m_clusters.layout ();
+  db::ICplxTrans mag (source.dbu () / layout.dbu ());
+
+  std::map<unsigned int, unsigned int> layer_map;
+  tl::ident_map<db::properties_id_type> pm;
+  std::vector<NetTracerShape> shapes;
+
+  for (size_t i = 0; i < m_nets.size (); ++i) {
+
+    shapes.clear ();
+    net_shapes (i, shapes);
+
+    for (std::vector<NetTracerShape>::const_iterator s = shapes.begin (); s != shapes.end (); ++s) {
+
+      std::map<unsigned int, unsigned int>::const_iterator lm = layer_map.find (s->layer ());
+      if (lm == layer_map.end ()) {
+
+        const db::LayerProperties &lp = source.get_properties (s->layer ());
+
+        int layer_index = -1;
+        for (db::Layout::layer_iterator l = layout.begin_layers (); l != layout.end_layers (); ++l) {
+          if ((*l).second->log_equal (lp)) {
+            layer_index = int ((*l).first);
+            break;
+          }
+        }
+
+        if (layer_index < 0) {
+          layer_index = int (layout.insert_layer (lp));
+        }
+
+        lm = layer_map.insert (std::make_pair (s->layer (), (unsigned int) layer_index)).first;
+
+      }
+
+      cell.shapes (lm->second).insert (s->shape (), mag * s->trans (), pm);
+
+      //  label the net at the first vertex of its first shape
+      if (s == shapes.begin ()) {
+        db::Polygon p;
+        if (s->shape ().polygon (p) && p.begin_hull () != p.end_hull ()) {
+          db::Point pt = (mag * s->trans ()) * *p.begin_hull ();
+          cell.shapes (lm->second).insert (db::Text (m_names [i], db::Trans (pt - db::Point ())));
+        }
+      }
+
+    }
+
+  }
+}
+
+}
+
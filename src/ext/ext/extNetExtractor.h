@@ -0,0 +1,195 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+
+#ifndef HDR_extNetExtractor
+#define HDR_extNetExtractor
+
+#include "extCommon.h"
+#include "extNetClusters.h"
+
+#include <vector>
+#include <set>
+#include <string>
+
+namespace rdb
+{
+  class Database;
+}
+
+namespace ext
+{
+
+class NetTracerData;
+class NetTracerShape;
+
+/**
+ *  @brief Extracts all nets of a cell at once
+ *
+ *  The extractor builds the hierarchical cluster database (see NetClusters) and
+ *  derives all nets of the cell from it. Net names are taken from the labels touching
+ *  the net (the one closest to the top cell wins). Nets without a label are named "$<n>".
+ *  Only labels up to a certain hierarchy depth (see set_label_depth) are considered for
+ *  the short and open checks.
+ *
+ *  The nets can be written to a report database or as shapes with labels into a layout.
+ *  Like the cluster database, the extractor does not support connections involving
+ *  computed (boolean) layers.
+ */
+class EXT_PUBLIC NetExtractor
+{
+public:
+  /**
+   *  @brief Constructor
+   */
+  NetExtractor ();
+
+  /**
+   *  @brief Sets the number of worker threads used for building the cluster database
+   */
+  void set_threads (int n)
+  {
+    m_clusters.set_threads (n);
+  }
+
+  /**
+   *  @brief Gets the number of worker threads used for building the cluster database
+   */
+  int threads () const
+  {
+    return m_clusters.threads ();
+  }
+
+  /**
+   *  @brief Sets the hierarchy depth of the labels which are checked for shorts and opens
+   *
+   *  0 (the default) will consider the labels of the top cell only. This way, pin labels 
+   *  of standard cells do not produce shorts or opens. A negative value will consider the 
+   *  labels from all hierarchy levels. The net names are taken from labels of any level.
+   *  This setting becomes effective on "extract".
+   */
+  void set_label_depth (int d)
+  {
+    m_label_depth = d;
+  }
+
+  /**
+   *  @brief Gets the hierarchy depth of the labels which are checked for shorts and opens
+   */
+  int label_depth () const
+  {
+    return m_label_depth;
+  }
+
+  /**
+   *  @brief Extracts the nets of the given cell with the given tracer data
+   *
+   *  Throws an exception if the tracer data involves computed layers.
+   */
+  void extract (const db::Layout &layout, const db::Cell &cell, const NetTracerData &data);
+
+  /**
+   *  @brief Clears the nets
+   */
+  void clear ();
+
+  /**
+   *  @brief Gets the number of nets
+   */
+  size_t size () const
+  {
+    return m_nets.size ();
+  }
+
+  /**
+   *  @brief Gets the name of the net with the given index
+   */
+  const std::string &net_name (size_t i) const
+  {
+    return m_names [i];
+  }
+
+  /**
+   *  @brief Gets the names of all labels attached to the net with the given index
+   *
+   *  Only labels up to the label depth are reported. A net with more than one distinct 
+   *  label indicates a short.
+   */
+  const std::set<std::string> &net_labels (size_t i) const
+  {
+    return m_labels [i];
+  }
+
+  /**
+   *  @brief Gets the cluster reference for the net with the given index
+   */
+  const NetClusterRef &net_ref (size_t i) const
+  {
+    return m_nets [i];
+  }
+
+  /**
+   *  @brief Collects the shapes of the net with the given index
+   */
+  void net_shapes (size_t i, std::vector<NetTracerShape> &shapes) const;
+
+  /**
+   *  @brief Gets the cluster database
+   */
+  const NetClusters &clusters () const
+  {
+    return m_clusters;
+  }
+
+  /**
+   *  @brief Writes the nets to the given report database
+   *
+   *  Each net becomes one item in the "Nets" category. In addition, nets with
+   *  more than one distinct label are reported in the "Shorts" category and labels
+   *  attached to more than one net are reported in the "Opens" category. Only labels
+   *  up to the label depth are considered for shorts and opens.
+   */
+  void write_rdb (rdb::Database &rdb) const;
+
+  /**
+   *  @brief Writes the nets as shapes into the given cell
+   *
+   *  The shapes are written flat into layers with the same layer properties than the
+   *  original ones. Each net receives a text with the net name on the layer of its first shape.
+   */
+  void write_layers (db::Layout &layout, db::Cell &cell) const;
+
+private:
+  NetClusters m_clusters;
+  std::vector<NetClusterRef> m_nets;
+  std::vector<std::string> m_names;
+  std::vector<std::set<std::string> > m_labels;
+  int m_label_depth;
+
+  void assign_labels ();
+};
+
+}
+
+#endif
+
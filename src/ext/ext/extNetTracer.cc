@@ -22,6 +22,7 @@
 
 
 #include "extNetTracer.h"
+#include "extNetClusters.h"
 
 #include "dbRecursiveShapeIterator.h"
 #include "dbPolygonTools.h"
@@ -225,6 +226,27 @@ NetTracerData::log_layers_for (unsigned int original_layer) const
   return log_layers;
 }
 
+std::set<unsigned int> 
+NetTracerData::original_layers () const
+{
+  std::set <unsigned int> original_layers;
+  for (std::map <unsigned int, std::set <unsigned int> >::const_iterator g = m_original_layers.begin (); g != m_original_layers.end (); ++g) {
+    original_layers.insert (g->second.begin (), g->second.end ());
+  }
+  return original_layers;
+}
+
+bool 
+NetTracerData::has_computed_layers () const
+{
+  for (std::map <unsigned int, std::set <unsigned int> >::const_iterator g = m_log_connection_graph.begin (); g != m_log_connection_graph.end (); ++g) {
+    if (! expression (g->first).is_alias ()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 const std::set<unsigned int> &
 NetTracerData::log_connections (unsigned int from_layer) const
 {
@@ -775,6 +797,89 @@ NetTracer::trace (const db::Layout &layout, const db::Cell &cell, const db::Poin
   m_shapes_graph.clear ();
 }
 
+void 
+NetTracer::trace (const NetClusters &clusters, const db::Point &pt_start, unsigned int l_start, const NetTracerData & /*data*/)
+{
+  mp_layout = &clusters.layout ();
+  mp_cell = &clusters.cell ();
+
+  m_shapes_graph.clear ();
+  m_shapes_found.clear ();
+
+  tl::SelfTimer timer (tl::verbosity () >= 11, tl::to_string (QObject::tr ("Net Tracing (clusters)")));
+
+  db::Box seed_box (pt_start - db::Vector (1, 1), pt_start + db::Vector (1, 1));
+
+  std::set<NetClusterRef> refs;
+  clusters.find_clusters (db::Polygon (seed_box), l_start, refs);
+
+  std::vector<NetTracerShape> shapes;
+  for (std::set<NetClusterRef>::const_iterator r = refs.begin (); r != refs.end (); ++r) {
+    clusters.collect_shapes (*r, shapes);
+  }
+
+  m_shapes_found.insert (shapes.begin (), shapes.end ());
+
+  //  Texts are not part of the clusters: add the ones touching a shape of the net on a connected layer
+  //  (or the seed) and derive the net name from them
+
+  db::Box net_box = seed_box;
+  std::set<unsigned int> net_layers;
+  net_layers.insert (l_start);
+
+  HitTestDataBoxTree net_tree;
+  for (std::set<NetTracerShape>::const_iterator s = m_shapes_found.begin (); s != m_shapes_found.end (); ++s) {
+    net_box += s->bbox ();
+    net_layers.insert (s->layer ());
+    net_tree.insert (&*s);
+  }
+  net_tree.sort (HitTestDataBoxConverter ());
+
+  std::set<unsigned int> text_layers;
+  for (db::Layout::layer_iterator l = layout ().begin_layers (); l != layout ().end_layers (); ++l) {
+    for (std::set<unsigned int>::const_iterator nl = net_layers.begin (); nl != net_layers.end (); ++nl) {
+      if (clusters.is_connected (*nl, (*l).first)) {
+        text_layers.insert ((*l).first);
+        break;
+      }
+    }
+  }
+
+  if (text_layers.empty ()) {
+    return;
+  }
+
+  db::RecursiveShapeIterator texts (layout (), cell (), text_layers, net_box);
+  texts.shape_flags (db::ShapeIterator::Texts);
+
+  while (! texts.at_end ()) {
+
+    NetTracerShape text (texts.trans (), texts.shape (), texts.layer (), texts.cell_index ());
+
+    bool interact = clusters.is_connected (l_start, text.layer ()) && interacts (seed_box, text);
+
+    for (HitTestDataBoxTree::touching_iterator s = net_tree.begin_touching (text.bbox (), HitTestDataBoxConverter ()); ! interact && ! s.at_end (); ++s) {
+
+      const NetTracerShape *net_shape = *s;
+      if (clusters.is_connected (net_shape->layer (), text.layer ())) {
+        db::Polygon p;
+        net_shape->shape ().polygon (p);
+        p.transform (db::ICplxTrans (net_shape->trans ()));
+        interact = interacts (p, text);
+      }
+
+    }
+
+    if (interact) {
+      evaluate_text (texts);
+      m_shapes_found.insert (text);
+    }
+
+    ++texts;
+
+  }
+}
+
 void
 NetTracer::compute_results_for_next_iteration (const std::vector <const NetTracerShape *> &new_seeds, unsigned int seed_layer, const std::set<unsigned int> &output_layers, std::set <std::pair<NetTracerShape, const NetTracerShape *> > &current, std::set <std::pair<NetTracerShape, const NetTracerShape *> > &output, const NetTracerData &data)
 {
@@ -47,6 +47,7 @@ namespace ext
 
 class NetTracerLayerElement;
 class NetTracerData;
+class NetClusters;
 
 /**
  *  @brief A shape heap where intermediate shapes can be placed into
@@ -548,6 +549,16 @@ public:
    */
   std::set<unsigned int> log_layers_for (unsigned int original_layer) const;
 
+  /**
+   *  @brief Gets all original layers participating in the connections
+   */
+  std::set<unsigned int> original_layers () const;
+
+  /**
+   *  @brief Returns true, if any of the connected logical layers is computed by a boolean operation
+   */
+  bool has_computed_layers () const;
+
   /**
    *  @brief returns the symbol list
    */
@@ -615,6 +626,15 @@ public:
    */
   void trace (const db::Layout &layout, const db::Cell &cell, const db::Point &pt_start, unsigned int l_start, const db::Point &pt_stop, unsigned int l_stop, const NetTracerData &data);
 
+  /**
+   *  @brief Trace the net starting from the given point/layer seed using a prebuilt cluster database
+   *
+   *  The cluster database must have been built for the layout, the cell and the tracer data.
+   *  This method does not do a flood fill but obtains the net from the clusters hit by the seed.
+   *  It can only be used if the tracer data does not involve computed layers (see NetClusters::is_supported).
+   */
+  void trace (const NetClusters &clusters, const db::Point &pt_start, unsigned int l_start, const NetTracerData &data);
+
   /**
    *  @brief Begin operator for the shapes found
    */
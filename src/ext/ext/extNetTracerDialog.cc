@@ -92,6 +92,8 @@ NetTracerDialog::NetTracerDialog (lay::PluginRoot *root, lay::LayoutView *view)
   connect (sticky_cbx, SIGNAL (clicked ()), this, SLOT (sticky_mode_clicked ()));
 
   view->layer_list_changed_event.add (this, &NetTracerDialog::layer_list_changed);
+  view->cellviews_about_to_change_event.add (this, &NetTracerDialog::layout_changed);
+  view->cellview_about_to_change_event.add (this, &NetTracerDialog::cellview_about_to_change);
 
   update_info ();
 }
@@ -102,6 +104,19 @@ NetTracerDialog::~NetTracerDialog ()
   clear_nets ();
 }
 
+void
+NetTracerDialog::layout_changed ()
+{
+  //  the cluster database refers to the shapes of the layout and needs to be rebuilt
+  m_net_clusters.clear ();
+}
+
+void
+NetTracerDialog::cellview_about_to_change (int /*index*/)
+{
+  m_net_clusters.clear ();
+}
+
 void
 NetTracerDialog::clear_nets ()
 {
@@ -389,6 +404,18 @@ NetTracerDialog::do_trace (const db::DBox &start_search_box, const db::DBox &sto
   try {
     if (trace_path) {
       net_tracer.trace (cv->layout (), *cv.cell (), start_point, start_layer, stop_point, stop_layer, tracer_data);
+    } else if (NetClusters::is_supported (tracer_data)) {
+
+      //  Without computed layers, the nets are taken from the cluster database. This database
+      //  is built once and kept until the layout changes.
+      if (! m_net_clusters.is_valid_for (cv->layout (), *cv.cell (), tracer_data)) {
+        m_net_clusters.build (cv->layout (), *cv.cell (), tracer_data);
+        cv->layout ().hier_changed_event.add (this, &NetTracerDialog::layout_changed);
+        cv->layout ().bboxes_changed_any_event.add (this, &NetTracerDialog::layout_changed);
+      }
+
+      net_tracer.trace (m_net_clusters, start_point, start_layer, tracer_data);
+
     } else {
       net_tracer.trace (cv->layout (), *cv.cell (), start_point, start_layer, tracer_data);
     }
@@ -28,6 +28,7 @@
 #include "ui_NetTracerDialog.h"
 
 #include "extNetTracer.h"
+#include "extNetClusters.h"
 #include "extNetTracerConfig.h"
 
 #include "layBrowser.h"
@@ -104,6 +105,7 @@ private:
   std::string m_export_cell_name;
   lay::FileDialog *mp_export_file_dialog;
   std::string m_export_file_name;
+  NetClusters m_net_clusters;
 
   void update_highlights ();
   void adjust_view ();
@@ -112,6 +114,8 @@ private:
   void update_list ();
   void update_info ();
   void layer_list_changed (int index);
+  void layout_changed ();
+  void cellview_about_to_change (int index);
   void release_mouse ();
   Net *do_trace (const db::DBox &start_search_box, const db::DBox &stop_search_box, bool trace_path);
 };
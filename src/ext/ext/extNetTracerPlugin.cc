@@ -24,8 +24,10 @@
 #include "extNetTracerIO.h"
 #include "extNetTracerDialog.h"
 #include "extNetTracerConfig.h"
+#include "extNetExtractor.h"
 
 #include "layConverters.h"
+#include "rdb.h"
 
 #include "gsiDecl.h"
 
@@ -412,5 +414,126 @@ gsi::Class<ext::NetTracer> decl_NetTracer ("NetTracer",
   "This class has been introduced in version 0.25."
 );
 
+static void extract_tech (ext::NetExtractor *extractor, const ext::NetTracerTechnologyComponent &tech, const db::Layout &layout, const db::Cell &cell)
+{
+  ext::NetTracerData tracer_data = tech.get_tracer_data (layout);
+  extractor->extract (layout, cell, tracer_data);
+}
+
+static void extract_tn (ext::NetExtractor *extractor, const std::string &tech, const db::Layout &layout, const db::Cell &cell)
+{
+  ext::NetTracerData tracer_data = get_tracer_data_from_tech (tech, layout);
+  extractor->extract (layout, cell, tracer_data);
+}
+
+static std::string net_name (const ext::NetExtractor *extractor, size_t index)
+{
+  if (index < extractor->size ()) {
+    return extractor->net_name (index);
+  } else {
+    return std::string ();
+  }
+}
+
+static std::vector<std::string> net_labels (const ext::NetExtractor *extractor, size_t index)
+{
+  std::vector<std::string> labels;
+  if (index < extractor->size ()) {
+    labels.insert (labels.end (), extractor->net_labels (index).begin (), extractor->net_labels (index).end ());
+  }
+  return labels;
 }
 
+static std::vector<ext::NetTracerShape> net_elements (const ext::NetExtractor *extractor, size_t index)
+{
+  std::vector<ext::NetTracerShape> shapes;
+  if (index < extractor->size ()) {
+    extractor->net_shapes (index, shapes);
+  }
+  return shapes;
+}
+
+gsi::Class<ext::NetExtractor> decl_NetExtractor ("NetExtractor",
+  gsi::method_ext ("extract", &extract_tech, gsi::arg ("tech"), gsi::arg ("layout"), gsi::arg ("cell"),
+    "@brief Extracts all nets of the given cell\n"
+    "\n"
+    "@param tech The technology definition\n"
+    "@param layout The layout on which to run the extraction\n"
+    "@param cell The cell on which to run the extraction (child cells will be included)\n"
+    "\n"
+    "The technology must not use boolean expressions for the conductive materials."
+  ) +
+  gsi::method_ext ("extract", &extract_tn, gsi::arg ("tech"), gsi::arg ("layout"), gsi::arg ("cell"),
+    "@brief Extracts all nets of the given cell taking a predefined technology\n"
+    "This method behaves identical as the version with a technology object, except that it will look for a technology "
+    "with the given name to obtain the extraction setup."
+  ) +
+  gsi::method ("threads=", &ext::NetExtractor::set_threads, gsi::arg ("n"),
+    "@brief Sets the number of threads to use for the extraction\n"
+    "The cells of one hierarchy level are processed in parallel. With 0 threads (the default), "
+    "the extraction happens in the calling thread."
+  ) +
+  gsi::method ("threads", &ext::NetExtractor::threads,
+    "@brief Gets the number of threads to use for the extraction\n"
+  ) +
+  gsi::method ("label_depth=", &ext::NetExtractor::set_label_depth, gsi::arg ("depth"),
+    "@brief Sets the hierarchy depth of the labels checked for shorts and opens\n"
+    "With 0 (the default), only the labels of the top cell are considered for the \"Shorts\" and \"Opens\" "
+    "reports and for \\net_labels. This way, pin labels of standard cells do not produce false shorts or opens. "
+    "A negative value will consider the labels of all hierarchy levels. The net names are taken from labels of "
+    "any level. This setting needs to be made before \\extract is called."
+  ) +
+  gsi::method ("label_depth", &ext::NetExtractor::label_depth,
+    "@brief Gets the hierarchy depth of the labels checked for shorts and opens\n"
+  ) +
+  gsi::method ("num_nets", &ext::NetExtractor::size,
+    "@brief Returns the number of nets extracted\n"
+  ) +
+  gsi::method_ext ("net_name", &net_name, gsi::arg ("index"),
+    "@brief Returns the name of the net with the given index\n"
+    "The name is taken from the label closest to the top cell. Nets without a label are named \"$<n>\"."
+  ) +
+  gsi::method_ext ("net_labels", &net_labels, gsi::arg ("index"),
+    "@brief Returns the distinct labels attached to the net with the given index\n"
+    "Only labels up to the label depth (see \\label_depth=) are reported. More than one label indicates a short."
+  ) +
+  gsi::method_ext ("net_elements", &net_elements, gsi::arg ("index"),
+    "@brief Returns the elements of the net with the given index\n"
+  ) +
+  gsi::method ("write_rdb", &ext::NetExtractor::write_rdb, gsi::arg ("rdb"),
+    "@brief Writes the nets to the given report database\n"
+    "Each net becomes one item in the \"Nets\" category. Nets with more than one label are reported in the "
+    "\"Shorts\" category and labels attached to more than one net in the \"Opens\" category."
+  ) +
+  gsi::method ("write_layers", &ext::NetExtractor::write_layers, gsi::arg ("layout"), gsi::arg ("cell"),
+    "@brief Writes the nets into the given cell\n"
+    "The shapes are written flat on layers with the same layer properties than the original ones. "
+    "Each net receives a text with the net name."
+  ) +
+  gsi::method ("clear", &ext::NetExtractor::clear,
+    "@brief Clears the nets\n"
+  ),
+  "@brief The bulk net extraction feature\n"
+  "\n"
+  "While the \\NetTracer extracts a single net from a seed point, the net extractor extracts all nets of a "
+  "cell at once. It builds the connectivity hierarchically, cell by cell, and stitches the nets through the "
+  "instances. The results can be written to a report database or into a layout.\n"
+  "\n"
+  "@code\n"
+  "ly = RBA::CellView::active.layout\n"
+  "\n"
+  "tech = RBA::NetTracerTechnology::new\n"
+  "tech.connection(\"1/0\", \"2/0\", \"3/0\")\n"
+  "\n"
+  "extractor = RBA::NetExtractor::new\n"
+  "extractor.threads = 4\n"
+  "extractor.extract(tech, ly, ly.top_cell)\n"
+  "\n"
+  "rdb = RBA::ReportDatabase::new(\"Nets\")\n"
+  "extractor.write_rdb(rdb)\n"
+  "@/code\n"
+  "\n"
+  "This class has been introduced in version 0.25."
+);
+
+}
@@ -25,6 +25,7 @@
 #include "dbWriter.h"
 #include "dbOASISWriter.h"
 #include "dbGDS2Writer.h"
+#include "dbStatic.h"
 #include "extDEFImporter.h"
 #include "extLEFImporter.h"
 
@@ -33,7 +34,7 @@
 #include <cstdlib>
 #include <QDir>
 
-static void run_test (tl::TestBase *_this, const char *lef_dir, const char *filename, const char *au)
+static void run_test (tl::TestBase *_this, const char *lef_dir, const char *filename, const char *au, bool compact_routing = false, bool editable = db::default_editable_mode ())
 {
   ext::LEFDEFReaderOptions tc;
   tc.set_via_geometry_datatype (0);
@@ -48,10 +49,11 @@ static void run_test (tl::TestBase *_this, const char *lef_dir, const char *file
   tc.set_labels_suffix (".LABEL");
   tc.set_blockages_datatype (4);
   tc.set_blockages_suffix (".BLK");
+  tc.set_compact_routing (compact_routing);
   ext::LEFDEFLayerDelegate ld (&tc);
 
   db::Manager m;
-  db::Layout layout (&m), layout2 (&m), layout_au (&m);
+  db::Layout layout (editable, &m), layout2 (&m), layout_au (&m);
 
   tl::Extractor ex (filename);
 
@@ -235,3 +237,86 @@ TEST(19)
   run_test (_this, "def10", "def:in.def", "au.oas.gz");
 }
 
+
+namespace
+{
+
+class TokenDumper
+  : public ext::LEFDEFImporter
+{
+public:
+  std::string tokens;
+
+protected:
+  virtual void do_read (db::Layout &)
+  {
+    while (! at_end ()) {
+      if (! tokens.empty ()) {
+        tokens += ",";
+      }
+      if (test ("design")) {
+        tokens += "<DESIGN>";
+      } else if (test ("NUM")) {
+        tokens += "D:" + tl::to_string (get_double ());
+      } else if (test ("INT")) {
+        tokens += "L:" + tl::to_string (get_long ());
+      } else {
+        tokens += get ();
+      }
+    }
+  }
+};
+
+}
+
+//  tokenizer
+TEST(20)
+{
+  std::string text = 
+    "# comment\n"
+    "DESIGN  top ;\r\n"
+    "UNITS DISTANCE microns 1000 ;\n"
+    "  num -12 NUM 0.25\tnum 1e3 int -42 \"quoted string\" 'a\\'b' esc\\ aped # another comment\n"
+    "END";
+
+  tl::InputMemoryStream ms (text.c_str (), text.size ());
+  tl::InputStream is (ms);
+
+  db::Layout layout;
+  ext::LEFDEFLayerDelegate ld (0);
+
+  TokenDumper dumper;
+  dumper.read (is, layout, ld);
+
+  EXPECT_EQ (dumper.tokens, "<DESIGN>,top,;,UNITS,DISTANCE,microns,1000,;,D:-12,D:0.25,D:1000,L:-42,quoted string,a'b,esc aped,END");
+
+  //  long input with tokens crossing the buffer boundaries
+  text.clear ();
+  for (int i = 0; i < 20000; ++i) {
+    text += "NEW M1 ( 100 200 ) ;\n";
+  }
+
+  tl::InputMemoryStream ms2 (text.c_str (), text.size ());
+  tl::InputStream is2 (ms2);
+
+  TokenDumper dumper2;
+  dumper2.read (is2, layout, ld);
+
+  EXPECT_EQ (dumper2.tokens.size (), size_t (20000 * 21 - 1));
+  EXPECT_EQ (std::string (dumper2.tokens, 0, 23), "NEW,M1,(,100,200,),;,NE");
+}
+
+//  compact routing must not change the geometry
+TEST(21)
+{
+  run_test (_this, "def7", "lef:cells.lef+lef:tech.lef+def:in.def.gz", "au.oas.gz", true);
+  run_test (_this, "def10", "def:in.def", "au.oas.gz", true);
+}
+
+TEST(22)
+{
+  //  compact routing in non-editable mode produces shape arrays
+  run_test (_this, "def7", "lef:cells.lef+lef:tech.lef+def:in.def.gz", "au.oas.gz", true, false);
+  run_test (_this, "def10", "def:in.def", "au.oas.gz", true, false);
+}
+
@@ -26,10 +26,13 @@
 #include "extNetTracerDialog.h"
 #include "extNetTracerIO.h"
 #include "extNetTracer.h"
+#include "extNetClusters.h"
+#include "extNetExtractor.h"
 #include "dbRecursiveShapeIterator.h"
 #include "dbLayoutDiff.h"
 #include "dbTestSupport.h"
 #include "dbWriter.h"
+#include "rdb.h"
 
 static ext::NetTracerConnectionInfo connection (const std::string &a, const std::string &v, const std::string &b)
 {
@@ -83,6 +86,19 @@ static ext::Net trace (ext::NetTracer &tracer, const db::Layout &layout, const d
   return ext::Net (tracer, db::ICplxTrans (), layout, cell.cell_index (), std::string (), std::string (), tracer_data);
 }
 
+static ext::Net trace_with_clusters (ext::NetTracer &tracer, const db::Layout &layout, const db::Cell &cell, const ext::NetTracerTechnologyComponent &tc, unsigned int l_start, const db::Point &p_start)
+{
+  ext::NetTracerData tracer_data = tc.get_tracer_data (layout);
+  tl_assert (ext::NetClusters::is_supported (tracer_data));
+
+  ext::NetClusters clusters;
+  clusters.build (layout, cell, tracer_data);
+  tl_assert (clusters.is_valid_for (layout, cell, tracer_data));
+
+  tracer.trace (clusters, p_start, l_start, tracer_data);
+  return ext::Net (tracer, db::ICplxTrans (), layout, cell.cell_index (), std::string (), std::string (), tracer_data);
+}
+
 static ext::Net trace (ext::NetTracer &tracer, const db::Layout &layout, const db::Cell &cell, const ext::NetTracerTechnologyComponent &tc, unsigned int l_start, const db::Point &p_start, unsigned int l_stop, const db::Point &p_stop)
 {
   ext::NetTracerData tracer_data = tc.get_tracer_data (layout);
@@ -90,7 +106,7 @@ static ext::Net trace (ext::NetTracer &tracer, const db::Layout &layout, const d
   return ext::Net (tracer, db::ICplxTrans (), layout, cell.cell_index (), std::string (), std::string (), tracer_data);
 }
 
-void run_test (tl::TestBase *_this, const std::string &file, const ext::NetTracerTechnologyComponent &tc, const db::LayerProperties &lp_start, const db::Point &p_start, const std::string &file_au, const char *net_name = 0)
+void run_test (tl::TestBase *_this, const std::string &file, const ext::NetTracerTechnologyComponent &tc, const db::LayerProperties &lp_start, const db::Point &p_start, const std::string &file_au, const char *net_name = 0, bool with_clusters = false)
 {
   db::Manager m;
 
@@ -107,7 +123,8 @@ void run_test (tl::TestBase *_this, const std::string &file, const ext::NetTrace
   const db::Cell &cell = layout_org.cell (*layout_org.begin_top_down ());
 
   ext::NetTracer tracer;
-  ext::Net net = trace (tracer, layout_org, cell, tc, layer_for (layout_org, lp_start), p_start);
+  ext::Net net = with_clusters ? trace_with_clusters (tracer, layout_org, cell, tc, layer_for (layout_org, lp_start), p_start)
+                               : trace (tracer, layout_org, cell, tc, layer_for (layout_org, lp_start), p_start);
 
   if (net_name) {
     EXPECT_EQ (net.name (), std::string (net_name));
@@ -376,3 +393,246 @@ TEST(9)
   run_test (_this, file, tc, db::LayerProperties (8, 0), db::Point (3000, 6800), file_au, "A");
 }
 
+//  cluster database: same results as the flood fill for layer sets without booleans
+TEST(10) 
+{
+  std::string file = "t1.oas.gz";
+  std::string file_au = "t1_net.oas.gz";
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("1/0", "2/0", "3/0"));
+
+  run_test (_this, file, tc, db::LayerProperties (1, 0), db::Point (7000, 1500), file_au, "THE_NAME", true);
+}
+
+TEST(10b) 
+{
+  std::string file = "t1.oas.gz";
+  std::string file_au = "t1b_net.oas.gz";
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("1/0", "2/0", "3/0"));
+
+  //  point is off net ...
+  run_test (_this, file, tc, db::LayerProperties (1, 0), db::Point (7000, 15000), file_au, 0, true);
+}
+
+TEST(10c) 
+{
+  std::string file = "t1.oas.gz";
+  std::string file_au = "t1_net.oas.gz";
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add_symbol (symbol ("a", "1/0"));
+  tc.add_symbol (symbol ("c", "cc"));
+  tc.add_symbol (symbol ("cc", "3/0"));
+  tc.add (connection ("a", "2/0", "cc"));
+
+  run_test (_this, file, tc, db::LayerProperties (1, 0), db::Point (7000, 1500), file_au, "THE_NAME", true);
+}
+
+TEST(10d) 
+{
+  std::string file = "t4.oas.gz";
+  std::string file_au = "t4b_net.oas.gz";
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("1/0", "3/0"));
+
+  run_test (_this, file, tc, db::LayerProperties (1, 0), db::Point (7000, 1500), file_au, "THE_NAME", true);
+}
+
+TEST(10e) 
+{
+  std::string file = "t8.oas.gz";
+  std::string file_au = "t8_net.oas.gz";
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("15", "14", "7"));
+
+  run_test (_this, file, tc, db::LayerProperties (15, 0), db::Point (4000, 10000), file_au, "", true);
+}
+
+TEST(10f) 
+{
+  db::Layout layout;
+  layout.insert_layer (db::LayerProperties (1, 0));
+  layout.insert_layer (db::LayerProperties (2, 0));
+  layout.insert_layer (db::LayerProperties (10, 0));
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("1/0", "2/0"));
+  EXPECT_EQ (ext::NetClusters::is_supported (tc.get_tracer_data (layout)), true);
+
+  //  computed layers require the flood fill
+  tc.add (connection ("1/0*10/0", "2/0"));
+  EXPECT_EQ (ext::NetClusters::is_supported (tc.get_tracer_data (layout)), false);
+}
+
+//  bulk extraction: the net from the seed is among the nets extracted
+TEST(11) 
+{
+  db::Manager m;
+
+  db::Layout layout_org (&m);
+  {
+    std::string fn (tl::testsrc ());
+    fn += "/testdata/net_tracer/t1.oas.gz";
+    tl::InputStream stream (fn);
+    db::Reader reader (stream);
+    reader.read (layout_org);
+  }
+
+  const db::Cell &cell = layout_org.cell (*layout_org.begin_top_down ());
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("1/0", "2/0", "3/0"));
+  ext::NetTracerData tracer_data = tc.get_tracer_data (layout_org);
+
+  ext::NetTracer tracer;
+  tracer.trace (layout_org, cell, db::Point (7000, 1500), layer_for (layout_org, db::LayerProperties (1, 0)), tracer_data);
+
+  std::set<std::pair<unsigned int, db::Polygon> > traced;
+  for (ext::NetTracer::iterator s = tracer.begin (); s != tracer.end (); ++s) {
+    db::Polygon p;
+    if (s->shape ().polygon (p)) {
+      traced.insert (std::make_pair (s->layer (), p.transformed (s->trans ())));
+    }
+  }
+
+  for (int threads = 0; threads < 3; threads += 2) {
+
+    ext::NetExtractor extractor;
+    extractor.set_threads (threads);
+    extractor.extract (layout_org, cell, tracer_data);
+
+    EXPECT_EQ (extractor.size () > 1, true);
+
+    size_t n = 0;
+    for (size_t i = 0; i < extractor.size (); ++i) {
+
+      if (extractor.net_name (i) != "THE_NAME") {
+        continue;
+      }
+
+      ++n;
+
+      std::vector<ext::NetTracerShape> shapes;
+      extractor.net_shapes (i, shapes);
+
+      std::set<std::pair<unsigned int, db::Polygon> > extracted;
+      for (std::vector<ext::NetTracerShape>::const_iterator s = shapes.begin (); s != shapes.end (); ++s) {
+        db::Polygon p;
+        if (s->shape ().polygon (p)) {
+          extracted.insert (std::make_pair (s->layer (), p.transformed (s->trans ())));
+        }
+      }
+
+      EXPECT_EQ (extracted == traced, true);
+
+    }
+
+    EXPECT_EQ (n, size_t (1));
+
+    db::Layout layout_nets;
+    extractor.write_layers (layout_nets, layout_nets.cell (layout_nets.add_cell ("NETS")));
+    EXPECT_EQ (layout_nets.begin_layers () != layout_nets.end_layers (), true);
+
+  }
+}
+
+static std::vector<std::string> rdb_texts (const rdb::Database &rdb, const std::string &category)
+{
+  std::vector<std::string> texts;
+
+  const rdb::Category *cat = rdb.category_by_name (category);
+  if (cat) {
+    for (rdb::Items::const_iterator i = rdb.items ().begin (); i != rdb.items ().end (); ++i) {
+      if (i->category_id () == cat->id ()) {
+        for (rdb::Values::const_iterator v = i->values ().begin (); v != i->values ().end (); ++v) {
+          texts.push_back (v->get ()->to_display_string ());
+        }
+      }
+    }
+  }
+
+  std::sort (texts.begin (), texts.end ());
+  return texts;
+}
+
+//  bulk extraction: shorts and opens from labels of the top cell or all levels
+TEST(12) 
+{
+  db::Layout ly;
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+  ly.insert_layer (db::LayerProperties (2, 0));
+  ly.insert_layer (db::LayerProperties (3, 0));
+
+  //  two standard cells with pin labels
+  db::Cell &a = ly.cell (ly.add_cell ("A"));
+  a.shapes (l1).insert (db::Box (0, 0, 100, 100));
+  a.shapes (l1).insert (db::Text ("A_PIN", db::Trans (db::Vector (50, 50))));
+
+  db::Cell &b = ly.cell (ly.add_cell ("B"));
+  b.shapes (l1).insert (db::Box (0, 0, 100, 100));
+  b.shapes (l1).insert (db::Text ("B_PIN", db::Trans (db::Vector (50, 50))));
+
+  db::Cell &top = ly.cell (ly.add_cell ("TOP"));
+
+  //  a net joining the pins of A and B
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans ()));
+  top.insert (db::CellInstArray (db::CellInst (b.cell_index ()), db::Trans (db::Vector (1000, 0))));
+  top.shapes (l1).insert (db::Box (50, 40, 1050, 60));
+  top.shapes (l1).insert (db::Text ("N1", db::Trans (db::Vector (500, 50))));
+
+  //  an unconnected second instance of A
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (db::Vector (0, 2000))));
+
+  //  a real short
+  top.shapes (l1).insert (db::Box (0, 4000, 1000, 4100));
+  top.shapes (l1).insert (db::Text ("X", db::Trans (db::Vector (10, 4050))));
+  top.shapes (l1).insert (db::Text ("Y", db::Trans (db::Vector (990, 4050))));
+
+  //  a real open
+  top.shapes (l1).insert (db::Box (0, 6000, 100, 6100));
+  top.shapes (l1).insert (db::Text ("Z", db::Trans (db::Vector (50, 6050))));
+  top.shapes (l1).insert (db::Box (1000, 6000, 1100, 6100));
+  top.shapes (l1).insert (db::Text ("Z", db::Trans (db::Vector (1050, 6050))));
+
+  ly.update ();
+
+  ext::NetTracerTechnologyComponent tc;
+  tc.add (connection ("1/0", "2/0", "3/0"));
+  ext::NetTracerData tracer_data = tc.get_tracer_data (ly);
+
+  ext::NetExtractor extractor;
+  EXPECT_EQ (extractor.label_depth (), 0);
+
+  //  by default, only the top cell's labels are checked
+  {
+    extractor.extract (ly, top, tracer_data);
+
+    rdb::Database rdb;
+    extractor.write_rdb (rdb);
+
+    std::vector<std::string> shorts = rdb_texts (rdb, "Shorts");
+    EXPECT_EQ (shorts.size (), size_t (1));
+    EXPECT_EQ (shorts.size () == 1 && shorts.front ().find ("has labels: X, Y") != std::string::npos, true);
+    EXPECT_EQ (tl::join (rdb_texts (rdb, "Opens"), ";"), "Label Z is attached to 2 nets");
+    EXPECT_EQ (rdb_texts (rdb, "Nets").size () > 0, true);
+  }
+
+  //  with all levels, the pin labels produce shorts and opens
+  {
+    extractor.set_label_depth (-1);
+    extractor.extract (ly, top, tracer_data);
+
+    rdb::Database rdb;
+    extractor.write_rdb (rdb);
+
+    std::vector<std::string> shorts = rdb_texts (rdb, "Shorts");
+    EXPECT_EQ (shorts.size (), size_t (2));
+    EXPECT_EQ (shorts.size () == 2 && shorts.front () == "Net N1 has labels: A_PIN, B_PIN, N1", true);
+    EXPECT_EQ (tl::join (rdb_texts (rdb, "Opens"), ";"), "Label A_PIN is attached to 2 nets;Label Z is attached to 2 nets");
+  }
+}
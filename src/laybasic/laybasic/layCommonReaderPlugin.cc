@@ -107,7 +107,8 @@ public:
       tl::make_member (&db::CommonReaderOptions::create_other_layers, "create-other-layers") +
       tl::make_member (&db::CommonReaderOptions::layer_map, "layer-map") +
       tl::make_member (&db::CommonReaderOptions::enable_properties, "enable-properties") +
-      tl::make_member (&db::CommonReaderOptions::enable_text_objects, "enable-text-objects")
+      tl::make_member (&db::CommonReaderOptions::enable_text_objects, "enable-text-objects") +
+      tl::make_member (&db::CommonReaderOptions::update_threads, "update-threads")
     );
   }
 };
@@ -164,6 +165,16 @@ static void set_properties_enabled (db::LoadLayoutOptions *options, bool l)
   options->get_options<db::CommonReaderOptions> ().enable_properties = l;
 }
 
+static int get_update_threads (const db::LoadLayoutOptions *options)
+{
+  return options->get_options<db::CommonReaderOptions> ().update_threads;
+}
+
+static void set_update_threads (db::LoadLayoutOptions *options, int n)
+{
+  options->get_options<db::CommonReaderOptions> ().update_threads = n;
+}
+
 //  extend lay::LoadLayoutOptions with the Common options 
 static
 gsi::ClassExt<db::LoadLayoutOptions> common_reader_options (
@@ -226,6 +237,20 @@ gsi::ClassExt<db::LoadLayoutOptions> common_reader_options (
     "@param enabled True, if properties should be read."
     "\n"
     "Starting with version 0.25 this option only applies to GDS2 and OASIS format. Other formats provide their own configuration."
+  ) +
+  gsi::method_ext ("update_threads=", &set_update_threads, gsi::arg ("threads"),
+    "@brief Specifies the number of threads used for preparing the layout after reading\n"
+    "If this value is larger than 0, the reader configures the target layout to distribute the bounding box computation "
+    "and the sorting of the shape and instance trees over the given number of threads. "
+    "The default is 0 which leaves the layout's setting unchanged.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
+  gsi::method_ext ("update_threads", &get_update_threads,
+    "@brief Gets the number of threads used for preparing the layout after reading\n"
+    "See \\update_threads= for details.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
   ),
   ""
 );
@@ -0,0 +1,384 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layDensityPyramid.h"
+#include "dbPolygonTools.h"
+#include "dbBoxConvert.h"
+
+#include <limits>
+
+namespace lay
+{
+
+// -------------------------------------------------------------
+//  DensityPyramid implementation
+
+DensityPyramid::DensityPyramid ()
+  : m_weight (0)
+{
+  for (unsigned int i = 0; i < max_resolution; ++i) {
+    m_rows [i] = 0;
+  }
+}
+
+DensityPyramid::DensityPyramid (const db::Box &box)
+  : m_box (box), m_weight (0)
+{
+  for (unsigned int i = 0; i < max_resolution; ++i) {
+    m_rows [i] = 0;
+  }
+}
+
+void
+DensityPyramid::add_weight (size_t w)
+{
+  if (w > std::numeric_limits<size_t>::max () - m_weight) {
+    m_weight = std::numeric_limits<size_t>::max ();
+  } else {
+    m_weight += w;
+  }
+}
+
+bool
+DensityPyramid::empty () const
+{
+  for (unsigned int i = 0; i < max_resolution; ++i) {
+    if (m_rows [i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+DensityPyramid::is_set (unsigned int ix, unsigned int iy, unsigned int resolution) const
+{
+  unsigned int f = max_resolution / resolution;
+
+  uint64_t mask = (f >= 64 ? ~uint64_t (0) : ((uint64_t (1) << f) - 1)) << (ix * f);
+  for (unsigned int i = iy * f; i < (iy + 1) * f; ++i) {
+    if ((m_rows [i] & mask) != 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+db::Coord
+DensityPyramid::grid_x (unsigned int i, unsigned int resolution) const
+{
+  return m_box.left () + db::Coord ((int64_t (m_box.width ()) * int64_t (i)) / int64_t (resolution));
+}
+
+db::Coord
+DensityPyramid::grid_y (unsigned int i, unsigned int resolution) const
+{
+  return m_box.bottom () + db::Coord ((int64_t (m_box.height ()) * int64_t (i)) / int64_t (resolution));
+}
+
+static unsigned int
+tile_index (db::Coord c, db::Coord c0, db::Box::distance_type size, unsigned int resolution)
+{
+  if (c <= c0 || size == 0) {
+    return 0;
+  }
+  int64_t i = (int64_t (c - c0) * int64_t (resolution)) / int64_t (size);
+  return i >= int64_t (resolution) ? resolution - 1 : (unsigned int) i;
+}
+
+std::pair<unsigned int, unsigned int>
+DensityPyramid::tile_range_x (db::Coord x1, db::Coord x2) const
+{
+  return std::make_pair (tile_index (x1, m_box.left (), m_box.width (), max_resolution), tile_index (x2, m_box.left (), m_box.width (), max_resolution));
+}
+
+std::pair<unsigned int, unsigned int>
+DensityPyramid::tile_range_y (db::Coord y1, db::Coord y2) const
+{
+  return std::make_pair (tile_index (y1, m_box.bottom (), m_box.height (), max_resolution), tile_index (y2, m_box.bottom (), m_box.height (), max_resolution));
+}
+
+void
+DensityPyramid::mark (const db::Box &b)
+{
+  db::Box bb = b & m_box;
+  if (bb.empty ()) {
+    return;
+  }
+
+  std::pair<unsigned int, unsigned int> rx = tile_range_x (bb.left (), bb.right ());
+  std::pair<unsigned int, unsigned int> ry = tile_range_y (bb.bottom (), bb.top ());
+
+  unsigned int n = rx.second - rx.first + 1;
+  uint64_t mask = (n >= 64 ? ~uint64_t (0) : ((uint64_t (1) << n) - 1)) << rx.first;
+  for (unsigned int i = ry.first; i <= ry.second; ++i) {
+    m_rows [i] |= mask;
+  }
+}
+
+void
+DensityPyramid::mark (const db::Polygon &poly)
+{
+  db::Box bb = poly.box () & m_box;
+  if (bb.empty ()) {
+    return;
+  }
+
+  std::pair<unsigned int, unsigned int> rx = tile_range_x (bb.left (), bb.right ());
+  std::pair<unsigned int, unsigned int> ry = tile_range_y (bb.bottom (), bb.top ());
+
+  //  small polygons and boxes are represented by their bounding box
+  if (poly.is_box () || (rx.second - rx.first < 2 && ry.second - ry.first < 2)) {
+    mark (bb);
+    return;
+  }
+
+  for (unsigned int iy = ry.first; iy <= ry.second; ++iy) {
+    for (unsigned int ix = rx.first; ix <= rx.second; ++ix) {
+      if ((m_rows [iy] & (uint64_t (1) << ix)) == 0 && db::interact (poly, tile (ix, iy))) {
+        m_rows [iy] |= (uint64_t (1) << ix);
+      }
+    }
+  }
+}
+
+db::Box
+DensityPyramid::tile (unsigned int ix, unsigned int iy, unsigned int resolution) const
+{
+  return db::Box (grid_x (ix, resolution), grid_y (iy, resolution), grid_x (ix + 1, resolution), grid_y (iy + 1, resolution));
+}
+
+std::vector<db::Box>
+DensityPyramid::boxes (unsigned int resolution) const
+{
+  std::vector<db::Box> res;
+
+  for (unsigned int iy = 0; iy < resolution; ++iy) {
+    for (unsigned int ix = 0; ix < resolution; ) {
+      if (is_set (ix, iy, resolution)) {
+        unsigned int ix0 = ix;
+        while (ix < resolution && is_set (ix, iy, resolution)) {
+          ++ix;
+        }
+        res.push_back (db::Box (grid_x (ix0, resolution), grid_y (iy, resolution), grid_x (ix, resolution), grid_y (iy + 1, resolution)));
+      } else {
+        ++ix;
+      }
+    }
+  }
+
+  return res;
+}
+
+unsigned int
+DensityPyramid::resolution_for (double size)
+{
+  unsigned int r = 1;
+  while (r < max_resolution && double (r) < size) {
+    r *= 2;
+  }
+  return r;
+}
+
+double
+DensityPyramid::tile_size () const
+{
+  return double (std::max (m_box.width (), m_box.height ())) / double (max_resolution);
+}
+
+// -------------------------------------------------------------
+//  DensityPyramidCache implementation
+
+DensityPyramidCache::DensityPyramidCache ()
+{
+  //  .. nothing yet ..
+}
+
+const DensityPyramid &
+DensityPyramidCache::get (const db::Layout &layout, db::cell_index_type ci, unsigned int layer)
+{
+  key_type key (&layout, std::make_pair (layer, ci));
+
+  {
+    QMutexLocker locker (&m_lock);
+    pyramid_map::const_iterator p = m_pyramids.find (key);
+    if (p != m_pyramids.end ()) {
+      return p->second;
+    }
+  }
+
+  //  NOTE: the pyramid is built outside the lock, so other threads are not blocked.
+  //  If another thread has built the same pyramid in the meantime, we'll use that one.
+  DensityPyramid pyramid = build (layout, ci, layer);
+
+  QMutexLocker locker (&m_lock);
+  return m_pyramids.insert (std::make_pair (key, pyramid)).first->second;
+}
+
+size_t
+DensityPyramidCache::weight (const db::Layout &layout, db::cell_index_type ci, unsigned int layer)
+{
+  key_type key (&layout, std::make_pair (layer, ci));
+
+  {
+    QMutexLocker locker (&m_lock);
+    weight_map::const_iterator w = m_weights.find (key);
+    if (w != m_weights.end ()) {
+      return w->second;
+    }
+  }
+
+  size_t w = compute_weight (layout, ci, layer);
+
+  QMutexLocker locker (&m_lock);
+  m_weights.insert (std::make_pair (key, w));
+  return w;
+}
+
+size_t
+DensityPyramidCache::compute_weight (const db::Layout &layout, db::cell_index_type ci, unsigned int layer)
+{
+  const db::Cell &cell = layout.cell (ci);
+  if (cell.bbox (layer).empty ()) {
+    return 0;
+  }
+
+  const size_t max_weight = std::numeric_limits<size_t>::max ();
+
+  size_t w = cell.shapes (layer).size ();
+
+  for (db::Cell::const_iterator inst = cell.begin (); ! inst.at_end (); ++inst) {
+
+    const db::CellInstArray &cell_inst = inst->cell_inst ();
+
+    size_t cw = weight (layout, cell_inst.object ().cell_index (), layer);
+    size_t n = cell_inst.size ();
+    if (cw > 0 && n > max_weight / cw) {
+      return max_weight;
+    } else if (n * cw > max_weight - w) {
+      return max_weight;
+    }
+    w += n * cw;
+
+  }
+
+  return w;
+}
+
+void
+DensityPyramidCache::clear ()
+{
+  QMutexLocker locker (&m_lock);
+  m_pyramids.clear ();
+  m_weights.clear ();
+}
+
+size_t
+DensityPyramidCache::size () const
+{
+  QMutexLocker locker (&m_lock);
+  return m_pyramids.size ();
+}
+
+DensityPyramid
+DensityPyramidCache::build (const db::Layout &layout, db::cell_index_type ci, unsigned int layer)
+{
+  const db::Cell &cell = layout.cell (ci);
+
+  DensityPyramid p (cell.bbox (layer));
+  if (p.box ().empty ()) {
+    return p;
+  }
+
+  double tile = std::max (1.0, p.tile_size ());
+
+  //  the shapes of the cell
+  const db::Shapes &shapes = cell.shapes (layer);
+  for (db::ShapeIterator s = shapes.begin (db::ShapeIterator::Boxes | db::ShapeIterator::Polygons | db::ShapeIterator::Paths | db::ShapeIterator::Edges); ! s.at_end (); ++s) {
+
+    p.add_weight (1);
+
+    db::Box sb = s->bbox ();
+    if ((s->is_polygon () || s->is_simple_polygon () || s->is_path ()) && (sb.width () > 2 * tile || sb.height () > 2 * tile)) {
+      db::Polygon poly;
+      s->polygon (poly);
+      p.mark (poly);
+    } else {
+      p.mark (sb);
+    }
+
+  }
+
+  //  the child cells
+  db::box_convert <db::CellInst> bc (layout, layer);
+
+  for (db::Cell::const_iterator inst = cell.begin (); ! inst.at_end (); ++inst) {
+
+    const db::CellInstArray &cell_inst = inst->cell_inst ();
+
+    const DensityPyramid &cp = get (layout, cell_inst.object ().cell_index (), layer);
+    if (cp.empty ()) {
+      continue;
+    }
+
+    size_t n = cell_inst.size ();
+    if (cp.weight () > 0 && n > std::numeric_limits<size_t>::max () / cp.weight ()) {
+      p.add_weight (std::numeric_limits<size_t>::max ());
+    } else {
+      p.add_weight (n * cp.weight ());
+    }
+
+    //  use a child level whose tiles are about the size of our tiles
+    db::Box child_box = cell_inst.complex_trans () * cp.box ();
+    unsigned int r = DensityPyramid::resolution_for (double (std::max (child_box.width (), child_box.height ())) / tile);
+
+    db::Vector a, b;
+    unsigned long na = 1, nb = 1;
+    bool dense = (n == 1 || (cell_inst.is_regular_array (a, b, na, nb) && (na <= 1 || a.double_length () <= tile) && (nb <= 1 || b.double_length () <= tile)));
+
+    if (r == 1 && dense) {
+
+      //  instances smaller than a tile and densely packed: mark the whole array
+      p.mark (cell_inst.bbox (bc));
+
+    } else {
+
+      std::vector<db::Box> child_boxes = cp.boxes (r);
+
+      for (db::CellInstArray::iterator i = cell_inst.begin (); ! i.at_end (); ++i) {
+        db::ICplxTrans t (cell_inst.complex_trans (*i));
+        for (std::vector<db::Box>::const_iterator cb = child_boxes.begin (); cb != child_boxes.end (); ++cb) {
+          p.mark (t * *cb);
+        }
+      }
+
+    }
+
+  }
+
+  return p;
+}
+
+}
+
@@ -0,0 +1,215 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#ifndef HDR_layDensityPyramid
+#define HDR_layDensityPyramid
+
+#include "laybasicCommon.h"
+
+#include "dbBox.h"
+#include "dbPolygon.h"
+#include "dbLayout.h"
+
+#include <QMutex>
+
+#include <map>
+#include <vector>
+#include <stdint.h>
+
+namespace lay
+{
+
+/**
+ *  @brief The coverage pyramid of a cell on a layer
+ *
+ *  The pyramid divides the bounding box of the cell on the layer into a grid of
+ *  max_resolution x max_resolution tiles and records, which tiles are covered by
+ *  shapes (of the cell or its children). Coarser levels with 2^n x 2^n tiles are
+ *  derived from that grid: a tile of a coarser level is covered, if any of the
+ *  finer tiles is covered.
+ *
+ *  The redraw thread uses the pyramid to render cells whose projected size is
+ *  small: instead of visiting all shapes, it just draws the covered tiles.
+ *
+ *  In addition, the pyramid records the "weight" of the cell, which is the number
+ *  of shapes drawn (hierarchically) when the cell is rendered.
+ */
+class LAYBASIC_PUBLIC DensityPyramid
+{
+public:
+  /**
+   *  @brief The number of tiles per dimension on the finest level
+   */
+  static const unsigned int max_resolution = 64;
+
+  /**
+   *  @brief Default constructor: creates an empty pyramid
+   */
+  DensityPyramid ();
+
+  /**
+   *  @brief Creates an empty pyramid for the given box
+   */
+  DensityPyramid (const db::Box &box);
+
+  /**
+   *  @brief Gets the box covered by the grid
+   */
+  const db::Box &box () const
+  {
+    return m_box;
+  }
+
+  /**
+   *  @brief Gets the weight (the number of shapes represented by the pyramid)
+   */
+  size_t weight () const
+  {
+    return m_weight;
+  }
+
+  /**
+   *  @brief Adds to the weight
+   *
+   *  The weight saturates at the maximum value of size_t.
+   */
+  void add_weight (size_t w);
+
+  /**
+   *  @brief Returns true, if no tile is covered
+   */
+  bool empty () const;
+
+  /**
+   *  @brief Tests whether a tile is covered
+   *
+   *  @param ix The column of the tile (0..resolution-1)
+   *  @param iy The row of the tile (0..resolution-1)
+   *  @param resolution The resolution of the level (a power of 2 up to max_resolution)
+   */
+  bool is_set (unsigned int ix, unsigned int iy, unsigned int resolution = max_resolution) const;
+
+  /**
+   *  @brief Marks the tiles covered by the given box as covered
+   */
+  void mark (const db::Box &b);
+
+  /**
+   *  @brief Marks the tiles covered by the given polygon as covered
+   */
+  void mark (const db::Polygon &poly);
+
+  /**
+   *  @brief Gets the box of the given tile
+   */
+  db::Box tile (unsigned int ix, unsigned int iy, unsigned int resolution = max_resolution) const;
+
+  /**
+   *  @brief Gets the covered area of the given level as a set of boxes
+   *
+   *  Adjacent covered tiles of one row are combined into a single box.
+   */
+  std::vector<db::Box> boxes (unsigned int resolution) const;
+
+  /**
+   *  @brief Gets the resolution for a certain projected size (in tiles)
+   *
+   *  This is the smallest power of 2 which is equal or larger than the size,
+   *  limited to max_resolution.
+   */
+  static unsigned int resolution_for (double size);
+
+  /**
+   *  @brief Gets the size of a tile on the finest level (the larger dimension)
+   */
+  double tile_size () const;
+
+private:
+  db::Box m_box;
+  size_t m_weight;
+  uint64_t m_rows [max_resolution];
+
+  db::Coord grid_x (unsigned int i, unsigned int resolution) const;
+  db::Coord grid_y (unsigned int i, unsigned int resolution) const;
+  std::pair<unsigned int, unsigned int> tile_range_x (db::Coord x1, db::Coord x2) const;
+  std::pair<unsigned int, unsigned int> tile_range_y (db::Coord y1, db::Coord y2) const;
+};
+
+/**
+ *  @brief A cache for the density pyramids of the cells of layouts
+ *
+ *  The pyramids are built lazily when they are requested first. Building the
+ *  pyramid of a cell will build the pyramids of the child cells as well.
+ *  The cache is thread-safe. Pyramids delivered by "get" remain valid until
+ *  the cache is cleared. "clear" must be called when the layout has changed
+ *  and only if no other thread is using the cache.
+ */
+class LAYBASIC_PUBLIC DensityPyramidCache
+{
+public:
+  /**
+   *  @brief Constructor
+   */
+  DensityPyramidCache ();
+
+  /**
+   *  @brief Gets the pyramid for the given cell and layer
+   */
+  const DensityPyramid &get (const db::Layout &layout, db::cell_index_type ci, unsigned int layer);
+
+  /**
+   *  @brief Gets the weight of the given cell on the given layer
+   *
+   *  The weight is the number of shapes (of any kind) drawn when the cell is rendered
+   *  hierarchically. It is much cheaper to compute than the pyramid and cached separately,
+   *  so it can be used to decide whether building the pyramid is worth the effort.
+   */
+  size_t weight (const db::Layout &layout, db::cell_index_type ci, unsigned int layer);
+
+  /**
+   *  @brief Clears the cache
+   */
+  void clear ();
+
+  /**
+   *  @brief Gets the number of pyramids stored
+   */
+  size_t size () const;
+
+private:
+  typedef std::pair<const db::Layout *, std::pair<unsigned int, db::cell_index_type> > key_type;
+  typedef std::map<key_type, DensityPyramid> pyramid_map;
+  typedef std::map<key_type, size_t> weight_map;
+
+  mutable QMutex m_lock;
+  pyramid_map m_pyramids;
+  weight_map m_weights;
+
+  DensityPyramid build (const db::Layout &layout, db::cell_index_type ci, unsigned int layer);
+  size_t compute_weight (const db::Layout &layout, db::cell_index_type ci, unsigned int layer);
+};
+
+}
+
+#endif
+
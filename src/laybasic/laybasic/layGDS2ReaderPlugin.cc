@@ -105,7 +105,8 @@ public:
     return new lay::ReaderOptionsXMLElement<db::GDS2ReaderOptions> ("gds2",
       tl::make_member (&db::GDS2ReaderOptions::box_mode, "box-mode") +
       tl::make_member (&db::GDS2ReaderOptions::allow_big_records, "allow-big-records") +
-      tl::make_member (&db::GDS2ReaderOptions::allow_multi_xy_records, "allow-multi-xy-records")
+      tl::make_member (&db::GDS2ReaderOptions::allow_multi_xy_records, "allow-multi-xy-records") +
+      tl::make_member (&db::GDS2ReaderOptions::read_threads, "read-threads")
     );
   }
 };
@@ -145,6 +146,16 @@ static bool get_gds2_allow_big_records (const db::LoadLayoutOptions *options)
   return options->get_options<db::GDS2ReaderOptions> ().allow_big_records;
 }
 
+static void set_gds2_read_threads (db::LoadLayoutOptions *options, int n)
+{
+  options->get_options<db::GDS2ReaderOptions> ().read_threads = n;
+}
+
+static int get_gds2_read_threads (const db::LoadLayoutOptions *options)
+{
+  return options->get_options<db::GDS2ReaderOptions> ().read_threads;
+}
+
 //  extend lay::LoadLayoutOptions with the GDS2 options 
 static
 gsi::ClassExt<db::LoadLayoutOptions> gds2_reader_options (
@@ -183,6 +194,19 @@ gsi::ClassExt<db::LoadLayoutOptions> gds2_reader_options (
     "@brief Gets a value specifying whether to allow big records with a length of 32768 to 65535 bytes.\n"
     "See \\gds2_allow_big_records= method for a description of this property."
     "\nThis property has been added in version 0.18.\n"
+  ) +
+  gsi::method_ext ("gds2_read_threads=", &set_gds2_read_threads,
+    "@brief Sets the number of threads to use for decoding the cells of a GDS2 file\n"
+    "@args n\n"
+    "If this value is larger than 0, the cell bodies are decoded on the given number of threads. "
+    "This is possible for uncompressed local files only. Otherwise the file is read sequentially. "
+    "The default value is 0 (sequential reading).\n"
+    "\nThis property has been added in version 0.25.\n"
+  ) +
+  gsi::method_ext ("gds2_read_threads", &get_gds2_read_threads,
+    "@brief Gets the number of threads to use for decoding the cells of a GDS2 file\n"
+    "See \\gds2_read_threads= method for a description of this property."
+    "\nThis property has been added in version 0.25.\n"
   ),
   ""
 );
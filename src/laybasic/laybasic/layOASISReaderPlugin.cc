@@ -56,10 +56,50 @@ public:
   {
     return new db::OASISReaderOptions ();
   }
+
+  virtual tl::XMLElementBase *xml_element () const
+  {
+    return new lay::ReaderOptionsXMLElement<db::OASISReaderOptions> ("oasis",
+      tl::make_member (&db::OASISReaderOptions::read_threads, "read-threads")
+    );
+  }
 };
 
 static tl::RegisteredClass<lay::PluginDeclaration> plugin_decl (new lay::OASISReaderPluginDeclaration (), 10000, "OASISReader");
 
+// ---------------------------------------------------------------
+//  gsi Implementation of specific methods
+
+static void set_oasis_read_threads (db::LoadLayoutOptions *options, int n)
+{
+  options->get_options<db::OASISReaderOptions> ().read_threads = n;
+}
+
+static int get_oasis_read_threads (const db::LoadLayoutOptions *options)
+{
+  return options->get_options<db::OASISReaderOptions> ().read_threads;
+}
+
+//  extend lay::LoadLayoutOptions with the OASIS options 
+static
+gsi::ClassExt<db::LoadLayoutOptions> oasis_reader_options (
+  gsi::method_ext ("oasis_read_threads=", &set_oasis_read_threads,
+    "@brief Sets the number of threads to use for decoding the cells of an OASIS file\n"
+    "@args n\n"
+    "If this value is larger than 0, the cell bodies are decoded on the given number of threads. "
+    "This is possible for strict-mode files which provide the S_CELL_OFFSET properties and for "
+    "uncompressed local files only. Otherwise the file is read sequentially. "
+    "The default value is 0 (sequential reading).\n"
+    "\nThis property has been added in version 0.25.\n"
+  ) +
+  gsi::method_ext ("oasis_read_threads", &get_oasis_read_threads,
+    "@brief Gets the number of threads to use for decoding the cells of an OASIS file\n"
+    "See \\oasis_read_threads= method for a description of this property."
+    "\nThis property has been added in version 0.25.\n"
+  ),
+  ""
+);
+
 }
 
 
@@ -125,6 +125,7 @@ public:
     return new lay::WriterOptionsXMLElement<db::OASISWriterOptions> ("oasis",
       tl::make_member (&db::OASISWriterOptions::compression_level, "compression-level") +
       tl::make_member (&db::OASISWriterOptions::write_cblocks, "write-cblocks") +
+      tl::make_member (&db::OASISWriterOptions::cblock_threads, "cblock-threads") +
       tl::make_member (&db::OASISWriterOptions::strict_mode, "strict-mode") +
       tl::make_member (&db::OASISWriterOptions::write_std_properties, "write-std-properties") +
       tl::make_member (&db::OASISWriterOptions::subst_char, "subst-char")
@@ -197,6 +198,16 @@ static bool get_oasis_write_cblocks (const db::SaveLayoutOptions *options)
   return options->get_options<db::OASISWriterOptions> ().write_cblocks;
 }
 
+static void set_oasis_cblock_threads (db::SaveLayoutOptions *options, int n)
+{
+  options->get_options<db::OASISWriterOptions> ().cblock_threads = n;
+}
+
+static int get_oasis_cblock_threads (const db::SaveLayoutOptions *options)
+{
+  return options->get_options<db::OASISWriterOptions> ().cblock_threads;
+}
+
 static void set_oasis_strict_mode (db::SaveLayoutOptions *options, bool f)
 {
   options->get_options<db::OASISWriterOptions> ().strict_mode = f;
@@ -228,6 +239,23 @@ gsi::ClassExt<db::SaveLayoutOptions> oasis_writer_options (
   gsi::method_ext ("oasis_write_cblocks?", &get_oasis_write_cblocks,
     "@brief Gets a value indicating whether to write compressed CBLOCKS per cell\n"
   ) +
+  gsi::method_ext ("oasis_cblock_threads=", &set_oasis_cblock_threads,
+    "@brief Sets the number of threads to use for compressing CBLOCKS\n"
+    "@args n\n"
+    "If this value is larger than 0 and CBLOCKS are written (see \\oasis_write_cblocks=), the "
+    "compression of the CBLOCKS runs on the given number of threads. The output is identical to "
+    "the single-threaded case. The default value is 0 (compression in the writer's thread).\n"
+    "\n"
+    "Setting this property clears all format specific options for other formats such as GDS.\n"
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
+  gsi::method_ext ("oasis_cblock_threads", &get_oasis_cblock_threads,
+    "@brief Gets the number of threads to use for compressing CBLOCKS\n"
+    "See \\oasis_cblock_threads= method for a description of this property."
+    "\n"
+    "This method has been introduced in version 0.25."
+  ) +
   gsi::method_ext ("oasis_strict_mode=", &set_oasis_strict_mode,
     "@brief Sets a value indicating whether to write strict-mode OASIS files\n"
     "@args flag\n"
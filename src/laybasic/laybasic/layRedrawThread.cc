@@ -68,6 +68,10 @@ void RedrawThread::layout_changed ()
 
   //  if something changed on the layouts we observe, stop the redraw thread
   stop ();
+
+  //  and drop the cached cell bitmaps and density pyramids which may not be valid anymore
+  m_cell_bitmap_cache.clear ();
+  m_density_pyramid_cache.clear ();
 }
 
 void
@@ -184,6 +188,13 @@ RedrawThread::start (int workers, const std::vector <lay::RedrawLayerInfo> &laye
 
   m_last_center = new_region.center ();
 
+  //  a forced redraw indicates a change of the layout or the drawing setup: in this case,
+  //  the cached cell bitmaps and density pyramids can't be used any longer
+  if (force_redraw) {
+    m_cell_bitmap_cache.clear ();
+    m_density_pyramid_cache.clear ();
+  }
+
   std::vector<int> restart;
   do_start (true, shift_vector, &layers, restart, workers);
 }
@@ -195,6 +206,9 @@ RedrawThread::restart (const std::vector<int> &restart)
   m_redraw_regions.push_back (db::Box (db::Point (0, 0), db::Point (m_width, m_height)));
   m_valid_region = m_stored_region = db::DBox ();
 
+  //  the layers to redraw have changed, so their cached cell bitmaps are no longer valid
+  m_cell_bitmap_cache.invalidate_layers (restart);
+
   do_start (false, 0, 0, restart, -1);
 }
 
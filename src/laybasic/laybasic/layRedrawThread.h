@@ -39,6 +39,7 @@
 #include "layLayoutView.h"
 #include "layRedrawThreadCanvas.h"
 #include "layRedrawLayerInfo.h"
+#include "layRedrawThreadWorker.h"
 #include "layCanvasPlane.h"
 #include "tlTimer.h"
 #include "tlThreadedWorkers.h"
@@ -83,6 +84,28 @@ public:
 
   void task_finished (int id);
 
+  /**
+   *  @brief Gets the cell bitmap cache shared by the workers
+   *
+   *  This cache persists over redraws. It is cleared when the layout changes or
+   *  a full redraw is requested.
+   */
+  CellBitmapCache &cell_bitmap_cache ()
+  {
+    return m_cell_bitmap_cache;
+  }
+
+  /**
+   *  @brief Gets the density pyramid cache shared by the workers
+   *
+   *  The pyramids are used to draw small cells with many shapes quickly. The
+   *  cache is cleared when the layout changes or a full redraw is requested.
+   */
+  DensityPyramidCache &density_pyramid_cache ()
+  {
+    return m_density_pyramid_cache;
+  }
+
 protected:
   tl::Worker *create_worker ();
   void setup_worker (tl::Worker *worker);
@@ -124,6 +147,8 @@ private:
   QWaitCondition m_initial_wait_cond;
 
   std::auto_ptr<tl::SelfTimer> m_main_timer;
+  CellBitmapCache m_cell_bitmap_cache;
+  DensityPyramidCache m_density_pyramid_cache;
 };
 
 }
@@ -30,6 +30,168 @@ namespace lay
 //  time delay until the first snapshot is taken
 const int first_snapshot_delay = 20;
 
+//  the minimum number of shapes a cell must represent for drawing it from the density pyramid
+const size_t density_pyramid_min_weight = 1000;
+
+// -------------------------------------------------------------
+//  CellCacheInfo implementation
+
+static size_t 
+bitmap_memory (const lay::Bitmap *bm)
+{
+  return bm ? size_t ((bm->width () + 31) / 32) * sizeof (uint32_t) * size_t (bm->height ()) : 0;
+}
+
+size_t 
+CellCacheInfo::memory () const
+{
+  return sizeof (CellCacheInfo) + bitmap_memory (fill) + bitmap_memory (frame) + bitmap_memory (vertex) + bitmap_memory (text);
+}
+
+// -------------------------------------------------------------
+//  CellBitmapCache implementation
+
+CellBitmapCache::CellBitmapCache (size_t max_memory)
+  : m_max_memory (max_memory), m_memory (0)
+{
+  //  .. nothing yet ..
+}
+
+CellBitmapCache::~CellBitmapCache ()
+{
+  clear ();
+}
+
+void 
+CellBitmapCache::set_max_memory (size_t max_memory)
+{
+  QMutexLocker locker (&m_lock);
+  m_max_memory = max_memory;
+  shrink ();
+}
+
+size_t 
+CellBitmapCache::memory () const
+{
+  QMutexLocker locker (&m_lock);
+  return m_memory;
+}
+
+size_t 
+CellBitmapCache::size () const
+{
+  QMutexLocker locker (&m_lock);
+  return m_cache.size ();
+}
+
+const CellCacheInfo *
+CellBitmapCache::acquire (const CellCacheKey &key)
+{
+  QMutexLocker locker (&m_lock);
+
+  cache_map_t::iterator e = m_cache.find (key);
+  if (e == m_cache.end ()) {
+    return 0;
+  }
+
+  //  renew the life time
+  m_lru.splice (m_lru.end (), m_lru, e->second.lru);
+
+  ++e->second.users;
+  ++e->second.info->hits;
+  return e->second.info;
+}
+
+const CellCacheInfo *
+CellBitmapCache::insert (const CellCacheKey &key, CellCacheInfo *info)
+{
+  QMutexLocker locker (&m_lock);
+
+  std::pair<cache_map_t::iterator, bool> e = m_cache.insert (std::make_pair (key, Entry ()));
+  if (! e.second) {
+    delete info;
+  } else {
+    e.first->second.info = info;
+    e.first->second.memory = info->memory ();
+    e.first->second.lru = m_lru.insert (m_lru.end (), key);
+    m_entry_by_info.insert (std::make_pair (info, e.first));
+    m_memory += e.first->second.memory;
+  }
+
+  ++e.first->second.users;
+  ++e.first->second.info->hits;
+
+  shrink ();
+
+  return e.first->second.info;
+}
+
+void 
+CellBitmapCache::release (const CellCacheInfo *info)
+{
+  QMutexLocker locker (&m_lock);
+
+  std::map<const CellCacheInfo *, cache_map_t::iterator>::iterator i = m_entry_by_info.find (info);
+  if (i != m_entry_by_info.end ()) {
+    --i->second->second.users;
+    shrink ();
+  }
+}
+
+void 
+CellBitmapCache::clear ()
+{
+  QMutexLocker locker (&m_lock);
+
+  for (cache_map_t::iterator e = m_cache.begin (); e != m_cache.end (); ++e) {
+    delete e->second.info;
+  }
+
+  m_cache.clear ();
+  m_entry_by_info.clear ();
+  m_lru.clear ();
+  m_memory = 0;
+}
+
+void 
+CellBitmapCache::invalidate_layers (const std::vector<int> &layers)
+{
+  QMutexLocker locker (&m_lock);
+
+  std::set<int> ls (layers.begin (), layers.end ());
+
+  for (cache_map_t::iterator e = m_cache.begin (); e != m_cache.end (); ) {
+    cache_map_t::iterator ee = e;
+    ++e;
+    if (ls.find (ee->first.layer) != ls.end ()) {
+      erase (ee);
+    }
+  }
+}
+
+void 
+CellBitmapCache::erase (cache_map_t::iterator e)
+{
+  m_memory -= e->second.memory;
+  m_lru.erase (e->second.lru);
+  m_entry_by_info.erase (e->second.info);
+  delete e->second.info;
+  m_cache.erase (e);
+}
+
+void 
+CellBitmapCache::shrink ()
+{
+  //  drop the least recently used entries which are not in use currently
+  for (std::list<CellCacheKey>::iterator l = m_lru.begin (); l != m_lru.end () && m_memory > m_max_memory; ) {
+    cache_map_t::iterator e = m_cache.find (*l);
+    ++l;
+    if (e != m_cache.end () && e->second.users == 0) {
+      erase (e);
+    }
+  }
+}
+
 // -------------------------------------------------------------
 //  RedrawThreadWorker implementation 
 
@@ -38,6 +200,11 @@ RedrawThreadWorker::RedrawThreadWorker (RedrawThread *redraw_thread)
 {
   mp_layout = 0;
   mp_cell_var_cache = 0;
+  mp_cell_bitmap_cache = 0;
+  mp_density_pyramid_cache = 0;
+  m_layer_id = 0;
+  m_vp_fraction_x = 0;
+  m_vp_fraction_y = 0;
   m_cache_hits = 0;
   m_cache_misses = 0;
   m_cv_index = -1;
@@ -93,7 +260,6 @@ RedrawThreadWorker::perform_task (tl::Task *task)
     return;
   }
 
-  m_cell_cache.clear ();
   m_mi_cache.clear ();
   m_mi_text_cache.clear ();
 
@@ -101,6 +267,7 @@ RedrawThreadWorker::perform_task (tl::Task *task)
   m_to_level = m_to_level_default;
 
   int task_id = redraw_thread_task->id ();
+  m_layer_id = task_id;
 
   if (task_id >= 0) {
 
@@ -444,15 +611,10 @@ RedrawThreadWorker::perform_task (tl::Task *task)
   transfer ();
   m_buffers.clear ();
 
-  if (tl::verbosity () >= 30) {
-    for (cell_cache_t::iterator cc = m_cell_cache.begin(); cc != m_cell_cache.end (); ++cc) {
-      tl::info << "Cell cache: " << mp_layout->cell_name(cc->first.ci) << " (" << cc->first.nlevels << ":" << cc->first.trans.to_string() << ") " 
-               << cc->second.fill->width() << " x " << cc->second.fill->height() << " -> " << cc->second.hits << " hits";
-    }
+  if (tl::verbosity () >= 30 && mp_cell_bitmap_cache) {
+    tl::info << "Cell cache: " << mp_cell_bitmap_cache->size () << " entries, " << mp_cell_bitmap_cache->memory () << " bytes";
   }
 
-  m_cell_cache.clear ();
-
   mp_redraw_thread->task_finished (task_id);
 }
 
@@ -477,6 +639,14 @@ RedrawThreadWorker::setup (LayoutView *view, RedrawThreadCanvas *canvas, const s
   m_redraw_region = redraw_region;
   m_vp_trans = vp_trans;
 
+  //  the cached cell bitmaps are pixel-aligned, so they can only be reused if the viewport 
+  //  has the same sub-pixel displacement (1/16 pixel resolution)
+  mp_cell_bitmap_cache = &mp_redraw_thread->cell_bitmap_cache ();
+  mp_density_pyramid_cache = &mp_redraw_thread->density_pyramid_cache ();
+  db::DVector vp_disp = vp_trans.disp ();
+  m_vp_fraction_x = int (floor ((vp_disp.x () - floor (vp_disp.x ())) * 16.0 + 0.5)) % 16;
+  m_vp_fraction_y = int (floor ((vp_disp.y () - floor (vp_disp.y ())) * 16.0 + 0.5)) % 16;
+
   mp_canvas = canvas;
 
   mp_drawings.clear ();
@@ -1750,6 +1920,27 @@ private:
   lay::CanvasPlane *mp_text;
 };
 
+bool
+RedrawThreadWorker::can_use_density_pyramid (const db::Cell &cell, const db::DBox &dbbox, int level, int to_level)
+{
+  //  the pyramid represents the full hierarchy without property selection, hidden cells or abstract mode
+  if (! mp_density_pyramid_cache || mp_prop_sel || m_abstract_mode_width > 0) {
+    return false;
+  }
+  if (m_cv_index < int (m_hidden_cells.size ()) && ! m_hidden_cells [m_cv_index].empty ()) {
+    return false;
+  }
+  if (std::max (dbbox.width (), dbbox.height ()) > double (DensityPyramid::max_resolution)) {
+    return false;
+  }
+  if (level + int (cell.hierarchy_levels ()) >= to_level) {
+    return false;
+  }
+
+  //  NOTE: the weight is a cheap estimate - the pyramid is only built for cells which are heavy enough
+  return mp_density_pyramid_cache->weight (*mp_layout, cell.cell_index (), m_layer) >= density_pyramid_min_weight;
+}
+
 void
 RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_type ci, const db::CplxTrans &trans, const db::Box &vp, int level,
                                 lay::CanvasPlane *fill, lay::CanvasPlane *frame, lay::CanvasPlane *vertex, lay::CanvasPlane *text, const UpdateSnapshotCallback *update_snapshot)
@@ -1804,6 +1995,15 @@ RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_typ
         mp_renderer->draw (dbbox, 0, frame, vertex, 0);
       } 
 
+    } else if (can_use_density_pyramid (cell, dbbox, level, to_level)) {
+
+      //  small, but heavy cells: draw the covered tiles of the density pyramid instead of the shapes
+      const DensityPyramid &pyramid = mp_density_pyramid_cache->get (*mp_layout, ci, m_layer);
+      std::vector<db::Box> boxes = pyramid.boxes (DensityPyramid::resolution_for (std::max (dbbox.width (), dbbox.height ())));
+      for (std::vector<db::Box>::const_iterator b = boxes.begin (); b != boxes.end (); ++b) {
+        mp_renderer->draw (*b, trans, fill, frame, 0, 0);
+      }
+
     } else {
 
       //  create a set of boxes to look into
@@ -1835,44 +2035,49 @@ RedrawThreadWorker::draw_layer (int from_level, int to_level, db::cell_index_typ
         trans_wo_disp.disp (db::DVector ());
 
         //  if we have the cell cached, use the cached bitmap
-        CellCacheKey key (to_level - level, ci, trans_wo_disp);
-        cell_cache_t::iterator cached_cell = m_cell_cache.find (key);
-        if (cached_cell == m_cell_cache.end ()) {
+        CellCacheKey key (m_layer_id, m_vp_fraction_x, m_vp_fraction_y, to_level - level, ci, trans_wo_disp);
+        const CellCacheInfo *cached_cell = mp_cell_bitmap_cache->acquire (key);
+        if (! cached_cell) {
 
-          //  put the cell into the cache
-          cached_cell = m_cell_cache.insert (std::make_pair (key, CellCacheInfo ())).first;
+          //  draw the cell into a new cache entry
+          //  HINT: the entry is put into the cache only when it is complete - if the drawing
+          //  gets interrupted, the auto_ptr will clean up.
+          std::auto_ptr<CellCacheInfo> new_cell (new CellCacheInfo ());
 
           db::DBox cell_box_trans = trans_wo_disp * cell_bbox;
 
           //  Hint: this rounding scheme guarantees a integer-pixel shift vector at least for the first instance
           db::DPoint d = cell_box_trans.lower_left () + trans.disp ();
           d = db::DPoint (floor (d.x ()), floor (d.y ()));
-          cached_cell->second.offset = d - trans.disp ();
+          new_cell->offset = d - trans.disp ();
           db::CplxTrans drawing_trans = trans_wo_disp;
-          drawing_trans.disp (db::DPoint () - cached_cell->second.offset);
+          drawing_trans.disp (db::DPoint () - new_cell->offset);
 
           int width = int (cell_box_trans.width () + 3);    //  +3 = one pixel for a one-pixel frame at both sides and one for safety
           int height = int (cell_box_trans.height () + 3);
 
-          cached_cell->second.fill   = new lay::Bitmap (width, height, 1.0);
-          cached_cell->second.frame  = new lay::Bitmap (width, height, 1.0);
-          cached_cell->second.vertex = new lay::Bitmap (width, height, 1.0);
-          cached_cell->second.text   = new lay::Bitmap (width, height, 1.0);
+          new_cell->fill   = new lay::Bitmap (width, height, 1.0);
+          new_cell->frame  = new lay::Bitmap (width, height, 1.0);
+          new_cell->vertex = new lay::Bitmap (width, height, 1.0);
+          new_cell->text   = new lay::Bitmap (width, height, 1.0);
 
           //  this object is responsible for doing updates when a snapshot is taken
-          UpdateSnapshotWithCache update_cached_snapshot (update_snapshot, &trans, &cached_cell->second, fill, frame, vertex, text);
+          UpdateSnapshotWithCache update_cached_snapshot (update_snapshot, &trans, new_cell.get (), fill, frame, vertex, text);
 
-          draw_layer_wo_cache (from_level, to_level, ci, drawing_trans, vv, level, cached_cell->second.fill, cached_cell->second.frame, cached_cell->second.vertex, cached_cell->second.text, &update_cached_snapshot);
+          draw_layer_wo_cache (from_level, to_level, ci, drawing_trans, vv, level, new_cell->fill, new_cell->frame, new_cell->vertex, new_cell->text, &update_cached_snapshot);
+
+          cached_cell = mp_cell_bitmap_cache->insert (key, new_cell.release ());
 
         }
-        cached_cell->second.hits++;
 
-        db::Point t = db::Point (cached_cell->second.offset + trans.disp ());
+        db::Point t = db::Point (cached_cell->offset + trans.disp ());
+
+        copy_bitmap(cached_cell->fill,   dynamic_cast<lay::Bitmap *> (fill),   t.x (), t.y ());
+        copy_bitmap(cached_cell->frame,  dynamic_cast<lay::Bitmap *> (frame),  t.x (), t.y ());
+        copy_bitmap(cached_cell->vertex, dynamic_cast<lay::Bitmap *> (vertex), t.x (), t.y ());
+        copy_bitmap(cached_cell->text,   dynamic_cast<lay::Bitmap *> (text),   t.x (), t.y ());
 
-        copy_bitmap(cached_cell->second.fill,   dynamic_cast<lay::Bitmap *> (fill),   t.x (), t.y ());
-        copy_bitmap(cached_cell->second.frame,  dynamic_cast<lay::Bitmap *> (frame),  t.x (), t.y ());
-        copy_bitmap(cached_cell->second.vertex, dynamic_cast<lay::Bitmap *> (vertex), t.x (), t.y ());
-        copy_bitmap(cached_cell->second.text,   dynamic_cast<lay::Bitmap *> (text),   t.x (), t.y ());
+        mp_cell_bitmap_cache->release (cached_cell);
 
       } else {
         draw_layer_wo_cache (from_level, to_level, ci, trans, vv, level, fill, frame, vertex, text, update_snapshot);
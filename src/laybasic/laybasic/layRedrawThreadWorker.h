@@ -24,13 +24,19 @@
 #ifndef HDR_layRedrawThreadWorker
 #define HDR_layRedrawThreadWorker
 
+#include "laybasicCommon.h"
+#include "layDensityPyramid.h"
+
 #include "dbLayout.h"
 #include "layLayoutView.h"
 #include "tlThreadedWorkers.h"
 #include "tlTimer.h"
 
+#include <QMutex>
+
 #include <memory>
 #include <map>
+#include <list>
 #include <vector>
 #include <set>
 
@@ -94,16 +100,27 @@ private:
 struct CellCacheKey 
 {
 public:
-  CellCacheKey (int n, db::cell_index_type c, const db::CplxTrans &t) 
-    : nlevels (n), ci (c), trans (t)
+  CellCacheKey (int l, int x, int y, int n, db::cell_index_type c, const db::CplxTrans &t) 
+    : layer (l), fx (x), fy (y), nlevels (n), ci (c), trans (t)
   { }
 
+  int layer;
+  int fx, fy;
   int nlevels;
   db::cell_index_type ci;
   db::CplxTrans trans;
 
   bool operator< (const CellCacheKey &other) const
   {
+    if (layer != other.layer) {
+      return layer < other.layer;
+    }
+    if (fx != other.fx) {
+      return fx < other.fx;
+    }
+    if (fy != other.fy) {
+      return fy < other.fy;
+    }
     if (nlevels != other.nlevels) {
       return nlevels < other.nlevels;
     }
@@ -120,7 +137,7 @@ public:
 /**
  *  @brief An value in the drawing cache
  */
-struct CellCacheInfo 
+struct LAYBASIC_PUBLIC CellCacheInfo 
 {
 public:
   CellCacheInfo ()
@@ -139,11 +156,124 @@ public:
     text = 0;
   }
 
+  /**
+   *  @brief Gets the (approximate) memory used by the bitmaps in bytes
+   */
+  size_t memory () const;
+
   size_t hits;
   db::DPoint offset;
   lay::Bitmap *fill, *frame, *vertex, *text;
 };
 
+/**
+ *  @brief The cell variant bitmap cache shared by the redraw workers
+ *
+ *  The cache holds the bitmaps of cell variants keyed by layer, viewport fraction,
+ *  hierarchy depth, cell and transformation (which includes the resolution). It lives 
+ *  as long as the redraw thread and hence survives individual redraws: when panning or 
+ *  toggling layers, cell variants drawn before are taken from the cache.
+ *  The cache is memory-bounded: when the memory limit is exceeded, the least 
+ *  recently used entries are dropped.
+ *
+ *  The cache is thread-safe. Entries delivered by "acquire" or "insert" are locked
+ *  against removal until they are handed back with "release". "clear" and "invalidate_layers"
+ *  must only be called while no redraw is in progress.
+ */
+class LAYBASIC_PUBLIC CellBitmapCache
+{
+public:
+  /**
+   *  @brief Constructor
+   *
+   *  @param max_memory The memory limit in bytes
+   */
+  CellBitmapCache (size_t max_memory = 64 * 1024 * 1024);
+
+  /**
+   *  @brief Destructor
+   */
+  ~CellBitmapCache ();
+
+  /**
+   *  @brief Sets the memory limit in bytes
+   */
+  void set_max_memory (size_t max_memory);
+
+  /**
+   *  @brief Gets the memory limit in bytes
+   */
+  size_t max_memory () const
+  {
+    return m_max_memory;
+  }
+
+  /**
+   *  @brief Gets the memory currently used in bytes
+   */
+  size_t memory () const;
+
+  /**
+   *  @brief Gets the number of entries
+   */
+  size_t size () const;
+
+  /**
+   *  @brief Looks up an entry
+   *
+   *  Returns 0 if there is no such entry. Otherwise the entry is locked and needs to be released.
+   */
+  const CellCacheInfo *acquire (const CellCacheKey &key);
+
+  /**
+   *  @brief Inserts a new entry
+   *
+   *  The cache takes over the ownership of the info object. The entry returned 
+   *  is locked and needs to be released. If there already is an entry with that key,
+   *  the new one is discarded and the existing one is returned.
+   */
+  const CellCacheInfo *insert (const CellCacheKey &key, CellCacheInfo *info);
+
+  /**
+   *  @brief Releases an entry delivered by acquire or insert
+   */
+  void release (const CellCacheInfo *info);
+
+  /**
+   *  @brief Removes all entries
+   */
+  void clear ();
+
+  /**
+   *  @brief Removes all entries for the given layers
+   */
+  void invalidate_layers (const std::vector<int> &layers);
+
+private:
+  struct Entry
+  {
+    Entry ()
+      : info (0), memory (0), users (0)
+    { }
+
+    CellCacheInfo *info;
+    size_t memory;
+    int users;
+    std::list<CellCacheKey>::iterator lru;
+  };
+
+  typedef std::map<CellCacheKey, Entry> cache_map_t;
+
+  mutable QMutex m_lock;
+  cache_map_t m_cache;
+  std::map<const CellCacheInfo *, cache_map_t::iterator> m_entry_by_info;
+  std::list<CellCacheKey> m_lru;
+  size_t m_max_memory, m_memory;
+
+  void erase (cache_map_t::iterator e);
+  void shrink ();
+};
+
 /**
  *  @brief A callback class which is triggered when a snapshot is taken
  */
@@ -162,7 +292,6 @@ class RedrawThreadWorker
   : public tl::Worker
 {
 public:
-  typedef std::map<CellCacheKey, CellCacheInfo> cell_cache_t;
   typedef std::map<std::pair<db::cell_index_type, unsigned int>, bool> micro_instance_cache_t;
 
   RedrawThreadWorker (RedrawThread *redraw_thread);
@@ -190,6 +319,7 @@ private:
   void iterate_variants (const std::vector <db::Box> &redraw_regions, db::cell_index_type ci, db::CplxTrans trans, void (RedrawThreadWorker::*what) (bool, db::cell_index_type ci, const db::CplxTrans &, const db::Box &, int level));
   void iterate_variants_rec (const std::vector <db::Box> &redraw_regions, db::cell_index_type ci, const db::CplxTrans &trans, int level, void (RedrawThreadWorker::*what) (bool, db::cell_index_type ci, const db::CplxTrans &, const db::Box &, int level), bool spread);
   bool cell_var_cached (db::cell_index_type ci, const db::CplxTrans &trans);
+  bool can_use_density_pyramid (const db::Cell &cell, const db::DBox &dbbox, int level, int to_level);
   bool drop_cell (const db::Cell &cell, const db::CplxTrans &trans);
   std::vector<db::Box> search_regions (const db::Box &cell_bbox, const db::Box &vp, int level);
   bool any_shapes (db::cell_index_type cell_index, unsigned int levels);
@@ -223,7 +353,10 @@ private:
   bool m_child_context_enabled;
 
   micro_instance_cache_t m_mi_cache, m_mi_text_cache, m_mi_cell_box_cache;
-  cell_cache_t m_cell_cache;
+  CellBitmapCache *mp_cell_bitmap_cache;
+  DensityPyramidCache *mp_density_pyramid_cache;
+  int m_layer_id;
+  int m_vp_fraction_x, m_vp_fraction_y;
   std::set <std::pair <db::CplxTrans, db::cell_index_type>, lay::CellVariantCacheCompare> *mp_cell_var_cache;
   unsigned int m_cache_hits, m_cache_misses;
   std::set <std::pair <db::DCplxTrans, int> > m_box_variants;
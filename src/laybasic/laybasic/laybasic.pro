@@ -109,6 +109,7 @@ SOURCES = \
   layConfigurationDialog.cc \
   layConverters.cc \
   layCursor.cc \
+  layDensityPyramid.cc \
   layDialogs.cc \
   layDisplayState.cc \
   layDitherPattern.cc \
@@ -203,6 +204,7 @@ HEADERS = \
   layConfigurationDialog.h \
   layConverters.h \
   layCursor.h \
+  layDensityPyramid.h \
   layDialogs.h \
   layDisplayState.h \
   layDitherPattern.h \
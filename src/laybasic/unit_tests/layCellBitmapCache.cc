@@ -0,0 +1,135 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layRedrawThreadWorker.h"
+#include "layBitmap.h"
+#include "tlUnitTest.h"
+
+static lay::CellCacheInfo *
+make_info (unsigned int w, unsigned int h)
+{
+  lay::CellCacheInfo *info = new lay::CellCacheInfo ();
+  info->fill = new lay::Bitmap (w, h, 1.0);
+  info->frame = new lay::Bitmap (w, h, 1.0);
+  info->vertex = new lay::Bitmap (w, h, 1.0);
+  info->text = new lay::Bitmap (w, h, 1.0);
+  return info;
+}
+
+static lay::CellCacheKey 
+make_key (int layer, db::cell_index_type ci, double mag = 1.0)
+{
+  return lay::CellCacheKey (layer, 0, 0, 1, ci, db::CplxTrans (mag));
+}
+
+TEST(1)
+{
+  lay::CellBitmapCache cache;
+
+  EXPECT_EQ (cache.size (), size_t (0));
+  EXPECT_EQ (cache.memory (), size_t (0));
+  EXPECT_EQ (cache.acquire (make_key (0, 1)) == 0, true);
+
+  lay::CellCacheInfo *info = make_info (64, 10);
+  const lay::CellCacheInfo *ci = cache.insert (make_key (0, 1), info);
+  EXPECT_EQ (ci == info, true);
+  EXPECT_EQ (cache.size (), size_t (1));
+  EXPECT_EQ (cache.memory (), info->memory ());
+  cache.release (ci);
+
+  //  the key covers layer, cell and transformation
+  EXPECT_EQ (cache.acquire (make_key (1, 1)) == 0, true);
+  EXPECT_EQ (cache.acquire (make_key (0, 2)) == 0, true);
+  EXPECT_EQ (cache.acquire (make_key (0, 1, 2.0)) == 0, true);
+  EXPECT_EQ (cache.acquire (lay::CellCacheKey (0, 8, 0, 1, 1, db::CplxTrans ())) == 0, true);
+
+  ci = cache.acquire (make_key (0, 1));
+  EXPECT_EQ (ci == info, true);
+  EXPECT_EQ (ci->hits, size_t (2));
+  cache.release (ci);
+
+  //  inserting the same key again delivers the existing entry
+  ci = cache.insert (make_key (0, 1), make_info (64, 10));
+  EXPECT_EQ (ci == info, true);
+  EXPECT_EQ (cache.size (), size_t (1));
+  cache.release (ci);
+
+  cache.clear ();
+  EXPECT_EQ (cache.size (), size_t (0));
+  EXPECT_EQ (cache.memory (), size_t (0));
+}
+
+TEST(2)
+{
+  //  memory limit and LRU
+  std::auto_ptr<lay::CellCacheInfo> proto (make_info (320, 100));
+  size_t mem = proto->memory ();
+
+  lay::CellBitmapCache cache (mem * 3);
+
+  for (db::cell_index_type i = 0; i < 3; ++i) {
+    cache.release (cache.insert (make_key (0, i), make_info (320, 100)));
+  }
+  EXPECT_EQ (cache.size (), size_t (3));
+
+  //  renew cell 0, so cell 1 is the oldest one now
+  cache.release (cache.acquire (make_key (0, 0)));
+
+  cache.release (cache.insert (make_key (0, 3), make_info (320, 100)));
+  EXPECT_EQ (cache.size (), size_t (3));
+  EXPECT_EQ (cache.memory () <= mem * 3, true);
+  EXPECT_EQ (cache.acquire (make_key (0, 1)) == 0, true);
+
+  //  entries in use are not removed
+  const lay::CellCacheInfo *locked = cache.acquire (make_key (0, 2));
+  EXPECT_EQ (locked != 0, true);
+  cache.set_max_memory (0);
+  EXPECT_EQ (cache.size (), size_t (1));
+  cache.release (locked);
+  EXPECT_EQ (cache.size (), size_t (0));
+}
+
+TEST(3)
+{
+  //  layer invalidation
+  lay::CellBitmapCache cache;
+
+  for (int l = 0; l < 4; ++l) {
+    cache.release (cache.insert (make_key (l, 1), make_info (64, 10)));
+    cache.release (cache.insert (make_key (l, 2), make_info (64, 10)));
+  }
+  EXPECT_EQ (cache.size (), size_t (8));
+
+  std::vector<int> layers;
+  layers.push_back (1);
+  layers.push_back (3);
+  cache.invalidate_layers (layers);
+
+  EXPECT_EQ (cache.size (), size_t (4));
+  EXPECT_EQ (cache.acquire (make_key (1, 1)) == 0, true);
+  EXPECT_EQ (cache.acquire (make_key (3, 2)) == 0, true);
+
+  const lay::CellCacheInfo *ci = cache.acquire (make_key (2, 2));
+  EXPECT_EQ (ci != 0, true);
+  cache.release (ci);
+}
@@ -0,0 +1,175 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "layDensityPyramid.h"
+#include "dbLayout.h"
+#include "tlUnitTest.h"
+
+#include <limits>
+
+static std::string
+boxes2string (const std::vector<db::Box> &boxes)
+{
+  std::string s;
+  for (std::vector<db::Box>::const_iterator b = boxes.begin (); b != boxes.end (); ++b) {
+    if (! s.empty ()) {
+      s += ";";
+    }
+    s += b->to_string ();
+  }
+  return s;
+}
+
+static unsigned int
+count_tiles (const lay::DensityPyramid &p, unsigned int resolution)
+{
+  unsigned int n = 0;
+  for (unsigned int iy = 0; iy < resolution; ++iy) {
+    for (unsigned int ix = 0; ix < resolution; ++ix) {
+      if (p.is_set (ix, iy, resolution)) {
+        ++n;
+      }
+    }
+  }
+  return n;
+}
+
+TEST(1)
+{
+  EXPECT_EQ (lay::DensityPyramid::resolution_for (0.5), (unsigned int) 1);
+  EXPECT_EQ (lay::DensityPyramid::resolution_for (1.0), (unsigned int) 1);
+  EXPECT_EQ (lay::DensityPyramid::resolution_for (3.0), (unsigned int) 4);
+  EXPECT_EQ (lay::DensityPyramid::resolution_for (16.5), (unsigned int) 32);
+  EXPECT_EQ (lay::DensityPyramid::resolution_for (1000.0), (unsigned int) 64);
+
+  lay::DensityPyramid p (db::Box (0, 0, 6400, 6400));
+  EXPECT_EQ (p.empty (), true);
+  EXPECT_EQ (p.tile_size (), 100.0);
+  EXPECT_EQ (p.tile (1, 2).to_string (), "(100,200;200,300)");
+  EXPECT_EQ (p.tile (1, 0, 2).to_string (), "(3200,0;6400,3200)");
+
+  p.mark (db::Box (10, 10, 290, 90));
+  EXPECT_EQ (p.empty (), false);
+  EXPECT_EQ (p.is_set (0, 0), true);
+  EXPECT_EQ (p.is_set (2, 0), true);
+  EXPECT_EQ (p.is_set (3, 0), false);
+  EXPECT_EQ (p.is_set (0, 1), false);
+  EXPECT_EQ (boxes2string (p.boxes (64)), "(0,0;300,100)");
+  EXPECT_EQ (boxes2string (p.boxes (4)), "(0,0;1600,1600)");
+  EXPECT_EQ (boxes2string (p.boxes (1)), "(0,0;6400,6400)");
+
+  //  outside boxes are ignored
+  p.mark (db::Box (-1000, -1000, -10, -10));
+  EXPECT_EQ (count_tiles (p, 64), (unsigned int) 3);
+
+  p.add_weight (10);
+  p.add_weight (5);
+  EXPECT_EQ (p.weight (), size_t (15));
+  p.add_weight (std::numeric_limits<size_t>::max ());
+  EXPECT_EQ (p.weight (), std::numeric_limits<size_t>::max ());
+}
+
+TEST(2)
+{
+  //  a diagonal triangle only marks the tiles it touches
+  lay::DensityPyramid p (db::Box (0, 0, 6400, 6400));
+
+  db::Point pts[] = { db::Point (0, 0), db::Point (6400, 6400), db::Point (6400, 6350) };
+  db::Polygon poly;
+  poly.assign_hull (pts, pts + sizeof (pts) / sizeof (pts[0]));
+  p.mark (poly);
+
+  EXPECT_EQ (p.is_set (0, 0), true);
+  EXPECT_EQ (p.is_set (32, 32), true);
+  EXPECT_EQ (p.is_set (63, 63), true);
+  EXPECT_EQ (p.is_set (0, 63), false);
+  EXPECT_EQ (p.is_set (63, 0), false);
+  EXPECT_EQ (count_tiles (p, 64) < 64 * 3, true);
+  EXPECT_EQ (p.is_set (0, 0, 2), true);
+  EXPECT_EQ (p.is_set (1, 1, 2), true);
+}
+
+TEST(3)
+{
+  db::Layout ly;
+  unsigned int l1 = ly.insert_layer (db::LayerProperties (1, 0));
+
+  db::Cell &a = ly.cell (ly.add_cell ("A"));
+  a.shapes (l1).insert (db::Box (0, 0, 100, 100));
+  a.shapes (l1).insert (db::Box (20, 20, 80, 80));
+
+  //  a sparse array: pitch is larger than the tiles of TOP
+  db::Cell &top = ly.cell (ly.add_cell ("TOP"));
+  top.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (), db::Vector (1000, 0), db::Vector (0, 1000), 10, 10));
+
+  //  a dense array: pitch is smaller than the tiles of TOP2
+  db::Cell &top2 = ly.cell (ly.add_cell ("TOP2"));
+  top2.insert (db::CellInstArray (db::CellInst (a.cell_index ()), db::Trans (), db::Vector (50, 0), db::Vector (0, 50), 1000, 1000));
+
+  ly.update ();
+
+  lay::DensityPyramidCache cache;
+
+  //  the weights are available without building the pyramids
+  EXPECT_EQ (cache.weight (ly, a.cell_index (), l1), size_t (2));
+  EXPECT_EQ (cache.weight (ly, top.cell_index (), l1), size_t (200));
+  EXPECT_EQ (cache.weight (ly, top2.cell_index (), l1), size_t (2000000));
+  EXPECT_EQ (cache.size (), size_t (0));
+
+  const lay::DensityPyramid &pa = cache.get (ly, a.cell_index (), l1);
+  EXPECT_EQ (pa.weight (), size_t (2));
+  EXPECT_EQ (pa.box ().to_string (), "(0,0;100,100)");
+  EXPECT_EQ (cache.size (), size_t (1));
+
+  const lay::DensityPyramid &pt = cache.get (ly, top.cell_index (), l1);
+  EXPECT_EQ (pt.weight (), size_t (200));
+  EXPECT_EQ (pt.box ().to_string (), "(0,0;9100,9100)");
+  EXPECT_EQ (cache.size (), size_t (2));
+
+  //  one tile per instance, the gaps remain empty
+  EXPECT_EQ (count_tiles (pt, 64), (unsigned int) 100);
+  EXPECT_EQ (pt.is_set (0, 0), true);
+  EXPECT_EQ (pt.is_set (3, 0), false);
+  EXPECT_EQ (pt.is_set (7, 7), true);
+  EXPECT_EQ (count_tiles (pt, 1), (unsigned int) 1);
+
+  const lay::DensityPyramid &pt2 = cache.get (ly, top2.cell_index (), l1);
+  EXPECT_EQ (pt2.weight (), size_t (2000000));
+  EXPECT_EQ (count_tiles (pt2, 64), (unsigned int) (64 * 64));
+  EXPECT_EQ (boxes2string (pt2.boxes (1)), "(0,0;50050,50050)");
+
+  //  the pyramids are cached
+  EXPECT_EQ (&cache.get (ly, top.cell_index (), l1) == &pt, true);
+
+  cache.clear ();
+  EXPECT_EQ (cache.size (), size_t (0));
+
+  //  empty layer
+  unsigned int l2 = ly.insert_layer (db::LayerProperties (2, 0));
+  ly.update ();
+  const lay::DensityPyramid &pe = cache.get (ly, top.cell_index (), l2);
+  EXPECT_EQ (pe.empty (), true);
+  EXPECT_EQ (pe.weight (), size_t (0));
+  EXPECT_EQ (cache.weight (ly, top.cell_index (), l2), size_t (0));
+}
+
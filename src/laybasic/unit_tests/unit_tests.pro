@@ -10,6 +10,8 @@ SOURCES = \
   layAnnotationShapes.cc \
   layBitmap.cc \
   layBitmapsToImage.cc \
+  layCellBitmapCache.cc \
+  layDensityPyramid.cc \
   layLayerProperties.cc \
   layParsedLayerSource.cc \
   layRenderer.cc \
@@ -44,49 +44,147 @@ namespace gsi
 // ---------------------------------------------------------------
 //  Utilities
 
+/**
+ *  @brief An iterator over a container with random access which works by index
+ *
+ *  Items and values are kept in contiguous storage, so adding items or values 
+ *  invalidates the plain iterators. Scripts may do so while iterating. Hence this
+ *  iterator keeps the container and the index. The end iterator is taken when the 
+ *  iteration starts, so elements added while iterating are not delivered.
+ */
+template <class C>
+class IndexedIterator
+{
+public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef typename C::const_iterator::difference_type difference_type;
+  typedef typename C::const_iterator::value_type value_type;
+  typedef const value_type &reference;
+  typedef const value_type *pointer;
+
+  IndexedIterator (const C *c, size_t index)
+    : mp_container (c), m_index (index)
+  { }
+
+  bool operator== (const IndexedIterator &d) const
+  {
+    return m_index == d.m_index;
+  }
+
+  bool operator!= (const IndexedIterator &d) const
+  {
+    return m_index != d.m_index;
+  }
+
+  IndexedIterator &operator++ () 
+  {
+    ++m_index;
+    return *this;
+  }
+
+  reference operator* () const
+  {
+    return *(mp_container->begin () + m_index);
+  }
+
+  pointer operator-> () const
+  {
+    return &operator* ();
+  }
+
+private:
+  const C *mp_container;
+  size_t m_index;
+};
+
+template <class C>
+static IndexedIterator<C> indexed_begin (const C &c)
+{
+  return IndexedIterator<C> (&c, 0);
+}
+
+template <class C>
+static IndexedIterator<C> indexed_end (const C &c)
+{
+  return IndexedIterator<C> (&c, size_t (std::distance (c.begin (), c.end ())));
+}
+
+/**
+ *  @brief An iterator delivering the items of an item reference list
+ *
+ *  The item reference lists are vectors which are extended when items are created.
+ *  Like IndexedIterator, this iterator works by index and fetches the list from 
+ *  the database on each access.
+ */
 class ItemRefUnwrappingIterator
 {
 public:
-  typedef rdb::Database::const_item_ref_iterator::iterator_category iterator_category;
+  typedef std::pair<rdb::Database::const_item_ref_iterator, rdb::Database::const_item_ref_iterator> range_type;
+  typedef range_type (*range_func) (const rdb::Database *db, rdb::id_type id1, rdb::id_type id2);
+
+  typedef std::forward_iterator_tag iterator_category;
   typedef rdb::Database::const_item_ref_iterator::difference_type difference_type;
   typedef rdb::Item value_type;
   typedef const rdb::Item &reference;
   typedef const rdb::Item *pointer;
 
-  ItemRefUnwrappingIterator (rdb::Database::const_item_ref_iterator i)
-    : m_iter (i)
-  { }
+  ItemRefUnwrappingIterator (const rdb::Database *db, range_func f, rdb::id_type id1, rdb::id_type id2, bool at_end)
+    : mp_db (db), m_func (f), m_id1 (id1), m_id2 (id2), m_index (0)
+  {
+    if (at_end) {
+      range_type r = (*m_func) (mp_db, m_id1, m_id2);
+      m_index = size_t (std::distance (r.first, r.second));
+    }
+  }
 
   bool operator== (const ItemRefUnwrappingIterator &d) const
   {
-    return m_iter == d.m_iter;
+    return m_index == d.m_index;
   }
 
   bool operator!= (const ItemRefUnwrappingIterator &d) const
   {
-    return m_iter != d.m_iter;
+    return m_index != d.m_index;
   }
 
   ItemRefUnwrappingIterator &operator++ () 
   {
-    ++m_iter;
+    ++m_index;
     return *this;
   }
 
   const rdb::Item &operator* () const
   {
-    return (*m_iter).operator* ();
+    return (*m_func) (mp_db, m_id1, m_id2).first [m_index].operator* ();
   }
 
   const rdb::Item *operator-> () const
   {
-    return (*m_iter).operator-> ();
+    return &operator* ();
   }
 
 private:
-  rdb::Database::const_item_ref_iterator m_iter;
+  const rdb::Database *mp_db;
+  range_func m_func;
+  rdb::id_type m_id1, m_id2;
+  size_t m_index;
 };
 
+static ItemRefUnwrappingIterator::range_type items_by_cell (const rdb::Database *db, rdb::id_type cell_id, rdb::id_type)
+{
+  return db->items_by_cell (cell_id);
+}
+
+static ItemRefUnwrappingIterator::range_type items_by_category (const rdb::Database *db, rdb::id_type cat_id, rdb::id_type)
+{
+  return db->items_by_category (cat_id);
+}
+
+static ItemRefUnwrappingIterator::range_type items_by_cell_and_category (const rdb::Database *db, rdb::id_type cell_id, rdb::id_type cat_id)
+{
+  return db->items_by_cell_and_category (cell_id, cat_id);
+}
+
 // ---------------------------------------------------------------
 //  rdb::Reference binding
 
@@ -156,13 +254,13 @@ static void clear_references (rdb::Cell *cell)
 ItemRefUnwrappingIterator cell_items_begin (const rdb::Cell *cell)
 {
   tl_assert (cell->database ());
-  return cell->database ()->items_by_cell (cell->id ()).first;
+  return ItemRefUnwrappingIterator (cell->database (), &items_by_cell, cell->id (), 0, false);
 }
 
 ItemRefUnwrappingIterator cell_items_end (const rdb::Cell *cell)
 {
   tl_assert (cell->database ());
-  return cell->database ()->items_by_cell (cell->id ()).second;
+  return ItemRefUnwrappingIterator (cell->database (), &items_by_cell, cell->id (), 0, true);
 }
 
 Class<rdb::Cell> decl_RdbCell ("RdbCell", 
@@ -242,13 +340,13 @@ static rdb::Categories::iterator end_sub_categories (rdb::Category *cat)
 ItemRefUnwrappingIterator category_items_begin (const rdb::Category *cat)
 {
   tl_assert (cat->database ());
-  return cat->database ()->items_by_category (cat->id ()).first;
+  return ItemRefUnwrappingIterator (cat->database (), &items_by_category, cat->id (), 0, false);
 }
 
 ItemRefUnwrappingIterator category_items_end (const rdb::Category *cat)
 {
   tl_assert (cat->database ());
-  return cat->database ()->items_by_category (cat->id ()).second;
+  return ItemRefUnwrappingIterator (cat->database (), &items_by_category, cat->id (), 0, true);
 }
 
 static void scan_layer1 (rdb::Category *cat, const db::Layout &layout, unsigned int layer)
@@ -703,14 +801,14 @@ Class<rdb::ValueWrapper> decl_RdbItemValue ("RdbItemValue",
 // ---------------------------------------------------------------
 //  rdb::Item binding
 
-static rdb::Values::const_iterator begin_values (const rdb::Item *item)
+static IndexedIterator<rdb::Values> begin_values (const rdb::Item *item)
 {
-  return item->values ().begin ();
+  return indexed_begin (item->values ());
 }
 
-static rdb::Values::const_iterator end_values (const rdb::Item *item)
+static IndexedIterator<rdb::Values> end_values (const rdb::Item *item)
 {
-  return item->values ().end ();
+  return indexed_end (item->values ());
 }
 
 static void add_value (rdb::Item *item, const rdb::ValueWrapper &value)
@@ -870,44 +968,44 @@ rdb::id_type database_user_tag_id (const rdb::Database *db, const std::string &n
   return db->tags ().tag (name, true).id ();
 }
 
-rdb::Items::const_iterator database_items_begin (const rdb::Database *db)
+IndexedIterator<rdb::Items> database_items_begin (const rdb::Database *db)
 {
-  return db->items ().begin ();
+  return indexed_begin (db->items ());
 }
 
-rdb::Items::const_iterator database_items_end (const rdb::Database *db)
+IndexedIterator<rdb::Items> database_items_end (const rdb::Database *db)
 {
-  return db->items ().end ();
+  return indexed_end (db->items ());
 }
 
 ItemRefUnwrappingIterator database_items_begin_cell (const rdb::Database *db, rdb::id_type cell_id)
 {
-  return db->items_by_cell (cell_id).first;
+  return ItemRefUnwrappingIterator (db, &items_by_cell, cell_id, 0, false);
 }
 
 ItemRefUnwrappingIterator database_items_end_cell (const rdb::Database *db, rdb::id_type cell_id)
 {
-  return db->items_by_cell (cell_id).second;
+  return ItemRefUnwrappingIterator (db, &items_by_cell, cell_id, 0, true);
 }
 
 ItemRefUnwrappingIterator database_items_begin_cat (const rdb::Database *db, rdb::id_type cat_id)
 {
-  return db->items_by_category (cat_id).first;
+  return ItemRefUnwrappingIterator (db, &items_by_category, cat_id, 0, false);
 }
 
 ItemRefUnwrappingIterator database_items_end_cat (const rdb::Database *db, rdb::id_type cat_id)
 {
-  return db->items_by_category (cat_id).second;
+  return ItemRefUnwrappingIterator (db, &items_by_category, cat_id, 0, true);
 }
 
 ItemRefUnwrappingIterator database_items_begin_cc (const rdb::Database *db, rdb::id_type cell_id, rdb::id_type cat_id)
 {
-  return db->items_by_cell_and_category (cell_id, cat_id).first;
+  return ItemRefUnwrappingIterator (db, &items_by_cell_and_category, cell_id, cat_id, false);
 }
 
 ItemRefUnwrappingIterator database_items_end_cc (const rdb::Database *db, rdb::id_type cell_id, rdb::id_type cat_id)
 {
-  return db->items_by_cell_and_category (cell_id, cat_id).second;
+  return ItemRefUnwrappingIterator (db, &items_by_cell_and_category, cell_id, cat_id, true);
 }
 
 rdb::Categories::const_iterator database_begin_categories (const rdb::Database *db)
@@ -313,6 +313,23 @@ Values::operator= (const Values &d)
   return *this;
 }
 
+void 
+Values::reserve (size_t n)
+{
+  if (n <= m_values.capacity ()) {
+    return;
+  }
+
+  std::vector <ValueWrapper> values;
+  values.reserve (n);
+  values.resize (m_values.size ());
+  for (size_t i = 0; i < m_values.size (); ++i) {
+    values [i].swap (m_values [i]);
+  }
+
+  m_values.swap (values);
+}
+
 std::string 
 Values::to_string (const Database *rdb) const
 {
@@ -1029,14 +1046,14 @@ Database::set_items (Items *items)
 
       cell->add_to_num_items (1);
 
-      m_items_by_cell_id.insert (std::make_pair (cell_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (&*i));
+      m_items_by_cell_id.insert (std::make_pair (cell_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (&*i));
 
       if (i->visited ()) {
         cell->add_to_num_items_visited (1);
       }
 
-      m_items_by_category_id.insert (std::make_pair (category_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (&*i));
-      m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::list<ItemRef> ())).first->second.push_back (ItemRef (&*i));
+      m_items_by_category_id.insert (std::make_pair (category_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (&*i));
+      m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::vector<ItemRef> ())).first->second.push_back (ItemRef (&*i));
 
       while (category) {
 
@@ -1351,19 +1368,19 @@ Database::create_item (id_type cell_id, id_type category_id)
   item->set_cell_id (cell_id);
   item->set_category_id (category_id);
 
-  m_items_by_cell_id.insert (std::make_pair (cell_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (item));
-  m_items_by_category_id.insert (std::make_pair (category_id, std::list<ItemRef> ())).first->second.push_back (ItemRef (item));
-  m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::list<ItemRef> ())).first->second.push_back (ItemRef (item));
+  m_items_by_cell_id.insert (std::make_pair (cell_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (item));
+  m_items_by_category_id.insert (std::make_pair (category_id, std::vector<ItemRef> ())).first->second.push_back (ItemRef (item));
+  m_items_by_cell_and_category_id.insert (std::make_pair (std::make_pair (cell_id, category_id), std::vector<ItemRef> ())).first->second.push_back (ItemRef (item));
 
   return item;
 }
 
-static std::list<ItemRef> empty_list;
+static std::vector<ItemRef> empty_list;
 
 std::pair<Database::const_item_ref_iterator, Database::const_item_ref_iterator> 
 Database::items_by_cell_and_category (id_type cell_id, id_type category_id) const
 {
-  std::map <std::pair <id_type, id_type>, std::list<ItemRef> >::const_iterator i = m_items_by_cell_and_category_id.find (std::make_pair (cell_id, category_id));
+  std::map <std::pair <id_type, id_type>, std::vector<ItemRef> >::const_iterator i = m_items_by_cell_and_category_id.find (std::make_pair (cell_id, category_id));
   if (i != m_items_by_cell_and_category_id.end ()) {
     return std::make_pair (i->second.begin (), i->second.end ());
   } else {
@@ -1374,7 +1391,7 @@ Database::items_by_cell_and_category (id_type cell_id, id_type category_id) cons
 std::pair<Database::const_item_ref_iterator, Database::const_item_ref_iterator> 
 Database::items_by_cell (id_type cell_id) const
 {
-  std::map <id_type, std::list<ItemRef> >::const_iterator i = m_items_by_cell_id.find (cell_id);
+  std::map <id_type, std::vector<ItemRef> >::const_iterator i = m_items_by_cell_id.find (cell_id);
   if (i != m_items_by_cell_id.end ()) {
     return std::make_pair (i->second.begin (), i->second.end ());
   } else {
@@ -1385,7 +1402,7 @@ Database::items_by_cell (id_type cell_id) const
 std::pair<Database::const_item_ref_iterator, Database::const_item_ref_iterator> 
 Database::items_by_category (id_type category_id) const
 {
-  std::map <id_type, std::list<ItemRef> >::const_iterator i = m_items_by_category_id.find (category_id);
+  std::map <id_type, std::vector<ItemRef> >::const_iterator i = m_items_by_category_id.find (category_id);
   if (i != m_items_by_category_id.end ()) {
     return std::make_pair (i->second.begin (), i->second.end ());
   } else {
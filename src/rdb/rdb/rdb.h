@@ -33,6 +33,7 @@
 
 #include <string>
 #include <list>
+#include <deque>
 #include <map>
 #include <set>
 #include <vector>
@@ -605,6 +606,17 @@ public:
     return m_tag_id;
   }
 
+  /**
+   *  @brief Swaps the contents with another wrapper
+   *
+   *  In contrast to assignment, this method does not clone the value.
+   */
+  void swap (ValueWrapper &other)
+  {
+    std::swap (mp_ptr, other.mp_ptr);
+    std::swap (m_tag_id, other.m_tag_id);
+  }
+
   /**
    *  @brief Convert the values collection to a string 
    */
@@ -627,12 +639,15 @@ private:
 
 /**
  *  @brief A collection of value objects for a RDB item
+ *
+ *  The value wrappers are kept in a contiguous array. Adding values invalidates
+ *  the iterators.
  */
 class RDB_PUBLIC Values
 {
 public:
-  typedef std::list<ValueWrapper>::const_iterator const_iterator;
-  typedef std::list<ValueWrapper>::iterator iterator;
+  typedef std::vector<ValueWrapper>::const_iterator const_iterator;
+  typedef std::vector<ValueWrapper>::iterator iterator;
 
   /**
    *  @brief The default constructor
@@ -694,6 +709,7 @@ public:
    */
   void add (ValueBase *value, id_type tag_id = 0)
   {
+    grow ();
     m_values.push_back (ValueWrapper ());
     m_values.back ().set (value);
     m_values.back ().set_tag_id (tag_id);
@@ -704,9 +720,23 @@ public:
    */
   void add (const ValueWrapper &value)
   {
+    grow ();
     m_values.push_back (value);
   }
 
+  /**
+   *  @brief Gets the number of values
+   */
+  size_t size () const
+  {
+    return m_values.size ();
+  }
+
+  /**
+   *  @brief Reserves space for the given number of values
+   */
+  void reserve (size_t n);
+
   /**
    *  @brief Swaps the values with other values
    */
@@ -726,7 +756,20 @@ public:
   void from_string (Database *rdb, const std::string &s);  
 
 private:
-  std::list <ValueWrapper> m_values;
+  std::vector <ValueWrapper> m_values;
+
+  /**
+   *  @brief Makes room for one more value
+   *
+   *  The vector would copy - and hence clone - the values when it grows. This method
+   *  relocates them by swapping instead.
+   */
+  void grow ()
+  {
+    if (m_values.size () == m_values.capacity ()) {
+      reserve (m_values.empty () ? 1 : m_values.size () * 2);
+    }
+  }
 };
 
 /**
@@ -1049,13 +1092,15 @@ public:
 /**
  *  @brief A container for items
  *
- *  This container is owned by the database.
+ *  This container is owned by the database. The items are kept in chunks of
+ *  contiguous memory. Adding items does not move existing ones, so pointers to
+ *  items stay valid.
  */
 class RDB_PUBLIC Items
 {
 public:
-  typedef std::list<Item>::const_iterator const_iterator;
-  typedef std::list<Item>::iterator iterator;
+  typedef std::deque<Item>::const_iterator const_iterator;
+  typedef std::deque<Item>::iterator iterator;
 
   /**
    *  @brief Construct an item list with a database reference
@@ -1131,7 +1176,7 @@ private:
   friend class Cell;
   friend class Database;
 
-  std::list <Item> m_items;
+  std::deque <Item> m_items;
   Database *mp_database;
 
   Items (const Items &d);
@@ -1899,8 +1944,8 @@ class RDB_PUBLIC Database
 public:
   typedef Items::const_iterator const_item_iterator;
   typedef Items::iterator item_iterator;
-  typedef std::list<ItemRef>::const_iterator const_item_ref_iterator;
-  typedef std::list<ItemRef>::iterator item_ref_iterator;
+  typedef std::vector<ItemRef>::const_iterator const_item_ref_iterator;
+  typedef std::vector<ItemRef>::iterator item_ref_iterator;
   typedef Cells::const_iterator const_cell_iterator;
   typedef Cells::iterator cell_iterator;
 
@@ -2283,11 +2328,11 @@ private:
   std::map <std::string, std::vector <id_type> > m_cell_variants;
   std::map <id_type, Cell *> m_cells_by_id;
   std::map <id_type, Category *> m_categories_by_id;
-  std::map <std::pair <id_type, id_type>, std::list<ItemRef> > m_items_by_cell_and_category_id;
+  std::map <std::pair <id_type, id_type>, std::vector<ItemRef> > m_items_by_cell_and_category_id;
   std::map <std::pair <id_type, id_type>, size_t> m_num_items_by_cell_and_category;
   std::map <std::pair <id_type, id_type>, size_t> m_num_items_visited_by_cell_and_category;
-  std::map <id_type, std::list<ItemRef> > m_items_by_cell_id;
-  std::map <id_type, std::list<ItemRef> > m_items_by_category_id;
+  std::map <id_type, std::vector<ItemRef> > m_items_by_cell_id;
+  std::map <id_type, std::vector<ItemRef> > m_items_by_category_id;
   Items *mp_items;
   Cells m_cells;
   size_t m_num_items;
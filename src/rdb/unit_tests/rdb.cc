@@ -547,3 +547,48 @@ TEST(6)
 }
 
 
+
+TEST(7)
+{
+  //  many items with many values: checks the storage stays consistent while growing
+  rdb::Database db;
+
+  rdb::Cell *c1 = db.create_cell ("c1");
+  rdb::Cell *c2 = db.create_cell ("c2");
+  rdb::Category *cat1 = db.create_category ("cat1");
+  rdb::Category *cat2 = db.create_category ("cat2");
+
+  std::vector<rdb::Item *> items;
+  for (int i = 0; i < 1000; ++i) {
+    rdb::Item *item = db.create_item ((i % 2) ? c2->id () : c1->id (), (i % 3) ? cat2->id () : cat1->id ());
+    for (int j = 0; j < 20; ++j) {
+      item->values ().add (new rdb::Value<double> (i * 100 + j));
+    }
+    items.push_back (item);
+  }
+
+  EXPECT_EQ (db.num_items (), size_t (1000));
+
+  for (int i = 0; i < 1000; ++i) {
+    //  item pointers stay valid
+    rdb::Item *item = items [i];
+    EXPECT_EQ (item->cell_id (), (i % 2) ? c2->id () : c1->id ());
+    EXPECT_EQ (item->values ().size (), size_t (20));
+    int j = 0;
+    for (rdb::Values::const_iterator v = item->values ().begin (); v != item->values ().end (); ++v, ++j) {
+      EXPECT_EQ (v->get ()->to_string (), rdb::Value<double> (i * 100 + j).to_string ());
+    }
+  }
+
+  std::pair<rdb::Database::const_item_ref_iterator, rdb::Database::const_item_ref_iterator> r;
+
+  r = db.items_by_cell (c1->id ());
+  EXPECT_EQ (size_t (r.second - r.first), size_t (500));
+  EXPECT_EQ (&**r.first == items [0], true);
+
+  r = db.items_by_category (cat1->id ());
+  EXPECT_EQ (size_t (r.second - r.first), size_t (334));
+
+  r = db.items_by_cell_and_category (c2->id (), cat2->id ());
+  EXPECT_EQ (size_t (r.second - r.first), size_t (333));
+}
@@ -38,52 +38,57 @@ namespace tl
 /**
  *  @brief The decoder for Huffmann codes
  *
- *  The decoder keeps a Huffmann code tree and decodes a value from a bit stream
- *  using this tree. 
- *  As specified by RFC1951, the code tree is constructed from a list of code lengths
+ *  The decoder keeps a Huffmann code table and decodes a value from a bit stream
+ *  using this table. 
+ *  As specified by RFC1951, the code table is constructed from a list of code lengths
  *  vs. value alone.
+ *
+ *  Decoding is table-driven: the next "table_bits" bits of the stream are used as an 
+ *  index into a lookup table which delivers the symbol and the code length in one step.
+ *  Since Huffmann codes are prefix-free, every code with up to "table_bits" bits 
+ *  occupies all table entries whose low bits are the (bit-reversed) code.
+ *  Codes longer than "table_bits" are rare by construction and are decoded bit by
+ *  bit using the canonical code representation (code counts per length and symbols
+ *  sorted by code).
  */
 class HuffmannDecoder
 {
 public:
   /**
-   *  @brief Constructor
-   *  
-   *  Creates an empty code tree.
+   *  @brief The maximum number of bits resolved by one table lookup
    */
-  HuffmannDecoder ()
-  {
-    mp_codes = 0;
-    mp_bitmasks = 0;
-    m_max_bits = 0;
-    m_num_codes = 0;
-  }
+  static const unsigned int max_table_bits = 9;
+
+  /**
+   *  @brief The maximum code length
+   */
+  static const unsigned int max_bits = 15;
 
   /**
-   *  @brief Destructor
+   *  @brief Constructor
+   *  
+   *  Creates an empty code table.
    */
-  ~HuffmannDecoder ()
+  HuffmannDecoder ()
+    : m_table_bits (0), m_max_bits (0)
   {
-    if (mp_codes) {
-      delete [] mp_codes;
+    for (unsigned int i = 0; i <= max_bits; ++i) {
+      m_count [i] = 0;
     }
-    mp_codes = 0;
-    if (mp_bitmasks) {
-      delete [] mp_bitmasks;
+    for (unsigned int i = 0; i < (1u << max_table_bits); ++i) {
+      m_table [i].symbol = 0;
+      m_table [i].length = 0;
     }
-    mp_bitmasks = 0;
   }
 
   /**
-   *  @brief Initialize the code tree with the fixed Huffmann code table for literals/lengths
+   *  @brief Initialize the code table with the fixed Huffmann code table for literals/lengths
    *
    *  This table is used by compression mode 1.
    *  It is specified in RFC1951.
    */
   void fill_fixed_table_length ()
   {
-    reserve (9);
-
     unsigned short lengths [288];
     for (unsigned int i = 0; i < 144; ++i) {
       lengths[i] = 8;
@@ -102,15 +107,13 @@ public:
   }
 
   /**
-   *  @brief Initialize the code tree with the fixed Huffmann code table for distances
+   *  @brief Initialize the code table with the fixed Huffmann code table for distances
    *
    *  This table is used by compression mode 1.
    *  It is specified in RFC1951.
    */
   void fill_fixed_table_dist ()
   {
-    reserve (5);
-
     unsigned short lengths [32];
     for (unsigned int i = 0; i < 32; ++i) {
       lengths[i] = 5;
@@ -119,9 +122,9 @@ public:
   }
 
   /**
-   *  @brief Initialize the code tree from a list of lengths
+   *  @brief Initialize the code table from a list of lengths
    *
-   *  This method initializes the code tree from a list of lengths, given 
+   *  This method initializes the code table from a list of lengths, given 
    *  by the sequence [begin_lengths, end_lengths). The codes are assumed to 
    *  range from 0 to distance(begin_lengths, end_lengths).
    *  See RFC1951 for a description about the procedure.
@@ -129,46 +132,66 @@ public:
   template <class Iter>
   void init_codes (Iter begin_lengths, Iter end_lengths)
   {
-    const unsigned int MAX_BITS = 16;
-    unsigned short bl_count[MAX_BITS + 1];
-    unsigned short bitmasks[MAX_BITS + 1];
-    unsigned short next_code[MAX_BITS + 1];
-    unsigned int max_bits = 0;
-
-    for (unsigned int bits = 0; bits <= MAX_BITS; bits++) {
-      bl_count[bits] = 0;
+    unsigned short next_code [max_bits + 1];
+    unsigned short offsets [max_bits + 1];
+
+    for (unsigned int bits = 0; bits <= max_bits; bits++) {
+      m_count [bits] = 0;
     }
 
+    m_max_bits = 0;
     for (Iter l = begin_lengths; l != end_lengths; ++l) {
-      tl_assert (*l < MAX_BITS);
+      tl_assert (*l <= max_bits);
       if (*l > 0) {
-        ++bl_count [*l];
+        ++m_count [*l];
+        if ((unsigned int) *l > m_max_bits) {
+          m_max_bits = *l;
+        }
       }
     }
 
     unsigned int code = 0;
-    for (unsigned int bits = 1; bits <= MAX_BITS; bits++) {
-      if (bl_count[bits - 1] > 0) {
-        max_bits = bits - 1;
-      }
-      code = (code + bl_count[bits - 1]) << 1;
-      next_code[bits] = code;
+    unsigned int offset = 0;
+    for (unsigned int bits = 1; bits <= max_bits; bits++) {
+      code = (code + m_count [bits - 1]) << 1;
+      next_code [bits] = code;
+      offsets [bits] = offset;
+      offset += m_count [bits];
     }
 
-    for (unsigned int bits = 0; bits <= max_bits; bits++) {
-      bitmasks [bits] = ((1 << bits) - 1) << (max_bits - bits);
+    m_table_bits = m_max_bits < max_table_bits ? m_max_bits : max_table_bits;
+    unsigned int table_size = 1u << m_table_bits;
+    for (unsigned int i = 0; i < table_size; ++i) {
+      m_table [i].length = 0;
     }
 
-    reserve (max_bits);
-
     unsigned short symbol = 0;
     for (Iter l = begin_lengths; l != end_lengths; ++l, ++symbol) {
-      if (*l > 0) {
-        unsigned int code = next_code [*l]++;
-        code <<= (max_bits - *l);
-        mp_codes [code] = symbol;
-        mp_bitmasks [code] = bitmasks [*l];
-      } 
+
+      unsigned int len = *l;
+      if (len == 0) {
+        continue;
+      }
+
+      m_symbols [offsets [len]++] = symbol;
+
+      unsigned int code = next_code [len]++;
+      if (len <= m_table_bits) {
+
+        //  the stream delivers the most significant code bit first, hence the table index is 
+        //  the reversed code
+        unsigned int rev = 0;
+        for (unsigned int i = 0; i < len; ++i) {
+          rev = (rev << 1) | ((code >> i) & 1);
+        }
+
+        for (unsigned int i = rev; i < table_size; i += (1u << len)) {
+          m_table [i].symbol = symbol;
+          m_table [i].length = (unsigned char) len;
+        }
+
+      }
+
     }
   }
 
@@ -176,46 +199,93 @@ public:
    *  @brief Decode the next value from a bit stream
    *
    *  This method takes the next value from the bit stream decoding the bits with
-   *  the code tree currently loaded.
+   *  the code table currently loaded.
+   *  Bytes are taken from the stream only if the code needs them, so this method
+   *  will not read beyond the end of the compressed data.
    */
   unsigned short decode (BitStream &s) const
   {
-    tl_assert (mp_codes != 0);
-
-    unsigned int m = m_num_codes / 2;
-    
-    unsigned int c = 0;
-    do {
-      if (s.get_bit ()) {
-        c |= m;
+    while (true) {
+
+      const table_entry &e = m_table [s.peek_bits () & ((1u << m_table_bits) - 1)];
+
+      //  NOTE: bits beyond the available ones are zero. But if the code found is not longer
+      //  than the available bits, it is a valid match because of the prefix property.
+      if (e.length > 0 && e.length <= s.bits_available ()) {
+        s.skip_bits (e.length);
+        return e.symbol;
+      } else if (s.bits_available () >= m_table_bits) {
+        return decode_slow (s);
       }
-      m >>= 1;
-    } while ((mp_bitmasks [c] & m) != 0);
 
-    return mp_codes [c];
+      s.fetch ();
+
+    }
   }
 
 private:
-  unsigned short *mp_codes, *mp_bitmasks;
-  unsigned int m_num_codes, m_max_bits;
+  struct table_entry
+  {
+    unsigned short symbol;
+    unsigned char length;
+  };
 
-  void reserve (unsigned int max_bits)
+  table_entry m_table [1 << max_table_bits];
+  unsigned short m_count [max_bits + 1];
+  unsigned short m_symbols [288];
+  unsigned int m_table_bits, m_max_bits;
+
+  /**
+   *  @brief Bit-by-bit decoding for codes longer than the table bits
+   */
+  unsigned short decode_slow (BitStream &s) const
   {
-    m_num_codes = 1 << max_bits;
-    if (max_bits > m_max_bits) {
-      m_max_bits = max_bits;
-      if (mp_codes) {
-        delete [] mp_codes;
-      }
-      mp_codes = new unsigned short [m_num_codes];
-      if (mp_bitmasks) {
-        delete [] mp_bitmasks;
+    int code = 0;
+    int first = 0;
+    int index = 0;
+
+    for (unsigned int len = 1; len <= m_max_bits; ++len) {
+      code |= s.get_bit () ? 1 : 0;
+      int count = m_count [len];
+      if (code - count < first) {
+        return m_symbols [index + (code - first)];
       }
-      mp_bitmasks = new unsigned short [m_num_codes];
+      index += count;
+      first += count;
+      first <<= 1;
+      code <<= 1;
     }
+
+    throw tl::Exception (tl::to_string (QObject::tr ("Invalid Huffmann code (DEFLATE implementation)")));
   }
 };
 
+/**
+ *  @brief Base values and extra bits for the length codes 257 to 285 (RFC1951)
+ */
+static const unsigned short length_base [] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const unsigned char length_extra [] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/**
+ *  @brief Base values and extra bits for the distance codes 0 to 29 (RFC1951)
+ */
+static const unsigned short dist_base [] = {
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const unsigned char dist_extra [] = {
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
 
 // ------------------------------------------------------------------------
 //  InflateFilter implementation
@@ -230,16 +300,33 @@ InflateFilter::InflateFilter (tl::InputStream &input)
     m_buffer[i] = 0;
   }
 
-  mp_dist_decoder = new HuffmannDecoder ();
-  mp_lit_decoder = new HuffmannDecoder ();
+  mp_dyn_dist_decoder = new HuffmannDecoder ();
+  mp_dyn_lit_decoder = new HuffmannDecoder ();
+  mp_fixed_dist_decoder = 0;
+  mp_fixed_lit_decoder = 0;
+
+  mp_dist_decoder = mp_dyn_dist_decoder;
+  mp_lit_decoder = mp_dyn_lit_decoder;
 }
 
 InflateFilter::~InflateFilter ()
 {
-  delete mp_dist_decoder;
   mp_dist_decoder = 0;
-  delete mp_lit_decoder;
   mp_lit_decoder = 0;
+
+  delete mp_dyn_dist_decoder;
+  mp_dyn_dist_decoder = 0;
+  delete mp_dyn_lit_decoder;
+  mp_dyn_lit_decoder = 0;
+
+  if (mp_fixed_dist_decoder) {
+    delete mp_fixed_dist_decoder;
+    mp_fixed_dist_decoder = 0;
+  }
+  if (mp_fixed_lit_decoder) {
+    delete mp_fixed_lit_decoder;
+    mp_fixed_lit_decoder = 0;
+  }
 }
 
 const char * 
@@ -328,53 +415,24 @@ InflateFilter::process ()
 
       } else {
 
-        unsigned int length = 0;
-        if (l < 265) {
-          length = l - 254;
-        } else if (l < 269) {
-          length = (l - 265) * 2 + 11 + m_input.get_bits (1);
-        } else if (l < 273) {
-          length = (l - 269) * 4 + 19 + m_input.get_bits (2);
-        } else if (l < 277) {
-          length = (l - 273) * 8 + 35 + m_input.get_bits (3);
-        } else if (l < 281) {
-          length = (l - 277) * 16 + 67 + m_input.get_bits (4);
-        } else if (l < 285) {
-          length = (l - 281) * 32 + 131 + m_input.get_bits (5);
-        } else {
-          length = 258;
+        l -= 257;
+        if (l >= sizeof (length_base) / sizeof (length_base [0])) {
+          throw tl::Exception (tl::to_string (QObject::tr ("Invalid length code: %d")), l + 257);
+        }
+
+        unsigned int length = length_base [l];
+        if (length_extra [l] > 0) {
+          length += m_input.get_bits (length_extra [l]);
         }
 
         unsigned int d = mp_dist_decoder->decode (m_input);
-        unsigned int dist = 0;
-        if (d < 4) {
-          dist = d + 1;
-        } else if (d < 6) {
-          dist = (d - 4) * 2 + 5 + m_input.get_bits (1);
-        } else if (d < 8) {
-          dist = (d - 6) * 4 + 9 + m_input.get_bits (2);
-        } else if (d < 10) {
-          dist = (d - 8) * 8 + 17 + m_input.get_bits (3);
-        } else if (d < 12) {
-          dist = (d - 10) * 16 + 33 + m_input.get_bits (4);
-        } else if (d < 14) {
-          dist = (d - 12) * 32 + 65 + m_input.get_bits (5);
-        } else if (d < 16) {
-          dist = (d - 14) * 64 + 129 + m_input.get_bits (6);
-        } else if (d < 18) {
-          dist = (d - 16) * 128 + 257 + m_input.get_bits (7);
-        } else if (d < 20) {
-          dist = (d - 18) * 256 + 513 + m_input.get_bits (8);
-        } else if (d < 22) {
-          dist = (d - 20) * 512 + 1025 + m_input.get_bits (9);
-        } else if (d < 24) {
-          dist = (d - 22) * 1024 + 2049 + m_input.get_bits (10);
-        } else if (d < 26) {
-          dist = (d - 24) * 2048 + 4097 + m_input.get_bits (11);
-        } else if (d < 28) {
-          dist = (d - 26) * 4096 + 8193 + m_input.get_bits (12);
-        } else {
-          dist = (d - 28) * 8192 + 16385 + m_input.get_bits (13);
+        if (d >= sizeof (dist_base) / sizeof (dist_base [0])) {
+          throw tl::Exception (tl::to_string (QObject::tr ("Invalid distance code: %d")), d);
+        }
+
+        unsigned int dist = dist_base [d];
+        if (dist_extra [d] > 0) {
+          dist += m_input.get_bits (dist_extra [d]);
         }
 
         while (length-- > 0) {
@@ -406,9 +464,18 @@ InflateFilter::process ()
         
         if (t == 1) {
 
-          //  KLUDGE: should use a different decoder object, so we save time to do this:
-          mp_lit_decoder->fill_fixed_table_length ();
-          mp_dist_decoder->fill_fixed_table_dist ();
+          //  the fixed tables are built once and kept
+          if (! mp_fixed_lit_decoder) {
+            mp_fixed_lit_decoder = new HuffmannDecoder ();
+            mp_fixed_lit_decoder->fill_fixed_table_length ();
+          }
+          if (! mp_fixed_dist_decoder) {
+            mp_fixed_dist_decoder = new HuffmannDecoder ();
+            mp_fixed_dist_decoder->fill_fixed_table_dist ();
+          }
+
+          mp_lit_decoder = mp_fixed_lit_decoder;
+          mp_dist_decoder = mp_fixed_dist_decoder;
 
         } else {
 
@@ -432,7 +499,7 @@ InflateFilter::process ()
           HuffmannDecoder ldecoder;
           ldecoder.init_codes (hclengths, hclengths + sizeof (hclengths) / sizeof (hclengths[0]));
 
-          unsigned int lengths [286 + 32];
+          unsigned int lengths [288 + 32];
           unsigned int nlengths = hlit + hdist;
 
           for (unsigned int i = 0; i < nlengths; ) {
@@ -466,8 +533,11 @@ InflateFilter::process ()
 
           }
 
-          mp_lit_decoder->init_codes (lengths, lengths + hlit);
-          mp_dist_decoder->init_codes (lengths + hlit, lengths + nlengths);
+          mp_dyn_lit_decoder->init_codes (lengths, lengths + hlit);
+          mp_dyn_dist_decoder->init_codes (lengths + hlit, lengths + nlengths);
+
+          mp_lit_decoder = mp_dyn_lit_decoder;
+          mp_dist_decoder = mp_dyn_dist_decoder;
 
         }
 
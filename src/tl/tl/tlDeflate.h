@@ -43,6 +43,12 @@ class HuffmannDecoder;
  *  This filter reads bytes from a tl::Stream and delivers bits, taken from
  *  these bytes. The bits are delivered in the order specified by the DEFLATE
  *  format specification (least significant bit first).
+ *
+ *  The bits are kept in a small bit buffer. Bytes are only taken from the 
+ *  input when the bits are actually required. This way, the stream is never
+ *  read beyond the end of the DEFLATE data. Huffmann decoders can use 
+ *  "peek_bits" to look at the bits available and "fetch" to request more
+ *  bits.
  */
 class TL_PUBLIC BitStream
 {
@@ -54,7 +60,7 @@ public:
    */
   BitStream (tl::InputStream &input)
     : mp_input (&input),
-      m_mask (0), m_byte (0)
+      m_bits (0), m_nbits (0)
   {
     // ...
   }
@@ -62,17 +68,20 @@ public:
   /**
    *  @brief Get a byte
    *
-   *  This method simply passes the byte.
+   *  This method skips the remaining bits of the current byte and 
+   *  delivers the next byte.
    *  The method expects the next byte to be available.
    */
   unsigned char get_byte ()
   {
-    m_mask = 0;
-    const char *c = mp_input->get (1, true /*bypass_deflate*/);
-    if (c == 0) {
-      throw tl::Exception (tl::to_string (QObject::tr ("Unexpected end of file (DEFLATE implementation)")));
+    skip_to_byte ();
+    if (m_nbits >= 8) {
+      unsigned char b = (unsigned char) m_bits;
+      skip_bits (8);
+      return b;
+    } else {
+      return read_byte ();
     }
-    return *c;
   }
 
   /**
@@ -83,12 +92,11 @@ public:
    */
   bool get_bit ()
   {
-    if (m_mask == 0) {
-      m_byte = get_byte ();
-      m_mask = 0x01;
+    if (m_nbits == 0) {
+      fetch ();
     } 
-    bool b = ((m_byte & m_mask) != 0);
-    m_mask <<= 1;
+    bool b = ((m_bits & 1) != 0);
+    skip_bits (1);
     return b;
   }
 
@@ -98,31 +106,80 @@ public:
    *  This method gets the next n bits and delivers them as a single unsigned int,
    *  packing the first bit into the least signification bit. This is the specification
    *  for reading multiple bit values except Huffmann codes.
+   *  n must not be larger than 16.
    */
   unsigned int get_bits (unsigned int n)
   {
-    //  KLUDGE: take directly from the byte for performance.
-    unsigned int r = 0;
-    unsigned int m = 1;
-    while (n-- > 0) {
-      r |= get_bit () ? m : 0;
-      m <<= 1;
+    while (m_nbits < n) {
+      fetch ();
     }
+    unsigned int r = m_bits & ((1u << n) - 1);
+    skip_bits (n);
     return r;
   }
 
+  /**
+   *  @brief Gets the bits currently available without consuming them
+   *
+   *  The next bit is the least significant one. Bits beyond "bits_available" 
+   *  are zero.
+   */
+  unsigned int peek_bits () const
+  {
+    return m_bits;
+  }
+
+  /**
+   *  @brief Gets the number of bits currently available in the bit buffer
+   */
+  unsigned int bits_available () const
+  {
+    return m_nbits;
+  }
+
+  /**
+   *  @brief Reads the next byte into the bit buffer
+   *
+   *  This makes 8 more bits available.
+   */
+  void fetch ()
+  {
+    m_bits |= (unsigned int) read_byte () << m_nbits;
+    m_nbits += 8;
+  }
+
+  /**
+   *  @brief Consumes the given number of bits
+   *
+   *  n must not be larger than the number of bits available.
+   */
+  void skip_bits (unsigned int n)
+  {
+    m_bits >>= n;
+    m_nbits -= n;
+  }
+
   /**
    *  @brief Skip the next bits up to the next byte boundary
    */
   void skip_to_byte ()
   {
-    m_mask = 0;
+    skip_bits (m_nbits % 8);
   }
 
 private:
   tl::InputStream *mp_input;
-  unsigned char m_mask;
-  unsigned char m_byte;
+  unsigned int m_bits;
+  unsigned int m_nbits;
+
+  unsigned char read_byte ()
+  {
+    const char *c = mp_input->get (1, true /*bypass_deflate*/);
+    if (c == 0) {
+      throw tl::Exception (tl::to_string (QObject::tr ("Unexpected end of file (DEFLATE implementation)")));
+    }
+    return (unsigned char) *c;
+  }
 };
 
 
@@ -241,6 +298,8 @@ private:
   bool m_last_block;
   int m_uncompressed_length;
   HuffmannDecoder *mp_lit_decoder, *mp_dist_decoder;
+  HuffmannDecoder *mp_dyn_lit_decoder, *mp_dyn_dist_decoder;
+  HuffmannDecoder *mp_fixed_lit_decoder, *mp_fixed_dist_decoder;
 
   void put_byte (char b);
   void put_byte_dist (unsigned int d);
@@ -30,6 +30,9 @@
 #include <errno.h>
 #ifdef _WIN32 
 #  include <io.h>
+#else
+#  include <unistd.h>
+#  include <sys/mman.h>
 #endif
 
 #include "tlStream.h"
@@ -43,6 +46,8 @@
 #include <QFileInfo>
 #include <QUrl>
 
+#include <limits>
+
 namespace tl
 {
 
@@ -300,19 +305,108 @@ private:
   std::string m_source;
 };
 
+#if !defined(_WIN32)
+
+/**
+ *  @brief A memory-mapped input file delegate
+ *
+ *  Implements the reader for plain (uncompressed) local files. The file is 
+ *  mapped into memory and InputStream hands out pointers into the mapping 
+ *  directly (see mapped_data).
+ *  Use "create" to obtain such a delegate. "create" will return 0 if the file
+ *  cannot be mapped or is gzip-compressed.
+ */
+class InputMappedFile
+  : public InputStreamBase
+{
+public:
+  /**
+   *  @brief Creates a delegate for the file with the given path
+   *
+   *  Returns 0 if the file cannot be opened or mapped or if it is not a plain file.
+   */
+  static InputMappedFile *create (const std::string &path);
+
+  /**
+   *  @brief Unmaps the file
+   */
+  virtual ~InputMappedFile ();
+
+  virtual size_t read (char *b, size_t n);
+
+  virtual void reset ()
+  {
+    m_pos = 0;
+  }
+
+  virtual std::string source () const
+  {
+    return m_source;
+  }
+
+  virtual std::string absolute_path () const;
+
+  virtual std::string filename () const;
+
+  virtual const char *mapped_data (size_t &n)
+  {
+    n = m_size - m_pos;
+    return mp_data + m_pos;
+  }
+
+  virtual void check_mapped ();
+
+private:
+  std::string m_source;
+  int m_fd;
+  const char *mp_data;
+  size_t m_size, m_pos;
+
+  InputMappedFile (const std::string &path, int fd, const char *data, size_t size);
+};
+
+#endif
+
+static bool s_mmap_enabled = true;
+
+//  the number of bytes after which a mapped file is checked for truncation
+static const size_t check_interval = 1024 * 1024;
+
+/**
+ *  @brief Creates the delegate for a local file
+ *
+ *  Plain files are memory-mapped where possible (unless disabled). Compressed files and 
+ *  files which cannot be mapped are read through zlib (which also reads uncompressed files).
+ */
+static InputStreamBase *
+create_file_delegate (const std::string &path)
+{
+#if !defined(_WIN32)
+  if (s_mmap_enabled) {
+    InputStreamBase *mapped = InputMappedFile::create (path);
+    if (mapped) {
+      return mapped;
+    }
+  }
+#endif
+  return new InputZLibFile (path);
+}
+
 // ---------------------------------------------------------------
 //  InputStream implementation
 
 InputStream::InputStream (InputStreamBase &delegate)
-  : m_pos (0), mp_bptr (0), mp_delegate (&delegate), m_owns_delegate (false), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), mp_delegate (&delegate), m_owns_delegate (false), m_mapped (false), m_next_check (0), mp_inflate (0)
 { 
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
   mp_buffer = new char [m_bcap];
+
+  init_mapped ();
 }
 
 InputStream::InputStream (const std::string &abstract_path)
-  : m_pos (0), mp_bptr (0), mp_delegate (0), m_owns_delegate (false), mp_inflate (0)
+  : m_pos (0), mp_bptr (0), mp_delegate (0), m_owns_delegate (false), m_mapped (false), m_next_check (0), mp_inflate (0)
 { 
   m_bcap = 4096; // initial buffer capacity
   m_blen = 0;
@@ -327,12 +421,34 @@ InputStream::InputStream (const std::string &abstract_path)
 #endif
   } else if (ex.test ("file:")) {
     QUrl url (tl::to_qstring (abstract_path));
-    mp_delegate = new InputZLibFile (tl::to_string (url.toLocalFile ()));
+    mp_delegate = create_file_delegate (tl::to_string (url.toLocalFile ()));
   } else {
-    mp_delegate = new InputZLibFile (abstract_path);
+    mp_delegate = create_file_delegate (abstract_path);
   }
 
   m_owns_delegate = true;
+
+  init_mapped ();
+}
+
+void
+InputStream::init_mapped ()
+{
+  size_t n = 0;
+  const char *data = mp_delegate->mapped_data (n);
+  if (data) {
+
+    //  the delegate provides the data as a memory block: we don't need a buffer
+    m_mapped = true;
+    mp_bptr = data;
+    m_blen = n;
+
+    if (mp_buffer) {
+      delete[] mp_buffer;
+      mp_buffer = 0;
+    }
+
+  }
 }
 
 std::string InputStream::absolute_path (const std::string &abstract_path)
@@ -387,7 +503,16 @@ InputStream::get (size_t n, bool bypass_inflate)
     }
   } 
 
-  if (m_blen < n) {
+  //  NOTE: in mapped mode, m_blen is the number of bytes remaining
+  if (m_mapped) {
+
+    //  check periodically whether the mapped data is still valid
+    if (m_pos + n > m_next_check) {
+      mp_delegate->check_mapped ();
+      m_next_check = m_pos + n + check_interval;
+    }
+
+  } else if (m_blen < n) {
 
     //  to keep move activity low, allocate twice as much as required
     if (m_bcap < n * 2) {
@@ -471,6 +596,14 @@ InputStream::read_all ()
 void
 InputStream::copy_to (tl::OutputStream &os)
 {
+  if (m_mapped) {
+    os.put (mp_bptr, m_blen);
+    mp_bptr += m_blen;
+    m_pos += m_blen;
+    m_blen = 0;
+    return;
+  }
+
   const size_t chunk = 65536;
   char b [chunk];
   size_t read;
@@ -479,6 +612,31 @@ InputStream::copy_to (tl::OutputStream &os)
   }
 }
 
+void
+InputStream::set_mmap_enabled (bool f)
+{
+  s_mmap_enabled = f;
+}
+
+bool
+InputStream::mmap_enabled ()
+{
+  return s_mmap_enabled;
+}
+
+const char *
+InputStream::mapped_data (size_t &n) const
+{
+  if (m_mapped) {
+    mp_delegate->check_mapped ();
+    //  NOTE: the delegate's position is not changed in mapped mode
+    return mp_delegate->mapped_data (n);
+  } else {
+    n = 0;
+    return 0;
+  }
+}
+
 void
 InputStream::inflate ()
 {
@@ -495,9 +653,19 @@ InputStream::reset ()
     mp_inflate = 0;
   } 
 
+  if (m_mapped) {
+
+    mp_delegate->reset ();
+    m_pos = 0;
+    m_next_check = 0;
+
+    size_t n = 0;
+    mp_bptr = mp_delegate->mapped_data (n);
+    m_blen = n;
+
   //  optimize for a reset in the first m_bcap bytes
   //  -> this reduces the reset calls on mp_delegate which may not support this
-  if (m_pos < m_bcap) {
+  } else if (m_pos < m_bcap) {
 
     m_blen += m_pos;
     mp_bptr = mp_buffer;
@@ -752,6 +920,106 @@ InputZLibFile::filename () const
   return tl::to_string (QFileInfo (tl::to_qstring (m_source)).fileName ());
 }
 
+// ---------------------------------------------------------------
+//  InputMappedFile implementation
+
+#if !defined(_WIN32)
+
+InputMappedFile::InputMappedFile (const std::string &path, int fd, const char *data, size_t size)
+  : m_source (path), m_fd (fd), mp_data (data), m_size (size), m_pos (0)
+{
+  //  .. nothing yet ..
+}
+
+InputMappedFile *
+InputMappedFile::create (const std::string &path)
+{
+  int fd = open (tl::string_to_system (path).c_str (), O_RDONLY);
+  if (fd < 0) {
+    //  InputZLibFile will report the error
+    return 0;
+  }
+
+  //  Only regular files can be mapped. Empty or tiny files are not worth mapping.
+  //  Files too large for the address space are read the conventional way.
+  struct stat st;
+  if (fstat (fd, &st) != 0 || ! S_ISREG (st.st_mode) || st.st_size < 2 || (unsigned long long) st.st_size > (unsigned long long) std::numeric_limits<size_t>::max ()) {
+    close (fd);
+    return 0;
+  }
+
+  //  gzip-compressed files are read through zlib
+  unsigned char magic [2];
+  if (pread (fd, magic, sizeof (magic), 0) != ptrdiff_t (sizeof (magic)) || (magic [0] == 0x1f && magic [1] == 0x8b)) {
+    close (fd);
+    return 0;
+  }
+
+  size_t size = size_t (st.st_size);
+  void *data = mmap (0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if (data == MAP_FAILED) {
+    close (fd);
+    return 0;
+  }
+
+#if defined(MADV_SEQUENTIAL)
+  //  the stream readers consume the file front to back
+  madvise (data, size, MADV_SEQUENTIAL);
+#endif
+
+  //  NOTE: the file descriptor is kept open for checking the file size
+  return new InputMappedFile (path, fd, (const char *) data, size);
+}
+
+InputMappedFile::~InputMappedFile ()
+{
+  if (mp_data) {
+    munmap ((void *) mp_data, m_size);
+    mp_data = 0;
+  }
+  if (m_fd >= 0) {
+    close (m_fd);
+    m_fd = -1;
+  }
+}
+
+void
+InputMappedFile::check_mapped ()
+{
+  //  accessing the mapping beyond the end of a truncated file raises SIGBUS: 
+  //  turn that into an error while we can
+  struct stat st;
+  if (fstat (m_fd, &st) != 0 || (unsigned long long) st.st_size < (unsigned long long) m_size) {
+    throw FileReadErrorException (m_source, EIO);
+  }
+}
+
+size_t 
+InputMappedFile::read (char *b, size_t n)
+{
+  if (n > m_size - m_pos) {
+    n = m_size - m_pos;
+  }
+  memcpy (b, mp_data + m_pos, n);
+  m_pos += n;
+  return n;
+}
+
+std::string
+InputMappedFile::absolute_path () const
+{
+  return tl::to_string (QFileInfo (tl::to_qstring (m_source)).absoluteFilePath ());
+}
+
+std::string
+InputMappedFile::filename () const
+{
+  return tl::to_string (QFileInfo (tl::to_qstring (m_source)).fileName ());
+}
+
+#endif
+
 // ---------------------------------------------------------------------------------
 //  OutputStreamBase implementations - declarations and implementation
 
@@ -56,7 +56,8 @@ extern TL_PUBLIC bool match_filename_to_format (const std::string &fn, const std
  *  @brief The input stream delegate base class
  *
  *  This class provides the basic input stream functionality.
- *  The actual implementation is provided through InputFile, InputPipe and InputZLibFile.
+ *  The actual implementation is provided through InputFile, InputPipe, InputZLibFile
+ *  and InputMappedFile.
  */
 
 class TL_PUBLIC InputStreamBase
@@ -97,6 +98,33 @@ public:
    *  @brief Gets the filename part of the source
    */
   virtual std::string filename () const = 0;
+
+  /**
+   *  @brief Gets the remaining data as a contiguous memory block if available
+   *
+   *  Delegates which can provide their data as one memory block (i.e. memory-mapped
+   *  files or memory streams) return a pointer to the data starting at the current
+   *  position and the number of bytes available in "n". InputStream will hand out 
+   *  pointers into this block rather than copying the data into its own buffer.
+   *  The block must stay valid as long as the delegate lives.
+   *  The default implementation returns 0 which means that the data is obtained through read.
+   */
+  virtual const char *mapped_data (size_t & /*n*/)
+  {
+    return 0;
+  }
+
+  /**
+   *  @brief Verifies that the memory block is still valid
+   *
+   *  Memory-mapped files may become invalid if the file is truncated by another process.
+   *  This method is called periodically while reading in mapped mode and should throw
+   *  an exception if the data is no longer available. The default implementation does nothing.
+   */
+  virtual void check_mapped ()
+  {
+    //  .. nothing yet ..
+  }
 };
 
 // ---------------------------------------------------------------------------------
@@ -151,6 +179,12 @@ public:
     return "data";
   }
 
+  virtual const char *mapped_data (size_t &n)
+  {
+    n = m_length - m_pos;
+    return mp_data + m_pos;
+  }
+
 private:
   const char *mp_data;
   size_t m_length, m_pos;
@@ -204,6 +238,9 @@ public:
    *  This implementation obtains data through the 
    *  protected read call and buffers the data accordingly so
    *  a contigous memory block can be returned.
+   *  If the delegate provides the data as a memory block (see 
+   *  InputStreamBase::mapped_data), the pointer returned points into
+   *  this block directly and no copy is made.
    *  If inline deflating is enabled, the method will return
    *  inflate data unless "bypass_inflate" is set to true.
    *
@@ -247,6 +284,42 @@ public:
    */
   void inflate ();
 
+  /**
+   *  @brief Returns true, if the stream is delivering uncompressed data from a DEFLATE block
+   */
+  bool is_inflating () const
+  {
+    return mp_inflate != 0;
+  }
+
+  /**
+   *  @brief Gets the complete data of a memory-mapped stream
+   *
+   *  If the stream reads from a memory block or a memory-mapped file, this method
+   *  returns a pointer to the beginning of the data and delivers the total number 
+   *  of bytes in "n". Positions reported by "pos" refer to this block.
+   *  This allows random access to the data in addition to sequential reading.
+   *  For other streams, this method returns 0.
+   */
+  const char *mapped_data (size_t &n) const;
+
+  /**
+   *  @brief Enables or disables memory mapping of local files
+   *
+   *  By default, plain local files are memory-mapped. If a mapped file is truncated
+   *  or replaced in place by another process while it is being read, the
+   *  application may be terminated by a bus error. The stream checks the file size
+   *  periodically and reports an error if the file has shrunk, but this check cannot
+   *  cover all cases. Disable memory mapping if files may be written while they are
+   *  being read. This setting applies to streams created afterwards.
+   */
+  static void set_mmap_enabled (bool f);
+
+  /**
+   *  @brief Gets a value indicating whether local files are memory-mapped
+   */
+  static bool mmap_enabled ();
+
   /**
    *  @brief Obtain the current file position
    */
@@ -317,9 +390,11 @@ private:
   char *mp_buffer;
   size_t m_bcap;
   size_t m_blen;
-  char *mp_bptr;
+  const char *mp_bptr;
   InputStreamBase *mp_delegate;
   bool m_owns_delegate;
+  bool m_mapped;
+  size_t m_next_check;
 
   //  inflate support 
   InflateFilter *mp_inflate;
@@ -327,6 +402,8 @@ private:
   //  No copying currently
   InputStream (const InputStream &);
   InputStream &operator= (const InputStream &);
+
+  void init_mapped ();
 };
 
 // ---------------------------------------------------------------------------------
@@ -511,6 +588,14 @@ public:
     m_buffer.clear ();
   }
 
+  /**
+   *  @brief Swaps the data with another memory stream
+   */
+  void swap (OutputMemoryStream &other)
+  {
+    m_buffer.swap (other.m_buffer);
+  }
+
 private:
   std::vector<char> m_buffer;
 };
@@ -38,22 +38,26 @@ namespace tl
 //  The maximum number of errors collected per worker
 const size_t max_errors = 100;
 
-// -----------------------------------------------------------------------------
-//  Some special tasks and exceptions
+//  Reads an atomic value with full memory barrier semantics
+static inline int atomic_value (QAtomicInt &v)
+{
+  return v.fetchAndAddOrdered (0);
+}
 
-class ExitTask : public Task 
+//  Reads an atomic flag with full memory barrier semantics
+static inline bool atomic_flag (QAtomicInt &v)
 {
-public:
-  ExitTask ()
-  { }
-};
+  return v.fetchAndAddOrdered (0) != 0;
+}
 
-class StartTask : public Task 
+//  Sets an atomic flag with full memory barrier semantics
+static inline void set_atomic_flag (QAtomicInt &v, bool f)
 {
-public:
-  StartTask ()
-  { }
-};
+  v.fetchAndStoreOrdered (f ? 1 : 0);
+}
+
+// -----------------------------------------------------------------------------
+//  Some special exceptions
 
 struct WorkerTerminatedException { };
 struct TaskTerminatedException { };
@@ -134,15 +138,27 @@ TaskList::fetch ()
 void 
 TaskList::put (Task *task)
 {
-  task->mp_next = 0;
-  task->mp_last = mp_last;
+  //  find the insert position: after the last task with the same or a higher priority
+  //  (usually this is the end of the list)
+  Task *after = mp_last;
+  while (after && after->m_priority < task->m_priority) {
+    after = after->mp_last;
+  }
 
-  mp_last = task;
-  if (task->mp_last) {
-    task->mp_last->mp_next = task;
+  task->mp_last = after;
+  if (after) {
+    task->mp_next = after->mp_next;
+    after->mp_next = task;
   } else {
+    task->mp_next = mp_first;
     mp_first = task;
   }
+
+  if (task->mp_next) {
+    task->mp_next->mp_last = task;
+  } else {
+    mp_last = task;
+  }
 }
 
 void 
@@ -159,16 +175,60 @@ TaskList::put_front (Task *task)
   }
 }
 
+// -----------------------------------------------------------------------------
+//  tl::TaskQueue definition and implementation
+
+/**
+ *  @brief A thread-safe task list
+ *
+ *  Each worker owns one queue. The owner and the workers stealing tasks
+ *  only lock this queue, not the job.
+ */
+class TaskQueue
+{
+public:
+  TaskQueue ()
+  {
+    //  .. nothing yet ..
+  }
+
+  void put (Task *task)
+  {
+    m_lock.lock ();
+    m_tasks.put (task);
+    m_lock.unlock ();
+  }
+
+  Task *fetch ()
+  {
+    Task *task = 0;
+    m_lock.lock ();
+    if (! m_tasks.is_empty ()) {
+      task = m_tasks.fetch ();
+    }
+    m_lock.unlock ();
+    return task;
+  }
+
+private:
+  QMutex m_lock;
+  TaskList m_tasks;
+
+  TaskQueue (const TaskQueue &);
+  TaskQueue &operator= (const TaskQueue &);
+};
+
 // -----------------------------------------------------------------------------
 //  tl::JobBase implementation
 
 JobBase::JobBase (int nworkers)
-  : m_nworkers (nworkers), m_idle_workers (0), m_stopping (false), m_running (false)
+  : m_nworkers (nworkers), m_idle_workers (0), m_tasks_queued (0), m_next_queue (0), 
+    m_stopping (0), m_running (0), m_exiting (0), m_start_count (0)
 {
   if (nworkers > 0) {
-    mp_per_worker_task_lists = new TaskList[nworkers];
+    mp_task_queues = new TaskQueue[nworkers];
   } else {
-    mp_per_worker_task_lists = 0;
+    mp_task_queues = 0;
   }
 }
 
@@ -180,9 +240,11 @@ JobBase::~JobBase ()
     (*(m_bosses.begin ()))->unregister_job (this);
   }
 
-  if (mp_per_worker_task_lists) {
-    delete[] mp_per_worker_task_lists;
-    mp_per_worker_task_lists = 0;
+  clear_task_queues ();
+
+  if (mp_task_queues) {
+    delete[] mp_task_queues;
+    mp_task_queues = 0;
   }
 }
 
@@ -225,17 +287,41 @@ JobBase::set_num_workers (int nworkers)
 {
   terminate ();
 
-  m_nworkers = nworkers;
-  m_idle_workers = 0;
-
-  if (mp_per_worker_task_lists) {
-    delete[] mp_per_worker_task_lists;
+  //  keep the tasks which are still left in the worker's queues
+  if (mp_task_queues) {
+    for (int i = 0; i < m_nworkers; ++i) {
+      while (Task *task = mp_task_queues [i].fetch ()) {
+        m_task_list.put (task);
+      }
+    }
+    delete[] mp_task_queues;
   }
 
+  m_nworkers = nworkers;
+  m_idle_workers.fetchAndStoreOrdered (0);
+  m_tasks_queued.fetchAndStoreOrdered (0);
+
   if (nworkers > 0) {
-    mp_per_worker_task_lists = new TaskList[nworkers];
+    mp_task_queues = new TaskQueue[nworkers];
   } else {
-    mp_per_worker_task_lists = 0;
+    mp_task_queues = 0;
+  }
+}
+
+void
+JobBase::clear_task_queues ()
+{
+  while (! m_task_list.is_empty ()) {
+    delete m_task_list.fetch ();
+  }
+
+  if (mp_task_queues) {
+    for (int i = 0; i < m_nworkers; ++i) {
+      while (Task *task = mp_task_queues [i].fetch ()) {
+        m_tasks_queued.fetchAndAddOrdered (-1);
+        delete task;
+      }
+    }
   }
 }
 
@@ -246,19 +332,10 @@ JobBase::start ()
 
   m_error_messages.clear ();
 
-  tl_assert (! m_running);
-
-  m_running = true;
-  
-  //  Add a start task for each worker
-  //  This serves as a synchronization measure such that each task gets called once and
-  //  the empty queue detection works properly.
-  for (int i = 0; i < m_nworkers; ++i) {
-    mp_per_worker_task_lists[i].put_front (new StartTask ());
-  }
-
-  m_task_available_condition.wakeAll ();
+  tl_assert (! atomic_flag (m_running));
 
+  //  NOTE: the workers are created before the job is marked running, so the 
+  //  worker list does not change while tasks are executed.
   while (m_nworkers > int (mp_workers.size ())) {
     mp_workers.push_back (create_worker ());
     mp_workers.back ()->start (this, int (mp_workers.size ()) - 1);
@@ -269,6 +346,28 @@ JobBase::start ()
     mp_workers [i]->reset_stop_request ();
   }
 
+  if (! mp_workers.empty ()) {
+
+    //  distribute the tasks scheduled so far over the worker's queues: each worker receives a
+    //  contiguous chunk which is better for locality than a round-robin distribution
+    std::vector<Task *> tasks;
+    while (! m_task_list.is_empty ()) {
+      tasks.push_back (m_task_list.fetch ());
+    }
+    for (size_t i = 0; i < tasks.size (); ++i) {
+      put_task (int ((i * size_t (m_nworkers)) / tasks.size ()), tasks [i], true);
+    }
+
+    //  The start count serves as a synchronization measure such that each worker wakes up
+    //  once and the empty queue detection works properly.
+    ++m_start_count;
+
+  }
+
+  set_atomic_flag (m_running, true);
+
+  m_task_available_condition.wakeAll ();
+
   m_lock.unlock ();
 
   if (mp_workers.empty ()) {
@@ -306,7 +405,7 @@ JobBase::start ()
     }
 
     finished ();
-    m_running = false;
+    set_atomic_flag (m_running, false);
 
   }
 }
@@ -314,7 +413,7 @@ JobBase::start ()
 bool 
 JobBase::is_running () 
 {
-  return m_running;
+  return atomic_flag (m_running);
 }
 
 bool 
@@ -324,7 +423,7 @@ JobBase::wait (long timeout)
   bool status = true;
 
   m_lock.lock ();
-  if (m_nworkers > 0 && m_running && ! m_queue_empty_condition.wait (&m_lock, timeout >= 0 ? (unsigned long) timeout : ULONG_MAX)) {
+  if (m_nworkers > 0 && atomic_flag (m_running) && ! m_queue_empty_condition.wait (&m_lock, timeout >= 0 ? (unsigned long) timeout : ULONG_MAX)) {
     status = false;
   }
   m_lock.unlock ();
@@ -335,18 +434,16 @@ JobBase::wait (long timeout)
 void 
 JobBase::stop ()
 {
-  if (! m_running) {
+  if (! atomic_flag (m_running)) {
     return;
   }
 
   m_lock.lock ();
 
-  m_stopping = true;
+  set_atomic_flag (m_stopping, true);
 
   //  Remove all pending tasks
-  while (! m_task_list.is_empty ()) {
-    delete m_task_list.fetch ();
-  }
+  clear_task_queues ();
 
   if (! mp_workers.empty ()) {
 
@@ -372,10 +469,14 @@ JobBase::stop ()
 
     //  Unless new tasks are scheduled, we can be sure that now all workers
     //  are idle.
+
+    //  Remove the tasks that have been scheduled by the workers while stopping
+    clear_task_queues ();
+
   }
 
-  m_stopping = false;
-  m_running = false;
+  set_atomic_flag (m_stopping, false);
+  set_atomic_flag (m_running, false);
 
   m_lock.unlock ();
 
@@ -391,13 +492,14 @@ JobBase::terminate ()
 
     m_lock.lock ();
 
-    //  Add a stop task for each worker and request a stop
+    //  Request a stop for each worker and make them exit
     for (int i = 0; i < int (mp_workers.size ()); ++i) {
       mp_workers [i]->stop_request ();
-      mp_per_worker_task_lists[i].put (new ExitTask ());
     }
 
-    //  signal that we have new tasks
+    set_atomic_flag (m_exiting, true);
+
+    //  wake up the workers so they can exit
     m_task_available_condition.wakeAll ();
 
     //  Unless new tasks are scheduled, we can be sure that now all workers
@@ -416,84 +518,163 @@ JobBase::terminate ()
 
     mp_workers.clear ();
 
+    set_atomic_flag (m_exiting, false);
+
   }
 }
 
 void 
 JobBase::schedule (Task *task)
 {
+  //  Tasks scheduled from within a worker go into the worker's own queue. This does not
+  //  require locking the job: as the worker is busy, the job cannot finish meanwhile.
+  int w = current_worker ();
+  if (w >= 0) {
+
+    //  Don't allow tasks to be scheduled while stopping or exiting (waiting for m_queue_empty_condition)
+    if (atomic_flag (m_stopping)) {
+      throw TaskTerminatedException ();
+    }
+
+    put_task (w, task);
+    return;
+
+  }
+
   m_lock.lock ();
 
   //  Don't allow tasks to be scheduled while stopping or exiting (waiting for m_queue_empty_condition)
-  if (m_stopping) {
+  if (atomic_flag (m_stopping)) {
     m_lock.unlock ();
     throw TaskTerminatedException ();
   }
 
-  //  Add the task to the task queue
-  m_task_list.put (task);
+  if (! atomic_flag (m_running) || mp_workers.empty ()) {
+
+    //  Add the task to the task queue - it will be distributed over the 
+    //  workers when the job is started
+    m_task_list.put (task);
+    m_lock.unlock ();
+
+  } else {
+
+    //  distribute the tasks over the workers in a round-robin fashion
+    //  NOTE: the task is put into the queue while the job is still locked. Otherwise the 
+    //  workers may finish the job between the check of m_running and the enqueuing and the
+    //  task would not be executed before the job is started again.
+    w = int ((unsigned int) m_next_queue.fetchAndAddRelaxed (1) % (unsigned int) m_nworkers);
+    put_task (w, task, true);
+
+    m_lock.unlock ();
 
-  if (m_running) {
-    m_task_available_condition.wakeAll ();
   }
+}
 
-  m_lock.unlock ();
+void
+JobBase::put_task (int worker, Task *task, bool job_locked)
+{
+  //  NOTE: the task counter is incremented before the task is put into the queue, so
+  //  m_tasks_queued is never less than the number of tasks available.
+  m_tasks_queued.fetchAndAddOrdered (1);
+  mp_task_queues [worker].put (task);
+
+  //  wake up a worker if there are idle ones
+  if (atomic_flag (m_running) && atomic_value (m_idle_workers) > 0) {
+    if (! job_locked) {
+      m_lock.lock ();
+    }
+    m_task_available_condition.wakeOne ();
+    if (! job_locked) {
+      m_lock.unlock ();
+    }
+  }
 }
 
 Task *
-JobBase::get_task (int worker)
+JobBase::take_task (int worker)
 {
-  while (true) {
+  //  take a task from our own queue first, then try to steal one from the other workers
+  Task *task = mp_task_queues [worker].fetch ();
+  for (int i = 1; ! task && i < m_nworkers; ++i) {
+    task = mp_task_queues [(worker + i) % m_nworkers].fetch ();
+  }
 
-    m_lock.lock ();
+  if (task) {
+    m_tasks_queued.fetchAndAddOrdered (-1);
+  }
 
-    //  wait for new relevant entries in the task queue
-    while (m_task_list.is_empty () && mp_per_worker_task_lists [worker].is_empty ()) {
+  return task;
+}
 
-      //  if the queue is empty, mark this worker as idle.
-      ++m_idle_workers;
+int
+JobBase::current_worker () const
+{
+  QThread *current = QThread::currentThread ();
+  for (int i = 0; i < int (mp_workers.size ()); ++i) {
+    if (static_cast<QThread *> (mp_workers [i]) == current) {
+      return i;
+    }
+  }
+  return -1;
+}
 
-      //  signal empty queue if all workers are waiting
-      if (m_idle_workers == m_nworkers) {
-        if (! m_stopping) {
-          finished ();
-        }
-        m_running = false;
-        m_queue_empty_condition.wakeAll ();
-      }
+Task *
+JobBase::get_task (int worker)
+{
+  while (true) {
 
-      //  wait until we receive a task
-      while (m_task_list.is_empty () && mp_per_worker_task_lists [worker].is_empty ()) {
-        mp_workers [worker]->set_idle (true);
-        m_task_available_condition.wait (&m_lock);
-        mp_workers [worker]->set_idle (false);
+    //  fast path: fetch a task without locking the job
+    if (atomic_flag (m_running) && ! atomic_flag (m_stopping)) {
+      Task *task = take_task (worker);
+      if (task) {
+        return task;
       }
+    }
 
-      --m_idle_workers;
+    m_lock.lock ();
 
-    } 
+    if (atomic_flag (m_exiting)) {
+      m_lock.unlock ();
+      //  stops the thread
+      throw WorkerTerminatedException ();
+    }
 
-    Task *task = 0;
-    if (! mp_per_worker_task_lists [worker].is_empty ()) {
-      task = mp_per_worker_task_lists [worker].fetch ();
-    } else if (! m_task_list.is_empty ()) {
-      task = m_task_list.fetch ();
+    unsigned int start_count = m_start_count;
+
+    //  Mark this worker as idle. NOTE: the idle counter is incremented before the task counter is 
+    //  checked while put_task does it the other way round. Hence, either we see the new task or 
+    //  put_task sees us idle and wakes us up.
+    int idle_workers = m_idle_workers.fetchAndAddOrdered (1) + 1;
+
+    if (atomic_flag (m_running) && ! atomic_flag (m_stopping) && atomic_value (m_tasks_queued) > 0) {
+      //  tasks have been scheduled meanwhile or are about to be put into a queue: try again
+      m_idle_workers.fetchAndAddOrdered (-1);
+      m_lock.unlock ();
+      QThread::yieldCurrentThread ();
+      continue;
     }
 
-    m_lock.unlock ();
+    //  signal empty queue if all workers are waiting
+    if (idle_workers == m_nworkers && atomic_flag (m_running)) {
+      if (! atomic_flag (m_stopping)) {
+        finished ();
+      }
+      set_atomic_flag (m_running, false);
+      m_queue_empty_condition.wakeAll ();
+    }
 
-    if (dynamic_cast <ExitTask *> (task) != 0) {
-      delete task;
-      //  stops the thread
-      throw WorkerTerminatedException ();
-    } else if (dynamic_cast <StartTask *> (task) != 0) {
-      delete task;
-      //  dummy task for synchronization - wait for new tasks to arrive.
-    } else if (task) {
-      return task;
+    //  wait until we receive a task or the job is restarted or terminated
+    mp_workers [worker]->set_idle (true);
+    while (! atomic_flag (m_exiting) && start_count == m_start_count && ! (atomic_flag (m_running) && ! atomic_flag (m_stopping) && atomic_value (m_tasks_queued) > 0)) {
+      m_task_available_condition.wait (&m_lock);
     }
+    mp_workers [worker]->set_idle (false);
 
-  }
+    m_idle_workers.fetchAndAddOrdered (-1);
+
+    m_lock.unlock ();
+
+  } 
 }
 
 // -----------------------------------------------------------------------------
@@ -29,6 +29,7 @@
 #include <QMutex>
 #include <QWaitCondition>
 #include <QThread>
+#include <QAtomicInt>
 
 #include <set>
 #include <vector>
@@ -55,11 +56,17 @@ namespace tl
  *      A job may be associated with multiple boss instances.
  *  3.) Workers: a job can be split into multiple tasks which are executed by the workers. A worker is
  *      a thread which receives tasks through a task queue.
+ *
+ *  Each worker owns a task queue. Tasks scheduled from outside are distributed over these queues
+ *  and tasks scheduled from within a worker are put into the worker's own queue. A worker running
+ *  out of tasks will steal tasks from the queues of the other workers. This way, the workers
+ *  don't compete for a single lock when fetching tasks.
  */
 
 class Boss;
 class Worker;
 class Task;
+class TaskQueue;
 
 /**
  *  @brief A task list
@@ -95,6 +102,10 @@ public:
 
   /**
    *  @brief Put (append) a task to the task list
+   *
+   *  The task is inserted after the last task with the same or a higher priority.
+   *  Hence, tasks with a higher priority are fetched first while tasks with the 
+   *  same priority are fetched in the order they were put.
    */
   void put (Task *task);
 
@@ -158,10 +169,15 @@ public:
    *
    *  This does not trigger the actual operation yet. It should be done separately before
    *  \start is called. However, it is possible to schedule jobs while the job is running and
-   *  even from within other tasks.
-   *  It is guaranteed that the order of processing of the tasks is maintained. However, 
-   *  it is not guaranteed that previous tasks have been processed already because they
-   *  might be send to a different thread.
+   *  even from within other tasks. Tasks scheduled from within a task are put into the queue 
+   *  of the worker executing the task.
+   *  Each worker takes tasks with a higher priority (see Task::set_priority) first. Tasks with the 
+   *  same priority are started roughly in the order they were scheduled.
+   *  NOTE: unlike in previous versions, the order of processing is no longer guaranteed: 
+   *  tasks are distributed over the worker's queues and idle workers steal tasks from the other 
+   *  queues. Hence a task may be started before a task which was scheduled earlier. Also, it is 
+   *  not guaranteed that previous tasks have been processed already because they might be sent 
+   *  to a different thread.
    */
   void schedule (Task *task);
 
@@ -260,12 +276,16 @@ private:
   friend class Boss;
 
   TaskList m_task_list;
-  TaskList *mp_per_worker_task_lists;
+  TaskQueue *mp_task_queues;
 
   int m_nworkers;
-  int m_idle_workers;
-  bool m_stopping;
-  bool m_running;
+  QAtomicInt m_idle_workers;
+  QAtomicInt m_tasks_queued;
+  QAtomicInt m_next_queue;
+  QAtomicInt m_stopping;
+  QAtomicInt m_running;
+  QAtomicInt m_exiting;
+  unsigned int m_start_count;
 
   QMutex m_lock;
   QWaitCondition m_task_available_condition;
@@ -277,6 +297,10 @@ private:
   std::vector<std::string> m_error_messages;
 
   Task *get_task (int for_worker);
+  Task *take_task (int for_worker);
+  int current_worker () const;
+  void put_task (int for_worker, Task *task, bool job_locked = false);
+  void clear_task_queues ();
   void log_error (const std::string &s);
 };
 
@@ -406,7 +430,7 @@ public:
    *  @brief Default ctor
    */
   Task () 
-    : mp_next (0), mp_last (0)
+    : mp_next (0), mp_last (0), m_priority (0)
   { }
 
   /**
@@ -415,10 +439,30 @@ public:
   virtual ~Task ()
   { }
 
+  /**
+   *  @brief Gets the priority of the task
+   */
+  int priority () const
+  {
+    return m_priority;
+  }
+
+  /**
+   *  @brief Sets the priority of the task
+   *
+   *  Tasks with a higher priority are taken first. The default priority is 0.
+   *  The priority must be set before the task is scheduled.
+   */
+  void set_priority (int p)
+  {
+    m_priority = p;
+  }
+
 private:
   friend class TaskList;
 
   Task *mp_next, *mp_last;
+  int m_priority;
 };
 
 /**
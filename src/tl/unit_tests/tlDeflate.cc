@@ -24,9 +24,12 @@
 #include "tlStream.h"
 #include "tlDeflate.h"
 #include "tlUnitTest.h"
+#include "tlTimer.h"
 
 #include "zlib.h"
 
+#include <algorithm>
+
 TEST(1) 
 {
   unsigned char data[] = {
@@ -118,3 +121,112 @@ TEST(3)
   delete[] hello;
 }
 
+
+static std::string deflate_string (const std::string &data)
+{
+  tl::OutputStringStream oss;
+  tl::OutputStream os (oss);
+  tl::DeflateFilter fg (os);
+  fg.put (data.c_str (), data.size ());
+  fg.flush ();
+  return oss.string ();
+}
+
+static std::string inflate_string (const std::string &deflated, size_t n)
+{
+  tl::InputMemoryStream ims ((const char *) deflated.c_str (), deflated.size ());
+  tl::InputStream is (ims);
+
+  std::string out;
+  out.reserve (n);
+
+  tl::InflateFilter f (is);
+  while (out.size () < n) {
+    size_t chunk = std::min (size_t (4096), n - out.size ());
+    out += std::string (f.get (chunk), chunk);
+  }
+
+  return out;
+}
+
+static std::string zlib_inflate_string (const std::string &deflated, size_t n)
+{
+  std::string out (n, 0);
+
+  z_stream z;
+  z.zalloc = (alloc_func) 0;
+  z.zfree = (free_func) 0;
+  z.opaque = (voidpf) 0;
+  z.next_in = (Bytef *) deflated.c_str ();
+  z.avail_in = (uInt) deflated.size ();
+  z.next_out = (Bytef *) &out [0];
+  z.avail_out = (uInt) n;
+
+  inflateInit2 (&z, -15 /* == raw deflate data*/);
+  inflate (&z, Z_FINISH);
+  inflateEnd (&z);
+
+  out.resize (z.total_out);
+  return out;
+}
+
+//  The inflate filter must not read beyond the compressed data
+TEST(4)
+{
+  const char hello[] = "This is a test \\!";
+
+  std::string deflated = deflate_string (std::string (hello, sizeof (hello) - 1));
+  deflated += "TRAILER";
+
+  tl::InputMemoryStream ims ((const char *) deflated.c_str (), deflated.size ());
+  tl::InputStream is (ims);
+
+  std::string out;
+  tl::InflateFilter f (is);
+  while (! f.at_end ()) {
+    out += f.get (1) [0];
+  }
+
+  EXPECT_EQ (out, "This is a test \\!");
+  EXPECT_EQ (std::string (is.get (7), 7), "TRAILER");
+}
+
+//  Inflate benchmark on real layout payloads
+TEST(5)
+{
+  const char *files[] = {
+    "/testdata/drc/drcSuiteTests_au3.gds",
+    "/testdata/bool/special2_au1.oas"
+  };
+
+  for (size_t i = 0; i < sizeof (files) / sizeof (files [0]); ++i) {
+
+    std::string fn (tl::testsrc ());
+    fn += files [i];
+
+    tl::InputStream stream (fn);
+    std::string data = stream.read_all ();
+    std::string deflated = deflate_string (data);
+
+    const int n = 10;
+    std::string out, out_zlib;
+
+    {
+      tl::SelfTimer timer (std::string ("InflateFilter: ") + files [i]);
+      for (int j = 0; j < n; ++j) {
+        out = inflate_string (deflated, data.size ());
+      }
+    }
+
+    {
+      tl::SelfTimer timer (std::string ("zlib inflate: ") + files [i]);
+      for (int j = 0; j < n; ++j) {
+        out_zlib = zlib_inflate_string (deflated, data.size ());
+      }
+    }
+
+    EXPECT_EQ (out == data, true);
+    EXPECT_EQ (out_zlib == data, true);
+
+  }
+}
@@ -0,0 +1,171 @@
+
+/*
+
+  KLayout Layout Viewer
+  Copyright (C) 2006-2017 Matthias Koefferlein
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+#include "tlStream.h"
+#include "tlUnitTest.h"
+
+namespace
+{
+
+std::string test_data ()
+{
+  std::string s;
+  for (int i = 0; i < 10000; ++i) {
+    s += "line ";
+    s += tl::to_string (i);
+    s += "\n";
+  }
+  return s;
+}
+
+void write_file (const std::string &path, const std::string &data, tl::OutputStream::OutputStreamMode om)
+{
+  tl::OutputStream os (path, om);
+  os.put (data.c_str (), data.size ());
+}
+
+}
+
+TEST(1_PlainFile)
+{
+  std::string data = test_data ();
+  std::string path = tmp_file ("plain.txt");
+  write_file (path, data, tl::OutputStream::OM_Plain);
+
+  tl::InputStream is (path);
+  EXPECT_EQ (is.source (), path);
+
+  const char *b = is.get (5);
+  EXPECT_EQ (b != 0, true);
+  EXPECT_EQ (std::string (b, 5), "line ");
+  is.unget (2);
+  EXPECT_EQ (is.pos (), size_t (3));
+  b = is.get (3);
+  EXPECT_EQ (std::string (b, 3), "e 0");
+
+  //  a big chunk in one piece
+  b = is.get (data.size () - 6);
+  EXPECT_EQ (b != 0, true);
+  EXPECT_EQ (std::string (b, data.size () - 6), data.substr (6));
+  EXPECT_EQ (is.get (1) == 0, true);
+
+  is.reset ();
+  EXPECT_EQ (is.pos (), size_t (0));
+  EXPECT_EQ (is.read_all (), data);
+
+  is.reset ();
+  tl::OutputStringStream oss;
+  {
+    tl::OutputStream os (oss);
+    is.copy_to (os);
+  }
+  EXPECT_EQ (oss.string (), data);
+}
+
+TEST(2_CompressedFile)
+{
+  std::string data = test_data ();
+  std::string path = tmp_file ("compressed.txt.gz");
+  write_file (path, data, tl::OutputStream::OM_Zlib);
+
+  tl::InputStream is (path);
+  EXPECT_EQ (std::string (is.get (5), 5), "line ");
+  EXPECT_EQ (is.read_all (), data.substr (5));
+
+  is.reset ();
+  EXPECT_EQ (is.read_all (), data);
+}
+
+TEST(3_MemoryStream)
+{
+  const char data[] = "abcdefghij";
+
+  tl::InputMemoryStream ims (data, sizeof (data) - 1);
+  tl::InputStream is (ims);
+
+  //  no copy is made: the pointers point into the memory block
+  EXPECT_EQ (is.get (3) == data, true);
+  EXPECT_EQ (is.get (4) == data + 3, true);
+  EXPECT_EQ (is.get (4) == 0, true);
+  EXPECT_EQ (std::string (is.get (3), 3), "hij");
+
+  is.reset ();
+  EXPECT_EQ (is.get (1) == data, true);
+}
+
+TEST(4_EmptyFile)
+{
+  std::string path = tmp_file ("empty.txt");
+  write_file (path, std::string (), tl::OutputStream::OM_Plain);
+
+  tl::InputStream is (path);
+  EXPECT_EQ (is.get (1) == 0, true);
+  EXPECT_EQ (is.read_all (), "");
+}
+
+
+TEST(5_NoMMap)
+{
+  std::string data = test_data ();
+  std::string path = tmp_file ("nommap.txt");
+  write_file (path, data, tl::OutputStream::OM_Plain);
+
+  EXPECT_EQ (tl::InputStream::mmap_enabled (), true);
+  tl::InputStream::set_mmap_enabled (false);
+
+  {
+    tl::InputStream is (path);
+    size_t n = 0;
+    EXPECT_EQ (is.mapped_data (n) == 0, true);
+    EXPECT_EQ (is.read_all (), data);
+  }
+
+  tl::InputStream::set_mmap_enabled (true);
+}
+
+#if !defined(_WIN32)
+
+TEST(6_TruncatedMappedFile)
+{
+  std::string data = test_data ();
+  std::string path = tmp_file ("truncated.txt");
+  write_file (path, data, tl::OutputStream::OM_Plain);
+
+  tl::InputStream is (path);
+  size_t n = 0;
+  EXPECT_EQ (is.mapped_data (n) != 0, true);
+  EXPECT_EQ (n, data.size ());
+
+  //  truncating the file while it is mapped must not crash but report an error
+  write_file (path, "line", tl::OutputStream::OM_Plain);
+
+  bool error = false;
+  try {
+    is.get (data.size ());
+  } catch (tl::Exception &) {
+    error = true;
+  }
+  EXPECT_EQ (error, true);
+}
+
+#endif
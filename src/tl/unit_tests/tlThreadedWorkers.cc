@@ -24,6 +24,7 @@
 
 #include "tlThreadedWorkers.h"
 #include "tlTimer.h"
+#include "tlString.h"
 #include "tlUnitTest.h"
 
 #include <stdio.h>
@@ -642,3 +643,68 @@ TEST(29)
   }
 }
 
+
+//  task priorities
+TEST(30) 
+{
+  tl::TaskList tl;
+
+  int p[] = { 0, 1, 0, 2, 1, 0 };
+  for (int i = 0; i < int (sizeof (p) / sizeof (p[0])); ++i) {
+    MyTask *t = new MyTask (i);
+    t->set_priority (p[i]);
+    tl.put (t);
+  }
+
+  std::string s;
+  while (! tl.is_empty ()) {
+    MyTask *t = dynamic_cast<MyTask *> (tl.fetch ());
+    if (! s.empty ()) {
+      s += ",";
+    }
+    s += tl::to_string (t->m_n);
+    delete t;
+  }
+
+  EXPECT_EQ (s, "3,1,4,0,2,5");
+}
+
+class RecordingWorker : public tl::Worker
+{
+public:
+  RecordingWorker () : tl::Worker () { }
+
+  static std::string order;
+
+protected:
+  void perform_task (tl::Task *task) 
+  { 
+    MyTask *mytask = dynamic_cast<MyTask *> (task);
+    if (mytask) {
+      if (! order.empty ()) {
+        order += ",";
+      }
+      order += tl::to_string (mytask->m_n);
+    }
+  }
+};
+
+std::string RecordingWorker::order;
+
+//  a single worker takes the tasks by priority
+TEST(31) 
+{
+  tl::Job<RecordingWorker> job (1);
+  RecordingWorker::order.clear ();
+
+  for (int i = 0; i < 10; ++i) {
+    MyTask *t = new MyTask (i);
+    t->set_priority (i % 2);
+    job.schedule (t);
+  }
+
+  job.start ();
+  job.wait ();
+
+  EXPECT_EQ (RecordingWorker::order, "1,3,5,7,9,0,2,4,6,8");
+}
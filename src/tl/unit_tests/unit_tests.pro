@@ -26,6 +26,7 @@ SOURCES = \
   tlObject.cc \
   tlReuseVector.cc \
   tlStableVector.cc \
+  tlStream.cc \
   tlString.cc \
   tlThreadedWorkers.cc \
   tlUtils.cc \
@@ -5,7 +5,7 @@ use strict;
 my %TESTS;
 my %TEST_INTENTION;
 
-my @MAJOR_TESTS = (1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14);
+my @MAJOR_TESTS = (1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
 my %MAJOR_DESCRIPTIONS = (
   1 => "Empty file. Various ways to specify a float (database unit).",
   2 => "Cells. Various ways to specify cell names (id, string) and refer to them.",
@@ -20,7 +20,8 @@ my %MAJOR_DESCRIPTIONS = (
   11 => "Properties",
   12 => "Circles",
   13 => "Layer names",
-  14 => "CBLOCK compression"
+  14 => "CBLOCK compression",
+  15 => "Strict mode"
 );
 
 my $file;
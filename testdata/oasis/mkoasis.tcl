@@ -171,6 +171,70 @@ proc tail {} {
 }
 
 
+# the current position in the output
+proc pos {} {
+  global output
+  return [ tell $output ]
+}
+
+# produce an unsigned int with a fixed length of 4 bytes, so it can be patched later
+proc uint4 { ui } {
+  for { set i 0 } { $i < 3 } { incr i } {
+    byte [ expr 128+($ui%128) ]
+    set ui [ expr $ui>>7 ]
+  }
+  byte $ui
+}
+
+# patch an unsigned int written with uint4 at the given position
+proc patch_uint4 { at ui } {
+  global output
+  set here [ tell $output ]
+  seek $output $at
+  uint4 $ui
+  seek $output $here
+}
+
+# begin a CBLOCK: the records up to end_cblock are compressed
+proc begin_cblock {} {
+  global output outfile cblock_output
+  set cblock_output $output
+  set output [ open "$outfile.cblock" "w" ]
+  fconfigure $output -translation binary
+}
+
+# end a CBLOCK and produce the CBLOCK record
+proc end_cblock {} {
+  global output outfile cblock_output
+  close $output
+  set f [ open "$outfile.cblock" "r" ]
+  fconfigure $f -translation binary
+  set data [ read $f ]
+  close $f
+  file delete "$outfile.cblock"
+  set output $cblock_output
+  set comp [ zlib deflate $data ]
+  record CBLOCK
+  uint 0 ;# comp-type
+  uint [ string length $data ]
+  uint [ string length $comp ]
+  puts -nonewline $output $comp
+}
+
+# produce tail with the table offsets in the END record 
+# offsets is a list of flag/offset pairs for CELLNAME, TEXTSTRING, PROPNAME, PROPSTRING, LAYERNAME and XNAME
+proc tail_with_offsets { offsets } {
+  global output
+  set p0 [ tell $output ]
+  record END
+  foreach o $offsets {
+    uint [ lindex $o 0 ]
+    uint [ lindex $o 1 ]
+  }
+  set n [ expr 256-([ tell $output ]-$p0) ]
+  puts -nonewline $output [ binary format x$n ]
+}
+
 # utility functions
 
 namespace eval soa {
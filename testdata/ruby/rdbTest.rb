@@ -763,6 +763,56 @@ class RDB_TestClass < TestBase
 
   end
 
+
+  # creating items and values while iterating
+  def test_12
+
+    db = RBA::ReportDatabase.new("name")
+    cell = db.create_cell("cell")
+    cat = db.create_category("cat")
+
+    10.times do |i|
+      db.create_item(cell.rdb_id, cat.rdb_id).add_value("v#{i}")
+    end
+
+    # items created while iterating are not delivered
+    n = 0
+    db.each_item_per_category(cat.rdb_id) do |item| 
+      n += 1
+      db.create_item(cell.rdb_id, cat.rdb_id).add_value("n#{n}")
+    end
+    assert_equal(n, 10)
+    assert_equal(cat.num_items, 20)
+
+    n = 0
+    db.each_item do |item| 
+      n += 1
+      db.create_item(cell.rdb_id, cat.rdb_id)
+    end
+    assert_equal(n, 20)
+
+    n = 0
+    cell.each_item do |item| 
+      n += 1
+      db.create_item(cell.rdb_id, cat.rdb_id)
+    end
+    assert_equal(n, 40)
+
+    item = db.create_item(cell.rdb_id, cat.rdb_id)
+    item.add_value("a")
+    vs = []
+    item.each_value do |v| 
+      vs << v.string
+      5.times { item.add_value("b") }
+    end
+    assert_equal(vs.join(","), "a")
+
+    vs = []
+    item.each_value { |v| vs << v.string }
+    assert_equal(vs.join(","), "a,b,b,b,b,b")
+
+  end
+
 end
 
 load("test_epilogue.rb")